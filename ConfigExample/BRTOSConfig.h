@@ -26,12 +26,25 @@
 /// Define if compute cpu load is active
 #define COMPUTES_CPU_LOAD 		1
 
+/// Define if the runtime of each task is computed at the context switch
+/// The application provides OSGetTimerForRuntimeStats and OSConfigureTimerForRuntimeStats
+#define COMPUTES_TASK_LOAD 		0
+
+/// Define if the switches, preemptions and wake up latencies of each task are computed
+/// Requires COMPUTES_TASK_LOAD
+#define BRTOS_TASK_STATS_EN 	0
+
+/// Enable or disable the CPU budgets of the tasks (OSTaskBudgetSet)
+/// Requires COMPUTES_TASK_LOAD. The application must define BRTOS_BudgetOverrunHook
+#define BRTOS_BUDGET_EN 		0
+
 // The Nesting define must be set in the file HAL.h
 // Example:
 /// Define if nesting interrupt is active
 //#define NESTING_INT 0
 
 /// Define Number of Priorities
+/// 8, 16 or 32 use a single bitmap word. 64, 128 or 256 use a two level bitmap (priority 255 is reserved)
 #define NUMBER_OF_PRIORITIES 	32
 
 /// Define the maximum number of Tasks to be Installed
@@ -41,6 +54,23 @@
 /// Enable or disable the dynamic task install and uninstall
 #define BRTOS_DYNAMIC_TASKS_ENABLED 1
 
+/// Enable more than one task per priority (FIFO ready list per priority)
+/// NUMBER_OF_TASKS is no longer limited by the number of priorities
+#define BRTOS_ROUND_ROBIN_EN   0
+
+/// Time slice of the tasks that share a priority, in ticks (0 - no time slicing)
+#define configTIME_SLICE_TICKS 0
+
+/// Enable or disable the earliest deadline first scheduling class at BRTOS_EDF_PRIORITY
+/// (requires BRTOS_ROUND_ROBIN_EN)
+#define BRTOS_EDF_EN           0
+
+/// Enable or disable the per task accounting of the dynamic heap
+#define BRTOS_HEAP_ACCOUNTING_EN 0
+
+/// Number of records of the dynamic heap allocation trace (0 - no trace)
+#define BRTOS_HEAP_TRACE_SIZE    0
+
 /// Defines the memory allocation and deallocation function to the dynamic queues
 #include "umm_malloc.h"
 #define BRTOS_ALLOC   umm_malloc
@@ -48,12 +78,14 @@
 
 #define configMAX_TASK_NAME_LEN 32
 
-/// Define if OS Trace is active
+/// Define if the binary event trace is active (OSTrace.h)
 #define OSTRACE 0
 
-#if (OSTRACE == 1)  
-  #include "debug_stack.h"
-#endif
+/// Number of records of the event trace ring buffer (power of 2)
+#define BRTOS_TRACE_SIZE 256
+
+/// Define if the tick interrupts are recorded by the event trace
+#define OS_TICK_SHOW 0
 
 /// Define if TimerHook function is active
 #define TIMER_HOOK_EN 0
@@ -61,6 +93,9 @@
 /// Define if IdleHook function is active
 #define IDLE_HOOK_EN 0
 
+/// Enable or disable the 64 bit tick count (OSGetTickCount64) and OSDelayUntil64
+#define BRTOS_TICK64_EN        0
+
 /// Enable or disable timers service
 #define BRTOS_TMR_EN           1
 
@@ -82,6 +117,28 @@
 /// Enable or disable dynamic queue controls
 #define BRTOS_DYNAMIC_QUEUE_ENABLED	1
 
+/// Enable or disable single producer / single consumer streams
+#define BRTOS_STREAM_EN        0
+
+/// Enable or disable event groups (event flags)
+#define BRTOS_EVENT_GROUP_EN   0
+
+/// Enable or disable the wait for multiple semaphores, mailboxes and queues (OSPendMultiple)
+#define BRTOS_PEND_MULTIPLE_EN 0
+
+/// Enable or disable the direct to task notifications
+#define BRTOS_TASK_NOTIFY_EN   0
+
+/// Enable or disable the deferred function calls run by the timer task (OSPendFunctionCall)
+#define BRTOS_PEND_CALL_EN     0
+
+/// Enable or disable the fixed block memory pools
+#define BRTOS_MEMPOOL_EN       0
+
+/// Enable or disable the task stack overflow check at the context switch\n
+/// The application must define BRTOS_StackOverflowHook
+#define BRTOS_STACK_CHECK_EN   0
+
 /// Enable or disable queue 16 bits controls
 #define BRTOS_QUEUE_16_EN      0
 
@@ -104,6 +161,25 @@
 /// Limits the memory allocation for queues
 #define BRTOS_MAX_QUEUE        20
 
+/// Defines the maximum number of event groups\n
+/// Limits the memory allocation for event groups
+#define BRTOS_MAX_EVENT_GROUP  4
+
+/// Defines the maximum number of memory pools\n
+/// Limits the memory allocation for memory pool control blocks
+#define BRTOS_MAX_MEMPOOL      4
+
+/// Defines the maximum number of soft timers\n
+/// Limits the memory allocation for soft timers
+#define BRTOS_MAX_TIMER        8
+
+/// Defines the number of bits of each level of the soft timer wheel (1 to 5)\n
+/// Each level uses 2^BRTOS_TIMER_WHEEL_BITS list pointers
+#define BRTOS_TIMER_WHEEL_BITS 4
+
+/// Defines the maximum number of pending deferred function calls (1 to 254)
+#define BRTOS_PEND_CALL_QUEUE_SIZE 8
+
 
 /// TickTimer Defines
 #define configCPU_CLOCK_HZ          	(INT32U)168000000   ///< CPU clock in Hertz
@@ -115,6 +115,18 @@ uint8_t NumberOfInstalledTasks;                 ///< Number of Installed tasks a
 volatile uint8_t currentTask;                            ///< Current task being executed
 volatile uint8_t SelectedTask;
 
+#if (NUMBER_OF_PRIORITIES > 32)
+  PriorityType OSReadyList;
+  #if (OS_PRIORITY_GROUPS == 8)
+    PriorityType OSBlockedList = {0xFF, {0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF}};
+  #else
+    #if (OS_PRIORITY_GROUPS == 4)
+      PriorityType OSBlockedList = {0x0F, {0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF}};
+    #else
+      PriorityType OSBlockedList = {0x03, {0xFFFFFFFF,0xFFFFFFFF}};
+    #endif
+  #endif
+#else
 #if (NUMBER_OF_PRIORITIES > 16)
   PriorityType OSReadyList = 0;
   PriorityType OSBlockedList = 0xFFFFFFFF;
@@ -127,8 +139,12 @@ volatile uint8_t SelectedTask;
     PriorityType OSBlockedList = 0xFF;
   #endif
 #endif
+#endif
 
 static   ostick_t OSTickCounter;                  ///< Incremented each tick timer - Used in delay and timeout functions
+#if (BRTOS_TICK64_EN == 1)
+static   uint32_t OSTickEpoch;                    ///< Number of overflows of the tick counter - Used by the 64 bit tick count
+#endif
 volatile uint32_t OSDuty=0;                         ///< Used to compute the CPU load
 volatile uint32_t OSDutyTmp=0;                      ///< Used to compute the CPU load
 
@@ -139,11 +155,22 @@ volatile uint16_t LastOSDuty = 0;                   ///< Last CPU load computed
 #endif
 
 uint16_t DutyCnt = 0;                               ///< Used to compute the CPU load
-uint32_t TaskAlloc = 0;                             ///< Used to search a empty task control block
+uint32_t TaskAlloc[OS_TASK_ALLOC_SIZE];              ///< Used to search a empty task control block
 uint8_t  iNesting = 0;                              ///< Used to inform if the current code position is an interrupt handler code
 
 ContextType *Tail;
 ContextType *Head;
+static ostick_t OSDelayListTick;                    ///< Tick count of the last delay list update - Reference to the delay list order
+
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+static uint8_t  OSReadyQueueHead[configMAX_TASK_INSTALL];   ///< First ready task of each priority - the task that runs
+static uint8_t  OSReadyQueueTail[configMAX_TASK_INSTALL];   ///< Last ready task of each priority
+static uint16_t OSWaitOrder = 0;                            ///< Arrival order of the tasks in the event wait lists
+#if (configTIME_SLICE_TICKS > 0)
+static uint8_t  OSSliceTask = 0;                            ///< Task that owns the current time slice
+static ostick_t OSSliceTicks = 0;                           ///< Ticks consumed from the current time slice
+#endif
+#endif
 
 #if (DEBUG == 0)
 volatile uint8_t flag_load = TRUE;
@@ -151,7 +178,7 @@ volatile uint8_t flag_load = TRUE;
 
 
 #if (NUMBER_OF_PRIORITIES > 16)
-  const PriorityType PriorityMask[configMAX_TASK_PRIORITY+1]=
+  const PriorityWordType PriorityMask[OS_PRIORITY_WORD_BITS]=
   {
     0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x0100,0x0200,0x0400,0x0800,0x1000,0x2000,0x4000,0x8000,
     0x010000,0x020000,0x040000,0x080000,0x100000,0x200000,0x400000,0x800000,0x01000000,0x02000000,
@@ -159,12 +186,12 @@ volatile uint8_t flag_load = TRUE;
   };
 #else
   #if (NUMBER_OF_PRIORITIES > 8)
-    const PriorityType PriorityMask[configMAX_TASK_PRIORITY+1]=
+    const PriorityWordType PriorityMask[OS_PRIORITY_WORD_BITS]=
     {
       0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x0100,0x0200,0x0400,0x0800,0x1000,0x2000,0x4000,0x8000
     };
   #else
-    const PriorityType PriorityMask[configMAX_TASK_PRIORITY+1]=
+    const PriorityWordType PriorityMask[OS_PRIORITY_WORD_BITS]=
     {
       0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80
     };  
@@ -209,6 +236,23 @@ volatile uint8_t flag_load = TRUE;
 #endif
 
 
+////////////////////////////////////////////////////////////
+/////      Event Group Control Block Declaration       /////
+////////////////////////////////////////////////////////////
+#if (BRTOS_EVENT_GROUP_EN == 1)
+  /// Event Group Control Block
+  BRTOS_EventGroup BRTOS_EventGroup_Table[BRTOS_MAX_EVENT_GROUP];  // Table of EVENT control blocks
+#endif
+
+////////////////////////////////////////////////////////////
+/////      Memory Pool Control Block Declaration       /////
+////////////////////////////////////////////////////////////
+#if (BRTOS_MEMPOOL_EN == 1)
+  /// Memory Pool Control Block
+  BRTOS_MemPool BRTOS_MemPool_Table[BRTOS_MAX_MEMPOOL];  // Table of EVENT control blocks
+#endif
+
+
 ///// RAM definitions
 #ifdef OS_CPU_TYPE
 #if (!BRTOS_DYNAMIC_TASKS_ENABLED)
@@ -237,12 +281,133 @@ ContextType ContextTask[NUMBER_OF_TASKS + 1];          ///< Task context info
 static volatile uint32_t OSTimeTaskSwitched = 0UL;				   	   ///< Value of a counter in the last time a task was switched.
 static volatile uint32_t OSTotalRuntime = 0UL;						   ///< Total amount of execution time
 
+#if (BRTOS_TASK_STATS_EN == 1)
+static OS_TASK_STATS OSTaskStats[NUMBER_OF_TASKS + 1];         ///< Scheduling statistics of the tasks
+
+// Statistics of the task switched out (currentTask) and of the task switched in (SelectedTask)
+static void OSTaskStatsSwitch(uint32_t elapsed)
+{
+	OS_TASK_STATS *stats = &OSTaskStats[currentTask];
+	ContextType *Task = &ContextTask[SelectedTask];
+	uint32_t latency, bin_limit;
+	uint8_t bin;
+
+	stats->runtime += elapsed;
+
+	// Switched out while still ready - preempted by a higher priority task or by a time slice
+	if ((currentTask != 0) && (ContextTask[currentTask].Priority != EMPTY_PRIO) &&
+		OSIsTaskReady(&ContextTask[currentTask]) && !OSIsTaskBlocked(&ContextTask[currentTask]))
+	{
+		stats->preemptions++;
+	}
+
+	stats = &OSTaskStats[SelectedTask];
+	stats->switches++;
+
+	if (Task->Waking)
+	{
+		Task->Waking = FALSE;
+		latency = OSTotalRuntime - Task->ReadyTime;
+
+		if ((stats->wakeups == 0) || (latency < stats->latency_min))
+		{
+			stats->latency_min = latency;
+		}
+		if (latency > stats->latency_max)
+		{
+			stats->latency_max = latency;
+		}
+		stats->latency_total += latency;
+		stats->wakeups++;
+
+		// Bins with doubling limits
+		bin = 0;
+		bin_limit = (uint32_t)1 << BRTOS_LATENCY_HIST_SHIFT;
+		while((bin < (BRTOS_LATENCY_HIST_SIZE - 1)) && (latency >= bin_limit))
+		{
+			bin++;
+			bin_limit <<= 1;
+			if (bin_limit == 0) bin_limit = 0xFFFFFFFFUL;
+		}
+		stats->latency_hist[bin]++;
+	}
+}
+
+void OSTaskStatsReady(ContextType *Task)
+{
+	Task->ReadyTime = OSGetTimerForRuntimeStats();
+	Task->Waking = TRUE;
+}
+
+uint8_t OSGetTaskStats(BRTOS_TH task, OS_TASK_STATS *stats)
+{
+	OS_SR_SAVE_VAR
+
+	if ((task == 0) || (task > NUMBER_OF_TASKS) || (stats == NULL))
+	{
+		return NOT_VALID_TASK;
+	}
+
+	// Enter Critical Section
+	OSEnterCritical();
+
+	*stats = OSTaskStats[task];
+
+	// Exit Critical Section
+	OSExitCritical();
+
+	return OK;
+}
+
+static void OSTaskStatsClear(uint16_t task)
+{
+	uint8_t i;
+
+	OSTaskStats[task].runtime = 0;
+	OSTaskStats[task].switches = 0;
+	OSTaskStats[task].preemptions = 0;
+	OSTaskStats[task].wakeups = 0;
+	OSTaskStats[task].latency_min = 0;
+	OSTaskStats[task].latency_max = 0;
+	OSTaskStats[task].latency_total = 0;
+	for(i = 0; i < BRTOS_LATENCY_HIST_SIZE; i++)
+	{
+		OSTaskStats[task].latency_hist[i] = 0;
+	}
+	OSTaskStats[task].overruns = 0;
+}
+
+void OSResetTaskStats(void)
+{
+	OS_SR_SAVE_VAR
+	uint16_t i;
+
+	// Enter Critical Section
+	OSEnterCritical();
+
+	for(i = 0; i <= NUMBER_OF_TASKS; i++)
+	{
+		OSTaskStatsClear(i);
+	}
+
+	// Exit Critical Section
+	OSExitCritical();
+}
+#endif
+
 void COMPUTE_TASK_LOAD(void){
+	uint32_t elapsed;
+
 	OSTotalRuntime = OSGetTimerForRuntimeStats();
-	if( OSTotalRuntime > OSTimeTaskSwitched ){
-		ContextTask[currentTask].Runtime += (OSTotalRuntime - OSTimeTaskSwitched);
-	}
+
+	// The unsigned difference is valid across an overflow of the runtime counter
+	elapsed = OSTotalRuntime - OSTimeTaskSwitched;
+	ContextTask[currentTask].Runtime += elapsed;
 	OSTimeTaskSwitched = OSTotalRuntime;
+
+	#if (BRTOS_TASK_STATS_EN == 1)
+	OSTaskStatsSwitch(elapsed);
+	#endif
 }
 #endif
 
@@ -253,6 +418,36 @@ void COMPUTE_TASK_LOAD(void){
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 
+#if ((BRTOS_ROUND_ROBIN_EN == 0) || (TICKLESS == 1))
+// Highest priority ready and not blocked - the idle task priority (0) is always ready
+static uint8_t OSReadyListHighest(void)
+{
+#if (NUMBER_OF_PRIORITIES > 32)
+  PriorityWordType Groups = OSReadyList.Group;
+  PriorityWordType Ready;
+  uint8_t iGroup;
+
+  while(Groups != 0)
+  {
+	  iGroup = SAScheduler(Groups);
+	  Ready = OSReadyList.Bits[iGroup] & OSBlockedList.Bits[iGroup];
+
+	  if (Ready != 0)
+	  {
+		  return (uint8_t)((iGroup << 5) + SAScheduler(Ready));
+	  }
+
+	  // Every ready task of the group is blocked
+	  Groups = Groups & ~(PriorityMask[iGroup]);
+  }
+
+  return 0;
+#else
+  return SAScheduler(OSReadyList & OSBlockedList);
+#endif
+}
+#endif
+
 /************************************************************//**
 * \fn void OSSchedule(void)
 * \brief Priority Preemptive Scheduler (Internal kernel function).
@@ -263,8 +458,15 @@ uint8_t OSSchedule(void)
 	uint8_t TaskSelect = 0xFF;
 	uint8_t Priority   = 0;
 	
-  Priority = SAScheduler(OSReadyList & OSBlockedList);
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+  // The first task of the highest priority ready list
+  // Blocked tasks are not linked into the ready list
+  Priority = OSPrioHighest(OSReadyList);
+  TaskSelect = OSReadyQueueHead[Priority];
+#else
+  Priority = OSReadyListHighest();
   TaskSelect = PriorityVector[Priority];
+#endif
   
 	return TaskSelect;
 }
@@ -275,27 +477,30 @@ uint8_t OSSchedule(void)
 
 
 
-
-
+#if (BRTOS_STACK_CHECK_EN == 1)
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
-/////      Get the current task handle                 /////
+/////      Task Stack Overflow Check                   /////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
-BRTOS_TH OSGetCurrentTaskHandle(void)
+
+void OSStackCheck(void)
 {
-	OS_SR_SAVE_VAR
-	BRTOS_TH task_handle;
+  uint32_t *guard = ContextTask[currentTask].StackGuard;
 
-  	OSEnterCritical();
-	task_handle = (BRTOS_TH)currentTask;
-  	OSExitCritical();
-	return task_handle;
+  // The guard word is written at the task installation
+  if ((guard != NULL) && (*guard != BRTOS_STACK_CANARY))
+  {
+    // Written again to report a new overflow
+    *guard = BRTOS_STACK_CANARY;
+    BRTOS_StackOverflowHook((BRTOS_TH)currentTask);
+  }
 }
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
+#endif
 
 
 
@@ -303,197 +508,1464 @@ BRTOS_TH OSGetCurrentTaskHandle(void)
 
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
-/////      Get task priority               			   /////
+/////      Ready List and Event Wait List Functions    /////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
-OS_CPU_TYPE OSGetTaskPriority(BRTOS_TH task_handle)
+
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+// More than one task per priority
+// PriorityVector holds one of the tasks installed with the priority and the
+// tasks of the same priority are linked in a circular list (PrioNext).
+// The ready tasks of each priority are kept in a FIFO list. The priority bit
+// of the ready list is set while this FIFO list is not empty.
+
+// Includes a task into the circular list of its priority
+static void OSPriorityListInsert(uint8_t TaskNumber)
 {
-	OS_SR_SAVE_VAR
-	OS_CPU_TYPE task_prio;
+  ContextType *Task = (ContextType*)&ContextTask[TaskNumber];
+  uint8_t First = PriorityVector[Task->Priority];
 
-  	OSEnterCritical();
-	task_prio = (OS_CPU_TYPE)ContextTask[task_handle].Priority;
-  	OSExitCritical();
-	return task_prio;
+  if ((First == EMPTY_PRIO) || (First == MUTEX_PRIO))
+  {
+	  Task->PrioNext = TaskNumber;
+	  PriorityVector[Task->Priority] = TaskNumber;
+  }
+  else
+  {
+	  Task->PrioNext = ContextTask[First].PrioNext;
+	  ContextTask[First].PrioNext = TaskNumber;
+  }
 }
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
 
+// Removes a task from the circular list of its priority
+static void OSPriorityListRemove(uint8_t TaskNumber)
+{
+  ContextType *Task = (ContextType*)&ContextTask[TaskNumber];
+  uint8_t iTask = TaskNumber;
 
+  if (Task->PrioNext == TaskNumber)
+  {
+	  // Last task of the priority
+	  PriorityVector[Task->Priority] = EMPTY_PRIO;
+  }
+  else
+  {
+	  while(ContextTask[iTask].PrioNext != TaskNumber)
+	  {
+		  iTask = ContextTask[iTask].PrioNext;
+	  }
+	  ContextTask[iTask].PrioNext = Task->PrioNext;
 
+	  if (PriorityVector[Task->Priority] == TaskNumber)
+	  {
+		  PriorityVector[Task->Priority] = Task->PrioNext;
+	  }
+  }
 
+  Task->PrioNext = 0;
+}
 
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-/////      Get the current tick count                  /////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-ostick_t OSGetTickCount(void)
+#if (BRTOS_EDF_EN == 1)
+// Order of the absolute deadline of an EDF task - ticks from half of the tick counter
+// range before the current tick count, so a missed deadline is before the next ones
+// The tasks of the EDF priority that are not EDF tasks are after every EDF task
+static ostick_t OSEDFKey(ContextType *Task)
 {
-  OS_SR_SAVE_VAR
-  ostick_t cnt;
-  
-  OSEnterCritical();
-  cnt = OSTickCounter;
-  OSExitCritical();
-  return cnt;
+  ostick_t half = (ostick_t)(TICK_COUNT_OVERFLOW / 2);
+  ostick_t ref;
+
+  if (Task->EDFPeriod == 0)
+  {
+	  return TICK_COUNT_OVERFLOW;
+  }
+
+  if (OSTickCounter >= half)
+  {
+	  ref = (ostick_t)(OSTickCounter - half);
+  }
+  else
+  {
+	  ref = (ostick_t)(OSTickCounter + (TICK_COUNT_OVERFLOW - half));
+  }
+
+  if (Task->EDFAbsDeadline >= ref)
+  {
+	  return (ostick_t)(Task->EDFAbsDeadline - ref);
+  }
+  else
+  {
+	  return (ostick_t)(Task->EDFAbsDeadline + (TICK_COUNT_OVERFLOW - ref));
+  }
 }
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
 
+// Puts a task into the ready list of the EDF priority, sorted by the absolute deadline
+// Tasks with the same deadline are kept in FIFO order
+static void OSEDFQueueLink(ContextType *Task)
+{
+  uint8_t TaskNumber = (uint8_t)(Task - ContextTask);
+  uint8_t Prev = OSReadyQueueTail[BRTOS_EDF_PRIORITY];
+  ostick_t Key = OSEDFKey(Task);
+
+  while((Prev != 0) && (OSEDFKey((ContextType*)&ContextTask[Prev]) > Key))
+  {
+	  Prev = ContextTask[Prev].ReadyPrev;
+  }
 
+  Task->ReadyPrev = Prev;
 
+  if (Prev != 0)
+  {
+	  Task->ReadyNext = ContextTask[Prev].ReadyNext;
+	  ContextTask[Prev].ReadyNext = TaskNumber;
+  }
+  else
+  {
+	  Task->ReadyNext = OSReadyQueueHead[BRTOS_EDF_PRIORITY];
+	  OSReadyQueueHead[BRTOS_EDF_PRIORITY] = TaskNumber;
+  }
 
+  if (Task->ReadyNext != 0)
+  {
+	  ContextTask[Task->ReadyNext].ReadyPrev = TaskNumber;
+  }
+  else
+  {
+	  OSReadyQueueTail[BRTOS_EDF_PRIORITY] = TaskNumber;
+  }
 
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-/////      Get the current tick count                  /////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-ostick_t OSGetCount(void)
-{
-  return OSTickCounter;
+  OSPrioSet(OSReadyList, BRTOS_EDF_PRIORITY);
 }
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
+#endif
 
+// Puts a task at the end of the ready list of its priority
+static void OSReadyQueueLink(ContextType *Task)
+{
+  uint8_t TaskNumber = (uint8_t)(Task - ContextTask);
+  uint8_t iPriority = Task->Priority;
 
+  #if (BRTOS_EDF_EN == 1)
+  if (iPriority == BRTOS_EDF_PRIORITY)
+  {
+	  OSEDFQueueLink(Task);
+	  return;
+  }
+  #endif
 
+  Task->ReadyNext = 0;
+  Task->ReadyPrev = OSReadyQueueTail[iPriority];
 
+  if (OSReadyQueueTail[iPriority])
+  {
+	  ContextTask[OSReadyQueueTail[iPriority]].ReadyNext = TaskNumber;
+  }
+  else
+  {
+	  OSReadyQueueHead[iPriority] = TaskNumber;
+	  OSPrioSet(OSReadyList, iPriority);
+  }
 
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-/////      Update the tick count                       /////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-#if (TICKLESS == 1)
-void OSIncCounter(ostick_t inc)
+  OSReadyQueueTail[iPriority] = TaskNumber;
+}
+
+// Removes a task from the ready list of its priority
+static void OSReadyQueueUnlink(ContextType *Task)
 {
-	if(inc !=1)
-	{
-		osdtick_t timeout = (osdtick_t)((osdtick_t)OSTickCounter + (osdtick_t)inc);
+  uint8_t iPriority = Task->Priority;
 
-        if (sizeof_ostick_t < 8){
-        	if (timeout >= TICK_COUNT_OVERFLOW)
-        	{
-        		OSTickCounter = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
-        	}
-        	else
-        	{
-        		OSTickCounter = (ostick_t)timeout;
-        	}
-        }else{
-        	OSTickCounter = (ostick_t)timeout;
-        }
-	} else
-	{
-		  OSTickCounter++;
-		  if (OSTickCounter == TICK_COUNT_OVERFLOW) OSTickCounter = 0;
-	}
+  if (Task->ReadyPrev)
+  {
+	  ContextTask[Task->ReadyPrev].ReadyNext = Task->ReadyNext;
+  }
+  else
+  {
+	  OSReadyQueueHead[iPriority] = Task->ReadyNext;
+  }
+
+  if (Task->ReadyNext)
+  {
+	  ContextTask[Task->ReadyNext].ReadyPrev = Task->ReadyPrev;
+  }
+  else
+  {
+	  OSReadyQueueTail[iPriority] = Task->ReadyPrev;
+  }
+
+  Task->ReadyNext = 0;
+  Task->ReadyPrev = 0;
+
+  if (OSReadyQueueHead[iPriority] == 0)
+  {
+	  OSPrioClear(OSReadyList, iPriority);
+  }
 }
-#else
 
-void OSIncCounter(void)
+void OSReadyListInsert(ContextType *Task)
 {
-	  OSTickCounter++;
-	  if (OSTickCounter == TICK_COUNT_OVERFLOW) OSTickCounter = 0;
+  if (!(Task->RunState & TASK_READY_FLAG))
+  {
+	  Task->RunState |= TASK_READY_FLAG;
+
+	  #if (BRTOS_TASK_STATS_EN == 1)
+	  OSTaskStatsReady(Task);
+	  #endif
+
+	  // A blocked task is only scheduled after being unblocked
+	  if (!(Task->RunState & TASK_BLOCKED_FLAG))
+	  {
+		  OSReadyQueueLink(Task);
+	  }
+  }
 }
-#endif
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////
 
+void OSReadyListRemove(ContextType *Task)
+{
+  if (Task->RunState & TASK_READY_FLAG)
+  {
+	  if (!(Task->RunState & TASK_BLOCKED_FLAG))
+	  {
+		  OSReadyQueueUnlink(Task);
+	  }
 
+	  Task->RunState &= (uint8_t)~TASK_READY_FLAG;
+  }
+}
 
+void OSBlockedListInsert(ContextType *Task)
+{
+  if (!(Task->RunState & TASK_BLOCKED_FLAG))
+  {
+	  if (Task->RunState & TASK_READY_FLAG)
+	  {
+		  OSReadyQueueUnlink(Task);
+	  }
 
+	  Task->RunState |= TASK_BLOCKED_FLAG;
+  }
+}
 
+void OSBlockedListRemove(ContextType *Task)
+{
+  if (Task->RunState & TASK_BLOCKED_FLAG)
+  {
+	  Task->RunState &= (uint8_t)~TASK_BLOCKED_FLAG;
+
+	  if (Task->RunState & TASK_READY_FLAG)
+	  {
+		  OSReadyQueueLink(Task);
+	  }
+  }
+}
+
+// The wait list of the events keeps the priorities of the waiting tasks.
+// The tasks of each priority are found by the event that they are waiting for.
+void OSEventWaitListInsert(PriorityType *WaitList, void *Event, ContextType *Task)
+{
+  Task->WaitEvent = Event;
+  Task->WaitList = WaitList;
+  Task->WaitOrder = OSWaitOrder++;
+  OSPrioSet(*WaitList, Task->Priority);
+}
+
+void OSEventWaitListRemove(PriorityType *WaitList, void *Event, ContextType *Task)
+{
+  uint8_t iTask = PriorityVector[Task->Priority];
+
+  Task->WaitEvent = NULL;
+
+  // Keeps the priority into the wait list if another task of the priority is waiting
+  do
+  {
+	  if (OSTaskWaitsFor(&ContextTask[iTask], Event))
+	  {
+		  return;
+	  }
+	  iTask = ContextTask[iTask].PrioNext;
+  }while(iTask != PriorityVector[Task->Priority]);
+
+  OSPrioClear(*WaitList, Task->Priority);
+}
+
+uint8_t OSEventWaitListSelect(PriorityType *WaitList, void *Event)
+{
+  uint8_t iPriority = OSPrioHighest(*WaitList);
+  uint8_t iTask = PriorityVector[iPriority];
+  uint8_t TaskSelect = 0;
+  uint8_t Waiting = 0;
+
+  // Selects the task of the priority that is waiting for more time
+  do
+  {
+	  if (OSTaskWaitsFor(&ContextTask[iTask], Event))
+	  {
+		  Waiting++;
+		  #if (BRTOS_EDF_EN == 1)
+		  // The EDF tasks are selected by the earliest deadline
+		  if ((iPriority == BRTOS_EDF_PRIORITY) && (TaskSelect != 0) &&
+			  (OSEDFKey((ContextType*)&ContextTask[iTask]) != OSEDFKey((ContextType*)&ContextTask[TaskSelect])))
+		  {
+			  if (OSEDFKey((ContextType*)&ContextTask[iTask]) < OSEDFKey((ContextType*)&ContextTask[TaskSelect]))
+			  {
+				  TaskSelect = iTask;
+			  }
+		  }
+		  else
+		  #endif
+		  if ((TaskSelect == 0) || ((int16_t)(uint16_t)(ContextTask[iTask].WaitOrder - ContextTask[TaskSelect].WaitOrder) < 0))
+		  {
+			  TaskSelect = iTask;
+		  }
+	  }
+	  iTask = ContextTask[iTask].PrioNext;
+  }while(iTask != PriorityVector[iPriority]);
+
+  ContextTask[TaskSelect].WaitEvent = NULL;
+
+  if (Waiting <= 1)
+  {
+	  OSPrioClear(*WaitList, iPriority);
+  }
+
+  #if (BRTOS_PEND_MULTIPLE_EN == 1)
+  if (ContextTask[TaskSelect].WaitMultiple != NULL)
+  {
+	  OSPendMultipleSelect((ContextType*)&ContextTask[TaskSelect], Event);
+  }
+  #endif
+
+  return TaskSelect;
+}
+
+#if (BRTOS_MUTEX_EN == 1)
+// Verifies if the priority is the priority ceiling of a mutex
+static uint8_t OSIsMutexPriority(uint8_t iPriority)
+{
+  uint8_t i = 0;
+
+  for(i=0;i<BRTOS_MAX_MUTEX;i++)
+  {
+	  if ((BRTOS_Mutex_Table[i].OSEventAllocated == TRUE) && (BRTOS_Mutex_Table[i].OSMaxPriority == iPriority))
+	  {
+		  return TRUE;
+	  }
+  }
+
+  return FALSE;
+}
+#else
+#define OSIsMutexPriority(iPriority) FALSE
+#endif
+
+#if (configTIME_SLICE_TICKS > 0)
+// Moves the current task to the end of its priority ready list when its time slice expires
+static void OSTimeSliceTick(void)
+{
+  #if (NESTING_INT == 1)
+  OS_SR_SAVE_VAR
+  #endif
+  ContextType *Task;
+
+  #if (NESTING_INT == 1)
+  OSEnterCritical();
+  #endif
+
+  if (currentTask != OSSliceTask)
+  {
+	  // Starts the time slice of the task
+	  OSSliceTask = currentTask;
+	  OSSliceTicks = 0;
+  }
+
+  Task = (ContextType*)&ContextTask[currentTask];
+
+  // Only if there is another ready task with the same priority
+  if ((Task->RunState == TASK_READY_FLAG) && (OSReadyQueueHead[Task->Priority] == currentTask) && (Task->ReadyNext != 0))
+  {
+	  OSSliceTicks++;
+
+	  if (OSSliceTicks >= configTIME_SLICE_TICKS)
+	  {
+		  OSSliceTicks = 0;
+		  Task->Slices++;
+
+		  OSReadyQueueUnlink(Task);
+		  OSReadyQueueLink(Task);
+
+		  #if ((PROCESSOR == ARM_Cortex_M0) || (PROCESSOR == ARM_Cortex_M3) || (PROCESSOR == ARM_Cortex_M4) || (PROCESSOR == ARM_Cortex_M4F))
+		  OS_INT_EXIT_EXT();
+		  #endif
+	  }
+  }
+
+  #if (NESTING_INT == 1)
+  OSExitCritical();
+  #endif
+}
+#endif
+#else
+uint8_t OSEventWaitListSelect(PriorityType *WaitList, void *Event)
+{
+  uint8_t iPriority = OSPrioHighest(*WaitList);
+
+  OSPrioClear(*WaitList, iPriority);
+
+  #if (BRTOS_PEND_MULTIPLE_EN == 1)
+  if (ContextTask[PriorityVector[iPriority]].WaitMultiple != NULL)
+  {
+	  OSPendMultipleSelect((ContextType*)&ContextTask[PriorityVector[iPriority]], Event);
+  }
+  #else
+  (void)Event;
+  #endif
+
+  return PriorityVector[iPriority];
+}
+#endif
+
+void OSSetTaskPriority(uint8_t TaskNumber, uint8_t iPriority)
+{
+  ContextType *Task = (ContextType*)&ContextTask[TaskNumber];
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+  uint8_t Linked = (uint8_t)(Task->RunState == TASK_READY_FLAG);
+  void *Event = Task->WaitEvent;
+  uint16_t WaitOrder = Task->WaitOrder;
+  #if (BRTOS_PEND_MULTIPLE_EN == 1)
+  OS_PEND_EVENT *Events = Task->WaitMultiple;
+  uint8_t Count = Task->WaitMultipleCount;
+  #endif
+
+  if (Linked)
+  {
+	  OSReadyQueueUnlink(Task);
+  }
+
+  // A waiting task leaves the wait list with the old priority
+  if (Event != NULL)
+  {
+	  OSEventWaitListRemove(Task->WaitList, Event, Task);
+  }
+
+  #if (BRTOS_PEND_MULTIPLE_EN == 1)
+  if (Events != NULL)
+  {
+	  OSPendMultipleSelect(Task, NULL);
+  }
+  #endif
+
+  OSPriorityListRemove(TaskNumber);
+  Task->Priority = iPriority;
+  OSPriorityListInsert(TaskNumber);
+
+  // and keeps waiting with the new priority, in the same wait order
+  if (Event != NULL)
+  {
+	  OSEventWaitListInsert(Task->WaitList, Event, Task);
+  }
+
+  #if (BRTOS_PEND_MULTIPLE_EN == 1)
+  if (Events != NULL)
+  {
+	  OSPendMultipleInsert(Task, Events, Count);
+  }
+  #endif
+
+  Task->WaitOrder = WaitOrder;
+
+  if (Linked)
+  {
+	  OSReadyQueueLink(Task);
+  }
+#else
+  if (OSPrioIsSet(OSReadyList, Task->Priority))
+  {
+	  OSPrioClear(OSReadyList, Task->Priority);
+	  OSPrioSet(OSReadyList, iPriority);
+  }
+
+  Task->Priority = iPriority;
+  PriorityVector[iPriority] = TaskNumber;
+#endif
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Get the current task handle                 /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+BRTOS_TH OSGetCurrentTaskHandle(void)
+{
+	OS_SR_SAVE_VAR
+	BRTOS_TH task_handle;
+
+  	OSEnterCritical();
+	task_handle = (BRTOS_TH)currentTask;
+  	OSExitCritical();
+	return task_handle;
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Get task priority               			   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+OS_CPU_TYPE OSGetTaskPriority(BRTOS_TH task_handle)
+{
+	OS_SR_SAVE_VAR
+	OS_CPU_TYPE task_prio;
+
+  	OSEnterCritical();
+	task_prio = (OS_CPU_TYPE)ContextTask[task_handle].Priority;
+  	OSExitCritical();
+	return task_prio;
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Get the current tick count                  /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+ostick_t OSGetTickCount(void)
+{
+  OS_SR_SAVE_VAR
+  ostick_t cnt;
+  
+  OSEnterCritical();
+  cnt = OSTickCounter;
+  OSExitCritical();
+  return cnt;
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Get the current tick count                  /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+ostick_t OSGetCount(void)
+{
+  return OSTickCounter;
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+#if (BRTOS_TICK64_EN == 1)
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Get the 64 bit tick count                   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Must be called inside a critical section
+static uint64_t OSTickCount64(void)
+{
+  return ((uint64_t)OSTickEpoch * (uint64_t)TICK_COUNT_OVERFLOW) + (uint64_t)OSTickCounter;
+}
+
+uint64_t OSGetTickCount64(void)
+{
+  OS_SR_SAVE_VAR
+  uint64_t cnt;
+
+  OSEnterCritical();
+  cnt = OSTickCount64();
+  OSExitCritical();
+  return cnt;
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+#endif
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Update the tick count                       /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+#if (TICKLESS == 1)
+void OSIncCounter(ostick_t inc)
+{
+	if(inc !=1)
+	{
+		osdtick_t timeout = (osdtick_t)((osdtick_t)OSTickCounter + (osdtick_t)inc);
+
+        if (sizeof_ostick_t < 8){
+        	if (timeout >= TICK_COUNT_OVERFLOW)
+        	{
+        		OSTickCounter = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+        		#if (BRTOS_TICK64_EN == 1)
+        		OSTickEpoch++;
+        		#endif
+        	}
+        	else
+        	{
+        		OSTickCounter = (ostick_t)timeout;
+        	}
+        }else{
+        	OSTickCounter = (ostick_t)timeout;
+        }
+	} else
+	{
+		  OSTickCounter++;
+		  if (OSTickCounter == TICK_COUNT_OVERFLOW)
+		  {
+			  OSTickCounter = 0;
+			  #if (BRTOS_TICK64_EN == 1)
+			  OSTickEpoch++;
+			  #endif
+		  }
+	}
+}
+#else
+
+void OSIncCounter(void)
+{
+	  OSTickCounter++;
+	  if (OSTickCounter == TICK_COUNT_OVERFLOW)
+	  {
+		  OSTickCounter = 0;
+		  #if (BRTOS_TICK64_EN == 1)
+		  OSTickEpoch++;
+		  #endif
+	  }
+}
+#endif
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Task Delay Function in Tick Times           /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Tick count "inc" ticks after the tick count "tick", considering the tick counter overflow
+static ostick_t OSTickAdd(ostick_t tick, ostick_t inc)
+{
+  osdtick_t timeout = (osdtick_t)((osdtick_t)tick + (osdtick_t)inc);
+
+  if (sizeof_ostick_t < 8){
+	  if (timeout >= TICK_COUNT_OVERFLOW)
+	  {
+		  return (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+	  }
+  }
+
+  return (ostick_t)timeout;
+}
+
+
+// Number of ticks from the tick count "from" until the tick count "to", considering the tick counter overflow
+static ostick_t OSTickElapsed(ostick_t from, ostick_t to)
+{
+  if (to >= from)
+  {
+	  return (ostick_t)(to - from);
+  }
+  else
+  {
+	  return (ostick_t)(to + (TICK_COUNT_OVERFLOW - from));
+  }
+}
+
+
+// Suspends the current task until the tick count "wake"
+// Must be called inside a critical section, returns inside the critical section
+static void OSDelayTaskUntil(ContextType *Task, ostick_t wake)
+{
+  Task->TimeToWait = wake;
+
+  // Put task into delay list
+  IncludeTaskIntoDelayList();
+
+  #if (VERBOSE == 1)
+  Task->State = SUSPENDED;
+  Task->SuspendedType = DELAY;
+  #endif
+
+  OSReadyListRemove(Task);
+
+  // Change context
+  // Return to task when occur delay overflow
+  ChangeContext();
+}
+
+
+// Atraso em passos de TickCount
+uint8_t OSDelayTask(ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task = (ContextType*)&ContextTask[currentTask];
+   
+  if (iNesting > 0) {                                // See if caller is an interrupt
+     return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
+  }
+
+  if (currentTask)
+  {
+    
+    if (time_wait > 0)
+    {
+        OSEnterCritical();
+        
+        // BRTOS TRACE SUPPORT
+        OS_TRACE(OS_TRACE_DELAY, time_wait, 0);
+
+        OSDelayTaskUntil(Task, OSTickAdd(OSTickCounter, time_wait));
+        
+        OSExitCritical();
+        
+        return OK;
+    }
+    else
+    {
+        return NO_TASK_DELAY;
+    }
+  }
+  else
+  {
+    return NOT_VALID_TASK;
+  }
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Task Delay Until an Absolute Tick Count     /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Periodic delay - the wake up time is computed from the last wake up time,
+// not from the time of the call, so the period does not drift
+uint8_t OSDelayUntil(ostick_t *last_wake, ostick_t period)
+{
+  OS_SR_SAVE_VAR
+  ostick_t elapsed, missed;
+  ContextType *Task = (ContextType*)&ContextTask[currentTask];
+
+  if (iNesting > 0) {                                // See if caller is an interrupt
+     return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
+  }
+
+  if (!currentTask)
+  {
+    return NOT_VALID_TASK;
+  }
+
+  if (period == 0)
+  {
+    return NO_TASK_DELAY;
+  }
+
+  if (period >= TICK_COUNT_OVERFLOW)
+  {
+    return INVALID_TIME;
+  }
+
+  OSEnterCritical();
+
+  // Ticks since the last wake up time
+  elapsed = OSTickElapsed(*last_wake, OSTickCounter);
+
+  if (elapsed >= period)
+  {
+    // Overrun - the task does not wait and the missed periods are skipped,
+    // keeping the phase of the next wake up times
+    missed = (ostick_t)(elapsed / period);
+    *last_wake = OSTickAdd(*last_wake, (ostick_t)(missed * period));
+
+    #if (BRTOS_TASK_STATS_EN == 1)
+    OSTaskStats[currentTask].overruns += (uint32_t)missed;
+    #endif
+
+    OSExitCritical();
+    return DELAY_OVERRUN;
+  }
+
+  *last_wake = OSTickAdd(*last_wake, period);
+
+  // BRTOS TRACE SUPPORT
+  OS_TRACE(OS_TRACE_DELAY, (ostick_t)(period - elapsed), 0);
+
+  OSDelayTaskUntil(Task, *last_wake);
+
+  OSExitCritical();
+
+  return OK;
+}
+
+
+#if (BRTOS_TICK64_EN == 1)
+// Longest part of a 64 bit delay - the wake up time must be in the range of the delay list
+#define OS_DELAY64_MAX      (ostick_t)(TICK_COUNT_OVERFLOW / 2)
+
+uint8_t OSDelayUntil64(uint64_t *last_wake, uint64_t period)
+{
+  OS_SR_SAVE_VAR
+  uint64_t now, wake, missed;
+  ostick_t ticks;
+  ContextType *Task = (ContextType*)&ContextTask[currentTask];
+
+  if (iNesting > 0) {                                // See if caller is an interrupt
+     return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
+  }
+
+  if (!currentTask)
+  {
+    return NOT_VALID_TASK;
+  }
+
+  if (period == 0)
+  {
+    return NO_TASK_DELAY;
+  }
+
+  OSEnterCritical();
+
+  now = OSTickCount64();
+  wake = *last_wake + period;
+
+  if (wake <= now)
+  {
+    // Overrun - the task does not wait and the missed periods are skipped
+    missed = (now - *last_wake) / period;
+    *last_wake += missed * period;
+
+    #if (BRTOS_TASK_STATS_EN == 1)
+    OSTaskStats[currentTask].overruns += (uint32_t)missed;
+    #endif
+
+    OSExitCritical();
+    return DELAY_OVERRUN;
+  }
+
+  *last_wake = wake;
+
+  // Each part is computed from the absolute wake up time
+  do
+  {
+    if ((wake - now) > (uint64_t)OS_DELAY64_MAX)
+    {
+      ticks = OS_DELAY64_MAX;
+    }
+    else
+    {
+      ticks = (ostick_t)(wake - now);
+    }
+
+    // BRTOS TRACE SUPPORT
+    OS_TRACE(OS_TRACE_DELAY, ticks, 0);
+
+    OSDelayTaskUntil(Task, OSTickAdd(OSTickCounter, ticks));
+    now = OSTickCount64();
+  }while(now < wake);
+
+  OSExitCritical();
+
+  return OK;
+}
+#endif
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+#if (BRTOS_EDF_EN == 1)
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Earliest Deadline First Scheduling          /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Utilization of an EDF task in hundredths of percent, rounded up
+// The deadline is not greater than the period, so wcet / deadline is the density of the task
+static uint32_t OSEDFDensity(ostick_t wcet, ostick_t deadline)
+{
+  return (uint32_t)((((osdtick_t)wcet * 10000) + (osdtick_t)deadline - 1) / (osdtick_t)deadline);
+}
+
+// Utilization of the EDF tasks, except the task "skip"
+static uint32_t OSEDFTotalDensity(BRTOS_TH skip)
+{
+  uint32_t utilization = 0;
+  uint16_t i;
+
+  for(i = 1; i <= NUMBER_OF_TASKS; i++)
+  {
+	  if ((i != skip) && (ContextTask[i].EDFPeriod != 0))
+	  {
+		  utilization += OSEDFDensity(ContextTask[i].EDFWcet, ContextTask[i].EDFDeadline);
+	  }
+  }
+
+  return utilization;
+}
+
+uint8_t OSEDFTaskSet(BRTOS_TH task, ostick_t period, ostick_t deadline, ostick_t wcet)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+
+  if ((task == 0) || (task > NUMBER_OF_TASKS))
+  {
+    return NOT_VALID_TASK;
+  }
+
+  // The deadlines of the ready tasks must be in half of the tick counter range
+  if ((period == 0) || (period >= (ostick_t)(TICK_COUNT_OVERFLOW / 2)) ||
+      (deadline == 0) || (deadline > period) || (wcet == 0) || (wcet > deadline))
+  {
+    return INVALID_PARAMETERS;
+  }
+
+  Task = (ContextType*)&ContextTask[task];
+
+  if (currentTask)
+    OSEnterCritical();
+
+  if (Task->Priority == EMPTY_PRIO)
+  {
+    if (currentTask)
+      OSExitCritical();
+    return NOT_VALID_TASK;
+  }
+
+  if (Task->Priority != BRTOS_EDF_PRIORITY)
+  {
+    if (currentTask)
+      OSExitCritical();
+    return INVALID_PARAMETERS;
+  }
+
+  // Admission control
+  if ((OSEDFTotalDensity(task) + OSEDFDensity(wcet, deadline)) > ((uint32_t)BRTOS_EDF_MAX_UTILIZATION * 100))
+  {
+    if (currentTask)
+      OSExitCritical();
+    return EDF_NOT_ADMITTED;
+  }
+
+  Task->EDFPeriod = period;
+  Task->EDFDeadline = deadline;
+  Task->EDFWcet = wcet;
+  Task->EDFJobs = 0;
+  Task->EDFMisses = 0;
+
+  // The first job is released now
+  Task->EDFRelease = OSTickCounter;
+  Task->EDFAbsDeadline = OSTickAdd(OSTickCounter, deadline);
+
+  // The position of a ready task depends on its deadline
+  if (Task->RunState == TASK_READY_FLAG)
+  {
+    OSReadyQueueUnlink(Task);
+    OSReadyQueueLink(Task);
+  }
+
+  if (currentTask)
+    OSExitCritical();
+
+  return OK;
+}
+
+
+uint8_t OSEDFWaitNextPeriod(void)
+{
+  OS_SR_SAVE_VAR
+  ostick_t elapsed, released;
+  uint8_t status = OK;
+  ContextType *Task = (ContextType*)&ContextTask[currentTask];
+
+  if (iNesting > 0) {                                // See if caller is an interrupt
+     return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
+  }
+
+  if ((!currentTask) || (Task->EDFPeriod == 0))
+  {
+    return NOT_VALID_TASK;
+  }
+
+  OSEnterCritical();
+
+  Task->EDFJobs++;
+
+  // Ticks since the release of the job
+  elapsed = OSTickElapsed(Task->EDFRelease, OSTickCounter);
+
+  if (elapsed > Task->EDFDeadline)
+  {
+    Task->EDFMisses++;
+    status = DEADLINE_MISSED;
+  }
+
+  if (elapsed < Task->EDFPeriod)
+  {
+    // Waits for the next release - the deadline is the order of the task in the ready list
+    Task->EDFRelease = OSTickAdd(Task->EDFRelease, Task->EDFPeriod);
+    Task->EDFAbsDeadline = OSTickAdd(Task->EDFRelease, Task->EDFDeadline);
+
+    OS_TRACE(OS_TRACE_DELAY, (ostick_t)(Task->EDFPeriod - elapsed), 0);
+
+    OSDelayTaskUntil(Task, Task->EDFRelease);
+  }
+  else
+  {
+    // The next releases were reached while the job was running: the job of the
+    // last one runs now and the others are missed
+    released = (ostick_t)(elapsed / Task->EDFPeriod);
+    if (released > 1)
+    {
+      Task->EDFMisses += (uint32_t)(released - 1);
+      status = DEADLINE_MISSED;
+    }
+
+    Task->EDFRelease = OSTickAdd(Task->EDFRelease, (ostick_t)(released * Task->EDFPeriod));
+    Task->EDFAbsDeadline = OSTickAdd(Task->EDFRelease, Task->EDFDeadline);
+
+    // New deadline - another EDF task may have an earlier one
+    OSReadyQueueUnlink(Task);
+    OSReadyQueueLink(Task);
+    ChangeContext();
+  }
+
+  OSExitCritical();
+
+  return status;
+}
+
+
+uint8_t OSEDFGetStats(BRTOS_TH task, OS_EDF_STATS *stats)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+
+  if ((task == 0) || (task > NUMBER_OF_TASKS) || (stats == NULL))
+  {
+    return NOT_VALID_TASK;
+  }
+
+  Task = (ContextType*)&ContextTask[task];
+
+  if (currentTask)
+    OSEnterCritical();
+
+  if (Task->EDFPeriod == 0)
+  {
+    if (currentTask)
+      OSExitCritical();
+    return NOT_VALID_TASK;
+  }
+
+  stats->period = Task->EDFPeriod;
+  stats->deadline = Task->EDFDeadline;
+  stats->wcet = Task->EDFWcet;
+  stats->abs_deadline = Task->EDFAbsDeadline;
+  stats->jobs = Task->EDFJobs;
+  stats->misses = Task->EDFMisses;
+
+  if (currentTask)
+    OSExitCritical();
+
+  return OK;
+}
+
+
+uint16_t OSEDFUtilization(void)
+{
+  OS_SR_SAVE_VAR
+  uint32_t utilization;
+
+  if (currentTask)
+    OSEnterCritical();
+
+  utilization = OSEDFTotalDensity(0);
+
+  if (currentTask)
+    OSExitCritical();
+
+  return (uint16_t)utilization;
+}
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
-/////      Task Delay Function in Tick Times           /////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
+#endif
 
-// Atraso em passos de TickCount
-uint8_t OSDelayTask(ostick_t time_wait)
+
+
+
+
+#if (BRTOS_BUDGET_EN == 1)
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Task CPU Budget Functions                   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Enforcement states of the budget
+#define OS_BUDGET_AVAILABLE     (uint8_t)0    ///< The task runs with its priority
+#define OS_BUDGET_BLOCKED       (uint8_t)1    ///< Budget exhausted - the task is blocked
+#define OS_BUDGET_DEMOTED       (uint8_t)2    ///< Budget exhausted - the task runs with BudgetPriority
+#define OS_BUDGET_PENDING       (uint8_t)4    ///< Budget replenished - the demoted task owns a mutex
+
+static ostick_t OSBudgetCheckTick = 0;        ///< Tick count of the last replenishment check
+static ostick_t OSBudgetWait = 0;             ///< Ticks from OSBudgetCheckTick to the next replenishment - 0 without budgets
+
+#if (BRTOS_MUTEX_EN == 1)
+// Verifies if the task owns a mutex - the priority of a mutex owner is not changed by its budget
+static uint8_t OSTaskOwnsMutex(uint8_t TaskNumber)
+{
+  uint8_t i = 0;
+
+  for(i=0;i<BRTOS_MAX_MUTEX;i++)
+  {
+	  if ((BRTOS_Mutex_Table[i].OSEventAllocated == TRUE) && (BRTOS_Mutex_Table[i].OSEventState == BUSY_RESOURCE) &&
+		  (BRTOS_Mutex_Table[i].OSEventOwner == TaskNumber))
+	  {
+		  return TRUE;
+	  }
+  }
+
+  return FALSE;
+}
+#else
+#define OSTaskOwnsMutex(TaskNumber) FALSE
+#endif
+
+// Runtime of the task, including the running time of the current task since the last switch
+static uint32_t OSBudgetRuntime(uint8_t TaskNumber)
+{
+  uint32_t runtime = ContextTask[TaskNumber].Runtime;
+
+  if (TaskNumber == currentTask)
+  {
+	  runtime += OSGetTimerForRuntimeStats() - OSTimeTaskSwitched;
+  }
+
+  return runtime;
+}
+
+// Blocks or demotes a task that exhausted its budget
+static void OSBudgetExhaust(uint8_t TaskNumber)
+{
+  ContextType *Task = (ContextType*)&ContextTask[TaskNumber];
+
+  Task->BudgetOverruns++;
+  Task->BudgetBase = Task->Priority;
+
+  if (Task->BudgetPriority == 0)
+  {
+	  #if (VERBOSE == 1)
+	  Task->Blocked = TRUE;
+	  #endif
+	  OSBlockedListInsert(Task);
+	  Task->BudgetState = OS_BUDGET_BLOCKED;
+  }
+  else
+  {
+	  OSSetTaskPriority(TaskNumber, Task->BudgetPriority);
+	  Task->BudgetState = OS_BUDGET_DEMOTED;
+  }
+}
+
+// Gives back the priority of a task blocked or demoted by its budget
+// A demoted task that owns a mutex keeps the priority given by the mutex until its release
+// Returns TRUE if the task was made ready or its priority was changed
+static uint8_t OSBudgetRestore(uint8_t TaskNumber)
+{
+  ContextType *Task = (ContextType*)&ContextTask[TaskNumber];
+
+  if (Task->BudgetState & OS_BUDGET_BLOCKED)
+  {
+	  #if (VERBOSE == 1)
+	  Task->Blocked = FALSE;
+	  #endif
+	  OSBlockedListRemove(Task);
+	  Task->BudgetState = OS_BUDGET_AVAILABLE;
+	  return TRUE;
+  }
+  else if (Task->BudgetState & OS_BUDGET_DEMOTED)
+  {
+	  if (OSTaskOwnsMutex(TaskNumber))
+	  {
+		  Task->BudgetState |= OS_BUDGET_PENDING;
+	  }
+	  else
+	  {
+		  OSSetTaskPriority(TaskNumber, Task->BudgetBase);
+		  Task->BudgetState = OS_BUDGET_AVAILABLE;
+		  return TRUE;
+	  }
+  }
+
+  return FALSE;
+}
+
+// Replenishes the budgets of the periods that ended and finds the next replenishment
+// Must be called inside a critical section
+// Returns TRUE if a task was made ready or its priority was changed
+static uint8_t OSBudgetReplenish(void)
+{
+  ContextType *Task;
+  ostick_t elapsed, wait;
+  ostick_t next = 0;
+  uint16_t i;
+  uint8_t changed = FALSE;
+
+  for(i = 1; i <= NUMBER_OF_TASKS; i++)
+  {
+	  Task = (ContextType*)&ContextTask[i];
+
+	  if (Task->Budget != 0)
+	  {
+		  elapsed = OSTickElapsed(Task->BudgetRelease, OSTickCounter);
+
+		  if (elapsed >= Task->BudgetPeriod)
+		  {
+			  // The periods suppressed by a tickless idle are replenished once
+			  Task->BudgetRelease = OSTickAdd(Task->BudgetRelease, (ostick_t)((elapsed / Task->BudgetPeriod) * Task->BudgetPeriod));
+			  Task->BudgetStart = OSBudgetRuntime((uint8_t)i);
+			  elapsed = (ostick_t)(elapsed % Task->BudgetPeriod);
+
+			  changed |= OSBudgetRestore((uint8_t)i);
+		  }
+
+		  wait = (ostick_t)(Task->BudgetPeriod - elapsed);
+		  if ((next == 0) || (wait < next))
+		  {
+			  next = wait;
+		  }
+	  }
+
+	  // Demoted tasks that waited for the release of a mutex
+	  if (Task->BudgetState & OS_BUDGET_PENDING)
+	  {
+		  changed |= OSBudgetRestore((uint8_t)i);
+	  }
+  }
+
+  OSBudgetCheckTick = OSTickCounter;
+  OSBudgetWait = next;
+
+  return changed;
+}
+
+// Verifies the budget of the current task at each tick
+static void OSBudgetTick(void)
 {
+  #if (NESTING_INT == 1)
   OS_SR_SAVE_VAR
-  osdtick_t timeout;
+  #endif
   ContextType *Task = (ContextType*)&ContextTask[currentTask];
-   
-  if (iNesting > 0) {                                // See if caller is an interrupt
-     return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
+  uint8_t changed = FALSE;
+
+  #if (NESTING_INT == 1)
+  OSEnterCritical();
+  #endif
+
+  if ((OSBudgetWait != 0) && (OSTickElapsed(OSBudgetCheckTick, OSTickCounter) >= OSBudgetWait))
+  {
+	  changed = OSBudgetReplenish();
+  }
+
+  if (Task->BudgetState & OS_BUDGET_PENDING)
+  {
+	  changed |= OSBudgetRestore(currentTask);
+  }
+  else if ((Task->Budget != 0) && (Task->BudgetState == OS_BUDGET_AVAILABLE) &&
+		   ((uint32_t)(OSBudgetRuntime(currentTask) - Task->BudgetStart) >= Task->Budget) &&
+		   !OSTaskOwnsMutex(currentTask))
+  {
+	  OSBudgetExhaust(currentTask);
+	  BRTOS_BudgetOverrunHook((BRTOS_TH)currentTask);
+	  changed = TRUE;
+  }
+
+  #if ((PROCESSOR == ARM_Cortex_M0) || (PROCESSOR == ARM_Cortex_M3) || (PROCESSOR == ARM_Cortex_M4) || (PROCESSOR == ARM_Cortex_M4F))
+  // The switch context is requested only if a task state was changed
+  if (changed)
+  {
+	  OS_INT_EXIT_EXT();
+  }
+  #else
+  (void)changed;
+  #endif
+
+  #if (NESTING_INT == 1)
+  OSExitCritical();
+  #endif
+}
+
+
+uint8_t OSTaskBudgetSet(BRTOS_TH task, uint32_t budget, ostick_t period, uint8_t priority)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  uint8_t base;
+  #endif
+
+  if ((task == 0) || (task > NUMBER_OF_TASKS))
+  {
+    return NOT_VALID_TASK;
+  }
+
+  // The replenishments must be in half of the tick counter range
+  if ((budget != 0) && ((period == 0) || (period >= (ostick_t)(TICK_COUNT_OVERFLOW / 2))))
+  {
+    return INVALID_PARAMETERS;
+  }
+
+  #if (BRTOS_ROUND_ROBIN_EN == 0)
+  // Only one task per priority
+  if (priority != 0)
+  {
+    return INVALID_PARAMETERS;
   }
+  #endif
+
+  Task = (ContextType*)&ContextTask[task];
 
   if (currentTask)
+    OSEnterCritical();
+
+  if ((Task->Priority == EMPTY_PRIO) || (Task->Priority == 0))
   {
-    
-    if (time_wait > 0)
-    {
-        OSEnterCritical();
-        
-        // BRTOS TRACE SUPPORT
-        #if (OSTRACE == 1) 
-            #if(OS_TRACE_BY_TASK == 1)
-            Update_OSTrace(currentTask, DELAYTASK);
-            #else
-            Update_OSTrace(Task->Priority, DELAYTASK);
-            #endif
-        #endif    
-
-        timeout = (osdtick_t)((osdtick_t)OSTickCounter + (osdtick_t)time_wait);
-        
-        if (sizeof_ostick_t < 8){
-        	if (timeout >= TICK_COUNT_OVERFLOW)
-        	{
-        		Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
-        	}
-        	else
-        	{
-        		Task->TimeToWait = (ostick_t)timeout;
-        	}
-        }else{
-        	Task->TimeToWait = (ostick_t)timeout;
-        }
-        
-        // Put task into delay list
-        IncludeTaskIntoDelayList();
-        
-        #if (VERBOSE == 1)
-        Task->State = SUSPENDED;
-        Task->SuspendedType = DELAY;
-        #endif
-        
-        OSReadyList = OSReadyList & ~(PriorityMask[Task->Priority]);
-        
-        // Change context
-        // Return to task when occur delay overflow
-        ChangeContext();
-        
-        OSExitCritical();
-        
-        return OK;
-    }
-    else
+    if (currentTask)
+      OSExitCritical();
+    return NOT_VALID_TASK;
+  }
+
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  // Priority of the task without the demotion
+  base = (Task->BudgetState & OS_BUDGET_DEMOTED) ? Task->BudgetBase : Task->Priority;
+
+  if ((budget != 0) && (priority != 0) && ((priority >= base) || (PriorityVector[priority] == MUTEX_PRIO)))
+  {
+    if (currentTask)
+      OSExitCritical();
+    return INVALID_PARAMETERS;
+  }
+  #endif
+
+  // The new budget starts with the priority of the task
+  (void)OSBudgetRestore((uint8_t)task);
+
+  Task->Budget = budget;
+  Task->BudgetPeriod = period;
+  Task->BudgetPriority = priority;
+  Task->BudgetOverruns = 0;
+  Task->BudgetRelease = OSTickCounter;
+  Task->BudgetStart = OSBudgetRuntime((uint8_t)task);
+
+  (void)OSBudgetReplenish();
+
+  if (currentTask)
+  {
+    if (!iNesting)
     {
-        return NO_TASK_DELAY;
+      ChangeContext();
     }
+    OSExitCritical();
   }
-  else
+
+  return OK;
+}
+
+
+uint8_t OSTaskBudgetGetStats(BRTOS_TH task, OS_BUDGET_STATS *stats)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+
+  if ((task == 0) || (task > NUMBER_OF_TASKS) || (stats == NULL))
+  {
+    return NOT_VALID_TASK;
+  }
+
+  Task = (ContextType*)&ContextTask[task];
+
+  if (currentTask)
+    OSEnterCritical();
+
+  if (Task->Budget == 0)
   {
+    if (currentTask)
+      OSExitCritical();
     return NOT_VALID_TASK;
   }
+
+  stats->budget = Task->Budget;
+  stats->period = Task->BudgetPeriod;
+  stats->used = (uint32_t)(OSBudgetRuntime((uint8_t)task) - Task->BudgetStart);
+  stats->overruns = Task->BudgetOverruns;
+  stats->exhausted = (uint8_t)(Task->BudgetState != OS_BUDGET_AVAILABLE);
+
+  if (currentTask)
+    OSExitCritical();
+
+  return OK;
 }
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
+#endif
 
 
 
@@ -509,7 +1981,12 @@ uint8_t OSDelayTask(ostick_t time_wait)
 uint8_t OSDelayTaskHMSM(uint8_t hours, uint8_t minutes, uint8_t seconds, uint16_t miliseconds)
 {
   uint32_t ticks=0;
+  #if (BRTOS_TICK64_EN == 1)
+  uint64_t last_wake;
+  #else
   uint32_t loops=0;
+  ostick_t last_wake;
+  #endif
   
   if (minutes > 59)
     return INVALID_TIME;
@@ -525,19 +2002,29 @@ uint8_t OSDelayTaskHMSM(uint8_t hours, uint8_t minutes, uint8_t seconds, uint16_
         + (uint32_t)seconds *         configTICK_RATE_HZ
         + ((uint32_t)miliseconds    * configTICK_RATE_HZ)/1000L;
   
-  // Task Delay limit = TickCounterOverflow
+  // The wake up time is absolute, so the parts of a long delay do not accumulate errors
   if (ticks > 0)
   {
+      #if (BRTOS_TICK64_EN == 1)
+      last_wake = OSGetTickCount64();
+      (void)OSDelayUntil64(&last_wake, (uint64_t)ticks);
+      #else
+      // Task Delay limit = TickCounterOverflow
       loops = ticks / 60000L;
       ticks = ticks % 60000L;
       
-      (void)DelayTask((uint16_t)ticks);
+      last_wake = OSGetTickCount();
+      if (ticks > 0)
+      {
+        (void)OSDelayUntil(&last_wake, (ostick_t)ticks);
+      }
       
       while(loops > 0)
       {
-        (void)DelayTask(60000);
+        (void)OSDelayUntil(&last_wake, 60000);
         loops--;
       }
+      #endif
       return OK;
   }
   else
@@ -554,6 +2041,74 @@ uint8_t OSDelayTaskHMSM(uint8_t hours, uint8_t minutes, uint8_t seconds, uint16_
 
 
 
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Delay List Functions                        /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Number of ticks from the tick count "from" until the tick count "to"
+// Considers the tick counter overflow. If "to" is equal to "from", a full counter period is returned
+static ostick_t OSTickDistance(ostick_t from, ostick_t to)
+{
+  if (to > from)
+  {
+	  return (ostick_t)(to - from);
+  }
+  else
+  {
+	  return (ostick_t)(to + (TICK_COUNT_OVERFLOW - from));
+  }
+}
+
+
+// Include the task into the delay list, sorted by the wake up time
+// Tasks with the same wake up time are kept in FIFO order
+// Must be called inside a critical section
+void OSDelayListInsert(ContextType *Task)
+{
+  ContextType *Prev = Tail;
+  ostick_t time_to_wake = OSTickDistance(OSDelayListTick, Task->TimeToWait);
+
+  // Most of the new delays are longer than the ones already in the list,
+  // so the search starts from the tail of the list
+  while((Prev != NULL) && (OSTickDistance(OSDelayListTick, Prev->TimeToWait) > time_to_wake))
+  {
+	  Prev = Prev->Previous;
+  }
+
+  Task->Previous = Prev;
+
+  if (Prev == NULL)
+  {
+	  // Insert task at the head of the list
+	  Task->Next = Head;
+	  Head = Task;
+  }
+  else
+  {
+	  Task->Next = Prev->Next;
+	  Prev->Next = Task;
+  }
+
+  if (Task->Next == NULL)
+  {
+	  Tail = Task;
+  }
+  else
+  {
+	  Task->Next->Previous = Task;
+  }
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 /////      OS Tick Timer Function                      /////
@@ -563,47 +2118,67 @@ uint8_t OSDelayTaskHMSM(uint8_t hours, uint8_t minutes, uint8_t seconds, uint16_
 void OS_TICK_HANDLER(void)
 {
   OS_SR_SAVE_VAR
-  uint8_t  iPrio = 0;  
-  ContextType *Task = Head;  
-   
+  ostick_t elapsed;
+  ContextType *Task;
+
   ////////////////////////////////////////////////////
   // Put task with delay overflow in the ready list //
-  ////////////////////////////////////////////////////  
-  while(Task != NULL)
-  {      
-      if (Task->TimeToWait == OSTickCounter)
-      {
+  // The delay list is sorted by the wake up time,  //
+  // so only the head of the list must be verified  //
+  ////////////////////////////////////////////////////
+  if (OSTickCounter != OSDelayListTick)
+  {
+	  elapsed = OSTickDistance(OSDelayListTick, OSTickCounter);
 
-        iPrio = Task->Priority;
-        
-        #if (NESTING_INT == 1)
-        OSEnterCritical();
-        #endif        
+	  while((Head != NULL) && (OSTickDistance(OSDelayListTick, Head->TimeToWait) <= elapsed))
+	  {
+		Task = Head;
 
-        // Put the task into the ready list
-        OSReadyList = OSReadyList | (PriorityMask[iPrio]);
-        
-        #if (VERBOSE == 1)
-            Task->State = READY;        
-        #endif
-        
-        Task->TimeToWait = EXIT_BY_TIMEOUT;
-        
-        #if (NESTING_INT == 1)
-        OSExitCritical();
-        #endif                  
-          
-        // Remove from delay list
-        RemoveFromDelayList();
+		#if (NESTING_INT == 1)
+		OSEnterCritical();
+		#endif
+
+		// Put the task into the ready list
+		OSReadyListInsert(Task);
+
+		#if (VERBOSE == 1)
+			Task->State = READY;
+		#endif
+
+		Task->TimeToWait = EXIT_BY_TIMEOUT;
+
+		// BRTOS TRACE SUPPORT
+		OS_TRACE(OS_TRACE_TIMEOUT, 0, (Task - ContextTask));
+
+		// Remove from delay list
+		RemoveFromDelayList();
+
+		#if (NESTING_INT == 1)
+		OSExitCritical();
+		#endif
 
 		#if ((PROCESSOR == ARM_Cortex_M0) || (PROCESSOR == ARM_Cortex_M3) || (PROCESSOR == ARM_Cortex_M4) || (PROCESSOR == ARM_Cortex_M4F))
 		OS_INT_EXIT_EXT();
 		#endif
-      }
- 
-      Task = Task->Next;
+	  }
+
+	  OSDelayListTick = OSTickCounter;
   }
 
+  #if ((BRTOS_ROUND_ROBIN_EN == 1) && (configTIME_SLICE_TICKS > 0))
+  //////////////////////////////////////////
+  // Time slice of equal priority tasks   //
+  //////////////////////////////////////////
+  OSTimeSliceTick();
+  #endif
+
+  #if (BRTOS_BUDGET_EN == 1)
+  //////////////////////////////////////////
+  // CPU budget of the current task       //
+  //////////////////////////////////////////
+  OSBudgetTick();
+  #endif
+
   //////////////////////////////////////////
   // System Load                          //
   //////////////////////////////////////////  
@@ -630,6 +2205,109 @@ void OS_TICK_HANDLER(void)
 
 
 
+#if (TICKLESS == 1)
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Tickless Idle Functions                     /////
+/////                                                  /////
+/////  Used by the HAL idle function to suppress the   /////
+/////  tick interrupt while there is nothing to do     /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Number of ticks until the next delay list deadline
+// The soft timers are included, because the timer task is delayed
+// until the earliest soft timer expiration
+// Must be called inside a critical section, from the idle task
+ostick_t OSTicklessIdleTime(ostick_t max_ticks)
+{
+  ostick_t idle_ticks = max_ticks;
+
+  // Any ready task other than the idle task requires the next tick
+  if (OSReadyListHighest() != 0)
+  {
+	  return 0;
+  }
+
+  // A tick not handled yet must be handled by the tick interrupt
+  if (OSTickCounter != OSDelayListTick)
+  {
+	  return 0;
+  }
+
+  if (Head != NULL)
+  {
+	  idle_ticks = OSTickDistance(OSTickCounter, Head->TimeToWait);
+	  if (idle_ticks > max_ticks)
+	  {
+		  idle_ticks = max_ticks;
+	  }
+  }
+
+  #if (BRTOS_BUDGET_EN == 1)
+  // The tasks blocked by their budgets are unblocked at the replenishment
+  if ((OSBudgetWait != 0) && ((ostick_t)(OSBudgetWait - OSTickElapsed(OSBudgetCheckTick, OSTickCounter)) < idle_ticks))
+  {
+	  idle_ticks = (ostick_t)(OSBudgetWait - OSTickElapsed(OSBudgetCheckTick, OSTickCounter));
+  }
+  #endif
+
+  // It is not worth to stop the tick timer for a few ticks
+  if (idle_ticks < configTICKLESS_MIN_IDLE_TICKS)
+  {
+	  return 0;
+  }
+
+  return idle_ticks;
+}
+
+
+// Updates the kernel time after a tickless idle period
+// The ticks elapsed while the tick interrupt was suppressed are added
+// to the tick counter and the delay list is updated
+// Must be called inside a critical section
+void OSTicklessCompensate(ostick_t ticks)
+{
+  if (ticks == 0)
+  {
+	  return;
+  }
+
+  #if (COMPUTES_CPU_LOAD == 1)
+  {
+	  // The suppressed ticks were idle ticks. The last one is accounted by the tick handler
+	  uint32_t cnt = (uint32_t)DutyCnt + (uint32_t)(ticks - 1);
+
+	  if (cnt >= 1000)
+	  {
+		  // Closes the load window in progress
+		  LastOSDuty = OSDuty;
+		  OSDuty = 0;
+		  cnt = cnt - 1000;
+
+		  // The next complete windows elapsed in the idle task, without load
+		  if (cnt >= 1000)
+		  {
+			  LastOSDuty = 0;
+			  cnt = cnt % 1000;
+		  }
+	  }
+	  DutyCnt = (uint16_t)cnt;
+  }
+  #endif
+
+  OSIncCounter(ticks);
+  OS_TICK_HANDLER();
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+#endif
+
+
+
+
 
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
@@ -650,9 +2328,12 @@ uint8_t BRTOSStart(void)
 
 #if (COMPUTES_TASK_LOAD == 1)
   OSConfigureTimerForRuntimeStats();
+  OSTimeTaskSwitched = OSGetTimerForRuntimeStats();
 #endif
 
   currentTask = OSSchedule();
+  OS_TRACE(OS_TRACE_SWITCH, 0, currentTask);
+  OS_STACK_GUARD_SET();
   SPvalue = ContextTask[currentTask].StackPoint;
   BTOSStartFirstTask();
   return OK;
@@ -674,19 +2355,31 @@ uint8_t BRTOSStart(void)
 
 void PreInstallTasks(void)
 {
-  uint8_t i=0;
+  uint16_t i=0;
   OSTickCounter = 0;
+  #if (BRTOS_TICK64_EN == 1)
+  OSTickEpoch = 0;
+  #endif
+  OSDelayListTick = 0;
   currentTask = 0;
   NumberOfInstalledTasks = 0;
-  TaskAlloc = 0;
   iStackAddress = 0;
 #if (!BRTOS_DYNAMIC_TASKS_ENABLED)
   StackAddress = (stack_pointer_t) &STACK;
 #endif
   
+  for(i=0;i<OS_TASK_ALLOC_SIZE;i++)
+  {
+    TaskAlloc[i] = 0;
+  }
+
   for(i=0;i<configMAX_TASK_INSTALL;i++)
   {
     PriorityVector[i]=EMPTY_PRIO;
+    #if (BRTOS_ROUND_ROBIN_EN == 1)
+    OSReadyQueueHead[i] = 0;
+    OSReadyQueueTail[i] = 0;
+    #endif
   }
 
   for(i=1;i<=NUMBER_OF_TASKS;i++)
@@ -694,8 +2387,40 @@ void PreInstallTasks(void)
 	  ContextTask[i].Priority = EMPTY_PRIO;
 #if (COMPUTES_TASK_LOAD == 1)
 	  ContextTask[i].Runtime = 0;
+#endif
+#if (BRTOS_TASK_STATS_EN == 1)
+	  ContextTask[i].Waking = FALSE;
+	  OSTaskStatsClear(i);
+#endif
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+	  ContextTask[i].RunState = 0;
+	  ContextTask[i].WaitEvent = NULL;
+	  ContextTask[i].InheritBase = EMPTY_PRIO;
+#endif
+#if (BRTOS_EDF_EN == 1)
+	  ContextTask[i].EDFPeriod = 0;
+#endif
+#if (BRTOS_BUDGET_EN == 1)
+	  ContextTask[i].Budget = 0;
+	  ContextTask[i].BudgetState = OS_BUDGET_AVAILABLE;
+#endif
+#if (BRTOS_PEND_MULTIPLE_EN == 1)
+	  ContextTask[i].WaitMultiple = NULL;
+#endif
+#if (BRTOS_TASK_NOTIFY_EN == 1)
+	  ContextTask[i].NotifyValue = 0;
+	  ContextTask[i].NotifyState = OS_NOTIFY_IDLE;
 #endif
   }
+
+  #if ((BRTOS_ROUND_ROBIN_EN == 1) && (configTIME_SLICE_TICKS > 0))
+  OSSliceTask = 0;
+  OSSliceTicks = 0;
+  #endif
+
+  #if (BRTOS_BUDGET_EN == 1)
+  OSBudgetWait = 0;
+  #endif
     
   Tail = NULL;
   Head = NULL;
@@ -733,6 +2458,23 @@ uint8_t OSBlockPriority(uint8_t iPriority)
     OSEnterCritical();
 
 
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  // Block every task with priority iPriority
+  BlockedTask = PriorityVector[iPriority];
+  if (BlockedTask <= NUMBER_OF_TASKS)
+  {
+    do
+    {
+      #if (VERBOSE == 1)
+      ContextTask[BlockedTask].Blocked = TRUE;
+      #endif
+      OSBlockedListInsert(&ContextTask[BlockedTask]);
+      BlockedTask = ContextTask[BlockedTask].PrioNext;
+    }while(BlockedTask != PriorityVector[iPriority]);
+  }
+
+  if (ContextTask[currentTask].Priority == iPriority)
+  #else
   // Detects the task priority
   BlockedTask = PriorityVector[iPriority];  
   // Block task with priority iPriority
@@ -740,10 +2482,11 @@ uint8_t OSBlockPriority(uint8_t iPriority)
   ContextTask[BlockedTask].Blocked = TRUE;
   #endif
   
-  OSBlockedList = OSBlockedList & ~(PriorityMask[iPriority]);
+  OSPrioClear(OSBlockedList, iPriority);
    
   
   if (currentTask == BlockedTask)
+  #endif
   {
      ChangeContext();
   }
@@ -772,7 +2515,7 @@ uint8_t OSBlockPriority(uint8_t iPriority)
 uint8_t OSUnBlockPriority(uint8_t iPriority)
 {
   OS_SR_SAVE_VAR
-  #if (VERBOSE == 1)
+  #if ((VERBOSE == 1) || (BRTOS_ROUND_ROBIN_EN == 1))
   uint8_t BlockedTask = 0;
   #endif
   
@@ -783,13 +2526,29 @@ uint8_t OSUnBlockPriority(uint8_t iPriority)
   #endif
      OSEnterCritical();
     
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  // Unblock every task with priority iPriority
+  BlockedTask = PriorityVector[iPriority];
+  if (BlockedTask <= NUMBER_OF_TASKS)
+  {
+    do
+    {
+      #if (VERBOSE == 1)
+      ContextTask[BlockedTask].Blocked = FALSE;
+      #endif
+      OSBlockedListRemove(&ContextTask[BlockedTask]);
+      BlockedTask = ContextTask[BlockedTask].PrioNext;
+    }while(BlockedTask != PriorityVector[iPriority]);
+  }
+  #else
   // Detects the task priority
   #if (VERBOSE == 1)  
   BlockedTask = PriorityVector[iPriority];  
   ContextTask[BlockedTask].Blocked = FALSE;
   #endif
   
-  OSBlockedList = OSBlockedList | (PriorityMask[iPriority]);
+  OSPrioSet(OSBlockedList, iPriority);
+  #endif
   
   // check if we have unblocked a higher priority task  
   if (currentTask)
@@ -826,7 +2585,6 @@ uint8_t OSUnBlockPriority(uint8_t iPriority)
 uint8_t OSBlockTask(BRTOS_TH TaskHandle)
 {
   OS_SR_SAVE_VAR
-  uint8_t iPriority = 0;
   
   if (iNesting > 0) {                                // See if caller is an interrupt
      return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
@@ -855,9 +2613,8 @@ uint8_t OSBlockTask(BRTOS_TH TaskHandle)
   #if (VERBOSE == 1)
   ContextTask[TaskHandle].Blocked = TRUE;
   #endif
-  iPriority = ContextTask[TaskHandle].Priority;
   
-  OSBlockedList = OSBlockedList & ~(PriorityMask[iPriority]);
+  OSBlockedListInsert(&ContextTask[TaskHandle]);
   
   if (currentTask == TaskHandle)
   {
@@ -888,7 +2645,6 @@ uint8_t OSBlockTask(BRTOS_TH TaskHandle)
 uint8_t OSUnBlockTask(BRTOS_TH TaskHandle)
 {
   OS_SR_SAVE_VAR
-  uint8_t iPriority = 0;
   
   // Enter Critical Section
   #if (NESTING_INT == 0)
@@ -900,10 +2656,7 @@ uint8_t OSUnBlockTask(BRTOS_TH TaskHandle)
   ContextTask[TaskHandle].Blocked = FALSE;
   #endif
   
-  // Determina a prioridade da funo  
-  iPriority = ContextTask[TaskHandle].Priority;
-
-  OSBlockedList = OSBlockedList | (PriorityMask[iPriority]);
+  OSBlockedListRemove(&ContextTask[TaskHandle]);
   
   // check if we have unblocked a higher priority task  
   if (currentTask)
@@ -943,7 +2696,6 @@ uint8_t OSBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
   OS_SR_SAVE_VAR
   uint8_t iTask = 0;
   uint8_t TaskFinish = 0;
-  uint8_t iPriority = 0;  
   
   if (iNesting > 0) {                                // See if caller is an interrupt
      return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
@@ -962,10 +2714,8 @@ uint8_t OSBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
       #if (VERBOSE == 1)
       ContextTask[iTask].Blocked = TRUE;
       #endif
-      // Determina a prioridade da funo
-      iPriority = ContextTask[iTask].Priority;   
       
-      OSBlockedList = OSBlockedList & ~(PriorityMask[iPriority]);
+      OSBlockedListInsert(&ContextTask[iTask]);
     }
   }
   
@@ -995,7 +2745,6 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
   OS_SR_SAVE_VAR
   uint8_t iTask = 0;
   uint8_t TaskFinish = 0;
-  uint8_t iPriority = 0;    
   
   if (iNesting > 0) {                                // See if caller is an interrupt
      return(IRQ_PEND_ERR);                           // Can't be blocked by interrupt
@@ -1009,16 +2758,13 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
   
   for (iTask = TaskStart; iTask <TaskFinish; iTask++)
   {
-    // Determina a prioridade da funo
     if (iTask != currentTask)
     {
-      iPriority = ContextTask[iTask].Priority;
-      
       #if (VERBOSE == 1)
       ContextTask[iTask].Blocked = FALSE;
       #endif
       
-      OSBlockedList = OSBlockedList | (PriorityMask[iPriority]);
+      OSBlockedListRemove(&ContextTask[iTask]);
     }
   }
   
@@ -1141,7 +2887,12 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
         return END_OF_AVAILABLE_PRIORITIES;
      }
      
+     #if (BRTOS_ROUND_ROBIN_EN == 1)
+     // Tasks can share a priority, but not the priority ceiling of a mutex
+     if ((PriorityVector[iPriority] == MUTEX_PRIO) || (OSIsMutexPriority(iPriority) == TRUE))
+     #else
      if (PriorityVector[iPriority] != EMPTY_PRIO)
+     #endif
      {
         if (currentTask)
          // Exit Critical Section
@@ -1164,12 +2915,12 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    for(i=0;i<NUMBER_OF_TASKS;i++)
    {
       uint32_t teste = 1;
-      teste = teste<<i;
+      teste = teste<<(i & 31);
     
-      if (!(teste & TaskAlloc))
+      if (!(teste & TaskAlloc[i >> 5]))
       {
          TaskNumber = i+1;
-         TaskAlloc = TaskAlloc | teste;
+         TaskAlloc[i >> 5] = TaskAlloc[i >> 5] | teste;
          break;
       }
    }   
@@ -1216,7 +2967,11 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    Task->Priority = iPriority;
 
    // Determina a tarefa que ir ocupar esta prioridade
+   #if (BRTOS_ROUND_ROBIN_EN == 1)
+   OSPriorityListInsert(TaskNumber);
+   #else
    PriorityVector[iPriority] = TaskNumber;
+   #endif
    // set the function entry address in the context
    
    // Fill the virtual task stack
@@ -1225,6 +2980,16 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    #else
       CreateVirtualStack(FctPtr, USER_STACKED_BYTES);   
    #endif
+
+   #if (BRTOS_STACK_CHECK_EN == 1)
+   // Guard word at the end of the task stack, verified at each context switch
+	#if STACK_GROWTH == 1
+   Task->StackGuard = (uint32_t*)&STACK[iStackAddress + (USER_STACKED_BYTES / sizeof(OS_CPU_TYPE))] - 1;
+	#else
+   Task->StackGuard = (uint32_t*)&STACK[iStackAddress];
+	#endif
+   *Task->StackGuard = BRTOS_STACK_CANARY;
+   #endif
    
    // Incrementa o contador de bytes do stack virtual (HEAP)
    iStackAddress = iStackAddress + (USER_STACKED_BYTES / sizeof(OS_CPU_TYPE));
@@ -1241,7 +3006,43 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    Task->State = READY;
    #endif   
    
-   OSReadyList = OSReadyList | (PriorityMask[iPriority]);   
+   #if (BRTOS_ROUND_ROBIN_EN == 1)
+   Task->RunState = 0;
+   Task->WaitEvent = NULL;
+   Task->InheritBase = EMPTY_PRIO;
+   Task->Slices = 0;
+   #endif
+
+   #if (BRTOS_EDF_EN == 1)
+   // Scheduled by deadline after OSEDFTaskSet
+   Task->EDFPeriod = 0;
+   #endif
+
+   #if (BRTOS_BUDGET_EN == 1)
+   // No execution time limit before OSTaskBudgetSet
+   Task->Budget = 0;
+   Task->BudgetState = OS_BUDGET_AVAILABLE;
+   #endif
+
+   #if (BRTOS_PEND_MULTIPLE_EN == 1)
+   Task->WaitMultiple = NULL;
+   #endif
+
+   #if (BRTOS_TASK_NOTIFY_EN == 1)
+   Task->NotifyValue = 0;
+   Task->NotifyState = OS_NOTIFY_IDLE;
+   #endif
+
+   OSReadyListInsert(Task);
+
+   #if (BRTOS_TASK_STATS_EN == 1)
+   // The first run of a task is not a wake up
+   Task->Waking = FALSE;
+   OSTaskStatsClear(TaskNumber);
+   #endif
+
+   // BRTOS TRACE SUPPORT
+   OS_TRACE(OS_TRACE_TASK_INSTALL, Task->Priority, TaskNumber);
    
    if (currentTask)
     // Exit Critical Section
@@ -1287,7 +3088,12 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
         return END_OF_AVAILABLE_PRIORITIES;
      }
 
+     #if (BRTOS_ROUND_ROBIN_EN == 1)
+     // Tasks can share a priority, but not the priority ceiling of a mutex
+     if ((PriorityVector[iPriority] == MUTEX_PRIO) || (OSIsMutexPriority(iPriority) == TRUE))
+     #else
      if (PriorityVector[iPriority] != EMPTY_PRIO)
+     #endif
      {
         if (currentTask)
          // Exit Critical Section
@@ -1321,12 +3127,12 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    for(i=0;i<NUMBER_OF_TASKS;i++)
    {
       uint32_t teste = 1;
-      teste = teste<<i;
+      teste = teste<<(i & 31);
 
-      if (!(teste & TaskAlloc))
+      if (!(teste & TaskAlloc[i >> 5]))
       {
          TaskNumber = i+1;
-         TaskAlloc = TaskAlloc | teste;
+         TaskAlloc[i >> 5] = TaskAlloc[i >> 5] | teste;
          break;
       }
    }
@@ -1361,7 +3167,11 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    Task->Priority = iPriority;
 
    // Determina a tarefa que ir ocupar esta prioridade
+   #if (BRTOS_ROUND_ROBIN_EN == 1)
+   OSPriorityListInsert(TaskNumber);
+   #else
    PriorityVector[iPriority] = TaskNumber;
+   #endif
    // set the function entry address in the context
 
    // Fill the virtual task stack
@@ -1371,6 +3181,16 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    Task->StackPoint = CreateDVirtualStack(FctPtr, (OS_CPU_TYPE)Stack, USER_STACKED_BYTES);
    #endif
 
+   #if (BRTOS_STACK_CHECK_EN == 1)
+   // Guard word at the end of the task stack, verified at each context switch
+	#if STACK_GROWTH == 1
+   Task->StackGuard = (uint32_t*)((uint8_t*)Stack + USER_STACKED_BYTES) - 1;
+	#else
+   Task->StackGuard = (uint32_t*)Stack;
+	#endif
+   *Task->StackGuard = BRTOS_STACK_CANARY;
+   #endif
+
    Task->StackSize = USER_STACKED_BYTES;
    Task->TimeToWait = NO_TIMEOUT;
    Task->Next     =  NULL;
@@ -1381,7 +3201,43 @@ uint8_t OSUnBlockMultipleTask(uint8_t TaskStart, uint8_t TaskNumber)
    Task->State = READY;
    #endif
 
-   OSReadyList = OSReadyList | (PriorityMask[iPriority]);
+   #if (BRTOS_ROUND_ROBIN_EN == 1)
+   Task->RunState = 0;
+   Task->WaitEvent = NULL;
+   Task->InheritBase = EMPTY_PRIO;
+   Task->Slices = 0;
+   #endif
+
+   #if (BRTOS_EDF_EN == 1)
+   // Scheduled by deadline after OSEDFTaskSet
+   Task->EDFPeriod = 0;
+   #endif
+
+   #if (BRTOS_BUDGET_EN == 1)
+   // No execution time limit before OSTaskBudgetSet
+   Task->Budget = 0;
+   Task->BudgetState = OS_BUDGET_AVAILABLE;
+   #endif
+
+   #if (BRTOS_PEND_MULTIPLE_EN == 1)
+   Task->WaitMultiple = NULL;
+   #endif
+
+   #if (BRTOS_TASK_NOTIFY_EN == 1)
+   Task->NotifyValue = 0;
+   Task->NotifyState = OS_NOTIFY_IDLE;
+   #endif
+
+   OSReadyListInsert(Task);
+
+   #if (BRTOS_TASK_STATS_EN == 1)
+   // The first run of a task is not a wake up
+   Task->Waking = FALSE;
+   OSTaskStatsClear(TaskNumber);
+   #endif
+
+   // BRTOS TRACE SUPPORT
+   OS_TRACE(OS_TRACE_TASK_INSTALL, Task->Priority, TaskNumber);
 
    if (currentTask)
     // Exit Critical Section
@@ -1445,7 +3301,7 @@ uint8_t OSUninstallTask(BRTOS_TH TaskHandle, OS_CPU_TYPE safety_off){
 	  // Checks whether the task handler is valid
 	  if (Task != NULL){
 		  // Verify if the task is waiting for an event
-		  if ((OSReadyList & PriorityMask[Task->Priority]) != PriorityMask[Task->Priority]){
+		  if (!OSIsTaskReady(Task)){
 			  // if so, verify if the user ensures that all system objects were deleted
 			  if (safety_off == TRUE){
 				  // Search the task into timer wait list
@@ -1469,12 +3325,33 @@ uint8_t OSUninstallTask(BRTOS_TH TaskHandle, OS_CPU_TYPE safety_off){
 			  }
 		  }else{
 			  // if not, remove the task from the ready list
-			  OSReadyList = OSReadyList & ~(PriorityMask[Task->Priority]);
+			  OSReadyListRemove(Task);
 		  }
 
+		  #if (BRTOS_BUDGET_EN == 1)
+		  // A task blocked by its budget leaves the blocked list
+		  (void)OSBudgetRestore((uint8_t)TaskHandle);
+		  Task->Budget = 0;
+		  #endif
+
 		  // Proceed with the uninstall
-		  TaskAlloc = TaskAlloc & ~(1 << (TaskHandle-1));
+		  TaskAlloc[(TaskHandle-1) >> 5] = TaskAlloc[(TaskHandle-1) >> 5] & ~((uint32_t)1 << ((TaskHandle-1) & 31));
+		  #if (BRTOS_ROUND_ROBIN_EN == 1)
+		  OSPriorityListRemove((uint8_t)TaskHandle);
+		  Task->RunState = 0;
+		  Task->WaitEvent = NULL;
+		  #if (BRTOS_EDF_EN == 1)
+		  // Frees the utilization of an EDF task
+		  Task->EDFPeriod = 0;
+		  #endif
+		  #else
 		  PriorityVector[Task->Priority] = EMPTY_PRIO;
+		  #endif
+
+		  #if (BRTOS_STACK_CHECK_EN == 1)
+		  // The freed stack is not verified by the switch out of the task
+		  Task->StackGuard = NULL;
+		  #endif
 
 		  BRTOS_DEALLOC((void*)Task->StackInit);
 
@@ -1523,6 +3400,13 @@ void BRTOSInit(void)
   /////      Initialize Event Control Blocks             /////
   ////////////////////////////////////////////////////////////
   initEvents();
+
+  #if (OSTRACE == 1)
+  ////////////////////////////////////////////////////////////  
+  /////            Initialize Event Trace                /////
+  ////////////////////////////////////////////////////////////  
+  OSTraceInit();
+  #endif
   
   ////////////////////////////////////////////////////////////  
   /////          Initialize global variables             /////
@@ -1568,6 +3452,16 @@ void initEvents(void)
     for(i=0;i<BRTOS_MAX_QUEUE;i++)
       BRTOS_Queue_Table[i].OSEventAllocated = 0;    
   #endif
+
+  #if (BRTOS_EVENT_GROUP_EN == 1)
+    for(i=0;i<BRTOS_MAX_EVENT_GROUP;i++)
+      BRTOS_EventGroup_Table[i].OSEventAllocated = 0;
+  #endif
+
+  #if (BRTOS_MEMPOOL_EN == 1)
+    for(i=0;i<BRTOS_MAX_MEMPOOL;i++)
+      BRTOS_MemPool_Table[i].OSEventAllocated = 0;
+  #endif
 }
 
 ////////////////////////////////////////////////////////////
@@ -1585,14 +3479,14 @@ void initEvents(void)
 ////////////////////////////////////////////////////////////
 #if (OPTIMIZED_SCHEDULER == 1)
 
-uint8_t SAScheduler(PriorityType READY_LIST_VAR)
+uint8_t SAScheduler(PriorityWordType READY_LIST_VAR)
 {
   Optimezed_Scheduler();
 }
 
 #else
 
-uint8_t SAScheduler(PriorityType ReadyList)
+uint8_t SAScheduler(PriorityWordType ReadyList)
 {
   uint8_t prio = 0;
   
@@ -1827,3 +3721,29 @@ uint8_t SAScheduler(PriorityType ReadyList)
 }
 
 #endif
+
+#if (NUMBER_OF_PRIORITIES > 32)
+////////////////////////////////////////////////////////////
+/////      Two Level Priority List                     /////
+////////////////////////////////////////////////////////////
+
+// The group word selects the word to be searched, so the highest priority
+// is found with two searches of 32 bits, whatever the number of priorities
+uint8_t OSPriorityHighest(const PriorityType *List)
+{
+  uint8_t iGroup = SAScheduler(List->Group);
+
+  return (uint8_t)((iGroup << 5) + SAScheduler(List->Bits[iGroup]));
+}
+
+void OSPriorityReset(PriorityType *List)
+{
+  uint8_t i = 0;
+
+  List->Group = 0;
+  for(i=0;i<OS_PRIORITY_GROUPS;i++)
+  {
+    List->Bits[i] = 0;
+  }
+}
+#endif
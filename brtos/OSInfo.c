@@ -63,8 +63,33 @@ char *PrintDecimal(int16_t val, CHAR8 *buff)
 }
 
 
+#if ((BRTOS_ROUND_ROBIN_EN == 1) || (BRTOS_HEAP_ACCOUNTING_EN == 1) || (BRTOS_TASK_STATS_EN == 1))
+// Right aligned unsigned decimal, 10 digits
+static char *PrintUnsigned(uint32_t val, CHAR8 *buff)
+{
+   int i = 0;
+
+   for (i = 0; i < 10; i++)
+   {
+      *(buff + i) = ' ';
+   }
+   *(buff + i) = 0;
+
+   for (i = 9; i >= 0; i--)
+   {
+      *(buff + i) = (CHAR8)((val % 10) + '0');
+      val /= 10;
+      if (val == 0) break;
+   }
+
+   return buff;
+}
+#endif
+
+
 // Imprimir ID, nome, estado, prioridade, stack
 /* Tasks are reported as blocked ('B'), ready ('R') or suspended ('S'). */
+/* With BRTOS_ROUND_ROBIN_EN the number of expired time slices is also reported. */
 void OSTaskList(char *string)
 {
     uint16_t VirtualStack = 0;
@@ -73,14 +98,20 @@ void OSTaskList(char *string)
     uint8_t  i = 0;
 #endif
     uint8_t  prio = 0;
-    CHAR8  str[9];
+    CHAR8  str[11];
     uint32_t *sp_end = 0;
     uint32_t *sp_address = 0;
     int z,count;
     
+    #if (BRTOS_ROUND_ROBIN_EN == 1)
+    string += mem_cpy(string,"\n\r***********************************************************************\n\r");
+    string += mem_cpy(string,"ID   NAME                    STATE   PRIORITY   STACK SIZE       SLICES\n\r");
+    string += mem_cpy(string,"***********************************************************************\n\r");
+    #else
     string += mem_cpy(string,"\n\r***********************************************************\n\r");
     string += mem_cpy(string,"ID   NAME                    STATE   PRIORITY   STACK SIZE\n\r");
     string += mem_cpy(string,"***********************************************************\n\r");
+    #endif
 
 	#if (!BRTOS_DYNAMIC_TASKS_ENABLED)
     for (j=1;j<=NumberOfInstalledTasks;j++)
@@ -112,10 +143,10 @@ void OSTaskList(char *string)
 			  // Print the task state
 			  string += mem_cpy(string,"  ");
 			  UserEnterCritical();
-			  if ((OSBlockedList & (PriorityMask[ContextTask[j].Priority])) == 0){
+			  if (OSIsTaskBlocked(&ContextTask[j])){
 				  *string++ = 'B';
 			  }else{
-				  if ((OSReadyList & (PriorityMask[ContextTask[j].Priority])) == PriorityMask[ContextTask[j].Priority]){
+				  if (OSIsTaskReady(&ContextTask[j])){
 					  *string++ = 'R';
 				  }else{
 					  *string++ = 'S';
@@ -203,6 +234,12 @@ void OSTaskList(char *string)
 			  (void)PrintDecimal(VirtualStack, str);
 			  string += mem_cpy(string, str);
 
+			  #if (BRTOS_ROUND_ROBIN_EN == 1)
+			  // Print the number of expired time slices
+			  string += mem_cpy(string, "   ");
+			  string += mem_cpy(string, PrintUnsigned(ContextTask[j].Slices, str));
+			  #endif
+
 			  string += mem_cpy(string, "\n\r");
 		}
     }
@@ -216,12 +253,19 @@ void OSTaskList(char *string)
 #if (COMPUTES_TASK_LOAD == 1)
 #include <string.h>
 #include <stdio.h>
+/* With BRTOS_TASK_STATS_EN the percentages are computed from the 64 bits runtimes, */
+/* and the switches, preemptions and wake up latencies are listed after the runtimes. */
 void OSRuntimeStats(char *string)
 {
     uint8_t  j = 0;
     CHAR8  str[16];
     int z,count;
     uint32_t runtime, total_time, percentage;
+#if (BRTOS_TASK_STATS_EN == 1)
+    OS_TASK_STATS stats;
+    uint64_t total_runtime = 0;
+    uint8_t  i;
+#endif
 
     string += mem_cpy(string,"\n\r**********************************************\n\r");
     string += mem_cpy(string,"ID   NAME                    Abs Time   % Time \n\r");
@@ -230,6 +274,18 @@ void OSRuntimeStats(char *string)
     total_time = OSGetTimerForRuntimeStats();
     total_time /= 100UL;
 
+#if (BRTOS_TASK_STATS_EN == 1)
+    // Sum of the runtimes, valid after an overflow of the runtime counter
+    for (j=1;j<=NUMBER_OF_TASKS;j++)
+    {
+    	if (OSGetTaskStats(j, &stats) == OK)
+    	{
+    		total_runtime += stats.runtime;
+    	}
+    }
+    total_runtime /= 100UL;
+#endif
+
 	#if (!BRTOS_DYNAMIC_TASKS_ENABLED)
     for (j=1;j<=NumberOfInstalledTasks;j++)
 	#else
@@ -262,7 +318,13 @@ void OSRuntimeStats(char *string)
 			  UserExitCritical();
 
 			  // Percentage calculation
+			  #if (BRTOS_TASK_STATS_EN == 1)
+			  (void)OSGetTaskStats(j, &stats);
+			  percentage = (total_runtime > 0) ? (uint32_t)(stats.runtime / total_runtime) : 0;
+			  (void)total_time;
+			  #else
 			  percentage = runtime / total_time;
+			  #endif
 
 
 			  // Print task runtime
@@ -289,6 +351,60 @@ void OSRuntimeStats(char *string)
 		  }
     }
 
+#if (BRTOS_TASK_STATS_EN == 1)
+    string += mem_cpy(string,"\n\r**********************************************************************\n\r");
+    string += mem_cpy(string,"ID     SWITCHES   PREEMPTS    WAKEUPS    LAT MIN    LAT AVG    LAT MAX\n\r");
+    string += mem_cpy(string,"**********************************************************************\n\r");
+
+    for (j=1;j<=NUMBER_OF_TASKS;j++)
+    {
+		  if ((ContextTask[j].Priority != EMPTY_PRIO) && (OSGetTaskStats(j, &stats) == OK)){
+			  *string++ = '[';
+			  if (j<10){
+				  *string++ = j+'0';
+				  string += mem_cpy(string, "] ");
+			  }else{
+				  (void)PrintDecimal(j, str);
+				  string += mem_cpy(string, (str+4));
+				  string += mem_cpy(string, "]");
+			  }
+			  string += mem_cpy(string, PrintUnsigned(stats.switches, str));
+			  *string++ = ' ';
+			  string += mem_cpy(string, PrintUnsigned(stats.preemptions, str));
+			  *string++ = ' ';
+			  string += mem_cpy(string, PrintUnsigned(stats.wakeups, str));
+			  *string++ = ' ';
+			  string += mem_cpy(string, PrintUnsigned(stats.latency_min, str));
+			  *string++ = ' ';
+			  string += mem_cpy(string, PrintUnsigned((stats.wakeups > 0) ? (uint32_t)(stats.latency_total / stats.wakeups) : 0, str));
+			  *string++ = ' ';
+			  string += mem_cpy(string, PrintUnsigned(stats.latency_max, str));
+			  string += mem_cpy(string,"\n\r");
+		  }
+    }
+
+    // Latency histogram - bin i counts the latencies below (2^i << BRTOS_LATENCY_HIST_SHIFT)
+    string += mem_cpy(string,"\n\rLatency histogram (bin: count)\n\r");
+    for (j=1;j<=NUMBER_OF_TASKS;j++)
+    {
+		  if ((ContextTask[j].Priority != EMPTY_PRIO) && (OSGetTaskStats(j, &stats) == OK) && (stats.wakeups > 0)){
+			  *string++ = '[';
+			  (void)PrintDecimal(j, str);
+			  string += mem_cpy(string, (str+4));
+			  *string++ = ']';
+			  for (i=0;i<BRTOS_LATENCY_HIST_SIZE;i++)
+			  {
+				  if (stats.latency_hist[i] > 0)
+				  {
+					  sprintf(str, " %u:%lu", (unsigned int)i, (unsigned long)stats.latency_hist[i]);
+					  string += mem_cpy(string, str);
+				  }
+			  }
+			  string += mem_cpy(string,"\n\r");
+		  }
+    }
+#endif
+
     string += mem_cpy(string, "\n\r");
 
     // End of string
@@ -304,6 +420,10 @@ void OSAvailableMemory(char *string)
 {
     uint16_t address = 0;
     CHAR8  str[8];
+#if (BRTOS_MEMPOOL_EN == 1)
+    BRTOS_MemPool pool;
+    uint8_t i;
+#endif
 
     string += mem_cpy(string, "\n\r***** BRTOS Memory Info *****\n\r");
 #if (!BRTOS_DYNAMIC_TASKS_ENABLED)
@@ -355,11 +475,122 @@ void OSAvailableMemory(char *string)
     	string += mem_cpy(string, "\n\r");
 	#endif
 
+	#if ((BRTOS_DYNAMIC_QUEUE_ENABLED == 1) || (BRTOS_DYNAMIC_TASKS_ENABLED == 1))
+    // Largest free block and fragmentation of the free memory of the dynamic heap
+    string += mem_cpy(string, "LARGEST FREE HEAP BLOCK:   ");
+    (void)PrintDecimal((int16_t)OSGetMaxFreeHeapBlock(), str);
+    string += mem_cpy(string, &str[1]);
+    string += mem_cpy(string, ", fragmentation ");
+    string += mem_cpy(string, PrintDecimal((int16_t)OSGetHeapFragmentation(), str));
+    string += mem_cpy(string, "%\n\r");
+	#endif
+
+	#if (BRTOS_MEMPOOL_EN == 1)
+    // Used blocks, maximum used blocks and failed gets of each memory pool
+    for(i=0;i<BRTOS_MAX_MEMPOOL;i++)
+    {
+    	UserEnterCritical();
+    	pool = BRTOS_MemPool_Table[i];
+    	UserExitCritical();
+
+    	if (pool.OSEventAllocated != TRUE) continue;
+
+    	string += mem_cpy(string, "MEMORY POOL ");
+    	string += mem_cpy(string, PrintDecimal(i, str));
+    	string += mem_cpy(string, ":             ");
+    	(void)PrintDecimal((int16_t)(pool.OSBlocks - pool.OSFreeBlocks), str);
+    	string += mem_cpy(string, &str[1]);
+    	string += mem_cpy(string, " of ");
+    	string += mem_cpy(string, PrintDecimal((int16_t)pool.OSBlocks, str));
+    	string += mem_cpy(string, " x ");
+    	string += mem_cpy(string, PrintDecimal((int16_t)pool.OSBlockSize, str));
+    	string += mem_cpy(string, " bytes, max ");
+    	string += mem_cpy(string, PrintDecimal((int16_t)(pool.OSBlocks - pool.OSMinFreeBlocks), str));
+    	string += mem_cpy(string, ", fails ");
+    	string += mem_cpy(string, PrintDecimal((int16_t)pool.OSAllocFails, str));
+    	string += mem_cpy(string, "\n\r");
+    }
+	#endif
+
     // End of string
     *string = '\0';
 }
 
 
+#if (BRTOS_HEAP_ACCOUNTING_EN == 1)
+/* Dynamic heap in use by each task, with the peak usage. */
+/* Task 0 is the code that runs before the scheduler start. The memory of */
+/* uninstalled tasks is reported until it is freed, which shows leaks. */
+void OSHeapTaskInfo(char *string)
+{
+    uint8_t  j = 0;
+    CHAR8  str[11];
+    OS_HEAP_TASK_STATS stats;
+    int z,count;
+
+    string += mem_cpy(string,"\n\r*************************************************************************\n\r");
+    string += mem_cpy(string,"ID   NAME                         BYTES     BLOCKS       PEAK     ALLOCS\n\r");
+    string += mem_cpy(string,"*************************************************************************\n\r");
+
+    for (j=0;j<=NUMBER_OF_TASKS;j++)
+    {
+		  (void)OSGetTaskHeapStats(j, &stats);
+
+		  if ((stats.allocs == 0) && (stats.blocks == 0)) continue;
+
+		  *string++ = '[';
+		  if (j<10)
+		  {
+			  *string++ = j+'0';
+			  string += mem_cpy(string, "]  ");
+		  }else
+		  {
+			  (void)PrintDecimal(j, str);
+			  string += mem_cpy(string, (str+4));
+			  string += mem_cpy(string, "] ");
+		  }
+
+		  UserEnterCritical();
+		  if (j == 0)
+		  {
+			  z = mem_cpy(string,"(startup)");
+		  }else
+		  {
+			  if (ContextTask[j].Priority != EMPTY_PRIO)
+			  {
+				  z = mem_cpy(string,(char*)ContextTask[j].TaskName);
+			  }else
+			  {
+				  z = mem_cpy(string,"(uninstalled)");
+			  }
+		  }
+		  UserExitCritical();
+		  string +=z;
+
+		  // Task name align
+		  for(count=0;count<(24-z);count++)
+		  {
+			  *string++ = ' ';
+		  }
+
+		  string += mem_cpy(string, PrintUnsigned(stats.bytes, str));
+		  string += mem_cpy(string, " ");
+		  string += mem_cpy(string, PrintUnsigned(stats.blocks, str));
+		  string += mem_cpy(string, " ");
+		  string += mem_cpy(string, PrintUnsigned(stats.peak_bytes, str));
+		  string += mem_cpy(string, " ");
+		  string += mem_cpy(string, PrintUnsigned(stats.allocs, str));
+		  string += mem_cpy(string, "\n\r");
+    }
+
+    string += mem_cpy(string, "\n\r");
+
+    // End of string
+    *string = '\0';
+}
+#endif
+
+
 void OSUptimeInfo(char *string)
 {
    OSTime Uptime;
@@ -0,0 +1,136 @@
+/**
+* \file OSTrace.c
+* \brief BRTOS binary event trace functions
+*
+* The kernel writes fixed size records into a RAM ring buffer. A record is
+* reserved by a single increment of the head counter, so the writers take no
+* lock and the oldest records are overwritten when the buffer is full. The
+* reader counts the records overwritten before it could read them.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                          OS Trace functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#include "BRTOS.h"
+
+#if (OSTRACE == 1)
+
+#if ((BRTOS_TRACE_SIZE & (BRTOS_TRACE_SIZE - 1)) != 0)
+#error "BRTOS_TRACE_SIZE must be a power of 2"
+#endif
+
+OS_TRACE_RECORD OSTraceBuffer[BRTOS_TRACE_SIZE];
+
+// Number of records written and read since the trace start
+volatile uint32_t OSTraceHead;
+static uint32_t OSTraceTail;
+static uint32_t OSTraceLost;
+
+
+
+void OSTraceInit(void)
+{
+  OS_TRACE_TIMESTAMP_INIT();
+
+  OSTraceHead = 0;
+  OSTraceTail = 0;
+  OSTraceLost = 0;
+
+  OSTraceEvent(OS_TRACE_START, (uint32_t)OS_TRACE_TIMESTAMP_HZ, 0);
+}
+
+
+
+void OSTraceEvent(uint8_t type, uint32_t object, uint16_t data)
+{
+  uint32_t timestamp;
+  OS_TRACE_RECORD *record = &OSTraceBuffer[(OS_TRACE_RESERVE(timestamp)) & (BRTOS_TRACE_SIZE - 1)];
+
+  record->timestamp = timestamp;
+  record->type = OS_TRACE_IN_ISR() ? (uint8_t)(type | OS_TRACE_ISR_FLAG) : type;
+  record->task = (uint8_t)currentTask;
+  record->data = data;
+  record->object = object;
+}
+
+
+
+void OSTraceUser(uint16_t id, uint32_t value)
+{
+  OS_SR_SAVE_VAR
+
+  if (!iNesting)
+  {
+    // Enter Critical Section
+    OSEnterCritical();
+  }
+
+  OSTraceEvent(OS_TRACE_USER, value, id);
+
+  if (!iNesting)
+  {
+    // Exit Critical Section
+    OSExitCritical();
+  }
+}
+
+
+
+uint16_t OSTraceRead(OS_TRACE_RECORD *records, uint16_t max, uint32_t *lost)
+{
+  OS_SR_SAVE_VAR
+  uint16_t count = 0;
+
+  while(count < max)
+  {
+    // Enter Critical Section
+    // One record at a time, the interrupts are disabled only for the copy
+    OSEnterCritical();
+
+    // Records overwritten before being read
+    if ((uint32_t)(OSTraceHead - OSTraceTail) > BRTOS_TRACE_SIZE)
+    {
+      OSTraceLost += (uint32_t)(OSTraceHead - OSTraceTail) - BRTOS_TRACE_SIZE;
+      OSTraceTail = OSTraceHead - BRTOS_TRACE_SIZE;
+    }
+
+    if (OSTraceTail == OSTraceHead)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      break;
+    }
+
+    records[count] = OSTraceBuffer[OSTraceTail & (BRTOS_TRACE_SIZE - 1)];
+    OSTraceTail++;
+    count++;
+
+    // Exit Critical Section
+    OSExitCritical();
+  }
+
+  if (lost != NULL)
+  {
+    *lost = OSTraceLost;
+    OSTraceLost = 0;
+  }
+
+  return count;
+}
+
+#endif
@@ -0,0 +1,512 @@
+/**
+* \file eventgroup.c
+* \brief BRTOS Event Group functions
+*
+* Functions to install and use event groups (event flags).
+* A task waits for any or all of a set of flags. Setting flags wakes up
+* every waiting task whose condition is satisfied.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                     OS Event Group functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#include "BRTOS.h"
+
+#if (BRTOS_EVENT_GROUP_EN == 1)
+
+// Verifies if the flags satisfy the wait condition
+static uint8_t OSEventGroupMatch(osflags_t flags, osflags_t wait, uint8_t options)
+{
+  if (options & OS_FLAGS_WAIT_ALL)
+  {
+    return (uint8_t)((flags & wait) == wait);
+  }
+
+  return (uint8_t)((flags & wait) != 0);
+}
+
+// Wakes up a waiting task if its condition is satisfied
+// Returns the flags to be cleared on exit of the task
+static osflags_t OSEventGroupWake(BRTOS_EventGroup *pont_event, ContextType *Task, uint8_t *woken)
+{
+  osflags_t clear = 0;
+
+  if (OSEventGroupMatch(pont_event->OSEventFlags, Task->WaitFlags, Task->WaitFlagsOptions))
+  {
+    if (Task->WaitFlagsOptions & OS_FLAGS_CLEAR_ON_EXIT)
+    {
+      clear = Task->WaitFlags;
+    }
+
+    // Every task woken up by this set sees the flags before the clear on exit
+    Task->WaitFlags = pont_event->OSEventFlags;
+
+    // Remove the task from the event group wait list
+    OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
+
+    // Decreases the event group wait list counter
+    pont_event->OSEventWait--;
+
+    // Put the task into Ready List
+    #if (VERBOSE == 1)
+    Task->State = READY;
+    #endif
+
+    OSReadyListInsert(Task);
+
+    *woken = TRUE;
+  }
+
+  return clear;
+}
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Create Event Group Function                 /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSEventGroupCreate(osflags_t flags, BRTOS_EventGroup **event)
+{
+  OS_SR_SAVE_VAR
+  int i=0;
+
+  BRTOS_EventGroup *pont_event;
+
+  if (iNesting > 0) {                                // See if caller is an interrupt
+     return(IRQ_PEND_ERR);                           // Can't be create by interrupt
+  }
+
+  // Enter critical Section
+  if (currentTask)
+     OSEnterCritical();
+
+  // Verifies if there is an available event control block
+  for(i=0;i<=BRTOS_MAX_EVENT_GROUP;i++)
+  {
+    if(i >= BRTOS_MAX_EVENT_GROUP)
+    {
+      // Exit critical Section
+      if (currentTask)
+         OSExitCritical();
+
+      return(NO_AVAILABLE_EVENT);
+    }
+
+    if(BRTOS_EventGroup_Table[i].OSEventAllocated != TRUE)
+    {
+      BRTOS_EventGroup_Table[i].OSEventAllocated = TRUE;
+      pont_event = &BRTOS_EventGroup_Table[i];
+      break;
+    }
+  }
+
+  pont_event->OSEventFlags = flags;
+  pont_event->OSEventWait  = 0;
+  OSPrioReset(pont_event->OSEventWaitList);
+
+  *event = pont_event;
+
+  // Exit critical Section
+  if (currentTask)
+     OSExitCritical();
+
+  return(ALLOC_EVENT_OK);
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Delete Event Group Function                 /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSEventGroupDelete(BRTOS_EventGroup **event)
+{
+  OS_SR_SAVE_VAR
+  BRTOS_EventGroup *pont_event;
+
+  if (iNesting > 0) {                                // See if caller is an interrupt
+      return(IRQ_PEND_ERR);                          // Can't be delete by interrupt
+  }
+
+  // Enter Critical Section
+  OSEnterCritical();
+
+  pont_event = *event;
+  pont_event->OSEventAllocated = 0;
+  pont_event->OSEventFlags     = 0;
+  pont_event->OSEventWait      = 0;
+  OSPrioReset(pont_event->OSEventWaitList);
+
+  *event = NULL;
+
+  // Exit Critical Section
+  OSExitCritical();
+
+  return(DELETE_EVENT_OK);
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Event Group Wait Function                   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSEventGroupWait(BRTOS_EventGroup *pont_event, osflags_t flags, uint8_t options, osflags_t *result, ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  osdtick_t timeout;
+  ContextType *Task;
+
+  #if (ERROR_CHECK == 1)
+    // Can not use event group wait function from interrupt handling code
+    if(iNesting > 0)
+    {
+      return(IRQ_PEND_ERR);
+    }
+
+    // Verifies if the pointer is NULL
+    if(pont_event == NULL)
+    {
+      return(NULL_EVENT_POINTER);
+    }
+  #endif
+
+  // There must be at least one flag to wait for
+  if (flags == 0)
+  {
+    return(INVALID_PARAMETERS);
+  }
+
+  // Enter Critical Section
+  OSEnterCritical();
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the event is allocated
+    if(pont_event->OSEventAllocated != TRUE)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return(ERR_EVENT_NO_CREATED);
+    }
+  #endif
+
+  // Verify if the flags are already set
+  if (OSEventGroupMatch(pont_event->OSEventFlags, flags, options))
+  {
+    if (result != NULL)
+    {
+      *result = pont_event->OSEventFlags;
+    }
+
+    if (options & OS_FLAGS_CLEAR_ON_EXIT)
+    {
+      pont_event->OSEventFlags &= (osflags_t)~flags;
+    }
+
+    // Exit Critical Section
+    OSExitCritical();
+    return OK;
+  }
+
+  // If no timeout is used and the flags are not set, exit the event group with an error
+  if (time_wait == NO_TIMEOUT){
+    // Exit Critical Section
+    OSExitCritical();
+    return EXIT_BY_NO_ENTRY_AVAILABLE;
+  }
+
+  Task = (ContextType*)&ContextTask[currentTask];
+
+  // The set function verifies the condition of each waiting task
+  Task->WaitFlags = flags;
+  Task->WaitFlagsOptions = options;
+
+  // Increases the event group wait list counter
+  pont_event->OSEventWait++;
+
+  // Allocates the current task on the event group wait list
+  OSEventWaitListInsert(&pont_event->OSEventWaitList, pont_event, Task);
+
+  // Task entered suspended state, waiting for the flags
+  #if (VERBOSE == 1)
+  Task->State = SUSPENDED;
+  Task->SuspendedType = EVENT_GROUP;
+  #endif
+
+  // Remove current task from the Ready List
+  OSReadyListRemove(Task);
+
+  // Set timeout overflow
+  if (time_wait)
+  {
+	  timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
+
+	  if (sizeof_ostick_t < 8){
+		  if (timeout >= TICK_COUNT_OVERFLOW)
+		  {
+			  Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+		  }
+		  else
+		  {
+			  Task->TimeToWait = (ostick_t)timeout;
+		  }
+	  }else{
+		  Task->TimeToWait = (ostick_t)timeout;
+	  }
+
+	  // Put task into delay list
+	  IncludeTaskIntoDelayList();
+  } else
+  {
+    Task->TimeToWait = NO_TIMEOUT;
+  }
+
+  // Change Context - Returns on time overflow or event group set
+  ChangeContext();
+
+  // Exit Critical Section
+  OSExitCritical();
+  // Enter Critical Section
+  OSEnterCritical();
+
+  if (time_wait)
+  {
+      // Verify if the reason of task wake up was event group timeout
+      if(Task->TimeToWait == EXIT_BY_TIMEOUT)
+      {
+          // Test if both timeout and set have occured before arrive here
+          if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, Task))
+          {
+            // Remove the task from the event group wait list
+            OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
+
+            // Decreases the event group wait list counter
+            pont_event->OSEventWait--;
+
+            // Exit Critical Section
+            OSExitCritical();
+
+            // Indicates event group timeout
+            return TIMEOUT;
+          }
+      }
+      else
+      {
+          // Remove the time to wait condition
+          Task->TimeToWait = NO_TIMEOUT;
+
+          // Remove from delay list
+          RemoveFromDelayList();
+      }
+  }
+
+  // The set function stored the flags that woke up the task
+  if (result != NULL)
+  {
+    *result = Task->WaitFlags;
+  }
+
+  // Exit Critical Section
+  OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Event Group Set Function                    /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSEventGroupSet(BRTOS_EventGroup *pont_event, osflags_t flags)
+{
+  OS_SR_SAVE_VAR
+  PriorityType Pending;
+  osflags_t clear = 0;
+  uint8_t iPriority;
+  uint8_t woken = FALSE;
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  uint8_t iTask;
+  uint8_t iNext;
+  #endif
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the pointer is NULL
+    if(pont_event == NULL)
+    {
+      return(NULL_EVENT_POINTER);
+    }
+  #endif
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the event is allocated
+    if(pont_event->OSEventAllocated != TRUE)
+    {
+      // Exit Critical Section
+      #if (NESTING_INT == 0)
+      if (!iNesting)
+      #endif
+         OSExitCritical();
+      return(ERR_EVENT_NO_CREATED);
+    }
+  #endif
+
+  pont_event->OSEventFlags |= flags;
+
+  // Broadcast - every waiting task is verified, from the highest priority,
+  // in the same critical section
+  Pending = pont_event->OSEventWaitList;
+
+  while(!OSPrioIsEmpty(Pending))
+  {
+    iPriority = OSPrioHighest(Pending);
+    OSPrioClear(Pending, iPriority);
+
+    #if (BRTOS_ROUND_ROBIN_EN == 1)
+    // The tasks of the priority that wait for this event group
+    iTask = PriorityVector[iPriority];
+    do
+    {
+      iNext = ContextTask[iTask].PrioNext;
+
+      if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, &ContextTask[iTask]))
+      {
+        clear |= OSEventGroupWake(pont_event, (ContextType*)&ContextTask[iTask], &woken);
+      }
+
+      iTask = iNext;
+    }while(iTask != PriorityVector[iPriority]);
+    #else
+    clear |= OSEventGroupWake(pont_event, (ContextType*)&ContextTask[PriorityVector[iPriority]], &woken);
+    #endif
+  }
+
+  // Flags consumed by the woken tasks
+  pont_event->OSEventFlags &= (osflags_t)~clear;
+
+  // If outside of an interrupt service routine, change context to the highest priority task
+  // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
+  if ((woken == TRUE) && (!iNesting))
+  {
+    ChangeContext();
+  }
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Event Group Clear Function                  /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSEventGroupClear(BRTOS_EventGroup *pont_event, osflags_t flags)
+{
+  OS_SR_SAVE_VAR
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the pointer is NULL
+    if(pont_event == NULL)
+    {
+      return(NULL_EVENT_POINTER);
+    }
+  #endif
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  pont_event->OSEventFlags &= (osflags_t)~flags;
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+osflags_t OSEventGroupGet(BRTOS_EventGroup *pont_event)
+{
+  return pont_event->OSEventFlags;
+}
+
+#endif
@@ -98,6 +98,128 @@
 #endif
 #define sizeof_ostick_t			sizeof(ostick_t)
 
+/// Minimum number of idle ticks to stop the tick timer in the tickless mode
+#ifndef configTICKLESS_MIN_IDLE_TICKS
+#define configTICKLESS_MIN_IDLE_TICKS	2
+#endif
+
+/// Enable more than one task per priority - FIFO ready list per priority (round-robin)
+#ifndef BRTOS_ROUND_ROBIN_EN
+#define BRTOS_ROUND_ROBIN_EN			0
+#endif
+
+/// Time slice of the tasks that share a priority, in ticks - 0 disables the time slicing
+#ifndef configTIME_SLICE_TICKS
+#define configTIME_SLICE_TICKS			0
+#endif
+
+/// Enable or disable the earliest deadline first scheduling class (OSEDFTaskSet)
+/// Requires BRTOS_ROUND_ROBIN_EN
+#ifndef BRTOS_EDF_EN
+#define BRTOS_EDF_EN					0
+#endif
+
+/// Priority of the EDF tasks - the tasks of higher priorities preempt them
+#ifndef BRTOS_EDF_PRIORITY
+#define BRTOS_EDF_PRIORITY				1
+#endif
+
+/// Maximum utilization of the EDF tasks, in percent, verified by the admission control
+#ifndef BRTOS_EDF_MAX_UTILIZATION
+#define BRTOS_EDF_MAX_UTILIZATION		100
+#endif
+
+#if ((BRTOS_EDF_EN == 1) && (BRTOS_ROUND_ROBIN_EN != 1))
+#error "BRTOS_EDF_EN requires BRTOS_ROUND_ROBIN_EN"
+#endif
+
+/// Enable or disable event groups (event flags)
+#ifndef BRTOS_EVENT_GROUP_EN
+#define BRTOS_EVENT_GROUP_EN			0
+#endif
+
+/// Defines the maximum number of event groups
+#ifndef BRTOS_MAX_EVENT_GROUP
+#define BRTOS_MAX_EVENT_GROUP			4
+#endif
+
+/// Event group flags type
+typedef uint32_t osflags_t;
+
+/// Enable or disable the wait for multiple events (OSPendMultiple)
+#ifndef BRTOS_PEND_MULTIPLE_EN
+#define BRTOS_PEND_MULTIPLE_EN			0
+#endif
+
+/// Enable or disable the direct to task notifications
+#ifndef BRTOS_TASK_NOTIFY_EN
+#define BRTOS_TASK_NOTIFY_EN			0
+#endif
+
+/// Enable or disable the fixed block memory pools
+#ifndef BRTOS_MEMPOOL_EN
+#define BRTOS_MEMPOOL_EN				0
+#endif
+
+/// Defines the maximum number of memory pools
+#ifndef BRTOS_MAX_MEMPOOL
+#define BRTOS_MAX_MEMPOOL				4
+#endif
+
+/// Enable or disable the task stack overflow check - a guard word at the end of
+/// each task stack is verified at each context switch
+#ifndef BRTOS_STACK_CHECK_EN
+#define BRTOS_STACK_CHECK_EN			0
+#endif
+
+/// Guard word written at the end of the task stacks
+#ifndef BRTOS_STACK_CANARY
+#define BRTOS_STACK_CANARY				(uint32_t)0xA5C33CA5UL
+#endif
+
+/// Enable or disable the binary event trace (OSTrace.h)
+#ifndef OSTRACE
+#define OSTRACE							0
+#endif
+
+/// Enable or disable the per task scheduling statistics (OSGetTaskStats)
+/// Requires COMPUTES_TASK_LOAD and the application runtime counter
+#ifndef BRTOS_TASK_STATS_EN
+#define BRTOS_TASK_STATS_EN				0
+#endif
+
+/// Number of bins of the wake up latency histogram
+#ifndef BRTOS_LATENCY_HIST_SIZE
+#define BRTOS_LATENCY_HIST_SIZE			12
+#endif
+
+/// The first bin of the latency histogram counts the latencies below 2^BRTOS_LATENCY_HIST_SHIFT,
+/// each following bin doubles the limit and the last bin counts the longer latencies
+#ifndef BRTOS_LATENCY_HIST_SHIFT
+#define BRTOS_LATENCY_HIST_SHIFT		4
+#endif
+
+/// Enable or disable the 64 bit monotonic tick count (OSGetTickCount64) and the
+/// absolute delays longer than the tick counter overflow (OSDelayUntil64)
+#ifndef BRTOS_TICK64_EN
+#define BRTOS_TICK64_EN					0
+#endif
+
+/// Enable or disable the CPU budgets of the tasks (OSTaskBudgetSet)
+/// Requires COMPUTES_TASK_LOAD and the application runtime counter
+/// The application must define BRTOS_BudgetOverrunHook
+#ifndef BRTOS_BUDGET_EN
+#define BRTOS_BUDGET_EN					0
+#endif
+
+#if ((BRTOS_TASK_STATS_EN == 1) && (COMPUTES_TASK_LOAD != 1))
+#error "BRTOS_TASK_STATS_EN requires COMPUTES_TASK_LOAD"
+#endif
+
+#if ((BRTOS_BUDGET_EN == 1) && (COMPUTES_TASK_LOAD != 1))
+#error "BRTOS_BUDGET_EN requires COMPUTES_TASK_LOAD"
+#endif
+
 
 /// Task States
 #define READY                        (uint8_t)0     ///< Task is ready to be executed - waiting for the scheduler authorization
@@ -136,6 +258,9 @@
 #define TASK_WAITING_EVENT			 (uint8_t)12	  ///< Error - The task being uninstalled is waiting for an event (uninstall aborted)
 #define CANNOT_UNINSTALL_IDLE_TASK   (uint8_t)13    ///< Error - It is not be allow to uninstall the idle task
 #define EXIT_BY_NO_RESOURCE_AVAILABLE (uint8_t)14	  ///< Error - The resource is not available with no timeout option
+#define DELAY_OVERRUN                (uint8_t)15    ///< Error - The wake up time of an absolute delay was already reached (OSDelayUntil)
+#define EDF_NOT_ADMITTED             (uint8_t)16    ///< Error - The EDF task would exceed BRTOS_EDF_MAX_UTILIZATION
+#define DEADLINE_MISSED              (uint8_t)17    ///< Error - The job of an EDF task completed after its deadline
 
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
@@ -194,11 +319,44 @@
 #define MAILBOX   2                               ///< Task suspended by mailbox
 #define QUEUE     3                               ///< Task suspended by queue
 #define MUTEX     4                               ///< Task suspended by mutex
+#define STREAM    5                               ///< Task suspended by stream
+#define EVENT_GROUP 6                             ///< Task suspended by event group
+#define PEND_MULTIPLE 7                           ///< Task suspended by multiple events
+#define NOTIFICATION  8                           ///< Task suspended by task notification
+#define MEMPOOL       9                           ///< Task suspended by memory pool
 
 
 
 /// Task Defines
 
+#if (NUMBER_OF_PRIORITIES > 32)
+  // Two level bitmap: one bit per group of 32 priorities and one word per group
+  #if (NUMBER_OF_PRIORITIES > 128)
+    #define configMAX_TASK_INSTALL  256                ///< Defines the maximum number of tasks that can be installed
+    #define configMAX_TASK_PRIORITY 254                ///< 255 is EMPTY_PRIO, which marks a free task context, so neither a task nor a mutex priority ceiling may use it
+  #else
+    #if (NUMBER_OF_PRIORITIES > 64)
+      #define configMAX_TASK_INSTALL  128              ///< Defines the maximum number of tasks that can be installed
+      #define configMAX_TASK_PRIORITY 127
+    #else
+      #define configMAX_TASK_INSTALL  64               ///< Defines the maximum number of tasks that can be installed
+      #define configMAX_TASK_PRIORITY 63
+    #endif
+  #endif
+  #define OS_PRIORITY_GROUPS      (configMAX_TASK_INSTALL / 32)
+  #define OS_PRIORITY_WORD_BITS   32
+  typedef uint32_t PriorityWordType;
+
+  /**
+  * \struct PriorityType
+  * Priority list with more than 32 priorities
+  */
+  typedef struct
+  {
+    PriorityWordType Group;                         ///< One bit per group with at least one priority in the list
+    PriorityWordType Bits[OS_PRIORITY_GROUPS];      ///< Priorities of each group
+  } PriorityType;
+#else
 #if (NUMBER_OF_PRIORITIES > 16)
   #define configMAX_TASK_INSTALL  32                 ///< Defines the maximum number of tasks that can be installed
   #define configMAX_TASK_PRIORITY 31  
@@ -214,6 +372,29 @@
     typedef uint8_t PriorityType;
   #endif
 #endif
+  #define OS_PRIORITY_WORD_BITS   (configMAX_TASK_PRIORITY + 1)
+  typedef PriorityType PriorityWordType;
+#endif
+
+/// Priority list operations - ready list, blocked list and event wait lists
+#if (NUMBER_OF_PRIORITIES > 32)
+#define OSPrioSet(List, Prio)        do { (List).Bits[(Prio) >> 5] |= PriorityMask[(Prio) & 31]; (List).Group |= PriorityMask[(Prio) >> 5]; } while(0)
+#define OSPrioClear(List, Prio)      do { (List).Bits[(Prio) >> 5] &= ~(PriorityMask[(Prio) & 31]); if ((List).Bits[(Prio) >> 5] == 0) (List).Group &= ~(PriorityMask[(Prio) >> 5]); } while(0)
+#define OSPrioIsSet(List, Prio)      (((List).Bits[(Prio) >> 5] & PriorityMask[(Prio) & 31]) != 0)
+#define OSPrioIsEmpty(List)          ((List).Group == 0)
+#define OSPrioHighest(List)          OSPriorityHighest(&(List))
+#define OSPrioReset(List)            OSPriorityReset(&(List))
+#else
+#define OSPrioSet(List, Prio)        (List) = (List) | (PriorityMask[(Prio)])
+#define OSPrioClear(List, Prio)      (List) = (List) & ~(PriorityMask[(Prio)])
+#define OSPrioIsSet(List, Prio)      (((List) & PriorityMask[(Prio)]) != 0)
+#define OSPrioIsEmpty(List)          ((List) == 0)
+#define OSPrioHighest(List)          SAScheduler(List)
+#define OSPrioReset(List)            (List) = 0
+#endif
+
+/// Number of words of the task control block allocation bitmap
+#define OS_TASK_ALLOC_SIZE           ((NUMBER_OF_TASKS + 31) / 32)
 
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
@@ -230,6 +411,81 @@
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 
+/// Types of the events of OSPendMultiple
+#define OS_PEND_SEM                  (uint8_t)0     ///< Semaphore - OSPendData is not used
+#define OS_PEND_MBOX                 (uint8_t)1     ///< Mailbox - OSPendData is a (void **) that receives the message
+#define OS_PEND_QUEUE                (uint8_t)2     ///< Queue - OSPendData is a (uint8_t *) that receives the entry
+#define OS_PEND_DQUEUE               (uint8_t)3     ///< Dynamic queue - OSPendData receives the entry
+
+/// Task notification actions
+#define OS_NOTIFY_NO_ACTION          (uint8_t)0     ///< Only notifies the task
+#define OS_NOTIFY_SET_BITS           (uint8_t)1     ///< ORs the value into the notification value
+#define OS_NOTIFY_INCREMENT          (uint8_t)2     ///< Increments the notification value - the value is not used
+#define OS_NOTIFY_OVERWRITE          (uint8_t)3     ///< Writes the value, even if the last notification is pending
+#define OS_NOTIFY_NO_OVERWRITE       (uint8_t)4     ///< Writes the value, unless the last notification is pending
+
+/// Task notification states
+#define OS_NOTIFY_IDLE               (uint8_t)0     ///< No notification pending
+#define OS_NOTIFY_WAITING            (uint8_t)1     ///< Task waiting for a notification
+#define OS_NOTIFY_PENDING            (uint8_t)2     ///< Notification not yet received by the task
+
+/**
+* \struct OS_PEND_EVENT
+* Event of a wait for multiple events
+*/
+typedef struct
+{
+  void      *OSPendEvent;             ///< Semaphore, mailbox or queue control block
+  uint8_t   OSPendType;               ///< Type of the event
+  void      *OSPendData;              ///< Where the message or queue entry is copied to
+} OS_PEND_EVENT;
+
+/**
+* \struct OS_TASK_STATS
+* Scheduling statistics of a task (BRTOS_TASK_STATS_EN == 1)
+* The times are in units of the runtime counter (OSGetTimerForRuntimeStats)
+*/
+typedef struct
+{
+  uint64_t  runtime;                  ///< Execution time
+  uint32_t  switches;                 ///< Number of times the task was switched in
+  uint32_t  preemptions;              ///< Number of times the task was switched out while ready
+  uint32_t  wakeups;                  ///< Number of wake up latency samples
+  uint32_t  latency_min;              ///< Minimum time from the wake up to the switch in
+  uint32_t  latency_max;              ///< Maximum time from the wake up to the switch in
+  uint64_t  latency_total;            ///< Sum of the latencies, for the mean latency
+  uint32_t  latency_hist[BRTOS_LATENCY_HIST_SIZE]; ///< Latency histogram (BRTOS_LATENCY_HIST_SHIFT)
+  uint32_t  overruns;                 ///< Number of periods of OSDelayUntil missed by the task
+} OS_TASK_STATS;
+
+/**
+* \struct OS_EDF_STATS
+* Parameters and deadline statistics of an EDF task (BRTOS_EDF_EN == 1)
+*/
+typedef struct
+{
+  ostick_t  period;                   ///< Period, in ticks
+  ostick_t  deadline;                 ///< Relative deadline, in ticks
+  ostick_t  wcet;                     ///< Worst case execution time declared for the admission control
+  ostick_t  abs_deadline;             ///< Absolute deadline of the current job (tick count)
+  uint32_t  jobs;                     ///< Number of completed jobs
+  uint32_t  misses;                   ///< Jobs completed after the deadline and jobs not released
+} OS_EDF_STATS;
+
+/**
+* \struct OS_BUDGET_STATS
+* CPU budget of a task (BRTOS_BUDGET_EN == 1)
+* The budget and the execution time are in units of the runtime counter (OSGetTimerForRuntimeStats)
+*/
+typedef struct
+{
+  uint32_t  budget;                   ///< Execution time allowed in each period
+  ostick_t  period;                   ///< Replenishment period, in ticks
+  uint32_t  used;                     ///< Execution time in the current period
+  uint32_t  overruns;                 ///< Number of periods in which the budget was exhausted
+  uint8_t   exhausted;                ///< TRUE while the task is blocked or demoted by its budget
+} OS_BUDGET_STATS;
+
 /**
 * \struct ContextType
 * Context Task Structure
@@ -250,6 +506,10 @@ struct Context
 #endif
 #if (COMPUTES_TASK_LOAD == 1)
    uint32_t Runtime;
+#endif
+#if (BRTOS_TASK_STATS_EN == 1)
+   uint32_t ReadyTime;        ///< Runtime counter at the last wake up
+   uint8_t  Waking;           ///< Woken and not yet switched in
 #endif
    ostick_t TimeToWait;     ///< Time to wait - could be used by delay or timeout
   #if (VERBOSE == 1)
@@ -258,6 +518,55 @@ struct Context
    uint8_t  SuspendedType;    ///< Task suspended type
   #endif
    uint8_t  Priority;         ///< Task priority
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+   void     *WaitEvent;       ///< Event that the task is waiting for
+   uint32_t Slices;           ///< Number of expired time slices
+   uint16_t WaitOrder;        ///< Arrival order in the event wait list
+   uint8_t  RunState;         ///< Ready list state flags
+   uint8_t  PrioNext;         ///< Next task installed with the same priority
+   uint8_t  ReadyNext;        ///< Next task in the priority ready list
+   uint8_t  ReadyPrev;        ///< Previous task in the priority ready list
+   PriorityType *WaitList;    ///< Wait list of the event that the task is waiting for
+   uint8_t  InheritBase;      ///< Priority before the mutex priority inheritance - EMPTY_PRIO if not inherited
+  #endif
+  #if (BRTOS_EVENT_GROUP_EN == 1)
+   osflags_t WaitFlags;       ///< Event group flags that the task is waiting for - the flags that woke up the task
+   uint8_t  WaitFlagsOptions; ///< Event group wait options
+  #endif
+  #if (BRTOS_PEND_MULTIPLE_EN == 1)
+   OS_PEND_EVENT *WaitMultiple; ///< Events of OSPendMultiple - NULL while the task is not waiting for them
+   uint8_t  WaitMultipleCount;  ///< Number of events of OSPendMultiple
+   uint8_t  WaitMultipleIndex;  ///< Index of the event that woke up the task
+  #endif
+  #if (BRTOS_TASK_NOTIFY_EN == 1)
+   uint32_t NotifyValue;      ///< Task notification value
+   uint8_t  NotifyState;      ///< Task notification state
+  #endif
+  #if (BRTOS_MEMPOOL_EN == 1)
+   void     *WaitBlock;       ///< Memory pool block given to the task by a block release
+  #endif
+  #if (BRTOS_STACK_CHECK_EN == 1)
+   uint32_t *StackGuard;      ///< Guard word at the end of the task stack - NULL if not verified
+  #endif
+  #if (BRTOS_EDF_EN == 1)
+   ostick_t EDFPeriod;        ///< Period of the EDF task - 0 if the task is not scheduled by deadline
+   ostick_t EDFDeadline;      ///< Relative deadline of the EDF task
+   ostick_t EDFWcet;          ///< Worst case execution time of the EDF task
+   ostick_t EDFRelease;       ///< Release time of the current job
+   ostick_t EDFAbsDeadline;   ///< Absolute deadline of the current job - order of the EDF ready list
+   uint32_t EDFJobs;          ///< Number of completed jobs
+   uint32_t EDFMisses;        ///< Number of missed deadlines
+  #endif
+  #if (BRTOS_BUDGET_EN == 1)
+   uint32_t Budget;           ///< Execution time allowed in each period - 0 if the task has no budget
+   uint32_t BudgetStart;      ///< Runtime of the task at the last replenishment
+   uint32_t BudgetOverruns;   ///< Number of periods in which the budget was exhausted
+   ostick_t BudgetPeriod;     ///< Replenishment period, in ticks
+   ostick_t BudgetRelease;    ///< Tick count of the last replenishment
+   uint8_t  BudgetPriority;   ///< Priority of the task while the budget is exhausted - 0 blocks the task
+   uint8_t  BudgetBase;       ///< Priority of the task before the demotion
+   uint8_t  BudgetState;      ///< Enforcement state of the budget
+  #endif
    struct Context *Next;
    struct Context *Previous;
 };
@@ -319,9 +628,15 @@ typedef struct {
   uint8_t        OSMaxPriority;                 ///< Defines max priority accessing resource
   uint8_t        OSOriginalPriority;            ///< Save original priority of Mutex owner task - used to the priority ceiling implementation
   uint8_t        OSEventWait;                   ///< Counter of waiting Tasks
+  uint8_t        OSEventNesting;                ///< Number of acquires of the owner - used by the recursive mutex
+  uint8_t        OSMutexOptions;                ///< Mutex options - OS_MUTEX_INHERIT and OS_MUTEX_RECURSIVE
   PriorityType OSEventWaitList;               ///< Task wait list for event to occur
 } BRTOS_Mutex;
 
+/// Mutex options
+#define OS_MUTEX_INHERIT             (uint8_t)0x01  ///< Priority inheritance - requires BRTOS_ROUND_ROBIN_EN
+#define OS_MUTEX_RECURSIVE           (uint8_t)0x02  ///< Each acquire of the owner needs a release
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
@@ -432,6 +747,8 @@ typedef struct
   uint16_t       OSQTSize;                ///< Size of the queue type - Defined in the create queue function
   uint16_t       OSQLength;               ///< Length of the queue - Defined in the create queue function
   uint16_t       OSQEntries;              ///< Size of data inside the queue
+  uint8_t        OSQReserved;             ///< Entry reserved by OSDQueueReserve and not committed yet
+  uint8_t        OSQPeeked;               ///< Entry read by OSDQueuePeek and not released yet
 } OS_DQUEUE;
 
 ////////////////////////////////////////////////////////////
@@ -500,6 +817,74 @@ typedef struct
 
 
 
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////    Event Group Control Block Structure           /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+/// Event group wait options
+#define OS_FLAGS_WAIT_ANY            (uint8_t)0x00  ///< Waits for any of the flags
+#define OS_FLAGS_WAIT_ALL            (uint8_t)0x01  ///< Waits for all the flags
+#define OS_FLAGS_CLEAR_ON_EXIT       (uint8_t)0x02  ///< Clears the waited flags when the wait is satisfied
+
+/**
+* \struct BRTOS_EventGroup
+* Event Group Control Block Structure
+*/
+typedef struct {
+  uint8_t        OSEventAllocated;              ///< Indicate if the event is allocated or not
+  uint8_t        OSEventWait;                   ///< Counter of waiting Tasks
+  osflags_t      OSEventFlags;                  ///< Current state of the flags
+  PriorityType   OSEventWaitList;               ///< Task wait list for event to occur
+} BRTOS_EventGroup;
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////    Memory Pool Control Block Structure           /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+/// Declares the memory of a pool of "blocks" blocks of "size" bytes, aligned to a pointer
+#define OS_MEMPOOL_STORAGE(name, size, blocks)  void *name[(((size) + sizeof(void*) - 1) / sizeof(void*)) * (blocks)]
+
+/**
+* \struct BRTOS_MemPool
+* Memory Pool Control Block Structure
+* The free blocks are linked through their first word, so allocation and release are O(1)
+*/
+typedef struct {
+  uint8_t        OSEventAllocated;              ///< Indicate if the event is allocated or not
+  uint8_t        OSEventWait;                   ///< Counter of waiting Tasks
+  void           *OSFreeList;                   ///< First free block
+  uint8_t        *OSPoolStart;                  ///< Pointer to the first block
+  uint8_t        *OSPoolEnd;                    ///< Pointer to the end of the last block
+  uint16_t       OSBlockSize;                   ///< Size of the blocks, rounded up to a multiple of a pointer
+  uint16_t       OSBlocks;                      ///< Number of blocks
+  uint16_t       OSFreeBlocks;                  ///< Number of free blocks
+  uint16_t       OSMinFreeBlocks;               ///< Minimum number of free blocks (high water mark of the used blocks)
+  uint16_t       OSAllocFails;                  ///< Number of gets that found no free block
+  PriorityType   OSEventWaitList;               ///< Task wait list for event to occur
+} BRTOS_MemPool;
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 /////      Functions Prototypes                        /////
@@ -539,6 +924,25 @@ typedef struct
 uint8_t OSUninstallTask(BRTOS_TH TaskHandle, OS_CPU_TYPE safety_off);
 #define UninstallTask OSUninstallTask
 
+#if (BRTOS_TASK_STATS_EN == 1)
+/*****************************************************************************************//**
+* \fn uint8_t OSGetTaskStats(BRTOS_TH task, OS_TASK_STATS *stats)
+* \brief Copies the scheduling statistics of a task
+*  The statistics of a task are cleared by its installation.
+* \param task The task handle id
+* \param stats Pointer to the statistics copy
+* \return OK Success
+* \return NOT_VALID_TASK Not valid task id
+*********************************************************************************************/
+uint8_t OSGetTaskStats(BRTOS_TH task, OS_TASK_STATS *stats);
+
+/*****************************************************************************************//**
+* \fn void OSResetTaskStats(void)
+* \brief Clears the scheduling statistics of every task
+*********************************************************************************************/
+void OSResetTaskStats(void);
+#endif
+
 /*****************************************************************************************//**
 * \fn void Idle(void)
 * \brief Idle Task. May be used to implement low power commands.
@@ -569,6 +973,31 @@ void BRTOS_TimerHook(void);
 void IdleHook(void);
 #endif
 
+/*****************************************************************************************//**
+* \fn void BRTOS_StackOverflowHook(BRTOS_TH task)
+* \brief Provide to the user a function called when a task stack overflow is detected
+*  Called from the context switch interrupt when the guard word at the end of the stack
+*  of the task being switched out was overwritten. The guard word is written again, so
+*  the hook can not use kernel services and usually records the fault and resets the system.
+* \param task Handle of the task that overflowed its stack
+* \return NONE
+*********************************************************************************************/
+#if (BRTOS_STACK_CHECK_EN == 1)
+void BRTOS_StackOverflowHook(BRTOS_TH task);
+#endif
+
+/*****************************************************************************************//**
+* \fn void BRTOS_BudgetOverrunHook(BRTOS_TH task)
+* \brief Provide to the user a function called when a task exhausts its CPU budget
+*  Called from the tick interrupt, after the task was blocked or demoted. The hook can
+*  only use the kernel services allowed in interrupt handlers.
+* \param task Handle of the task that exhausted its budget
+* \return NONE
+*********************************************************************************************/
+#if (BRTOS_BUDGET_EN == 1)
+void BRTOS_BudgetOverrunHook(BRTOS_TH task);
+#endif
+
 /**************************************************************************//**
 * \fn void OS_TICK_HANDLER(void)
 * \brief Tick timer interrupt handler routine (Internal kernel function).
@@ -627,6 +1056,139 @@ uint8_t OSDelayTask(ostick_t time_wait);
 uint8_t OSDelayTaskHMSM(uint8_t hours, uint8_t minutes, uint8_t seconds, uint16_t miliseconds);
 #define DelayTaskHMSM OSDelayTaskHMSM
 
+/*****************************************************************************************//**
+* \fn uint8_t OSDelayUntil(ostick_t *last_wake, ostick_t period)
+* \brief Wait until an absolute tick count, for periodic tasks without drift.
+*  The task wakes up at *last_wake + period, which is written back to *last_wake.
+*  The wake up time does not depend on the execution time of the task.
+*  Initialize *last_wake with OSGetTickCount before the first call.
+*  If the wake up time was already reached, the task does not wait: *last_wake is
+*  advanced by whole periods to the last wake up time before the current tick, so
+*  the phase of the next periods is kept, and the missed periods are counted in
+*  the task statistics (BRTOS_TASK_STATS_EN).
+*  The time from *last_wake to the call must be shorter than the tick counter overflow.
+* \param last_wake Wake up time of the last period, updated by the call
+* \param period Period in ticks, smaller than TICK_COUNT_OVERFLOW
+* \return OK Success
+* \return DELAY_OVERRUN The wake up time was already reached, the task did not wait
+* \return NO_TASK_DELAY The period is zero
+* \return INVALID_TIME The period is not smaller than the tick counter overflow
+* \return IRQ_PEND_ERR - Can not use block priority function from interrupt handler code
+*********************************************************************************************/
+uint8_t OSDelayUntil(ostick_t *last_wake, ostick_t period);
+
+#if (BRTOS_TICK64_EN == 1)
+/*****************************************************************************************//**
+* \fn uint8_t OSDelayUntil64(uint64_t *last_wake, uint64_t period)
+* \brief Wait until an absolute 64 bit tick count (OSGetTickCount64).
+*  As OSDelayUntil, without the limit of the tick counter overflow on the period.
+*  Waits longer than the delay list range are split by the kernel, each part is
+*  computed from the absolute wake up time, so no error is accumulated.
+* \param last_wake Wake up time of the last period, updated by the call
+* \param period Period in ticks
+* \return OK Success
+* \return DELAY_OVERRUN The wake up time was already reached, the task did not wait
+* \return NO_TASK_DELAY The period is zero
+* \return IRQ_PEND_ERR - Can not use block priority function from interrupt handler code
+*********************************************************************************************/
+uint8_t OSDelayUntil64(uint64_t *last_wake, uint64_t period);
+
+/*****************************************************************************************//**
+* \fn uint64_t OSGetTickCount64(void)
+* \brief Return the number of ticks since the start of the kernel.
+*  Monotonic count of 64 bits, without the overflow of OSGetTickCount.
+* \return current 64 bit tick count
+*********************************************************************************************/
+uint64_t OSGetTickCount64(void);
+#endif
+
+#if (BRTOS_EDF_EN == 1)
+/*****************************************************************************************//**
+* \fn uint8_t OSEDFTaskSet(BRTOS_TH task, ostick_t period, ostick_t deadline, ostick_t wcet)
+* \brief Schedules a task by earliest deadline first.
+*  The task must be installed with the priority BRTOS_EDF_PRIORITY, the ready tasks of
+*  this priority run in the order of their absolute deadlines. The tasks of higher
+*  priorities preempt the EDF tasks.
+*  Admission control: the sum of wcet / min(period, deadline) of the EDF tasks must
+*  not exceed BRTOS_EDF_MAX_UTILIZATION. The first job is released at the call.
+*  Call it after the installation of the task, before the task runs.
+* \param task Handle of the task
+* \param period Period in ticks, smaller than half of the tick counter overflow
+* \param deadline Deadline relative to the release of each job, not greater than the period
+* \param wcet Worst case execution time of a job, in ticks
+* \return OK Success
+* \return EDF_NOT_ADMITTED The utilization of the EDF tasks would exceed the limit
+* \return INVALID_PARAMETERS The task does not have the EDF priority or the times are not valid
+* \return NOT_VALID_TASK The task is not installed
+*********************************************************************************************/
+uint8_t OSEDFTaskSet(BRTOS_TH task, ostick_t period, ostick_t deadline, ostick_t wcet);
+
+/*****************************************************************************************//**
+* \fn uint8_t OSEDFWaitNextPeriod(void)
+* \brief Completes the current job of an EDF task and waits for the release of the next one.
+*  The deadline is missed if the job completes after its absolute deadline. If the next
+*  release time was already reached, the task does not wait, the releases that were
+*  reached are skipped (missed too) and the task runs the job of the last one.
+* \return OK The job completed in time
+* \return DEADLINE_MISSED The job completed after its deadline or releases were skipped
+* \return NOT_VALID_TASK The current task is not an EDF task
+* \return IRQ_PEND_ERR - Can not use block priority function from interrupt handler code
+*********************************************************************************************/
+uint8_t OSEDFWaitNextPeriod(void);
+
+/*****************************************************************************************//**
+* \fn uint8_t OSEDFGetStats(BRTOS_TH task, OS_EDF_STATS *stats)
+* \brief Copies the parameters and the deadline statistics of an EDF task.
+* \param task Handle of the task
+* \param stats Receives the parameters and the statistics
+* \return OK Success
+* \return NOT_VALID_TASK The task is not an EDF task
+*********************************************************************************************/
+uint8_t OSEDFGetStats(BRTOS_TH task, OS_EDF_STATS *stats);
+
+/*****************************************************************************************//**
+* \fn uint16_t OSEDFUtilization(void)
+* \brief Utilization admitted for the EDF tasks, in hundredths of percent.
+* \return Sum of wcet / min(period, deadline) of the EDF tasks (10000 = 100%)
+*********************************************************************************************/
+uint16_t OSEDFUtilization(void);
+#endif
+
+#if (BRTOS_BUDGET_EN == 1)
+/*****************************************************************************************//**
+* \fn uint8_t OSTaskBudgetSet(BRTOS_TH task, uint32_t budget, ostick_t period, uint8_t priority)
+* \brief Limits the execution time of a task in each period.
+*  The execution time is measured by the runtime counter of COMPUTES_TASK_LOAD and verified
+*  at each tick. When the task exhausts its budget, BRTOS_BudgetOverrunHook is called and
+*  the task is blocked or runs with a lower priority until the next replenishment. The
+*  whole budget is replenished at each period, the unused budget is not kept.
+*  The budget is not enforced while the task owns a mutex, the task is blocked or demoted
+*  at the first tick after the release of the mutex.
+*  The first period starts at the call.
+* \param task Handle of the task
+* \param budget Execution time allowed in each period, in units of the runtime counter -
+*  0 removes the budget of the task
+* \param period Replenishment period in ticks, smaller than half of the tick counter overflow
+* \param priority Priority of the task while its budget is exhausted, lower than the task
+*  priority - 0 blocks the task. Only 0 without BRTOS_ROUND_ROBIN_EN, because the other
+*  priorities have their own tasks
+* \return OK Success
+* \return INVALID_PARAMETERS The period or the priority are not valid
+* \return NOT_VALID_TASK The task is not installed or is the idle task
+*********************************************************************************************/
+uint8_t OSTaskBudgetSet(BRTOS_TH task, uint32_t budget, ostick_t period, uint8_t priority);
+
+/*****************************************************************************************//**
+* \fn uint8_t OSTaskBudgetGetStats(BRTOS_TH task, OS_BUDGET_STATS *stats)
+* \brief Copies the budget, the execution time in the current period and the overruns of a task.
+* \param task Handle of the task
+* \param stats Receives the budget statistics
+* \return OK Success
+* \return NOT_VALID_TASK The task has no budget
+*********************************************************************************************/
+uint8_t OSTaskBudgetGetStats(BRTOS_TH task, OS_BUDGET_STATS *stats);
+#endif
+
 /*****************************************************************************************//**
 * \fn ostick_t OSGetTickCount(void)
 * \brief Return current tick count.
@@ -654,6 +1216,181 @@ void OSIncCounter(ostick_t inc);
 void OSIncCounter(void);
 #endif
 
+/*****************************************************************************************//**
+* \fn void OSDelayListInsert(ContextType *Task)
+* \brief Includes a task into the delay list (Internal kernel function).
+*  The list is kept sorted by the task wake up time (TimeToWait), so the tick handler
+*  only verifies the head of the list. Must be called inside a critical section.
+* \param *Task Task to be included into the delay list. TimeToWait must be already set.
+* \return NONE
+*********************************************************************************************/
+void OSDelayListInsert(ContextType *Task);
+
+#if (TICKLESS == 1)
+/*****************************************************************************************//**
+* \fn ostick_t OSTicklessIdleTime(ostick_t max_ticks)
+* \brief Number of ticks that the tick interrupt can be suppressed (Internal kernel function).
+*  Computed from the earliest deadline of the delay list, which includes the soft timers.
+*  Must be called by the idle task inside a critical section.
+* \param max_ticks Maximum number of ticks supported by the tick timer
+* \return Number of idle ticks, or zero if the tick interrupt must not be suppressed
+*********************************************************************************************/
+ostick_t OSTicklessIdleTime(ostick_t max_ticks);
+
+/*****************************************************************************************//**
+* \fn void OSTicklessCompensate(ostick_t ticks)
+* \brief Updates the tick counter and the delay list after a tickless idle period (Internal kernel function).
+*  Must be called inside a critical section.
+* \param ticks Number of ticks elapsed while the tick interrupt was suppressed
+* \return NONE
+*********************************************************************************************/
+void OSTicklessCompensate(ostick_t ticks);
+#endif
+
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+/// Ready list state flags of the tasks (round-robin mode)
+#define TASK_READY_FLAG              (uint8_t)0x01
+#define TASK_BLOCKED_FLAG            (uint8_t)0x02
+
+/*****************************************************************************************//**
+* \fn void OSReadyListInsert(ContextType *Task)
+* \brief Puts a task into the ready list (Internal kernel function).
+*  The task is placed at the end of the FIFO list of its priority. Must be called inside a critical section.
+* \param *Task Task to be included into the ready list
+* \return NONE
+*********************************************************************************************/
+void OSReadyListInsert(ContextType *Task);
+
+/*****************************************************************************************//**
+* \fn void OSReadyListRemove(ContextType *Task)
+* \brief Removes a task from the ready list (Internal kernel function).
+*  Must be called inside a critical section.
+* \param *Task Task to be removed from the ready list
+* \return NONE
+*********************************************************************************************/
+void OSReadyListRemove(ContextType *Task);
+
+/*****************************************************************************************//**
+* \fn void OSBlockedListInsert(ContextType *Task)
+* \brief Blocks a task (Internal kernel function).
+*  A blocked task is not scheduled, even if it is ready. Must be called inside a critical section.
+* \param *Task Task to be blocked
+* \return NONE
+*********************************************************************************************/
+void OSBlockedListInsert(ContextType *Task);
+
+/*****************************************************************************************//**
+* \fn void OSBlockedListRemove(ContextType *Task)
+* \brief Unblocks a task (Internal kernel function).
+*  Must be called inside a critical section.
+* \param *Task Task to be unblocked
+* \return NONE
+*********************************************************************************************/
+void OSBlockedListRemove(ContextType *Task);
+
+#define OSIsTaskReady(Task)          (((Task)->RunState & TASK_READY_FLAG) != 0)
+#define OSIsTaskBlocked(Task)        (((Task)->RunState & TASK_BLOCKED_FLAG) != 0)
+
+/*****************************************************************************************//**
+* \fn void OSEventWaitListInsert(PriorityType *WaitList, void *Event, ContextType *Task)
+* \brief Includes a task into the wait list of an event (Internal kernel function).
+*  The tasks of the same priority receive the event in the arrival order.
+*  Must be called inside a critical section.
+* \param *WaitList Event wait list
+* \param *Event Event control block
+* \param *Task Task that will wait for the event
+* \return NONE
+*********************************************************************************************/
+void OSEventWaitListInsert(PriorityType *WaitList, void *Event, ContextType *Task);
+
+/*****************************************************************************************//**
+* \fn void OSEventWaitListRemove(PriorityType *WaitList, void *Event, ContextType *Task)
+* \brief Removes a task from the wait list of an event (Internal kernel function).
+*  Must be called inside a critical section.
+* \param *WaitList Event wait list
+* \param *Event Event control block
+* \param *Task Task to be removed from the wait list
+* \return NONE
+*********************************************************************************************/
+void OSEventWaitListRemove(PriorityType *WaitList, void *Event, ContextType *Task);
+
+#if (BRTOS_PEND_MULTIPLE_EN == 1)
+#define OSTaskWaitsFor(Task, Event)  (((Task)->WaitEvent == (void*)(Event)) || (((Task)->WaitMultiple != NULL) && OSPendMultipleHas((Task), (Event))))
+#else
+#define OSTaskWaitsFor(Task, Event)  ((Task)->WaitEvent == (void*)(Event))
+#endif
+#define OSEventWaitListHas(WaitList, Event, Task)    OSTaskWaitsFor((Task), (Event))
+#else
+#if (BRTOS_TASK_STATS_EN == 1)
+#define OSReadyListInsert(Task)      do { if (!OSIsTaskReady(Task)) OSTaskStatsReady(Task); OSPrioSet(OSReadyList, (Task)->Priority); } while(0)
+#else
+#define OSReadyListInsert(Task)      OSPrioSet(OSReadyList, (Task)->Priority)
+#endif
+#define OSReadyListRemove(Task)      OSPrioClear(OSReadyList, (Task)->Priority)
+#define OSBlockedListInsert(Task)    OSPrioClear(OSBlockedList, (Task)->Priority)
+#define OSBlockedListRemove(Task)    OSPrioSet(OSBlockedList, (Task)->Priority)
+#define OSIsTaskReady(Task)          OSPrioIsSet(OSReadyList, (Task)->Priority)
+#define OSIsTaskBlocked(Task)        (!OSPrioIsSet(OSBlockedList, (Task)->Priority))
+#define OSEventWaitListInsert(WaitList, Event, Task) OSPrioSet(*(WaitList), (Task)->Priority)
+#define OSEventWaitListRemove(WaitList, Event, Task) OSPrioClear(*(WaitList), (Task)->Priority)
+#define OSEventWaitListHas(WaitList, Event, Task)    OSPrioIsSet(*(WaitList), (Task)->Priority)
+#endif
+
+/*****************************************************************************************//**
+* \fn uint8_t OSEventWaitListSelect(PriorityType *WaitList, void *Event)
+* \brief Selects the highest priority task of an event wait list (Internal kernel function).
+*  The selected task is removed from the wait list. Must be called inside a critical section,
+*  with at least one task waiting for the event.
+* \param *WaitList Event wait list
+* \param *Event Event control block
+* \return Task number of the selected task
+*********************************************************************************************/
+uint8_t OSEventWaitListSelect(PriorityType *WaitList, void *Event);
+
+#if (BRTOS_PEND_MULTIPLE_EN == 1)
+/*****************************************************************************************//**
+* \fn uint8_t OSPendMultipleHas(ContextType *Task, void *Event)
+* \brief Verifies if a task waits for an event in OSPendMultiple (Internal kernel function).
+* \param *Task Task waiting for multiple events
+* \param *Event Event control block
+* \return TRUE if the event is one of the events of the task
+*********************************************************************************************/
+uint8_t OSPendMultipleHas(ContextType *Task, void *Event);
+
+/*****************************************************************************************//**
+* \fn void OSPendMultipleSelect(ContextType *Task, void *Event)
+* \brief Called when an event selects a task waiting for multiple events (Internal kernel function).
+*  Saves the index of the event and removes the task from the wait list of the other events.
+*  Must be called inside a critical section.
+* \param *Task Selected task
+* \param *Event Event that selected the task
+* \return NONE
+*********************************************************************************************/
+void OSPendMultipleSelect(ContextType *Task, void *Event);
+
+/*****************************************************************************************//**
+* \fn void OSPendMultipleInsert(ContextType *Task, OS_PEND_EVENT *events, uint8_t count)
+* \brief Includes a task into the wait list of every event of OSPendMultiple (Internal kernel function).
+*  Must be called inside a critical section.
+* \param *Task Task that will wait for the events
+* \param *events Array of events
+* \param count Number of events
+* \return NONE
+*********************************************************************************************/
+void OSPendMultipleInsert(ContextType *Task, OS_PEND_EVENT *events, uint8_t count);
+#endif
+
+/*****************************************************************************************//**
+* \fn void OSSetTaskPriority(uint8_t TaskNumber, uint8_t iPriority)
+* \brief Changes the priority of a task (Internal kernel function).
+*  Used by the mutex priority ceiling and priority inheritance. With round-robin, a task that waits
+*  for an event keeps waiting for it with the new priority. Must be called inside a critical section.
+* \param TaskNumber Task to be changed
+* \param iPriority New priority of the task
+* \return NONE
+*********************************************************************************************/
+void OSSetTaskPriority(uint8_t TaskNumber, uint8_t iPriority);
+
 /*****************************************************************************************//**
 * \fn void PreInstallTasks(void)
 * \brief Function that initialize the kernel main variables.
@@ -666,6 +1403,7 @@ void PreInstallTasks(void);
 * \fn uint8_t OSBlockPriority(uint8_t iPriority)
 * \brief Blocks a specific priority
 *  Blocks the task that is associated with the specified priority.
+*  If BRTOS_ROUND_ROBIN_EN is active, every task of the priority is blocked.
 *  The user must be careful when using this function in together with mutexes.
 *  This can lead to undesired results due the "cealing priority" property used in the mutex.
 * \param iPriority Priority to be blocked
@@ -679,6 +1417,7 @@ uint8_t OSBlockPriority(uint8_t iPriority);
 * \fn uint8_t OSUnBlockPriority(uint8_t iPriority)
 * \brief UnBlock a specific priority
 *  UnBlocks the task that is associated with the specified priority.
+*  If BRTOS_ROUND_ROBIN_EN is active, every task of the priority is unblocked.
 *  The user must be careful when using this function in together with mutexes.
 *  This can lead to undesired results due the "cealing priority" property used in the mutex.
 * \param iPriority Priority to be unblocked
@@ -743,12 +1482,60 @@ void BRTOSInit(void);
 uint8_t OSSchedule(void);
 
 /*****************************************************************//**
-* \fn uint8_t SAScheduler(PriorityType ReadyList)
+* \fn void OSStackCheck(void)
+* \brief Verifies the guard word at the end of the current task stack (Internal kernel function).
+*  Called by the context switch before the current task is switched out.
+*********************************************************************/
+#if (BRTOS_STACK_CHECK_EN == 1)
+void OSStackCheck(void);
+#endif
+
+/*****************************************************************//**
+* \fn void OSTaskStatsReady(ContextType *Task)
+* \brief Records the wake up time of a task (Internal kernel function).
+*  Called when the task is put into the ready list, inside a critical section.
+*********************************************************************/
+#if (BRTOS_TASK_STATS_EN == 1)
+void OSTaskStatsReady(ContextType *Task);
+#endif
+
+// Runtime counter provided by the application, either as functions or as macros of the port
+#if (COMPUTES_TASK_LOAD == 1)
+#ifndef OSGetTimerForRuntimeStats
+uint32_t OSGetTimerForRuntimeStats(void);
+#endif
+#ifndef OSConfigureTimerForRuntimeStats
+void OSConfigureTimerForRuntimeStats(void);
+#endif
+#endif
+
+/*****************************************************************//**
+* \fn uint8_t SAScheduler(PriorityWordType ReadyList)
 * \brief Sucessive Aproximation Scheduler (Internal kernel function).
+*  With more than 32 priorities, it is used for each word of the two level bitmap.
 * \param ReadyList List of the tasks ready to run
 * \return The priority of the highest priority task ready to run
 *********************************************************************/
-uint8_t SAScheduler(PriorityType ReadyList);
+uint8_t SAScheduler(PriorityWordType ReadyList);
+
+#if (NUMBER_OF_PRIORITIES > 32)
+/*****************************************************************//**
+* \fn uint8_t OSPriorityHighest(const PriorityType *List)
+* \brief Highest priority of a two level priority list (Internal kernel function).
+*  The group word is searched first and then the word of the group.
+* \param *List Priority list, must not be empty
+* \return The highest priority of the list
+*********************************************************************/
+uint8_t OSPriorityHighest(const PriorityType *List);
+
+/*****************************************************************//**
+* \fn void OSPriorityReset(PriorityType *List)
+* \brief Removes every priority of a two level priority list (Internal kernel function).
+* \param *List Priority list
+* \return NONE
+*********************************************************************/
+void OSPriorityReset(PriorityType *List);
+#endif
 
 
 
@@ -779,6 +1566,16 @@ uint8_t SAScheduler(PriorityType ReadyList);
   extern OS_QUEUE	 BRTOS_OS_QUEUE_Table[BRTOS_MAX_QUEUE];
 #endif
 
+#if (BRTOS_EVENT_GROUP_EN == 1)
+  /// Event Group Control Block
+  extern BRTOS_EventGroup BRTOS_EventGroup_Table[BRTOS_MAX_EVENT_GROUP];
+#endif
+
+#if (BRTOS_MEMPOOL_EN == 1)
+  /// Memory Pool Control Block
+  extern BRTOS_MemPool BRTOS_MemPool_Table[BRTOS_MAX_MEMPOOL];
+#endif
+
 
 /*****************************************************************************************//**
 * \fn void initEvents(void)
@@ -859,6 +1656,21 @@ void initEvents(void);
   * \return ALLOC_EVENT_OK Mutex control block successfully allocated
   *********************************************************************************************/
   uint8_t OSMutexCreate (BRTOS_Mutex **event, uint8_t HigherPriority);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSMutexCreateOptions (BRTOS_Mutex **event, uint8_t HigherPriority, uint8_t options)
+  * \brief Allocates a mutex control block with options
+  *  With OS_MUTEX_INHERIT no priority is reserved. The owner receives the priority of the
+  *  highest priority waiting task, following the chain of owners of nested mutexes.
+  * \param **event Address of the mutex control block pointer
+  * \param HigherPriority Priority ceiling, as in OSMutexCreate - must be 0 with OS_MUTEX_INHERIT
+  * \param options OS_MUTEX_INHERIT and/or OS_MUTEX_RECURSIVE
+  * \return IRQ_PEND_ERR Can not use mutex create function from interrupt handler code
+  * \return INVALID_PARAMETERS Priority ceiling used with priority inheritance, or inheritance without round-robin
+  * \return NO_AVAILABLE_EVENT No mutex control blocks available
+  * \return ALLOC_EVENT_OK Mutex control block successfully allocated
+  *********************************************************************************************/
+  uint8_t OSMutexCreateOptions (BRTOS_Mutex **event, uint8_t HigherPriority, uint8_t options);
   
   /*****************************************************************************************//**
   * \fn uint8_t OSMutexDelete (BRTOS_Mutex **event)
@@ -1202,6 +2014,283 @@ void initEvents(void);
   * \return
   *********************************************************************************************/
   uint8_t OSDQueuePost(BRTOS_Queue *pont_event, void *pdata);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSDQueuePendN (BRTOS_Queue *pont_event, void *pdata, uint16_t *count, ostick_t time_wait)
+  * \brief Wait for a queue post and read up to *count entries in one critical section
+  *  The task only waits while the queue is empty. The available entries are read, up to *count.
+  * \param *pont_event Queue event pointer
+  * \param *pdata Buffer for *count entries
+  * \param *count Number of entries to read. Returns the number of entries read
+  * \param timeout Timeout to the queue pend exits
+  * \return INVALID_PARAMETERS *count is zero
+  * \return ERR_EVENT_NO_CREATED The pont_event is not valid
+  * \return TIMEOUT The queue pend exit by timeout
+  * \return EXIT_BY_NO_ENTRY_AVAILABLE The queue is empty and NO_TIMEOUT was used
+  * \return READ_BUFFER_OK At least one entry was successfully read
+  *********************************************************************************************/
+  uint8_t OSDQueuePendN (BRTOS_Queue *pont_event, void *pdata, uint16_t *count, ostick_t time_wait);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSDQueuePostN(BRTOS_Queue *pont_event, void *pdata, uint16_t *count)
+  * \brief Write up to *count entries into the queue in one critical section
+  *  One waiting task is woken up for each new entry.
+  * \param *pont_event Queue event pointer
+  * \param *pdata Pointer of the *count entries to be written in the queue
+  * \param *count Number of entries to write. Returns the number of entries written
+  * \return INVALID_PARAMETERS *count is zero
+  * \return ERR_EVENT_NO_CREATED The pont_event is not valid
+  * \return BUFFER_UNDERRUN Queue overflow - Only *count entries were written
+  * \return WRITE_BUFFER_OK Every entry was successfully written
+  *********************************************************************************************/
+  uint8_t OSDQueuePostN(BRTOS_Queue *pont_event, void *pdata, uint16_t *count);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSDQueueReserve(BRTOS_Queue *pont_event, void **entry)
+  * \brief Reserves the next queue entry, to be written in place
+  *  The entry is only delivered to the consumers by OSDQueueCommit.
+  *  While an entry is reserved, OSDQueuePost returns BUFFER_UNDERRUN.
+  * \param *pont_event Queue event pointer
+  * \param **entry Returns the address of the reserved entry
+  * \return ERR_EVENT_NO_CREATED The pont_event is not valid
+  * \return BUSY_RESOURCE There is already a reserved entry
+  * \return BUFFER_UNDERRUN Queue overflow - There is no more available for new data
+  * \return WRITE_BUFFER_OK Entry successfully reserved
+  *********************************************************************************************/
+  uint8_t OSDQueueReserve(BRTOS_Queue *pont_event, void **entry);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSDQueueCommit(BRTOS_Queue *pont_event)
+  * \brief Posts the reserved entry
+  * \param *pont_event Queue event pointer
+  * \return INVALID_PARAMETERS There is no reserved entry
+  * \return WRITE_BUFFER_OK Entry successfully posted
+  *********************************************************************************************/
+  uint8_t OSDQueueCommit(BRTOS_Queue *pont_event);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSDQueuePeek(BRTOS_Queue *pont_event, void **entry, ostick_t time_wait)
+  * \brief Wait for a queue post and read the entry in place
+  *  The entry is removed from the queue, but its buffer is only reused after OSDQueueRelease.
+  * \param *pont_event Queue event pointer
+  * \param **entry Returns the address of the entry
+  * \param timeout Timeout to the queue peek exits
+  * \return ERR_EVENT_NO_CREATED The pont_event is not valid
+  * \return BUSY_RESOURCE There is already a peeked entry
+  * \return TIMEOUT The queue peek exit by timeout
+  * \return EXIT_BY_NO_ENTRY_AVAILABLE The queue is empty and NO_TIMEOUT was used
+  * \return READ_BUFFER_OK Entry successfully read
+  *********************************************************************************************/
+  uint8_t OSDQueuePeek(BRTOS_Queue *pont_event, void **entry, ostick_t time_wait);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSDQueueRelease(BRTOS_Queue *pont_event)
+  * \brief Releases the buffer of the peeked entry
+  * \param *pont_event Queue event pointer
+  * \return INVALID_PARAMETERS There is no peeked entry
+  * \return READ_BUFFER_OK Entry successfully released
+  *********************************************************************************************/
+  uint8_t OSDQueueRelease(BRTOS_Queue *pont_event);
+
+#if (BRTOS_PEND_MULTIPLE_EN == 1)
+  /*****************************************************************************************//**
+  * \fn uint8_t OSDQueueTake(BRTOS_Queue *pont_event, void *pdata)
+  * \brief Reads one entry of a dynamic queue, if available (Internal kernel function).
+  *  Must be called inside a critical section.
+  * \param *pont_event Queue event pointer
+  * \param *pdata Pointer to the data destination
+  * \return TRUE if an entry was read
+  *********************************************************************************************/
+  uint8_t OSDQueueTake(BRTOS_Queue *pont_event, void *pdata);
+#endif
+#endif
+
+#if (BRTOS_EVENT_GROUP_EN == 1)
+  /*****************************************************************************************//**
+  * \fn uint8_t OSEventGroupCreate(osflags_t flags, BRTOS_EventGroup **event)
+  * \brief Allocates an event group control block
+  * \param flags Initial state of the flags
+  * \param **event Address of the event group control block pointer
+  * \return IRQ_PEND_ERR Can not use event group create function from interrupt handler code
+  * \return NO_AVAILABLE_EVENT No event group control blocks available
+  * \return ALLOC_EVENT_OK Event group control block successfully allocated
+  *********************************************************************************************/
+  uint8_t OSEventGroupCreate(osflags_t flags, BRTOS_EventGroup **event);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSEventGroupDelete(BRTOS_EventGroup **event)
+  * \brief Releases an event group control block
+  * \param **event Address of the event group control block pointer
+  * \return IRQ_PEND_ERR Can not use event group delete function from interrupt handler code
+  * \return DELETE_EVENT_OK Event group control block released with success
+  *********************************************************************************************/
+  uint8_t OSEventGroupDelete(BRTOS_EventGroup **event);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSEventGroupWait(BRTOS_EventGroup *pont_event, osflags_t flags, uint8_t options, osflags_t *result, ostick_t time_wait)
+  * \brief Wait for any or all of the flags of an event group
+  * \param *pont_event Event group pointer
+  * \param flags Flags to wait for
+  * \param options OS_FLAGS_WAIT_ANY or OS_FLAGS_WAIT_ALL, optionally ORed with OS_FLAGS_CLEAR_ON_EXIT
+  * \param *result Returns the state of the flags that satisfied the wait, before the clear on exit - may be NULL
+  * \param time_wait Timeout to the event group wait exits
+  * \return OK Success
+  * \return TIMEOUT The flags were not set in the specified time
+  * \return EXIT_BY_NO_ENTRY_AVAILABLE The flags are not set and NO_TIMEOUT was used
+  * \return INVALID_PARAMETERS No flag to wait for
+  * \return IRQ_PEND_ERR Can not use event group wait function from interrupt handler code
+  *********************************************************************************************/
+  uint8_t OSEventGroupWait(BRTOS_EventGroup *pont_event, osflags_t flags, uint8_t options, osflags_t *result, ostick_t time_wait);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSEventGroupSet(BRTOS_EventGroup *pont_event, osflags_t flags)
+  * \brief Sets flags of an event group
+  *  Every waiting task whose condition is satisfied is woken up. May be called from interrupts.
+  * \param *pont_event Event group pointer
+  * \param flags Flags to be set
+  * \return OK Success
+  *********************************************************************************************/
+  uint8_t OSEventGroupSet(BRTOS_EventGroup *pont_event, osflags_t flags);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSEventGroupClear(BRTOS_EventGroup *pont_event, osflags_t flags)
+  * \brief Clears flags of an event group. May be called from interrupts.
+  * \param *pont_event Event group pointer
+  * \param flags Flags to be cleared
+  * \return OK Success
+  *********************************************************************************************/
+  uint8_t OSEventGroupClear(BRTOS_EventGroup *pont_event, osflags_t flags);
+
+  /*****************************************************************************************//**
+  * \fn osflags_t OSEventGroupGet(BRTOS_EventGroup *pont_event)
+  * \brief Returns the current state of the flags of an event group
+  * \param *pont_event Event group pointer
+  * \return The flags
+  *********************************************************************************************/
+  osflags_t OSEventGroupGet(BRTOS_EventGroup *pont_event);
+#endif
+
+#if (BRTOS_TASK_NOTIFY_EN == 1)
+  /*****************************************************************************************//**
+  * \fn uint8_t OSTaskNotify(BRTOS_TH TaskHandle, uint32_t value, uint8_t action)
+  * \brief Sends a notification to a task. May be called from interrupts.
+  *  No event control block is used - the notification value is kept by the task context.
+  * \param TaskHandle Task to be notified
+  * \param value Notification value, used according to the action
+  * \param action OS_NOTIFY_NO_ACTION, OS_NOTIFY_SET_BITS, OS_NOTIFY_INCREMENT, OS_NOTIFY_OVERWRITE or OS_NOTIFY_NO_OVERWRITE
+  * \return OK Success
+  * \return BUSY_RESOURCE OS_NOTIFY_NO_OVERWRITE was used and the last notification is still pending
+  * \return NOT_VALID_TASK Invalid task handle
+  *********************************************************************************************/
+  uint8_t OSTaskNotify(BRTOS_TH TaskHandle, uint32_t value, uint8_t action);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSTaskNotifyGive(BRTOS_TH TaskHandle)
+  * \brief Increments the notification value of a task, as a semaphore post. May be called from interrupts.
+  * \param TaskHandle Task to be notified
+  * \return OK Success
+  * \return NOT_VALID_TASK Invalid task handle
+  *********************************************************************************************/
+  #define OSTaskNotifyGive(TaskHandle)  OSTaskNotify((TaskHandle), 0, OS_NOTIFY_INCREMENT)
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSTaskNotifyTake(uint8_t clear, uint32_t *value, ostick_t time_wait)
+  * \brief Waits for the notification value of the current task to be non zero, as a semaphore pend
+  * \param clear TRUE clears the notification value on exit (binary semaphore), FALSE decrements it (counting semaphore)
+  * \param *value Returns the notification value before being cleared or decremented - may be NULL
+  * \param time_wait Timeout to the notification take exits
+  * \return OK Success
+  * \return TIMEOUT No notification in the specified time
+  * \return EXIT_BY_NO_ENTRY_AVAILABLE The notification value is zero and NO_TIMEOUT was used
+  * \return IRQ_PEND_ERR Can not use notification take function from interrupt handler code
+  *********************************************************************************************/
+  uint8_t OSTaskNotifyTake(uint8_t clear, uint32_t *value, ostick_t time_wait);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, ostick_t time_wait)
+  * \brief Waits for a notification of the current task
+  * \param clear_on_entry Bits of the notification value cleared if no notification is pending
+  * \param clear_on_exit Bits of the notification value cleared when a notification is received
+  * \param *value Returns the notification value before clear_on_exit - may be NULL
+  * \param time_wait Timeout to the notification wait exits
+  * \return OK Success
+  * \return TIMEOUT No notification in the specified time
+  * \return EXIT_BY_NO_ENTRY_AVAILABLE No notification pending and NO_TIMEOUT was used
+  * \return IRQ_PEND_ERR Can not use notification wait function from interrupt handler code
+  *********************************************************************************************/
+  uint8_t OSTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, ostick_t time_wait);
+#endif
+
+#if (BRTOS_PEND_MULTIPLE_EN == 1)
+  /*****************************************************************************************//**
+  * \fn uint8_t OSPendMultiple(OS_PEND_EVENT *events, uint8_t count, uint8_t *index, ostick_t time_wait)
+  * \brief Wait for the first of several semaphores, mailboxes and queues
+  *  The task is included into the wait list of every event. The first post selects the task
+  *  and removes it from the other wait lists, in the same critical section.
+  *  If more than one event is available, the first event of the array is used.
+  * \param *events Array of events - each event can only appear once
+  * \param count Number of events
+  * \param *index Returns the index of the event that was received
+  * \param time_wait Timeout to the wait exits
+  * \return OK Success - the semaphore was taken, or the message / entry was copied to OSPendData
+  * \return TIMEOUT No event was posted in the specified time
+  * \return EXIT_BY_NO_ENTRY_AVAILABLE No event available and NO_TIMEOUT was used,
+  *  or the entry was read by a higher priority task before the task runs
+  * \return INVALID_PARAMETERS Invalid number of events, event type or repeated event
+  * \return IRQ_PEND_ERR Can not use the pend multiple function from interrupt handler code
+  *********************************************************************************************/
+  uint8_t OSPendMultiple(OS_PEND_EVENT *events, uint8_t count, uint8_t *index, ostick_t time_wait);
+#endif
+
+#if (BRTOS_MEMPOOL_EN == 1)
+  /*****************************************************************************************//**
+  * \fn uint8_t OSMemPoolCreate(void *memory, uint16_t block_size, uint16_t blocks, BRTOS_MemPool **event)
+  * \brief Allocates a memory pool control block and splits the memory into fixed size blocks
+  * \param *memory Memory of the pool, aligned to a pointer - may be declared with OS_MEMPOOL_STORAGE
+  * \param block_size Size of the blocks, in bytes - rounded up to a multiple of the size of a pointer
+  * \param blocks Number of blocks
+  * \param **event Address of the memory pool control block pointer
+  * \return ALLOC_EVENT_OK Memory pool successfully allocated
+  * \return NO_AVAILABLE_EVENT No memory pool control blocks available
+  * \return INVALID_PARAMETERS NULL memory, zero blocks or zero block size
+  * \return IRQ_PEND_ERR Can not use the memory pool create function from interrupt handler code
+  *********************************************************************************************/
+  uint8_t OSMemPoolCreate(void *memory, uint16_t block_size, uint16_t blocks, BRTOS_MemPool **event);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSMemPoolDelete(BRTOS_MemPool **event)
+  * \brief Releases a memory pool control block. The memory of the pool is not used anymore.
+  * \param **event Address of the memory pool control block pointer
+  * \return DELETE_EVENT_OK Memory pool successfully released
+  * \return IRQ_PEND_ERR Can not use the memory pool delete function from interrupt handler code
+  *********************************************************************************************/
+  uint8_t OSMemPoolDelete(BRTOS_MemPool **event);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSMemPoolGet(BRTOS_MemPool *pont_event, void **block, ostick_t time_wait)
+  * \brief Gets a block of a memory pool in constant time.
+  *  May be called from interrupts with NO_TIMEOUT.
+  * \param *pont_event Memory pool pointer
+  * \param **block Returns the block
+  * \param time_wait Timeout to the get exits - NO_TIMEOUT does not wait for a free block
+  * \return OK Success
+  * \return TIMEOUT No block was released in the specified time
+  * \return EXIT_BY_NO_ENTRY_AVAILABLE No free block and NO_TIMEOUT was used
+  * \return IRQ_PEND_ERR Can not wait for a block in interrupt handler code
+  *********************************************************************************************/
+  uint8_t OSMemPoolGet(BRTOS_MemPool *pont_event, void **block, ostick_t time_wait);
+
+  /*****************************************************************************************//**
+  * \fn uint8_t OSMemPoolPut(BRTOS_MemPool *pont_event, void *block)
+  * \brief Releases a block of a memory pool in constant time. May be called from interrupts.
+  *  If a task is waiting for a block, the block is given to the highest priority waiting task.
+  * \param *pont_event Memory pool pointer
+  * \param *block Block to be released
+  * \return OK Success
+  * \return INVALID_PARAMETERS The block does not belong to the pool
+  * \return BUFFER_UNDERRUN Every block of the pool is already free
+  *********************************************************************************************/
+  uint8_t OSMemPoolPut(BRTOS_MemPool *pont_event, void *block);
 #endif
 
 ////////////////////////////////////////////////////////////
@@ -1221,7 +2310,7 @@ void initEvents(void);
 
 extern       PriorityType OSReadyList;
 extern       PriorityType OSBlockedList;
-extern const PriorityType PriorityMask[configMAX_TASK_PRIORITY+1];
+extern const PriorityWordType PriorityMask[OS_PRIORITY_WORD_BITS];
 
 extern ContextType *Tail;
 extern ContextType *Head;
@@ -1251,7 +2340,7 @@ extern volatile uint32_t      OSDutyTmp;
 	#error("You must define the OS_CPU_TYPE !!!")
 #endif
 
-extern uint32_t TaskAlloc;
+extern uint32_t TaskAlloc[OS_TASK_ALLOC_SIZE];
 extern uint16_t iQueueAddress;
 
 #if (PROCESSOR == ATMEGA)
@@ -1281,23 +2370,48 @@ extern stack_pointer_t StackAddress;
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
+/// Verifies the stack of the task being switched out
+#if (BRTOS_STACK_CHECK_EN == 1)
+#define OS_STACK_CHECK()  OSStackCheck()
+#else
+#define OS_STACK_CHECK()
+#endif
+
+/// Port hook run for the task being switched in (e.g. MPU stack guard)
+#ifndef OS_STACK_GUARD_SET
+#define OS_STACK_GUARD_SET()
+#endif
+
+/// Binary event trace records
+#if (OSTRACE == 1)
+#include "OSTrace.h"
+#else
+#define OS_TRACE(type, value, data)
+#define OS_TRACE_EVENT(type, event)
+#define OS_TRACE_ISR(type)
+#endif
+
 ////////////////////////////////////////////////////////////
 #if (defined ISR_DEDICATED_STACK && ISR_DEDICATED_STACK == 1)
 
 ////////////////////////////////////////////////////////////
-#define OS_INT_ENTER() if (!iNesting){OS_SAVE_SP(); OS_RESTORE_ISR_SP(); }; iNesting++;
+#define OS_INT_ENTER() if (!iNesting){OS_SAVE_SP(); OS_RESTORE_ISR_SP(); }; iNesting++; OS_TRACE_ISR(OS_TRACE_ISR_ENTER);
 
 #define OS_INT_EXIT()                                                   \
+  OS_TRACE_ISR(OS_TRACE_ISR_EXIT);                                      \
   CriticalDecNesting();                                                 \
   if (!iNesting)                                                        \
   {                                                                     \
 	OS_RESTORE_SP();                                                    \
     SelectedTask = OSSchedule();                                        \
     if (currentTask != SelectedTask){                                   \
+        OS_TRACE(OS_TRACE_SWITCH, 0, SelectedTask);                     \
+        OS_STACK_CHECK();                                               \
         OS_SAVE_CONTEXT();                                              \
         OS_SAVE_SP();                                                   \
         ContextTask[currentTask].StackPoint = SPvalue;                  \
 	      currentTask = SelectedTask;                                   \
+        OS_STACK_GUARD_SET();                                           \
         SPvalue = ContextTask[currentTask].StackPoint;                  \
         OS_RESTORE_SP();                                                \
         OS_RESTORE_CONTEXT();                                           \
@@ -1307,23 +2421,27 @@ extern stack_pointer_t StackAddress;
 
 #else
 
-#define OS_INT_ENTER()  iNesting++;
+#define OS_INT_ENTER()  iNesting++; OS_TRACE_ISR(OS_TRACE_ISR_ENTER);
 
       
 #if (COMPUTES_TASK_LOAD == 1)
 extern void COMPUTE_TASK_LOAD(void);
 
 #define OS_INT_EXIT()                                                   					\
+	OS_TRACE_ISR(OS_TRACE_ISR_EXIT);																\
 	CriticalDecNesting();                                                 					\
 	if (!iNesting)                                                        					\
 	{                                                                     					\
 		SelectedTask = OSSchedule();                                        				\
 		if (currentTask != SelectedTask){                                   				\
 			COMPUTE_TASK_LOAD();															\
+			OS_TRACE(OS_TRACE_SWITCH, 0, SelectedTask);										\
+			OS_STACK_CHECK();																\
 			OS_SAVE_CONTEXT();                                              				\
 			OS_SAVE_SP();                                                   				\
 			ContextTask[currentTask].StackPoint = SPvalue;                  				\
 			currentTask = SelectedTask;                                   					\
+			OS_STACK_GUARD_SET();															\
 			SPvalue = ContextTask[currentTask].StackPoint;                  				\
 			OS_RESTORE_SP();                                                				\
 			OS_RESTORE_CONTEXT();                                           				\
@@ -1332,15 +2450,19 @@ extern void COMPUTE_TASK_LOAD(void);
 
 #else
 #define OS_INT_EXIT()                                                   \
+  OS_TRACE_ISR(OS_TRACE_ISR_EXIT);                                      \
   CriticalDecNesting();                                                 \
   if (!iNesting)                                                        \
   {                                                                     \
     SelectedTask = OSSchedule();                                        \
     if (currentTask != SelectedTask){                                   \
+        OS_TRACE(OS_TRACE_SWITCH, 0, SelectedTask);                     \
+        OS_STACK_CHECK();                                               \
         OS_SAVE_CONTEXT();                                              \
         OS_SAVE_SP();                                                   \
         ContextTask[currentTask].StackPoint = SPvalue;                  \
 	    currentTask = SelectedTask;                                     \
+        OS_STACK_GUARD_SET();                                           \
         SPvalue = ContextTask[currentTask].StackPoint;                  \
         OS_RESTORE_SP();                                                \
         OS_RESTORE_CONTEXT();                                           \
@@ -1385,22 +2507,7 @@ extern void COMPUTE_TASK_LOAD(void);
         }
 
 
-#define IncludeTaskIntoDelayList()                  \
-        if(Tail != NULL)                            \
-        {                                           \
-          /* Insert task into list */               \
-          Tail->Next = Task;                        \
-          Task->Previous = Tail;                    \
-          Tail = Task;                              \
-          Tail->Next = NULL;                        \
-        }                                           \
-        else{                                       \
-           /* Init delay list */                    \
-           Tail = Task;                             \
-           Head = Task;                             \
-           Task->Next = NULL;                       \
-           Task->Previous = NULL;                   \
-        }
+#define IncludeTaskIntoDelayList()  OSDelayListInsert(Task)
 
 
 #endif
@@ -15,6 +15,7 @@
 void OSTaskList(char *string);
 void OSRuntimeStats(char *string);
 void OSAvailableMemory(char *string);
+void OSHeapTaskInfo(char *string);
 void OSUptimeInfo(char *string);
 void OSCPULoad(char *string);
 char *PrintDecimal(signed short val, char *buff);
@@ -0,0 +1,154 @@
+/**
+* \file OSTrace.h
+* \brief BRTOS binary event trace
+*
+* Timestamped records of the context switches, interrupts, event pend and
+* post, delays and timeouts, written to a RAM ring buffer (OSTRACE == 1).
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                          OS Trace functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#ifndef OS_TRACE_H_
+#define OS_TRACE_H_
+
+#include <stddef.h>
+#include "OS_types.h"
+#include "BRTOSConfig.h"
+#include "BRTOS.h"
+
+#if (OSTRACE == 1)
+
+/// Number of records of the trace ring buffer (power of 2)
+#ifndef BRTOS_TRACE_SIZE
+#define BRTOS_TRACE_SIZE			256
+#endif
+
+/// Records each tick interrupt
+#ifndef OS_TICK_SHOW
+#define OS_TICK_SHOW				0
+#endif
+
+/// Timestamp of the records - the port should provide a cycle counter.
+/// By default the tick counter is used
+#ifndef OS_TRACE_TIMESTAMP
+#define OS_TRACE_TIMESTAMP()		(uint32_t)OSGetCount()
+#define OS_TRACE_TIMESTAMP_HZ		configTICK_RATE_HZ
+#endif
+
+#ifndef OS_TRACE_TIMESTAMP_INIT
+#define OS_TRACE_TIMESTAMP_INIT()
+#endif
+
+/// Reserves a record and takes its timestamp - the port may provide an atomic increment,
+/// which must read the timestamp inside the reservation to keep the records in order.
+/// By default the trace must be written with the interrupts disabled
+#ifndef OS_TRACE_RESERVE
+#define OS_TRACE_RESERVE(timestamp)	((timestamp) = OS_TRACE_TIMESTAMP(), OSTraceHead++)
+#endif
+
+/// Interrupt entry and exit records of OS_INT_ENTER and OS_INT_EXIT
+#ifndef OS_TRACE_ISR
+#define OS_TRACE_ISR(type)			OSTraceEvent((type), 0, (uint16_t)iNesting)
+#endif
+
+/// Records written by an interrupt carry OS_TRACE_ISR_FLAG
+#ifndef OS_TRACE_IN_ISR
+#define OS_TRACE_IN_ISR()			(iNesting > 0)
+#endif
+
+/// Trace record types
+#define OS_TRACE_START				(uint8_t)0		///< Trace start, object: timestamp frequency in Hz
+#define OS_TRACE_SWITCH				(uint8_t)1		///< Context switch, data: task switched in
+#define OS_TRACE_ISR_ENTER			(uint8_t)2		///< Interrupt entry, data: nesting level
+#define OS_TRACE_ISR_EXIT			(uint8_t)3		///< Interrupt exit, data: nesting level
+#define OS_TRACE_TICK				(uint8_t)4		///< Tick interrupt, object: tick counter
+#define OS_TRACE_TIMEOUT			(uint8_t)5		///< Time to wait expired, data: woken task
+#define OS_TRACE_DELAY				(uint8_t)6		///< Task delay, object: ticks
+#define OS_TRACE_TASK_INSTALL		(uint8_t)7		///< Task installed, object: priority, data: task
+#define OS_TRACE_SEM_PEND			(uint8_t)8		///< Semaphore pend, object: semaphore
+#define OS_TRACE_SEM_POST			(uint8_t)9		///< Semaphore post, object: semaphore
+#define OS_TRACE_MUTEX_PEND			(uint8_t)10		///< Mutex acquire, object: mutex
+#define OS_TRACE_MUTEX_POST			(uint8_t)11		///< Mutex release, object: mutex
+#define OS_TRACE_MBOX_PEND			(uint8_t)12		///< Mailbox pend, object: mailbox
+#define OS_TRACE_MBOX_POST			(uint8_t)13		///< Mailbox post, object: mailbox
+#define OS_TRACE_QUEUE_PEND			(uint8_t)14		///< Queue pend, object: queue
+#define OS_TRACE_QUEUE_POST			(uint8_t)15		///< Queue post, object: queue
+#define OS_TRACE_USER				(uint8_t)16		///< Application record, object: value, data: id
+
+/// Set in the type of the records written by interrupt handlers
+#define OS_TRACE_ISR_FLAG			(uint8_t)0x80
+
+/// Trace record - 12 bytes in the byte order of the target
+typedef struct
+{
+  uint32_t timestamp;		///< OS_TRACE_TIMESTAMP of the record
+  uint8_t  type;			///< Record type, with OS_TRACE_ISR_FLAG
+  uint8_t  task;			///< Running task, or the task interrupted
+  uint16_t data;			///< Record data
+  uint32_t object;			///< Event address or record value
+} OS_TRACE_RECORD;
+
+extern OS_TRACE_RECORD OSTraceBuffer[BRTOS_TRACE_SIZE];
+extern volatile uint32_t OSTraceHead;
+
+/// Records an event - empty if OSTRACE is disabled
+#define OS_TRACE(type, value, data)		OSTraceEvent((type), (uint32_t)(value), (uint16_t)(data))
+
+/// Records the pend or post of an event, identified by its address
+#define OS_TRACE_EVENT(type, event)		OSTraceEvent((type), (uint32_t)(size_t)(event), 0)
+
+/*****************************************************************************************//**
+* \fn void OSTraceInit(void)
+* \brief Clears the trace and writes the start record. Called by BRTOSInit.
+*********************************************************************************************/
+void OSTraceInit(void);
+
+/*****************************************************************************************//**
+* \fn void OSTraceEvent(uint8_t type, uint32_t object, uint16_t data)
+* \brief Writes a trace record (Internal kernel function).
+*  Must be called with the interrupts disabled, unless the port provides OS_TRACE_RESERVE.
+*  The oldest records are overwritten when the ring buffer is full.
+* \param type Record type
+* \param object Event address or record value
+* \param data Record data
+*********************************************************************************************/
+void OSTraceEvent(uint8_t type, uint32_t object, uint16_t data);
+
+/*****************************************************************************************//**
+* \fn void OSTraceUser(uint16_t id, uint32_t value)
+* \brief Writes an application record into the trace
+* \param id Application defined record id
+* \param value Application defined value
+*********************************************************************************************/
+void OSTraceUser(uint16_t id, uint32_t value);
+
+/*****************************************************************************************//**
+* \fn uint16_t OSTraceRead(OS_TRACE_RECORD *records, uint16_t max, uint32_t *lost)
+* \brief Reads the oldest records of the trace, removing them from the ring buffer.
+*  The records can be sent to a host and converted by tools/brtos_trace.c.
+* \param records Buffer to the records
+* \param max Maximum number of records to be read
+* \param lost Number of records overwritten before being read since the last call (may be NULL)
+* \return Number of records read
+*********************************************************************************************/
+uint16_t OSTraceRead(OS_TRACE_RECORD *records, uint16_t max, uint32_t *lost);
+
+#endif
+
+#endif /* OS_TRACE_H_ */
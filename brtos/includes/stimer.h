@@ -45,14 +45,44 @@
   #define BRTOS_MAX_TIMER BRTOS_MAX_TIMER_DEFAULT
 #endif
 
+/// Number of bits of each level of the timer wheel (1 to 5)
+/// Each level has 2^BRTOS_TIMER_WHEEL_BITS slots
+#ifndef BRTOS_TIMER_WHEEL_BITS
+  #define BRTOS_TIMER_WHEEL_BITS 4
+#endif
+
+#define TIMER_WHEEL_SLOTS     (1 << BRTOS_TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK      (TIMER_WHEEL_SLOTS - 1)
+
+/// Number of levels of the timer wheel - covers the full range of the tick counter
+#define TIMER_WHEEL_LEVELS    (((sizeof(ostick_t) * 8) + BRTOS_TIMER_WHEEL_BITS - 1) / BRTOS_TIMER_WHEEL_BITS)
+
 /* config defines */ 
 // do not change, unless we know what are you doing
 #define TIMER_CNT             ostick_t
 #define TIMER_MAX_COUNTER     (TIMER_CNT)(TICK_COUNT_OVERFLOW-1)   
 
+/// Enable or disable the deferred function calls (OSPendFunctionCall)
+/// The calls are run by the timer task
+#ifndef BRTOS_PEND_CALL_EN
+  #define BRTOS_PEND_CALL_EN 0
+#endif
+
+/// Defines the maximum number of pending function calls (1 to 254)
+#ifndef BRTOS_PEND_CALL_QUEUE_SIZE
+  #define BRTOS_PEND_CALL_QUEUE_SIZE 8
+#endif
+
 /* typedefs for callback struct */  
+/* a return value greater than 0 restarts the timer with this timeout */
 typedef TIMER_CNT (*FCN_CALLBACK) (void);  
 
+/* soft timer modes:
+*/
+#define TIMER_CALLBACK        (uint8_t)0   ///< Restarted by the callback return value, released when it returns 0 (OSTimerSet)
+#define TIMER_ONE_SHOT        (uint8_t)1   ///< Stopped on expiration, kept allocated to be started again
+#define TIMER_PERIODIC        (uint8_t)2   ///< Restarted on expiration with its period, without drift
+
 /* soft timer possible states:
 */
 typedef enum
@@ -68,23 +98,34 @@ typedef enum
 */
 typedef struct BRTOS_TIMER_S 
 {
-      FCN_CALLBACK       func_cb;
-      TIMER_CNT          timeout;
-      TIMER_STATE        state;
+      FCN_CALLBACK           func_cb;
+      osdtick_t              expires;   /* expiration time, in ticks of the timer wheel */
+      TIMER_CNT              period;    /* period of the periodic timers */
+      TIMER_STATE            state;
+      uint8_t                mode;
+      uint8_t                slot;      /* timer wheel slot of the running timer */
+      struct BRTOS_TIMER_S  *next;      /* timers of the same slot or free timers */
+      struct BRTOS_TIMER_S  *prev;
 } BRTOS_TIMER_T;
 
 /* soft timer typedef
 */
 typedef  BRTOS_TIMER_T*  BRTOS_TIMER; 
 
-/* soft timers list data struct 
-*/
+#if (BRTOS_PEND_CALL_EN == 1)
+/* deferred function typedef */
+typedef void (*FCN_PEND_CALL) (void *arg);
 
+/* deferred function calls statistics
+*/
 typedef struct
-{    
-    BRTOS_TIMER timers [BRTOS_MAX_TIMER];
-    int8_t      count;
-}BRTOS_TMR_T;
+{
+      uint32_t               calls;       /* calls run by the timer task */
+      uint32_t               overflows;   /* calls lost because the queue was full */
+      uint8_t                pending;     /* calls waiting to be run */
+      uint8_t                max_pending; /* maximum number of calls waiting to be run */
+} OS_PEND_CALL_STATS;
+#endif
 
 
 /* TIMER TASK prototype */  
@@ -97,10 +138,16 @@ void BRTOSTimerTask(void);
 /************* public API *********************/ 
 void OSTimerInit(uint16_t timertask_stacksize, uint8_t prio);
 uint8_t OSTimerSet (BRTOS_TIMER *cbp, FCN_CALLBACK cb, TIMER_CNT timeout);
+uint8_t OSTimerCreate (BRTOS_TIMER *cbp, FCN_CALLBACK cb, TIMER_CNT timeout, uint8_t mode);
 TIMER_CNT OSTimerGet (BRTOS_TIMER p);
 uint8_t OSTimerStart (BRTOS_TIMER p, TIMER_CNT timeout);  
 uint8_t OSTimerStop (BRTOS_TIMER p, uint8_t del); 
 
+#if (BRTOS_PEND_CALL_EN == 1)
+uint8_t OSPendFunctionCall (FCN_PEND_CALL fn, void *arg);
+void OSPendFunctionCallStats (OS_PEND_CALL_STATS *stats, uint8_t reset);
+#endif
+
 /***************************************/
 
 
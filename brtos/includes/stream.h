@@ -0,0 +1,119 @@
+/**
+* \file stream.h
+* \brief OS single producer / single consumer stream functions
+*
+* Byte stream between one producer (usually an interrupt handler)
+* and one consumer task. The data path does not disable the interrupts.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                     OS Stream functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "OS_types.h"
+#include "BRTOSConfig.h"
+#include "BRTOS.h"
+
+/// Enable or disable the stream service
+#ifndef BRTOS_STREAM_EN
+#define BRTOS_STREAM_EN        0
+#endif
+
+#if (BRTOS_STREAM_EN == 1)
+
+/// Memory barrier of the stream data path
+/// The port may define it in HAL.h (a DMB instruction, for example)
+#ifndef OS_MEMORY_BARRIER
+  #if defined(__GNUC__)
+    #define OS_MEMORY_BARRIER()   __sync_synchronize()
+  #else
+    #define OS_MEMORY_BARRIER()
+  #endif
+#endif
+
+/**
+* \struct BRTOS_Stream
+* Stream Control Block Structure
+* The producer only writes OSStreamIn and the consumer only writes OSStreamOut.
+*/
+typedef struct
+{
+  uint8_t           *OSStreamBuffer;      ///< Stream buffer
+  uint16_t          OSStreamSize;         ///< Size of the buffer - up to OSStreamSize - 1 bytes are stored
+  volatile uint16_t OSStreamIn;           ///< Index of the next byte to be written
+  volatile uint16_t OSStreamOut;          ///< Index of the next byte to be read
+  volatile uint16_t OSStreamWaiting;      ///< Number of bytes waited by the consumer, 0 if it is not waiting
+  PriorityType      OSEventWaitList;      ///< Task wait list for the stream data
+} BRTOS_Stream;
+
+/*****************************************************************************************//**
+* \fn uint8_t OSStreamCreate(BRTOS_Stream *stream, uint8_t *buffer, uint16_t size)
+* \brief Initializes a stream control block
+* \param *stream Stream control block
+* \param *buffer Stream buffer
+* \param size Size of the stream buffer, in bytes. The stream stores up to size - 1 bytes
+* \return INVALID_PARAMETERS There is at least one invalid parameter
+* \return ALLOC_EVENT_OK Stream successfully initialized
+*********************************************************************************************/
+uint8_t OSStreamCreate(BRTOS_Stream *stream, uint8_t *buffer, uint16_t size);
+
+/*****************************************************************************************//**
+* \fn uint8_t OSStreamWrite(BRTOS_Stream *stream, const void *data, uint16_t bytes)
+* \brief Writes data into the stream, from the producer (interrupt handler or task)
+*  The data is written only if it fits entirely. The interrupts are only disabled
+*  to wake up the consumer, when it is waiting and enough data is available.
+* \param *stream Stream control block
+* \param *data Data to be written
+* \param bytes Number of bytes
+* \return BUFFER_UNDERRUN There is not enough space for the data
+* \return WRITE_BUFFER_OK Data successfully written
+*********************************************************************************************/
+uint8_t OSStreamWrite(BRTOS_Stream *stream, const void *data, uint16_t bytes);
+
+/*****************************************************************************************//**
+* \fn uint8_t OSStreamRead(BRTOS_Stream *stream, void *data, uint16_t min, uint16_t max, uint16_t *read, ostick_t time_wait)
+* \brief Reads data from the stream, from the consumer task
+*  Waits until at least min bytes are available, then reads up to max bytes.
+*  Nothing is read if the call exits with an error.
+* \param *stream Stream control block
+* \param *data Buffer for up to max bytes
+* \param min Minimum number of bytes to read
+* \param max Maximum number of bytes to read
+* \param *read Returns the number of bytes read
+* \param time_wait Timeout to the stream read exits
+* \return INVALID_PARAMETERS min is zero, min is higher than max or min does not fit into the stream
+* \return IRQ_PEND_ERR The stream read can only wait in task code
+* \return TIMEOUT The stream read exit by timeout
+* \return EXIT_BY_NO_ENTRY_AVAILABLE There are less than min bytes and NO_TIMEOUT was used
+* \return READ_BUFFER_OK Data successfully read
+*********************************************************************************************/
+uint8_t OSStreamRead(BRTOS_Stream *stream, void *data, uint16_t min, uint16_t max, uint16_t *read, ostick_t time_wait);
+
+/*****************************************************************************************//**
+* \fn uint16_t OSStreamAvailable(BRTOS_Stream *stream)
+* \brief Number of bytes that can be read from the stream
+* \param *stream Stream control block
+* \return Number of bytes
+*********************************************************************************************/
+uint16_t OSStreamAvailable(BRTOS_Stream *stream);
+
+#endif
+
+#endif
@@ -131,7 +131,7 @@ uint8_t OSMboxCreate (BRTOS_Mbox **event, void *message)
   
   pont_event->OSEventPointer   = message;
   pont_event->OSEventWait      = 0;  
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
   
   
   *event = pont_event;
@@ -176,7 +176,7 @@ uint8_t OSMboxDelete (BRTOS_Mbox **event)
   pont_event->OSEventWait        = 0;
   pont_event->OSEventState       = NO_MESSAGE;
   
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
   
   *event = NULL;
   
@@ -204,7 +204,6 @@ uint8_t OSMboxDelete (BRTOS_Mbox **event)
 uint8_t OSMboxPend (BRTOS_Mbox *pont_event, void **Mail, ostick_t time_wait)
 {
   OS_SR_SAVE_VAR
-  uint8_t  iPriority = 0;
   osdtick_t timeout;
   ContextType *Task;  
   
@@ -236,6 +235,9 @@ uint8_t OSMboxPend (BRTOS_Mbox *pont_event, void **Mail, ostick_t time_wait)
       return(ERR_EVENT_NO_CREATED);
     }
   #endif
+
+  // BRTOS TRACE SUPPORT
+  OS_TRACE_EVENT(OS_TRACE_MBOX_PEND, pont_event);
   
   // Verify if there was a message post
   if (pont_event->OSEventState == AVAILABLE_MESSAGE)
@@ -261,14 +263,11 @@ uint8_t OSMboxPend (BRTOS_Mbox *pont_event, void **Mail, ostick_t time_wait)
   	
     Task = (ContextType*)&ContextTask[currentTask];
       
-    // Copy task priority to local scope
-    iPriority = Task->Priority;
-    
     // Increases the semaphore wait list counter
     pont_event->OSEventWait++;
     
     // Allocates the current task on the mailbox wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList | (PriorityMask[iPriority]);
+    OSEventWaitListInsert(&pont_event->OSEventWaitList, pont_event, Task);
     
     // Task entered suspended state, waiting for mailbox post
     #if (VERBOSE == 1)
@@ -277,7 +276,7 @@ uint8_t OSMboxPend (BRTOS_Mbox *pont_event, void **Mail, ostick_t time_wait)
     #endif
     
     // Remove current task from the Ready List
-    OSReadyList = OSReadyList & ~(PriorityMask[iPriority]);
+    OSReadyListRemove(Task);
 
     // Set timeout overflow
     if (time_wait)
@@ -318,10 +317,10 @@ uint8_t OSMboxPend (BRTOS_Mbox *pont_event, void **Mail, ostick_t time_wait)
         if(Task->TimeToWait == EXIT_BY_TIMEOUT)
         {
             // Test if both timeout and post have occured before arrive here
-            if ((pont_event->OSEventWaitList & PriorityMask[iPriority]))
+            if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, Task))
             {
               // Remove the task from the queue wait list
-              pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+              OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
               
               // Decreases the queue wait list counter
               pont_event->OSEventWait--;
@@ -377,10 +376,7 @@ uint8_t OSMboxPend (BRTOS_Mbox *pont_event, void **Mail, ostick_t time_wait)
 uint8_t OSMboxPost(BRTOS_Mbox *pont_event, void *message)
 {
   OS_SR_SAVE_VAR
-  uint8_t iPriority = (uint8_t)0;
-  #if (VERBOSE == 1)
-  uint8_t TaskSelect = 0;  
-  #endif
+  uint8_t TaskSelect = 0;
   
   #if (ERROR_CHECK == 1)    
     // Verifies if the pointer is NULL
@@ -408,26 +404,25 @@ uint8_t OSMboxPost(BRTOS_Mbox *pont_event, void *message)
       return(ERR_EVENT_NO_CREATED);
     }
   #endif
+
+  // BRTOS TRACE SUPPORT
+  OS_TRACE_EVENT(OS_TRACE_MBOX_POST, pont_event);
        
   // See if any task is waiting for a message
   if (pont_event->OSEventWait != 0)
   {
-    // Selects the highest priority task
-    iPriority = SAScheduler(pont_event->OSEventWaitList);
-
-    // Remove the selected task from the mailbox wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+    // Selects the highest priority task and removes it from the mailbox wait list
+    TaskSelect = OSEventWaitListSelect(&pont_event->OSEventWaitList, pont_event);
     
     // Decreases the mailbox wait list counter
     pont_event->OSEventWait--;
     
     // Put the selected task into Ready List
     #if (VERBOSE == 1)
-    TaskSelect = PriorityVector[iPriority];
     ContextTask[TaskSelect].State = READY;
     #endif
     
-    OSReadyList = OSReadyList | (PriorityMask[iPriority]);
+    OSReadyListInsert(&ContextTask[TaskSelect]);
     
     // Copy message pointer
     pont_event->OSEventPointer = message;
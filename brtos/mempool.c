@@ -0,0 +1,461 @@
+/**
+* \file mempool.c
+* \brief BRTOS fixed block memory pool functions
+*
+* Functions to install and use memory pools (partitions).
+* The memory of a pool is split into blocks of the same size. The free
+* blocks are linked through their first word, so a block is taken or
+* released in constant time, also from interrupts.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                     OS Memory Pool functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#include "BRTOS.h"
+
+#if (BRTOS_MEMPOOL_EN == 1)
+
+// Takes the first free block - must be called inside a critical section
+static void *OSMemPoolTake(BRTOS_MemPool *pont_event)
+{
+  void *block = pont_event->OSFreeList;
+
+  pont_event->OSFreeList = *(void**)block;
+  pont_event->OSFreeBlocks--;
+
+  if (pont_event->OSFreeBlocks < pont_event->OSMinFreeBlocks)
+  {
+    pont_event->OSMinFreeBlocks = pont_event->OSFreeBlocks;
+  }
+
+  return block;
+}
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Create Memory Pool Function                 /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSMemPoolCreate(void *memory, uint16_t block_size, uint16_t blocks, BRTOS_MemPool **event)
+{
+  OS_SR_SAVE_VAR
+  int i=0;
+  uint8_t *block;
+
+  BRTOS_MemPool *pont_event;
+
+  if (iNesting > 0) {                                // See if caller is an interrupt
+     return(IRQ_PEND_ERR);                           // Can't be create by interrupt
+  }
+
+  if ((memory == NULL) || (block_size == 0) || (blocks == 0))
+  {
+     return(INVALID_PARAMETERS);
+  }
+
+  // Each free block holds the address of the next free block
+  block_size = (uint16_t)(((block_size + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*));
+
+  // Enter critical Section
+  if (currentTask)
+     OSEnterCritical();
+
+  // Verifies if there is an available event control block
+  for(i=0;i<=BRTOS_MAX_MEMPOOL;i++)
+  {
+    if(i >= BRTOS_MAX_MEMPOOL)
+    {
+      // Exit critical Section
+      if (currentTask)
+         OSExitCritical();
+
+      return(NO_AVAILABLE_EVENT);
+    }
+
+    if(BRTOS_MemPool_Table[i].OSEventAllocated != TRUE)
+    {
+      BRTOS_MemPool_Table[i].OSEventAllocated = TRUE;
+      pont_event = &BRTOS_MemPool_Table[i];
+      break;
+    }
+  }
+
+  // Exit critical Section
+  if (currentTask)
+     OSExitCritical();
+
+  // Links the blocks of the free list - the control block is not visible yet
+  block = (uint8_t*)memory;
+  for(i=0;i<(blocks - 1);i++)
+  {
+    *(void**)block = (void*)(block + block_size);
+    block += block_size;
+  }
+  *(void**)block = NULL;
+
+  pont_event->OSFreeList      = memory;
+  pont_event->OSPoolStart     = (uint8_t*)memory;
+  pont_event->OSPoolEnd       = block + block_size;
+  pont_event->OSBlockSize     = block_size;
+  pont_event->OSBlocks        = blocks;
+  pont_event->OSFreeBlocks    = blocks;
+  pont_event->OSMinFreeBlocks = blocks;
+  pont_event->OSAllocFails    = 0;
+  pont_event->OSEventWait     = 0;
+  OSPrioReset(pont_event->OSEventWaitList);
+
+  *event = pont_event;
+
+  return(ALLOC_EVENT_OK);
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Delete Memory Pool Function                 /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSMemPoolDelete(BRTOS_MemPool **event)
+{
+  OS_SR_SAVE_VAR
+  BRTOS_MemPool *pont_event;
+
+  if (iNesting > 0) {                                // See if caller is an interrupt
+      return(IRQ_PEND_ERR);                          // Can't be delete by interrupt
+  }
+
+  // Enter Critical Section
+  OSEnterCritical();
+
+  pont_event = *event;
+  pont_event->OSEventAllocated = 0;
+  pont_event->OSFreeList       = NULL;
+  pont_event->OSFreeBlocks     = 0;
+  pont_event->OSEventWait      = 0;
+  OSPrioReset(pont_event->OSEventWaitList);
+
+  *event = NULL;
+
+  // Exit Critical Section
+  OSExitCritical();
+
+  return(DELETE_EVENT_OK);
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Memory Pool Get Function                    /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSMemPoolGet(BRTOS_MemPool *pont_event, void **block, ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  osdtick_t timeout;
+  ContextType *Task;
+
+  #if (ERROR_CHECK == 1)
+    // Can not wait for a block in interrupt handling code
+    if((iNesting > 0) && (time_wait != NO_TIMEOUT))
+    {
+      return(IRQ_PEND_ERR);
+    }
+
+    // Verifies if the pointers are NULL
+    if((pont_event == NULL) || (block == NULL))
+    {
+      return(NULL_EVENT_POINTER);
+    }
+  #endif
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the event is allocated
+    if(pont_event->OSEventAllocated != TRUE)
+    {
+      // Exit Critical Section
+      #if (NESTING_INT == 0)
+      if (!iNesting)
+      #endif
+         OSExitCritical();
+      return(ERR_EVENT_NO_CREATED);
+    }
+  #endif
+
+  // Verify if there is a free block
+  if (pont_event->OSFreeList != NULL)
+  {
+    *block = OSMemPoolTake(pont_event);
+
+    // Exit Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+       OSExitCritical();
+    return OK;
+  }
+
+  pont_event->OSAllocFails++;
+
+  // If no timeout is used and there is no free block, exit with an error
+  if (time_wait == NO_TIMEOUT){
+    // Exit Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+       OSExitCritical();
+    return EXIT_BY_NO_ENTRY_AVAILABLE;
+  }
+
+  Task = (ContextType*)&ContextTask[currentTask];
+  Task->WaitBlock = NULL;
+
+  // Increases the memory pool wait list counter
+  pont_event->OSEventWait++;
+
+  // Allocates the current task on the memory pool wait list
+  OSEventWaitListInsert(&pont_event->OSEventWaitList, pont_event, Task);
+
+  // Task entered suspended state, waiting for a block release
+  #if (VERBOSE == 1)
+  Task->State = SUSPENDED;
+  Task->SuspendedType = MEMPOOL;
+  #endif
+
+  // Remove current task from the Ready List
+  OSReadyListRemove(Task);
+
+  // Set timeout overflow
+  if (time_wait)
+  {
+	  timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
+
+	  if (sizeof_ostick_t < 8){
+		  if (timeout >= TICK_COUNT_OVERFLOW)
+		  {
+			  Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+		  }
+		  else
+		  {
+			  Task->TimeToWait = (ostick_t)timeout;
+		  }
+	  }else{
+		  Task->TimeToWait = (ostick_t)timeout;
+	  }
+
+	  // Put task into delay list
+	  IncludeTaskIntoDelayList();
+  } else
+  {
+    Task->TimeToWait = NO_TIMEOUT;
+  }
+
+  // Change Context - Returns on time overflow or block release
+  ChangeContext();
+
+  // Exit Critical Section
+  OSExitCritical();
+  // Enter Critical Section
+  OSEnterCritical();
+
+  if (time_wait)
+  {
+      // Verify if the reason of task wake up was timeout
+      if(Task->TimeToWait == EXIT_BY_TIMEOUT)
+      {
+          // Test if both timeout and release have occured before arrive here
+          if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, Task))
+          {
+            // Remove the task from the memory pool wait list
+            OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
+
+            // Decreases the memory pool wait list counter
+            pont_event->OSEventWait--;
+
+            // Exit Critical Section
+            OSExitCritical();
+
+            // Indicates memory pool timeout
+            return TIMEOUT;
+          }
+      }
+      else
+      {
+          // Remove the time to wait condition
+          Task->TimeToWait = NO_TIMEOUT;
+
+          // Remove from delay list
+          RemoveFromDelayList();
+      }
+  }
+
+  // The released block was given to the task
+  *block = Task->WaitBlock;
+
+  // Exit Critical Section
+  OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Memory Pool Put Function                    /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSMemPoolPut(BRTOS_MemPool *pont_event, void *block)
+{
+  OS_SR_SAVE_VAR
+  uint8_t TaskSelect = 0;
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the pointer is NULL
+    if(pont_event == NULL)
+    {
+      return(NULL_EVENT_POINTER);
+    }
+
+    // Verifies if the block belongs to the pool
+    if(((uint8_t*)block < pont_event->OSPoolStart) || ((uint8_t*)block >= pont_event->OSPoolEnd) ||
+       ((uint32_t)((uint8_t*)block - pont_event->OSPoolStart) % pont_event->OSBlockSize))
+    {
+      return(INVALID_PARAMETERS);
+    }
+  #endif
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the event is allocated
+    if(pont_event->OSEventAllocated != TRUE)
+    {
+      // Exit Critical Section
+      #if (NESTING_INT == 0)
+      if (!iNesting)
+      #endif
+         OSExitCritical();
+      return(ERR_EVENT_NO_CREATED);
+    }
+  #endif
+
+  // See if any task is waiting for a block
+  if (pont_event->OSEventWait != 0)
+  {
+    // Selects the highest priority task and removes it from the memory pool wait list
+    TaskSelect = OSEventWaitListSelect(&pont_event->OSEventWaitList, pont_event);
+
+    // Decreases the memory pool wait list counter
+    pont_event->OSEventWait--;
+
+    // The block is given to the task, so it can not be taken by another task before it runs
+    ContextTask[TaskSelect].WaitBlock = block;
+
+    // Put the selected task into Ready List
+    #if (VERBOSE == 1)
+    ContextTask[TaskSelect].State = READY;
+    #endif
+
+    OSReadyListInsert(&ContextTask[TaskSelect]);
+
+    // If outside of an interrupt service routine, change context to the highest priority task
+    // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
+    if (!iNesting)
+    {
+      // Verify if there is a higher priority task ready to run
+      ChangeContext();
+    }
+
+    // Exit Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+      OSExitCritical();
+
+    return OK;
+  }
+
+  // Make sure the free list will not overflow
+  if (pont_event->OSFreeBlocks >= pont_event->OSBlocks)
+  {
+    // Exit Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+       OSExitCritical();
+    return BUFFER_UNDERRUN;
+  }
+
+  *(void**)block = pont_event->OSFreeList;
+  pont_event->OSFreeList = block;
+  pont_event->OSFreeBlocks++;
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+#endif
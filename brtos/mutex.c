@@ -64,6 +64,135 @@
 
 
 #if (BRTOS_MUTEX_EN == 1)
+
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+// Priority inheritance
+// The owner of a priority inheritance mutex runs with the priority of the highest
+// priority task waiting for it. InheritBase keeps the priority of the task without
+// the inherited priority. Since the inherited priority is shared with the waiting
+// task, priority inheritance is only available with BRTOS_ROUND_ROBIN_EN.
+
+// Priority of the task without the inherited priority
+#define OSMutexBasePriority(Task)   (((Task)->InheritBase != EMPTY_PRIO) ? (Task)->InheritBase : (Task)->Priority)
+
+// Finds the priority inheritance mutex that the task is waiting for
+static BRTOS_Mutex *OSMutexWaitedBy(ContextType *Task)
+{
+  uint8_t i;
+
+  if (Task->WaitEvent != NULL)
+  {
+    for(i=0;i<BRTOS_MAX_MUTEX;i++)
+    {
+      if (Task->WaitEvent == (void*)&BRTOS_Mutex_Table[i])
+      {
+        if (BRTOS_Mutex_Table[i].OSMutexOptions & OS_MUTEX_INHERIT)
+        {
+          return &BRTOS_Mutex_Table[i];
+        }
+        break;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+// Applies to the task the highest priority between its base priority and the priorities of
+// the tasks waiting for its priority inheritance mutexes - returns TRUE if the priority changed
+static uint8_t OSMutexUpdatePriority(uint8_t TaskNumber)
+{
+  ContextType *Task = (ContextType*)&ContextTask[TaskNumber];
+  uint8_t iBase = OSMutexBasePriority(Task);
+  uint8_t iPriority = iBase;
+  uint8_t iWait;
+  uint8_t i;
+
+  for(i=0;i<BRTOS_MAX_MUTEX;i++)
+  {
+    if ((BRTOS_Mutex_Table[i].OSEventAllocated == TRUE) && (BRTOS_Mutex_Table[i].OSEventOwner == TaskNumber) &&
+        (BRTOS_Mutex_Table[i].OSMutexOptions & OS_MUTEX_INHERIT) && (BRTOS_Mutex_Table[i].OSEventWait > 0))
+    {
+      iWait = OSPrioHighest(BRTOS_Mutex_Table[i].OSEventWaitList);
+      if (iWait > iPriority)
+      {
+        iPriority = iWait;
+      }
+    }
+  }
+
+  if (iPriority == iBase)
+  {
+    Task->InheritBase = EMPTY_PRIO;
+  }
+  else
+  {
+    Task->InheritBase = iBase;
+  }
+
+  if (iPriority != Task->Priority)
+  {
+    OSSetTaskPriority(TaskNumber, iPriority);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+// Updates the priority of the mutex owner and follows the chain of owners of nested mutexes
+// The chain is limited to the number of mutexes, what also stops on a deadlock
+static void OSMutexInherit(BRTOS_Mutex *pont_event)
+{
+  uint8_t i;
+
+  for(i=0;(i<BRTOS_MAX_MUTEX) && (pont_event != NULL);i++)
+  {
+    if (pont_event->OSEventOwner == 0)
+    {
+      return;
+    }
+
+    // The owners of the next mutexes only change if this owner has changed
+    if (OSMutexUpdatePriority(pont_event->OSEventOwner) == FALSE)
+    {
+      return;
+    }
+
+    pont_event = OSMutexWaitedBy((ContextType*)&ContextTask[pont_event->OSEventOwner]);
+  }
+}
+#endif
+
+// Receives the priority ceiling of the mutex temporarily
+static void OSMutexCeiling(BRTOS_Mutex *pont_event, ContextType *Task)
+{
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  if (Task->InheritBase != EMPTY_PRIO)
+  {
+    // The task is running with an inherited priority - the ceiling changes its base priority
+    pont_event->OSOriginalPriority = Task->InheritBase;
+
+    if (pont_event->OSMaxPriority > Task->InheritBase)
+    {
+      Task->InheritBase = pont_event->OSMaxPriority;
+      (void)OSMutexUpdatePriority(currentTask);
+    }
+    return;
+  }
+  #endif
+
+  // Backup the original task priority
+  pont_event->OSOriginalPriority = Task->Priority;
+
+  if (pont_event->OSMaxPriority > Task->Priority)
+  {
+    // Moves the current task to the "max priority" into the Ready List
+    OSSetTaskPriority(currentTask, pont_event->OSMaxPriority);
+  }
+}
+
+
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 /////      Create Mutex Function                       /////
@@ -71,6 +200,11 @@
 ////////////////////////////////////////////////////////////
 
 uint8_t OSMutexCreate (BRTOS_Mutex **event, uint8_t HigherPriority)
+{
+  return OSMutexCreateOptions(event, HigherPriority, 0);
+}
+
+uint8_t OSMutexCreateOptions (BRTOS_Mutex **event, uint8_t HigherPriority, uint8_t options)
 {
   OS_SR_SAVE_VAR
   int i=0;
@@ -80,6 +214,17 @@ uint8_t OSMutexCreate (BRTOS_Mutex **event, uint8_t HigherPriority)
   if (iNesting > 0) {                                // See if caller is an interrupt
       return(IRQ_PEND_ERR);                          // Can't be create by interrupt
   }
+
+  // Priority inheritance does not use a priority ceiling and needs tasks sharing a priority
+  if (options & OS_MUTEX_INHERIT)
+  {
+    #if (BRTOS_ROUND_ROBIN_EN == 1)
+    if (HigherPriority > 0)
+    #endif
+    {
+      return(INVALID_PARAMETERS);
+    }
+  }
     
   // Enter critical Section
   if (currentTask)
@@ -129,9 +274,11 @@ uint8_t OSMutexCreate (BRTOS_Mutex **event, uint8_t HigherPriority)
   pont_event->OSEventState = AVAILABLE_RESOURCE;       // Set mutex init value
   pont_event->OSEventWait  = 0;
   pont_event->OSMaxPriority = HigherPriority;          // Determina a tarefa de maior prioridade acessando o mutex
+  pont_event->OSEventNesting = 0;
+  pont_event->OSMutexOptions = options;
 
   
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
   
   *event = pont_event;
   
@@ -176,8 +323,10 @@ uint8_t OSMutexDelete (BRTOS_Mutex **event)
   pont_event->OSMaxPriority      = 0;                      
   pont_event->OSOriginalPriority = 0;                
   pont_event->OSEventWait        = 0;  
+  pont_event->OSEventNesting     = 0;
+  pont_event->OSMutexOptions     = 0;
   
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
   
   *event = NULL;
   
@@ -205,7 +354,6 @@ uint8_t OSMutexDelete (BRTOS_Mutex **event)
 uint8_t OSMutexAcquire(BRTOS_Mutex *pont_event, ostick_t time_wait)
 {
   OS_SR_SAVE_VAR
-  uint8_t  iPriority = 0;
   osdtick_t timeout;
   ContextType *Task;
 
@@ -238,19 +386,18 @@ uint8_t OSMutexAcquire(BRTOS_Mutex *pont_event, ostick_t time_wait)
   #endif
   
   // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, MUTEXPEND);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, MUTEXPEND);
-      #endif 
-  #endif    
+  OS_TRACE_EVENT(OS_TRACE_MUTEX_PEND, pont_event);
   
   
   // Verifies if the task is trying to acquire the mutex again
   if (currentTask == pont_event->OSEventOwner) 
   {
     // It is already the mutex owner
+    // A recursive mutex counts the acquires, each one needs a release
+    if ((pont_event->OSMutexOptions & OS_MUTEX_RECURSIVE) && (pont_event->OSEventNesting < 0xFF))
+    {
+      pont_event->OSEventNesting++;
+    }
     OSExitCritical();
     return OK;
   }
@@ -265,26 +412,16 @@ uint8_t OSMutexAcquire(BRTOS_Mutex *pont_event, ostick_t time_wait)
     
     // Current task becomes the temporary owner of the mutex
     pont_event->OSEventOwner = currentTask;
+    pont_event->OSEventNesting = 1;
         
     ///////////////////////////////////////////////////////////////////////////////
     // Performs the temporary exchange of mutex owner priority, if needed        //
     ///////////////////////////////////////////////////////////////////////////////
     
-    // Backup the original task priority
-    pont_event->OSOriginalPriority = ContextTask[currentTask].Priority;
-    
-    if (pont_event->OSMaxPriority > ContextTask[currentTask].Priority)
+    // A priority inheritance mutex only changes the owner priority when a task waits for it
+    if (!(pont_event->OSMutexOptions & OS_MUTEX_INHERIT))
     {
-      // Receives the priority ceiling temporarily
-      Task->Priority = pont_event->OSMaxPriority;
-      
-      // Priority vector change       
-      PriorityVector[pont_event->OSMaxPriority] = currentTask;
-      
-      // Remove "original priority current task" from the Ready List
-      OSReadyList = OSReadyList & ~(PriorityMask[pont_event->OSOriginalPriority]);
-      // Put the "max priority current task" into Ready List
-      OSReadyList = OSReadyList | (PriorityMask[pont_event->OSMaxPriority]);
+      OSMutexCeiling(pont_event, Task);
     }
     
     OSExitCritical();
@@ -299,13 +436,19 @@ uint8_t OSMutexAcquire(BRTOS_Mutex *pont_event, ostick_t time_wait)
 		return EXIT_BY_NO_RESOURCE_AVAILABLE;
 	}
 
-	// Copy task priority to local scope
-    iPriority = Task->Priority;
     // Increases the mutex wait list counter
     pont_event->OSEventWait++;
     
     // Allocates the current task on the mutex wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList | (PriorityMask[iPriority]);
+    OSEventWaitListInsert(&pont_event->OSEventWaitList, pont_event, Task);
+
+    #if (BRTOS_ROUND_ROBIN_EN == 1)
+    // The owner receives the priority of the current task, if higher
+    if (pont_event->OSMutexOptions & OS_MUTEX_INHERIT)
+    {
+      OSMutexInherit(pont_event);
+    }
+    #endif
       
     // Task entered suspended state, waiting for mutex release
     #if (VERBOSE == 1)
@@ -314,7 +457,7 @@ uint8_t OSMutexAcquire(BRTOS_Mutex *pont_event, ostick_t time_wait)
     #endif
 
     // Remove current task from the Ready List
-    OSReadyList = OSReadyList & ~(PriorityMask[iPriority]);
+    OSReadyListRemove(Task);
 
     // Set timeout overflow
     if (time_wait)
@@ -354,14 +497,22 @@ uint8_t OSMutexAcquire(BRTOS_Mutex *pont_event, ostick_t time_wait)
         if(Task->TimeToWait == EXIT_BY_TIMEOUT)
         {
             // Test if both timeout and post have occured before arrive here
-            if ((pont_event->OSEventWaitList & PriorityMask[iPriority]))
+            if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, Task))
             {
               // Remove the task from the queue wait list
-              pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+              OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
 
               // Decreases the queue wait list counter
               pont_event->OSEventWait--;
 
+              #if (BRTOS_ROUND_ROBIN_EN == 1)
+              // The owner loses the priority inherited from the current task
+              if (pont_event->OSMutexOptions & OS_MUTEX_INHERIT)
+              {
+                OSMutexInherit(pont_event);
+              }
+              #endif
+
               // Exit Critical Section
               OSExitCritical();
 
@@ -380,21 +531,10 @@ uint8_t OSMutexAcquire(BRTOS_Mutex *pont_event, ostick_t time_wait)
 
     }
     
-    // Backup the original task priority
-    pont_event->OSOriginalPriority = iPriority;
-    
-    if (pont_event->OSMaxPriority > iPriority)
+    // The priority of a priority inheritance mutex owner was updated by the release
+    if (!(pont_event->OSMutexOptions & OS_MUTEX_INHERIT))
     {
-      // Receives the priority ceiling temporarily
-      Task->Priority = pont_event->OSMaxPriority;
-      
-      // Priority vector change
-      PriorityVector[pont_event->OSMaxPriority] = currentTask;
-      
-      // Remove "original priority current task" from the Ready List
-      OSReadyList = OSReadyList & ~(PriorityMask[iPriority]);
-      // Put the "max priority current task" into Ready List
-      OSReadyList = OSReadyList | (PriorityMask[pont_event->OSMaxPriority]);
+      OSMutexCeiling(pont_event, Task);
     }
     
     OSExitCritical();
@@ -421,8 +561,9 @@ uint8_t OSMutexRelease(BRTOS_Mutex *pont_event)
 {
   OS_SR_SAVE_VAR
   uint8_t iPriority = (uint8_t)0;
-  #if (VERBOSE == 1)
   uint8_t TaskSelect = 0;
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  ContextType *Task = (ContextType*)&ContextTask[currentTask];
   #endif
   
   #if (ERROR_CHECK == 1)      
@@ -453,17 +594,7 @@ uint8_t OSMutexRelease(BRTOS_Mutex *pont_event)
   #endif
      
   // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)  
-    if(!iNesting){  
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, MUTEXPOST);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, MUTEXPOST);
-      #endif 
-    }else{
-      Update_OSTrace(0, MUTEXPOST);
-    }
-  #endif     
+  OS_TRACE_EVENT(OS_TRACE_MUTEX_POST, pont_event);
 
   // Verify Mutex Owner
   if (pont_event->OSEventOwner != currentTask)
@@ -471,49 +602,81 @@ uint8_t OSMutexRelease(BRTOS_Mutex *pont_event)
     OSExitCritical();
     return ERR_EVENT_OWNER;
   }  
+
+  // A recursive mutex is released by the last release of the owner
+  if ((pont_event->OSMutexOptions & OS_MUTEX_RECURSIVE) && (pont_event->OSEventNesting > 1))
+  {
+    pont_event->OSEventNesting--;
+    OSExitCritical();
+    return OK;
+  }
   
-  
-  // Returns to the original priority, if needed
-  // Copy backuped original priority to the task context
+  // Priority of the owner before the release
   iPriority = ContextTask[currentTask].Priority;
-  if (iPriority != pont_event->OSOriginalPriority)
-  {              
-    // Since current task is executing with another priority, reallocate its priority to the original
-    // into the Ready List
-    // Remove "max priority current task" from the Ready List
-    OSReadyList = OSReadyList & ~(PriorityMask[iPriority]);
-    // Put the "original priority current task" into Ready List
-    OSReadyList = OSReadyList | (PriorityMask[pont_event->OSOriginalPriority]);
-    
-    ContextTask[currentTask].Priority = pont_event->OSOriginalPriority;
+
+  if (!(pont_event->OSMutexOptions & OS_MUTEX_INHERIT))
+  {
+    // Returns to the original priority, if needed
+    // Copy backuped original priority to the task context
+    #if (BRTOS_ROUND_ROBIN_EN == 1)
+    if (Task->InheritBase != EMPTY_PRIO)
+    {
+      // The task keeps the inherited priority, only its base priority returns to the original
+      Task->InheritBase = pont_event->OSOriginalPriority;
+
+      // The priority ceiling returns to the mutex
+      if ((pont_event->OSMaxPriority > 0) && (PriorityVector[pont_event->OSMaxPriority] == EMPTY_PRIO))
+      {
+        PriorityVector[pont_event->OSMaxPriority] = MUTEX_PRIO;
+      }
+    }
+    else
+    #endif
+    if (iPriority != pont_event->OSOriginalPriority)
+    {              
+      // Since current task is executing with another priority, reallocate its priority to the original
+      // into the Ready List
+      OSSetTaskPriority(currentTask, pont_event->OSOriginalPriority);
+
+      // The priority ceiling returns to the mutex
+      PriorityVector[iPriority] = MUTEX_PRIO;
+    }
   }
 
   // Release mutex ownership
   pont_event->OSEventOwner = 0;
+  pont_event->OSEventNesting = 0;
   
   // See if any task is waiting for mutex release
   if (pont_event->OSEventWait != 0)
   {
-    // Selects the highest priority task
-    iPriority = SAScheduler(pont_event->OSEventWaitList);
-
-    // Remove the selected task from the mutex wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+    // Selects the highest priority task and removes it from the mutex wait list
+    TaskSelect = OSEventWaitListSelect(&pont_event->OSEventWaitList, pont_event);
     
     // Decreases the mutex wait list counter
     pont_event->OSEventWait--;
     
     // Changes the task that owns the mutex
-    pont_event->OSEventOwner = PriorityVector[iPriority];    
+    pont_event->OSEventOwner = TaskSelect;
+    pont_event->OSEventNesting = 1;
          
     // Indicates that selected task is ready to run
     #if (VERBOSE == 1)
-    TaskSelect = PriorityVector[iPriority];
     ContextTask[TaskSelect].State = READY;    
     #endif    
     
     // Put the selected task into Ready List
-    OSReadyList = OSReadyList | (PriorityMask[iPriority]);
+    OSReadyListInsert(&ContextTask[TaskSelect]);
+
+    #if (BRTOS_ROUND_ROBIN_EN == 1)
+    // The current task loses the priority inherited from the tasks waiting for this mutex
+    // and the new owner inherits the priority of the remaining waiting tasks
+    (void)OSMutexUpdatePriority(currentTask);
+    if (pont_event->OSMutexOptions & OS_MUTEX_INHERIT)
+    {
+      OSMutexInherit(pont_event);
+    }
+    #endif
         
     // Verify if there is a higher priority task ready to run
     ChangeContext();
@@ -530,6 +693,17 @@ uint8_t OSMutexRelease(BRTOS_Mutex *pont_event)
   if (pont_event->OSMaxPriority > 0){
 	  PriorityVector[pont_event->OSMaxPriority] = MUTEX_PRIO;
   }
+
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  // Updates the priority inherited from the other mutexes of the task
+  (void)OSMutexUpdatePriority(currentTask);
+  #endif
+
+  // A task made ready while the owner had a higher priority may preempt it now
+  if (ContextTask[currentTask].Priority < iPriority)
+  {
+    ChangeContext();
+  }
       
   // Exit Critical Section
   OSExitCritical();      
@@ -0,0 +1,369 @@
+/**
+* \file notify.c
+* \brief BRTOS task notification functions
+*
+* Direct to task notifications. The notification value is kept by the
+* task context, so no event control block is needed to signal a task.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                  OS Task Notification functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#include "BRTOS.h"
+
+#if (BRTOS_TASK_NOTIFY_EN == 1)
+
+// Suspends the current task until a notification or the timeout
+// Must be called inside a critical section, which is exited and entered again by the caller
+static void OSTaskNotifySuspend(ContextType *Task, ostick_t time_wait)
+{
+  osdtick_t timeout;
+
+  Task->NotifyState = OS_NOTIFY_WAITING;
+
+  // Task entered suspended state, waiting for a notification
+  #if (VERBOSE == 1)
+  Task->State = SUSPENDED;
+  Task->SuspendedType = NOTIFICATION;
+  #endif
+
+  // Remove current task from the Ready List
+  OSReadyListRemove(Task);
+
+  // Set timeout overflow
+  if (time_wait)
+  {
+	  timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
+
+	  if (sizeof_ostick_t < 8){
+		  if (timeout >= TICK_COUNT_OVERFLOW)
+		  {
+			  Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+		  }
+		  else
+		  {
+			  Task->TimeToWait = (ostick_t)timeout;
+		  }
+	  }else{
+		  Task->TimeToWait = (ostick_t)timeout;
+	  }
+
+	  // Put task into delay list
+	  IncludeTaskIntoDelayList();
+  } else
+  {
+    Task->TimeToWait = NO_TIMEOUT;
+  }
+
+  // Change Context - Returns on time overflow or notification
+  ChangeContext();
+}
+
+// Verifies why the task was woken up - returns TIMEOUT or OK
+static uint8_t OSTaskNotifyResume(ContextType *Task, ostick_t time_wait)
+{
+  if (time_wait)
+  {
+      // Verify if the reason of task wake up was timeout
+      if(Task->TimeToWait == EXIT_BY_TIMEOUT)
+      {
+          // Test if both timeout and notification have occured before arrive here
+          if (Task->NotifyState == OS_NOTIFY_WAITING)
+          {
+            Task->NotifyState = OS_NOTIFY_IDLE;
+
+            // Indicates notification timeout
+            return TIMEOUT;
+          }
+      }
+      else
+      {
+          // Remove the time to wait condition
+          Task->TimeToWait = NO_TIMEOUT;
+
+          // Remove from delay list
+          RemoveFromDelayList();
+      }
+  }
+
+  return OK;
+}
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Task Notify Function                        /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSTaskNotify(BRTOS_TH TaskHandle, uint32_t value, uint8_t action)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+
+  #if (ERROR_CHECK == 1)
+    // Verifies the task handle
+    if ((TaskHandle == 0) || (TaskHandle > NUMBER_OF_TASKS))
+    {
+      return(NOT_VALID_TASK);
+    }
+  #endif
+
+  Task = (ContextType*)&ContextTask[TaskHandle];
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  switch(action)
+  {
+    case OS_NOTIFY_SET_BITS:
+      Task->NotifyValue |= value;
+      break;
+
+    case OS_NOTIFY_INCREMENT:
+      Task->NotifyValue++;
+      break;
+
+    case OS_NOTIFY_NO_OVERWRITE:
+      if (Task->NotifyState == OS_NOTIFY_PENDING)
+      {
+        // Exit Critical Section
+        #if (NESTING_INT == 0)
+        if (!iNesting)
+        #endif
+           OSExitCritical();
+
+        return BUSY_RESOURCE;
+      }
+      Task->NotifyValue = value;
+      break;
+
+    case OS_NOTIFY_OVERWRITE:
+      Task->NotifyValue = value;
+      break;
+
+    default:
+      break;
+  }
+
+  if (Task->NotifyState == OS_NOTIFY_WAITING)
+  {
+    Task->NotifyState = OS_NOTIFY_PENDING;
+
+    // Put the task into Ready List
+    #if (VERBOSE == 1)
+    Task->State = READY;
+    #endif
+
+    OSReadyListInsert(Task);
+
+    // If outside of an interrupt service routine, change context to the highest priority task
+    // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
+    if (!iNesting)
+    {
+      ChangeContext();
+    }
+  }
+  else
+  {
+    Task->NotifyState = OS_NOTIFY_PENDING;
+  }
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Task Notify Take Function                   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSTaskNotifyTake(uint8_t clear, uint32_t *value, ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+
+  #if (ERROR_CHECK == 1)
+    // Can not use notification take function from interrupt handling code
+    if(iNesting > 0)
+    {
+      return(IRQ_PEND_ERR);
+    }
+  #endif
+
+  // Enter Critical Section
+  OSEnterCritical();
+
+  Task = (ContextType*)&ContextTask[currentTask];
+
+  if (Task->NotifyValue == 0)
+  {
+    // If no timeout is used and the value is zero, exit with an error
+    if (time_wait == NO_TIMEOUT)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
+    }
+
+    OSTaskNotifySuspend(Task, time_wait);
+
+    // Exit Critical Section
+    OSExitCritical();
+    // Enter Critical Section
+    OSEnterCritical();
+
+    if (OSTaskNotifyResume(Task, time_wait) == TIMEOUT)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return TIMEOUT;
+    }
+
+    // Notified without changing the value
+    if (Task->NotifyValue == 0)
+    {
+      Task->NotifyState = OS_NOTIFY_IDLE;
+
+      // Exit Critical Section
+      OSExitCritical();
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
+    }
+  }
+
+  if (value != NULL)
+  {
+    *value = Task->NotifyValue;
+  }
+
+  if (clear)
+  {
+    Task->NotifyValue = 0;
+  }
+  else
+  {
+    Task->NotifyValue--;
+  }
+
+  Task->NotifyState = OS_NOTIFY_IDLE;
+
+  // Exit Critical Section
+  OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Task Notify Wait Function                   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+
+  #if (ERROR_CHECK == 1)
+    // Can not use notification wait function from interrupt handling code
+    if(iNesting > 0)
+    {
+      return(IRQ_PEND_ERR);
+    }
+  #endif
+
+  // Enter Critical Section
+  OSEnterCritical();
+
+  Task = (ContextType*)&ContextTask[currentTask];
+
+  if (Task->NotifyState != OS_NOTIFY_PENDING)
+  {
+    // If no timeout is used and there is no notification, exit with an error
+    if (time_wait == NO_TIMEOUT)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
+    }
+
+    Task->NotifyValue &= ~clear_on_entry;
+
+    OSTaskNotifySuspend(Task, time_wait);
+
+    // Exit Critical Section
+    OSExitCritical();
+    // Enter Critical Section
+    OSEnterCritical();
+
+    if (OSTaskNotifyResume(Task, time_wait) == TIMEOUT)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return TIMEOUT;
+    }
+  }
+
+  if (value != NULL)
+  {
+    *value = Task->NotifyValue;
+  }
+
+  Task->NotifyValue &= ~clear_on_exit;
+  Task->NotifyState = OS_NOTIFY_IDLE;
+
+  // Exit Critical Section
+  OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,392 @@
+/**
+* \file pendmultiple.c
+* \brief BRTOS wait for multiple events
+*
+* A task waits for the first of several semaphores, mailboxes and queues.
+* The task is included into the wait list of every event and the first
+* post removes it from the other wait lists.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                   OS Pend Multiple functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#include "BRTOS.h"
+
+#if (BRTOS_PEND_MULTIPLE_EN == 1)
+
+// Finds the wait list and the wait counter of an event
+static uint8_t OSPendMultipleWaitList(OS_PEND_EVENT *pend, PriorityType **WaitList, uint8_t **Wait)
+{
+  switch(pend->OSPendType)
+  {
+    #if (BRTOS_SEM_EN == 1)
+    case OS_PEND_SEM:
+      *WaitList = &((BRTOS_Sem*)pend->OSPendEvent)->OSEventWaitList;
+      *Wait     = &((BRTOS_Sem*)pend->OSPendEvent)->OSEventWait;
+      return TRUE;
+    #endif
+
+    #if (BRTOS_MBOX_EN == 1)
+    case OS_PEND_MBOX:
+      *WaitList = &((BRTOS_Mbox*)pend->OSPendEvent)->OSEventWaitList;
+      *Wait     = &((BRTOS_Mbox*)pend->OSPendEvent)->OSEventWait;
+      return TRUE;
+    #endif
+
+    #if (BRTOS_QUEUE_EN == 1)
+    case OS_PEND_QUEUE:
+      *WaitList = &((BRTOS_Queue*)pend->OSPendEvent)->OSEventWaitList;
+      *Wait     = &((BRTOS_Queue*)pend->OSPendEvent)->OSEventWait;
+      return TRUE;
+    #endif
+
+    #if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+    case OS_PEND_DQUEUE:
+      *WaitList = &((BRTOS_Queue*)pend->OSPendEvent)->OSEventWaitList;
+      *Wait     = &((BRTOS_Queue*)pend->OSPendEvent)->OSEventWait;
+      return TRUE;
+    #endif
+
+    default:
+      return FALSE;
+  }
+}
+
+// Takes the semaphore, message or entry of an event, if available
+// A semaphore post that selects a waiting task does not increase the semaphore count
+static uint8_t OSPendMultipleTake(OS_PEND_EVENT *pend, uint8_t posted)
+{
+  #if (BRTOS_SEM_EN == 1)
+  BRTOS_Sem   *sem;
+  #endif
+  #if (BRTOS_MBOX_EN == 1)
+  BRTOS_Mbox  *mbox;
+  #endif
+  #if (BRTOS_QUEUE_EN == 1)
+  OS_QUEUE    *cqueue;
+  #endif
+
+  switch(pend->OSPendType)
+  {
+    #if (BRTOS_SEM_EN == 1)
+    case OS_PEND_SEM:
+      sem = (BRTOS_Sem*)pend->OSPendEvent;
+      if (posted)
+      {
+        return TRUE;
+      }
+      if (sem->OSEventCount > 0)
+      {
+        sem->OSEventCount--;
+        return TRUE;
+      }
+      return FALSE;
+    #endif
+
+    #if (BRTOS_MBOX_EN == 1)
+    case OS_PEND_MBOX:
+      mbox = (BRTOS_Mbox*)pend->OSPendEvent;
+      if (mbox->OSEventState == AVAILABLE_MESSAGE)
+      {
+        *(void**)pend->OSPendData = mbox->OSEventPointer;
+        mbox->OSEventState = NO_MESSAGE;
+        return TRUE;
+      }
+      return FALSE;
+    #endif
+
+    #if (BRTOS_QUEUE_EN == 1)
+    case OS_PEND_QUEUE:
+      cqueue = ((BRTOS_Queue*)pend->OSPendEvent)->OSEventPointer;
+      if (cqueue->OSQEntries > 0)
+      {
+        // Verify for output pointer overflow
+        if (cqueue->OSQOut == cqueue->OSQEnd)
+          cqueue->OSQOut = cqueue->OSQStart;
+
+        *(uint8_t*)pend->OSPendData = *cqueue->OSQOut;
+        cqueue->OSQOut++;
+        cqueue->OSQEntries--;
+        return TRUE;
+      }
+      return FALSE;
+    #endif
+
+    #if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+    case OS_PEND_DQUEUE:
+      return OSDQueueTake((BRTOS_Queue*)pend->OSPendEvent, pend->OSPendData);
+    #endif
+
+    default:
+      return FALSE;
+  }
+}
+
+
+
+uint8_t OSPendMultipleHas(ContextType *Task, void *Event)
+{
+  uint8_t i;
+
+  for(i=0;i<Task->WaitMultipleCount;i++)
+  {
+    if (Task->WaitMultiple[i].OSPendEvent == Event)
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+
+
+// With a NULL event the task is removed from every wait list (timeout)
+void OSPendMultipleSelect(ContextType *Task, void *Event)
+{
+  OS_PEND_EVENT *events = Task->WaitMultiple;
+  PriorityType  *WaitList;
+  uint8_t       *Wait;
+  uint8_t       i;
+
+  // The wait lists of the other events verify if the task is still waiting
+  Task->WaitMultiple = NULL;
+
+  for(i=0;i<Task->WaitMultipleCount;i++)
+  {
+    if (events[i].OSPendEvent == Event)
+    {
+      // Removed from this wait list by the event itself
+      Task->WaitMultipleIndex = i;
+    }
+    else
+    {
+      if (OSPendMultipleWaitList(&events[i], &WaitList, &Wait))
+      {
+        OSEventWaitListRemove(WaitList, events[i].OSPendEvent, Task);
+        (*Wait)--;
+      }
+    }
+  }
+}
+
+
+
+void OSPendMultipleInsert(ContextType *Task, OS_PEND_EVENT *events, uint8_t count)
+{
+  PriorityType  *WaitList;
+  uint8_t       *Wait;
+  uint8_t       i;
+
+  // Allocates the task on the wait list of every event
+  // Events of an unknown type are skipped (only verified with ERROR_CHECK)
+  for(i=0;i<count;i++)
+  {
+    if (OSPendMultipleWaitList(&events[i], &WaitList, &Wait))
+    {
+      (*Wait)++;
+      OSEventWaitListInsert(WaitList, events[i].OSPendEvent, Task);
+    }
+  }
+
+  #if (BRTOS_ROUND_ROBIN_EN == 1)
+  // The events of the task are found through WaitMultiple
+  Task->WaitEvent = NULL;
+  #endif
+
+  Task->WaitMultiple = events;
+  Task->WaitMultipleCount = count;
+}
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Pend Multiple Function                      /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSPendMultiple(OS_PEND_EVENT *events, uint8_t count, uint8_t *index, ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  osdtick_t timeout;
+  ContextType *Task;
+  uint8_t i;
+  #if (ERROR_CHECK == 1)
+  PriorityType *WaitList;
+  uint8_t *Wait;
+  uint8_t j;
+  #endif
+
+  #if (ERROR_CHECK == 1)
+    // Can not use pend multiple function from interrupt handling code
+    if(iNesting > 0)
+    {
+      return(IRQ_PEND_ERR);
+    }
+
+    // Verifies if the pointers are NULL
+    if((events == NULL) || (index == NULL))
+    {
+      return(NULL_EVENT_POINTER);
+    }
+
+    for(i=0;i<count;i++)
+    {
+      if ((events[i].OSPendEvent == NULL) || (!OSPendMultipleWaitList(&events[i], &WaitList, &Wait)))
+      {
+        return(INVALID_PARAMETERS);
+      }
+
+      // An event can only be in the wait list once
+      for(j=0;j<i;j++)
+      {
+        if (events[j].OSPendEvent == events[i].OSPendEvent)
+        {
+          return(INVALID_PARAMETERS);
+        }
+      }
+    }
+  #endif
+
+  if (count == 0)
+  {
+    return(INVALID_PARAMETERS);
+  }
+
+  // Enter Critical Section
+  OSEnterCritical();
+
+  // Verify if any event is available, in the order of the array
+  for(i=0;i<count;i++)
+  {
+    if (OSPendMultipleTake(&events[i], FALSE))
+    {
+      *index = i;
+
+      // Exit Critical Section
+      OSExitCritical();
+      return OK;
+    }
+  }
+
+  // If no timeout is used and no event is available, exit with an error
+  if (time_wait == NO_TIMEOUT){
+    // Exit Critical Section
+    OSExitCritical();
+    return EXIT_BY_NO_ENTRY_AVAILABLE;
+  }
+
+  Task = (ContextType*)&ContextTask[currentTask];
+
+  // Allocates the current task on the wait list of every event
+  OSPendMultipleInsert(Task, events, count);
+
+  // Task entered suspended state, waiting for the events
+  #if (VERBOSE == 1)
+  Task->State = SUSPENDED;
+  Task->SuspendedType = PEND_MULTIPLE;
+  #endif
+
+  // Remove current task from the Ready List
+  OSReadyListRemove(Task);
+
+  // Set timeout overflow
+  if (time_wait)
+  {
+	  timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
+
+	  if (sizeof_ostick_t < 8){
+		  if (timeout >= TICK_COUNT_OVERFLOW)
+		  {
+			  Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+		  }
+		  else
+		  {
+			  Task->TimeToWait = (ostick_t)timeout;
+		  }
+	  }else{
+		  Task->TimeToWait = (ostick_t)timeout;
+	  }
+
+	  // Put task into delay list
+	  IncludeTaskIntoDelayList();
+  } else
+  {
+    Task->TimeToWait = NO_TIMEOUT;
+  }
+
+  // Change Context - Returns on time overflow or on the post of one of the events
+  ChangeContext();
+
+  // Exit Critical Section
+  OSExitCritical();
+  // Enter Critical Section
+  OSEnterCritical();
+
+  if (time_wait)
+  {
+      // Verify if the reason of task wake up was timeout
+      if(Task->TimeToWait == EXIT_BY_TIMEOUT)
+      {
+          // Test if both timeout and post have occured before arrive here
+          if (Task->WaitMultiple != NULL)
+          {
+            // Remove the task from every wait list
+            OSPendMultipleSelect(Task, NULL);
+
+            // Exit Critical Section
+            OSExitCritical();
+
+            // Indicates timeout
+            return TIMEOUT;
+          }
+      }
+      else
+      {
+          // Remove the time to wait condition
+          Task->TimeToWait = NO_TIMEOUT;
+
+          // Remove from delay list
+          RemoveFromDelayList();
+      }
+  }
+
+  *index = Task->WaitMultipleIndex;
+
+  // The post that woke up the task left the message or entry into the event,
+  // unless a higher priority task has read it first
+  if (!OSPendMultipleTake(&events[*index], TRUE))
+  {
+    // Exit Critical Section
+    OSExitCritical();
+    return EXIT_BY_NO_ENTRY_AVAILABLE;
+  }
+
+  // Exit Critical Section
+  OSExitCritical();
+
+  return OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+#endif
@@ -77,6 +77,7 @@
 *********************************************************************************************************/
 
 #include "BRTOS.h"
+#include <string.h>
 
 #if (PROCESSOR == COLDFIRE_V1 && __CWCC__)
 #pragma warn_implicitconv off
@@ -158,7 +159,7 @@ uint8_t OSQueueCreate(uint16_t size, BRTOS_Queue **event)
   pont_event->OSEventWait = 0;
 
 
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
 
   *event = pont_event;
 
@@ -339,7 +340,6 @@ uint8_t OSQueueClean(BRTOS_Queue *pont_event)
 uint8_t OSQueuePend (BRTOS_Queue *pont_event, uint8_t* pdata, ostick_t time_wait)
 {
   OS_SR_SAVE_VAR
-  uint8_t iPriority = 0;
   osdtick_t timeout;
   ContextType *Task;
   OS_QUEUE *cqueue = pont_event->OSEventPointer;
@@ -372,13 +372,7 @@ uint8_t OSQueuePend (BRTOS_Queue *pont_event, uint8_t* pdata, ostick_t time_wait
   #endif
 
   // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, QUEUEPEND);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, QUEUEPEND);
-      #endif
-  #endif
+  OS_TRACE_EVENT(OS_TRACE_QUEUE_PEND, pont_event);
 
   // Verify if there is data in the queue
   if(cqueue->OSQEntries > 0)
@@ -411,14 +405,11 @@ uint8_t OSQueuePend (BRTOS_Queue *pont_event, uint8_t* pdata, ostick_t time_wait
 
     Task = (ContextType*)&ContextTask[currentTask];
 
-    // Copy task priority to local scope
-    iPriority = Task->Priority;
-
     // Increases the queue wait list counter
     pont_event->OSEventWait++;
 
     // Allocates the current task on the queue wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList | (PriorityMask[iPriority]);
+    OSEventWaitListInsert(&pont_event->OSEventWaitList, pont_event, Task);
 
     // Task entered suspended state, waiting for queue post
     #if (VERBOSE == 1)
@@ -427,7 +418,7 @@ uint8_t OSQueuePend (BRTOS_Queue *pont_event, uint8_t* pdata, ostick_t time_wait
     #endif
 
     // Remove current task from the Ready List
-    OSReadyList = OSReadyList & ~(PriorityMask[iPriority]);
+    OSReadyListRemove(Task);
 
     // Set timeout overflow
     if (time_wait)
@@ -468,10 +459,10 @@ uint8_t OSQueuePend (BRTOS_Queue *pont_event, uint8_t* pdata, ostick_t time_wait
         if(Task->TimeToWait == EXIT_BY_TIMEOUT)
         {
             // Test if both timeout and post have occured before arrive here
-            if ((pont_event->OSEventWaitList & PriorityMask[iPriority]))
+            if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, Task))
             {
               // Remove the task from the queue wait list
-              pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+              OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
 
               // Decreases the queue wait list counter
               pont_event->OSEventWait--;
@@ -531,10 +522,7 @@ uint8_t OSQueuePend (BRTOS_Queue *pont_event, uint8_t* pdata, ostick_t time_wait
 uint8_t OSQueuePost(BRTOS_Queue *pont_event, uint8_t data)
 {
   OS_SR_SAVE_VAR
-  uint8_t iPriority = (uint8_t)0;
-  #if (VERBOSE == 1)
   uint8_t TaskSelect = 0;
-  #endif
   OS_QUEUE *cqueue = pont_event->OSEventPointer;
 
   #if (ERROR_CHECK == 1)
@@ -565,17 +553,7 @@ uint8_t OSQueuePost(BRTOS_Queue *pont_event, uint8_t data)
   #endif
 
   // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)
-    if(!iNesting){
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, QUEUEPOST);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, QUEUEPOST);
-      #endif
-    }else{
-      Update_OSTrace(0, QUEUEPOST);
-    }
-  #endif
+  OS_TRACE_EVENT(OS_TRACE_QUEUE_POST, pont_event);
 
   // Checks for queue overflow
   if (cqueue->OSQEntries < cqueue->OSQSize)
@@ -608,22 +586,18 @@ uint8_t OSQueuePost(BRTOS_Queue *pont_event, uint8_t data)
   // See if any task is waiting for new data in the queue
   if (pont_event->OSEventWait != 0)
   {
-    // Selects the highest priority task
-    iPriority = SAScheduler(pont_event->OSEventWaitList);
-
-    // Remove the selected task from the queue wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+    // Selects the highest priority task and removes it from the queue wait list
+    TaskSelect = OSEventWaitListSelect(&pont_event->OSEventWaitList, pont_event);
 
     // Decreases the queue wait list counter
     pont_event->OSEventWait--;
 
     // Put the selected task into Ready List
     #if (VERBOSE == 1)
-    TaskSelect = PriorityVector[iPriority];
     ContextTask[TaskSelect].State = READY;
     #endif
 
-    OSReadyList = OSReadyList | (PriorityMask[iPriority]);
+    OSReadyListInsert(&ContextTask[TaskSelect]);
 
     // If outside of an interrupt service routine, change context to the highest priority task
     // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
@@ -1174,6 +1148,8 @@ uint8_t OSDQueueCreate(uint16_t queue_length, OS_CPU_TYPE type_size, BRTOS_Queue
   cqueue->OSQLength  = queue_length;
   cqueue->OSQTSize   = (uint16_t)type_size;
   cqueue->OSQEntries = 0;
+  cqueue->OSQReserved = 0;
+  cqueue->OSQPeeked  = 0;
   cqueue->OSQEnd     = cqueue->OSQStart + size_in_bytes;
   cqueue->OSQIn      = cqueue->OSQStart;
   cqueue->OSQOut     = cqueue->OSQStart;
@@ -1183,7 +1159,7 @@ uint8_t OSDQueueCreate(uint16_t queue_length, OS_CPU_TYPE type_size, BRTOS_Queue
   pont_event->OSEventWait = 0;
 
 
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
 
   *event = pont_event;
 
@@ -1228,7 +1204,7 @@ uint8_t OSDQueueDelete (BRTOS_Queue **event)
   pont_event->OSEventAllocated = 0;
   pont_event->OSEventCount     = 0;
   pont_event->OSEventWait      = 0;
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
 
   BRTOS_DEALLOC(pont_event);
 
@@ -1267,6 +1243,8 @@ uint8_t OSDQueueClean(BRTOS_Queue *pont_event)
      OSEnterCritical();
 
   cqueue->OSQEntries  = 0;
+  cqueue->OSQReserved = 0;
+  cqueue->OSQPeeked   = 0;
   cqueue->OSQIn       = cqueue->OSQStart;
   cqueue->OSQOut      = cqueue->OSQStart;
 
@@ -1288,21 +1266,214 @@ uint8_t OSDQueueClean(BRTOS_Queue *pont_event)
 
 
 
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Dynamic Queue Copy Functions                /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Entries up to this size are copied word by word, instead of calling memcpy
+#define OS_DQUEUE_WORD_COPY_MAX   (4 * sizeof(OS_CPU_TYPE))
+
+static void OSDQueueCopy(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+  OS_CPU_TYPE       *wdst;
+  const OS_CPU_TYPE *wsrc;
+
+  // Aligned small entries (pointers, messages of a few words) are copied word by word
+  if ((size <= OS_DQUEUE_WORD_COPY_MAX) &&
+      ((((size_t)dst | (size_t)src | (size_t)size) & (sizeof(OS_CPU_TYPE) - 1)) == 0))
+  {
+    wdst = (OS_CPU_TYPE*)dst;
+    wsrc = (const OS_CPU_TYPE*)src;
+    size = size / sizeof(OS_CPU_TYPE);
+    while(size)
+    {
+      *wdst++ = *wsrc++;
+      size--;
+    }
+  }
+  else
+  {
+    memcpy(dst, src, (size_t)size);
+  }
+}
+
+// Number of entries that can be written. The peeked entry buffer is not free until its release
+static uint16_t OSDQueueFree(OS_DQUEUE *cqueue)
+{
+  return (uint16_t)(cqueue->OSQLength - cqueue->OSQEntries - cqueue->OSQPeeked);
+}
+
+// Copies entries into the queue, in at most two contiguous chunks (before and after the wrap point)
+static void OSDQueueWrite(OS_DQUEUE *cqueue, const uint8_t *src, uint16_t entries)
+{
+  uint32_t size  = (uint32_t)entries * cqueue->OSQTSize;
+  uint32_t chunk;
+
+  // Verify for input pointer overflow
+  if (cqueue->OSQIn == cqueue->OSQEnd)
+    cqueue->OSQIn = cqueue->OSQStart;
+
+  chunk = (uint32_t)(cqueue->OSQEnd - cqueue->OSQIn);
+  if (chunk > size)
+    chunk = size;
+
+  OSDQueueCopy(cqueue->OSQIn, src, chunk);
+  cqueue->OSQIn += chunk;
+  size -= chunk;
+
+  if (size)
+  {
+    OSDQueueCopy(cqueue->OSQStart, src + chunk, size);
+    cqueue->OSQIn = cqueue->OSQStart + size;
+  }
+
+  cqueue->OSQEntries = (uint16_t)(cqueue->OSQEntries + entries);
+}
+
+// Copies entries from the queue, in at most two contiguous chunks (before and after the wrap point)
+static void OSDQueueRead(OS_DQUEUE *cqueue, uint8_t *dst, uint16_t entries)
+{
+  uint32_t size  = (uint32_t)entries * cqueue->OSQTSize;
+  uint32_t chunk;
+
+  // Verify for output pointer overflow
+  if (cqueue->OSQOut == cqueue->OSQEnd)
+    cqueue->OSQOut = cqueue->OSQStart;
+
+  chunk = (uint32_t)(cqueue->OSQEnd - cqueue->OSQOut);
+  if (chunk > size)
+    chunk = size;
+
+  OSDQueueCopy(dst, cqueue->OSQOut, chunk);
+  cqueue->OSQOut += chunk;
+  size -= chunk;
+
+  if (size)
+  {
+    OSDQueueCopy(dst + chunk, cqueue->OSQStart, size);
+    cqueue->OSQOut = cqueue->OSQStart + size;
+  }
+
+  cqueue->OSQEntries = (uint16_t)(cqueue->OSQEntries - entries);
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 /////      Dynamic Queue Pend Function                 /////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 
+// Puts the current task into the queue wait list, until a queue post or timeout
+// Must be called inside a critical section, which must be left to switch the context
+static void OSDQueueSuspend(BRTOS_Queue *pont_event, ostick_t time_wait)
+{
+  osdtick_t   timeout;
+  ContextType *Task = (ContextType*)&ContextTask[currentTask];
+
+  // Increases the queue wait list counter
+  pont_event->OSEventWait++;
+
+  // Allocates the current task on the queue wait list
+  OSEventWaitListInsert(&pont_event->OSEventWaitList, pont_event, Task);
+
+  // Task entered suspended state, waiting for queue post
+  #if (VERBOSE == 1)
+  Task->State = SUSPENDED;
+  Task->SuspendedType = QUEUE;
+  #endif
+
+  // Remove current task from the Ready List
+  OSReadyListRemove(Task);
+
+  // Set timeout overflow
+  if (time_wait)
+  {
+	  timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
+
+	  if (sizeof_ostick_t < 8){
+		  if (timeout >= TICK_COUNT_OVERFLOW)
+		  {
+			  Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+		  }
+		  else
+		  {
+			  Task->TimeToWait = (ostick_t)timeout;
+		  }
+	  }else{
+		  Task->TimeToWait = (ostick_t)timeout;
+	  }
+
+    // Put task into delay list
+    IncludeTaskIntoDelayList();
+  } else
+  {
+    Task->TimeToWait = NO_TIMEOUT;
+  }
+
+  // Change Context - Returns on time overflow or queue post
+  ChangeContext();
+}
+
+// Verifies the reason of the current task wake up - queue post or timeout
+static uint8_t OSDQueueResume(BRTOS_Queue *pont_event, ostick_t time_wait)
+{
+  ContextType *Task = (ContextType*)&ContextTask[currentTask];
+
+  if (time_wait)
+  {
+      // Verify if the reason of task wake up was queue timeout
+      if(Task->TimeToWait == EXIT_BY_TIMEOUT)
+      {
+          // Test if both timeout and post have occured before arrive here
+          if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, Task))
+          {
+            // Remove the task from the queue wait list
+            OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
+
+            // Decreases the queue wait list counter
+            pont_event->OSEventWait--;
+
+            // Indicates queue timeout
+            return TIMEOUT;
+          }
+      }
+      else
+      {
+          // Remove the time to wait condition
+          Task->TimeToWait = NO_TIMEOUT;
+
+          // Remove from delay list
+          RemoveFromDelayList();
+      }
+  }
+
+  return READ_BUFFER_OK;
+}
+
 uint8_t OSDQueuePend (BRTOS_Queue *pont_event, void *pdata, ostick_t time_wait)
+{
+  uint16_t count = 1;
+
+  return OSDQueuePendN(pont_event, pdata, &count, time_wait);
+}
+
+uint8_t OSDQueuePendN (BRTOS_Queue *pont_event, void *pdata, uint16_t *count, ostick_t time_wait)
 {
   OS_SR_SAVE_VAR
-  uint8_t       iPriority = 0;
-  osdtick_t   timeout;
   uint16_t      n;
-  ContextType *Task;
+  uint8_t       status;
   OS_DQUEUE   *cqueue;
-  uint8_t       *dst;
 
   #if (ERROR_CHECK == 1)
     /// Can not use Queue pend function from interrupt handling code
@@ -1316,13 +1487,19 @@ uint8_t OSDQueuePend (BRTOS_Queue *pont_event, void *pdata, ostick_t time_wait)
     {
       return(NULL_EVENT_POINTER);
     }
+
+    // At least one entry must be read
+    if ((count == NULL) || (*count == 0))
+    {
+      return(INVALID_PARAMETERS);
+    }
   #endif
 
   // Enter Critical Section
   OSEnterCritical();
   cqueue  = pont_event->OSEventPointer;
-  n       = cqueue->OSQTSize;
-  dst     = (uint8_t*)pdata;
+  n       = *count;
+  *count  = 0;
 
   #if (ERROR_CHECK == 1)
     // Verifies if the event is allocated
@@ -1335,149 +1512,196 @@ uint8_t OSDQueuePend (BRTOS_Queue *pont_event, void *pdata, ostick_t time_wait)
   #endif
 
   // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, QUEUEPEND);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, QUEUEPEND);
-      #endif
-  #endif
+  OS_TRACE_EVENT(OS_TRACE_QUEUE_PEND, pont_event);
 
   // Verify if there is data in the queue
-  if(cqueue->OSQEntries > 0)
+  if(cqueue->OSQEntries == 0)
   {
-    // Verify for output pointer overflow
-    if (cqueue->OSQOut == cqueue->OSQEnd)
-      cqueue->OSQOut = cqueue->OSQStart;
-
-    // Copy data from queue
-    while(n)
+    // If no timeout is used and the queue is empty, exit the queue with an error
+    if (time_wait == NO_TIMEOUT)
     {
-      // copy data and increase the input pointer
-      *dst++ = *cqueue->OSQOut++;
-      n--;
+      // Exit Critical Section
+      OSExitCritical();
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
     }
 
-    // Decreases queue entries
-    cqueue->OSQEntries--;
+    OSDQueueSuspend(pont_event, time_wait);
 
     // Exit Critical Section
     OSExitCritical();
-    return READ_BUFFER_OK;
+    // Enter Critical Section
+    OSEnterCritical();
+
+    status = OSDQueueResume(pont_event, time_wait);
+    if (status != READ_BUFFER_OK)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return status;
+    }
+
+    // The post that woke up the task wrote at least one entry,
+    // unless a higher priority task has read it first
+    if (cqueue->OSQEntries == 0)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
+    }
   }
-  else
-  {
-  	// If no timeout is used and the queue is empty, exit the queue with an error
-	if (time_wait == NO_TIMEOUT){
-		// Exit Critical Section
-	    OSExitCritical();
-	    return EXIT_BY_NO_ENTRY_AVAILABLE;
-	}
 
-    Task = (ContextType*)&ContextTask[currentTask];
+  // Copy as many entries as available
+  if (n > cqueue->OSQEntries)
+    n = cqueue->OSQEntries;
 
-    // Copy task priority to local scope
-    iPriority = Task->Priority;
+  OSDQueueRead(cqueue, (uint8_t*)pdata, n);
+  *count = n;
 
-    // Increases the queue wait list counter
-    pont_event->OSEventWait++;
+  // Exit Critical Section
+  OSExitCritical();
+  return READ_BUFFER_OK;
+}
 
-    // Allocates the current task on the queue wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList | (PriorityMask[iPriority]);
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
 
-    // Task entered suspended state, waiting for queue post
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Post Dynamic Queue Function                 /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+// Wakes up one waiting task for each new entry. Must be called inside a critical section.
+static void OSDQueueWakeUp(BRTOS_Queue *pont_event, uint16_t entries)
+{
+  uint8_t TaskSelect = 0;
+  uint8_t Wake = FALSE;
+
+  while ((entries > 0) && (pont_event->OSEventWait != 0))
+  {
+    // Selects the highest priority task and removes it from the queue wait list
+    TaskSelect = OSEventWaitListSelect(&pont_event->OSEventWaitList, pont_event);
+
+    // Decreases the queue wait list counter
+    pont_event->OSEventWait--;
+
+    // Put the selected task into Ready List
     #if (VERBOSE == 1)
-    Task->State = SUSPENDED;
-    Task->SuspendedType = QUEUE;
+    ContextTask[TaskSelect].State = READY;
     #endif
 
-    // Remove current task from the Ready List
-    OSReadyList = OSReadyList & ~(PriorityMask[iPriority]);
+    OSReadyListInsert(&ContextTask[TaskSelect]);
 
-    // Set timeout overflow
-    if (time_wait)
-    {
-  	  timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
+    Wake = TRUE;
+    entries--;
+  }
 
-  	  if (sizeof_ostick_t < 8){
-  		  if (timeout >= TICK_COUNT_OVERFLOW)
-  		  {
-  			  Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
-  		  }
-  		  else
-  		  {
-  			  Task->TimeToWait = (ostick_t)timeout;
-  		  }
-  	  }else{
-  		  Task->TimeToWait = (ostick_t)timeout;
-  	  }
+  // If outside of an interrupt service routine, change context to the highest priority task
+  // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
+  if ((Wake == TRUE) && (!iNesting))
+  {
+    // Verify if there is a higher priority task ready to run
+    ChangeContext();
+  }
+}
 
-      // Put task into delay list
-      IncludeTaskIntoDelayList();
-    } else
+uint8_t OSDQueuePost(BRTOS_Queue *pont_event, void *pdata)
+{
+  uint16_t count = 1;
+
+  return OSDQueuePostN(pont_event, pdata, &count);
+}
+
+uint8_t OSDQueuePostN(BRTOS_Queue *pont_event, void *pdata, uint16_t *count)
+{
+  OS_SR_SAVE_VAR
+  uint16_t    n;
+  uint16_t    requested;
+  OS_DQUEUE *cqueue;
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the pointer is NULL
+    if(pont_event == NULL)
     {
-      Task->TimeToWait = NO_TIMEOUT;
+      return(NULL_EVENT_POINTER);
     }
 
-    // Change Context - Returns on time overflow or queue post
-    ChangeContext();
+    // At least one entry must be written
+    if ((count == NULL) || (*count == 0))
+    {
+      return(INVALID_PARAMETERS);
+    }
+  #endif
 
-    // Exit Critical Section
-    OSExitCritical();
-    // Enter Critical Section
-    OSEnterCritical();
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
 
-    if (time_wait)
-    {
-        // Verify if the reason of task wake up was queue timeout
-        if(Task->TimeToWait == EXIT_BY_TIMEOUT)
-        {
-            // Test if both timeout and post have occured before arrive here
-            if ((pont_event->OSEventWaitList & PriorityMask[iPriority]))
-            {
-              // Remove the task from the queue wait list
-              pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+  cqueue    = pont_event->OSEventPointer;
+  requested = *count;
+  *count    = 0;
 
-              // Decreases the queue wait list counter
-              pont_event->OSEventWait--;
+  #if (ERROR_CHECK == 1)
+    // Verifies if the event is allocated
+    if(pont_event->OSEventAllocated != TRUE)
+    {
+      // Exit Critical Section
+      #if (NESTING_INT == 0)
+      if (!iNesting)
+      #endif
+         OSExitCritical();
+      return(ERR_EVENT_NO_CREATED);
+    }
+  #endif
 
-              // Exit Critical Section
-              OSExitCritical();
+  // BRTOS TRACE SUPPORT
+  OS_TRACE_EVENT(OS_TRACE_QUEUE_POST, pont_event);
 
-              // Indicates queue timeout
-              return TIMEOUT;
-            }
-        }
-        else
-        {
-            // Remove the time to wait condition
-            Task->TimeToWait = NO_TIMEOUT;
+  // Checks for queue overflow - a reserved entry holds the queue input
+  n = OSDQueueFree(cqueue);
+  if ((n == 0) || (cqueue->OSQReserved != 0))
+  {
+     // Exit Critical Section
+     #if (NESTING_INT == 0)
+     if (!iNesting)
+     #endif
+       OSExitCritical();
 
-            // Remove from delay list
-            RemoveFromDelayList();
-        }
+     // Indicates queue overflow
+     return BUFFER_UNDERRUN;
+  }
 
-    }
+  // Copy as many entries as fit into the queue
+  if (n > requested)
+    n = requested;
 
-    // Verify for output pointer overflow
-    if (cqueue->OSQOut == cqueue->OSQEnd)
-      cqueue->OSQOut = cqueue->OSQStart;
+  OSDQueueWrite(cqueue, (const uint8_t*)pdata, n);
+  *count = n;
 
-    // Copy data from queue
-    while(n)
-    {
-      // copy data and increase the input pointer
-      *dst++ = *cqueue->OSQOut++;
-      n--;
-    }
+  // See if any task is waiting for new data in the queue
+  OSDQueueWakeUp(pont_event, n);
 
-    // Decreases queue entries
-    cqueue->OSQEntries--;
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
 
-    // Exit Critical Section
-    OSExitCritical();
-    return READ_BUFFER_OK;
+  // Indicates queue overflow if some entries were not written
+  if (n < requested)
+  {
+    return BUFFER_UNDERRUN;
   }
+
+  return WRITE_BUFFER_OK;
 }
 
 ////////////////////////////////////////////////////////////
@@ -1491,26 +1715,22 @@ uint8_t OSDQueuePend (BRTOS_Queue *pont_event, void *pdata, ostick_t time_wait)
 
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
-/////      Post Dynamic Queue Function                 /////
+/////      Dynamic Queue Zero Copy Functions           /////
+/////                                                  /////
+/////  The producer writes the entry into the queue    /////
+/////  buffer between reserve and commit. The consumer /////
+/////  reads it in place between peek and release.     /////
 ////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////
 
-uint8_t OSDQueuePost(BRTOS_Queue *pont_event, void *pdata)
+uint8_t OSDQueueReserve(BRTOS_Queue *pont_event, void **entry)
 {
   OS_SR_SAVE_VAR
-  uint8_t iPriority = (uint8_t)0;
-
-  #if (VERBOSE == 1)
-  uint8_t TaskSelect = 0;
-  #endif
-
-  uint16_t    n;
-  uint8_t     *src;
   OS_DQUEUE *cqueue;
 
   #if (ERROR_CHECK == 1)
-    // Verifies if the pointer is NULL
-    if(pont_event == NULL)
+    // Verifies if the pointers are NULL
+    if((pont_event == NULL) || (entry == NULL))
     {
       return(NULL_EVENT_POINTER);
     }
@@ -1522,9 +1742,7 @@ uint8_t OSDQueuePost(BRTOS_Queue *pont_event, void *pdata)
   #endif
      OSEnterCritical();
 
-  cqueue  = pont_event->OSEventPointer;
-  src     = (uint8_t*)pdata;
-  n       = cqueue->OSQTSize;
+  cqueue = pont_event->OSEventPointer;
 
   #if (ERROR_CHECK == 1)
     // Verifies if the event is allocated
@@ -1539,26 +1757,20 @@ uint8_t OSDQueuePost(BRTOS_Queue *pont_event, void *pdata)
     }
   #endif
 
-  // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)
-    if(!iNesting){
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, QUEUEPOST);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, QUEUEPOST);
-      #endif
-    }else{
-      Update_OSTrace(0, QUEUEPOST);
-    }
-  #endif
-
-  // Checks for queue overflow
-  if (cqueue->OSQEntries < cqueue->OSQLength)
+  // Only one entry can be reserved at a time
+  if (cqueue->OSQReserved != 0)
   {
-    // If no, increases the queue entries
-    cqueue->OSQEntries++;
+     // Exit Critical Section
+     #if (NESTING_INT == 0)
+     if (!iNesting)
+     #endif
+       OSExitCritical();
+
+     return BUSY_RESOURCE;
   }
-  else
+
+  // Checks for queue overflow
+  if (OSDQueueFree(cqueue) == 0)
   {
      // Exit Critical Section
      #if (NESTING_INT == 0)
@@ -1574,60 +1786,209 @@ uint8_t OSDQueuePost(BRTOS_Queue *pont_event, void *pdata)
   if (cqueue->OSQIn == cqueue->OSQEnd)
     cqueue->OSQIn = cqueue->OSQStart;
 
-  // copy data into the queue
-  while(n)
+  // The entry is only visible to the consumers after the commit
+  cqueue->OSQReserved = 1;
+  *entry = cqueue->OSQIn;
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+
+  return WRITE_BUFFER_OK;
+}
+
+uint8_t OSDQueueCommit(BRTOS_Queue *pont_event)
+{
+  OS_SR_SAVE_VAR
+  OS_DQUEUE *cqueue;
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the pointer is NULL
+    if(pont_event == NULL)
+    {
+      return(NULL_EVENT_POINTER);
+    }
+  #endif
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  cqueue = pont_event->OSEventPointer;
+
+  // There must be a reserved entry
+  if (cqueue->OSQReserved == 0)
   {
-    // copy data and increase the input pointer
-    *cqueue->OSQIn++ = *src++;
-    n--;
+     // Exit Critical Section
+     #if (NESTING_INT == 0)
+     if (!iNesting)
+     #endif
+       OSExitCritical();
+
+     return INVALID_PARAMETERS;
   }
 
+  // BRTOS TRACE SUPPORT
+  OS_TRACE_EVENT(OS_TRACE_QUEUE_POST, pont_event);
+
+  cqueue->OSQReserved = 0;
+  cqueue->OSQIn += cqueue->OSQTSize;
+  cqueue->OSQEntries++;
+
   // See if any task is waiting for new data in the queue
-  if (pont_event->OSEventWait != 0)
-  {
-    // Selects the highest priority task
-    iPriority = SAScheduler(pont_event->OSEventWaitList);
+  OSDQueueWakeUp(pont_event, 1);
 
-    // Remove the selected task from the queue wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
 
-    // Decreases the queue wait list counter
-    pont_event->OSEventWait--;
+  return WRITE_BUFFER_OK;
+}
 
-    // Put the selected task into Ready List
-    #if (VERBOSE == 1)
-    TaskSelect = PriorityVector[iPriority];
-    ContextTask[TaskSelect].State = READY;
-    #endif
+uint8_t OSDQueuePeek(BRTOS_Queue *pont_event, void **entry, ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  uint8_t     status;
+  OS_DQUEUE   *cqueue;
 
-    OSReadyList = OSReadyList | (PriorityMask[iPriority]);
+  #if (ERROR_CHECK == 1)
+    /// Can not use Queue peek function from interrupt handling code
+    if(iNesting > 0)
+    {
+      return(IRQ_PEND_ERR);
+    }
 
-    // If outside of an interrupt service routine, change context to the highest priority task
-    // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
-    if (!iNesting)
+    // Verifies if the pointers are NULL
+    if((pont_event == NULL) || (entry == NULL))
     {
-      // Verify if there is a higher priority task ready to run
-      ChangeContext();
+      return(NULL_EVENT_POINTER);
     }
+  #endif
 
-    // Exit Critical Section
-    #if (NESTING_INT == 0)
-    if (!iNesting)
-    #endif
+  // Enter Critical Section
+  OSEnterCritical();
+  cqueue  = pont_event->OSEventPointer;
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the event is allocated
+    if(pont_event->OSEventAllocated != TRUE)
+    {
+      // Exit Critical Section
       OSExitCritical();
+      return(ERR_EVENT_NO_CREATED);
+    }
+  #endif
 
-    return WRITE_BUFFER_OK;
+  // Only one entry can be peeked at a time
+  if (cqueue->OSQPeeked != 0)
+  {
+    // Exit Critical Section
+    OSExitCritical();
+    return BUSY_RESOURCE;
   }
-  else
+
+  // BRTOS TRACE SUPPORT
+  OS_TRACE_EVENT(OS_TRACE_QUEUE_PEND, pont_event);
+
+  // Verify if there is data in the queue
+  if(cqueue->OSQEntries == 0)
   {
+    // If no timeout is used and the queue is empty, exit the queue with an error
+    if (time_wait == NO_TIMEOUT)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
+    }
+
+    OSDQueueSuspend(pont_event, time_wait);
+
     // Exit Critical Section
-    #if (NESTING_INT == 0)
-    if (!iNesting)
-    #endif
+    OSExitCritical();
+    // Enter Critical Section
+    OSEnterCritical();
+
+    status = OSDQueueResume(pont_event, time_wait);
+    if (status != READ_BUFFER_OK)
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return status;
+    }
+
+    // The entry may have been read by a higher priority task,
+    // or another task may have peeked it
+    if ((cqueue->OSQEntries == 0) || (cqueue->OSQPeeked != 0))
+    {
+      // Exit Critical Section
+      OSExitCritical();
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
+    }
+  }
+
+  // Verify for output pointer overflow
+  if (cqueue->OSQOut == cqueue->OSQEnd)
+    cqueue->OSQOut = cqueue->OSQStart;
+
+  // The entry leaves the queue, but its buffer is only reused after the release
+  *entry = cqueue->OSQOut;
+  cqueue->OSQOut += cqueue->OSQTSize;
+  cqueue->OSQEntries--;
+  cqueue->OSQPeeked = 1;
+
+  // Exit Critical Section
+  OSExitCritical();
+  return READ_BUFFER_OK;
+}
+
+uint8_t OSDQueueRelease(BRTOS_Queue *pont_event)
+{
+  OS_SR_SAVE_VAR
+  OS_DQUEUE *cqueue;
+
+  #if (ERROR_CHECK == 1)
+    // Verifies if the pointer is NULL
+    if(pont_event == NULL)
+    {
+      return(NULL_EVENT_POINTER);
+    }
+  #endif
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  cqueue = pont_event->OSEventPointer;
+
+  // There must be a peeked entry
+  if (cqueue->OSQPeeked == 0)
+  {
+     // Exit Critical Section
+     #if (NESTING_INT == 0)
+     if (!iNesting)
+     #endif
        OSExitCritical();
 
-    return WRITE_BUFFER_OK;
+     return INVALID_PARAMETERS;
   }
+
+  cqueue->OSQPeeked = 0;
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+
+  return READ_BUFFER_OK;
 }
 
 ////////////////////////////////////////////////////////////
@@ -1636,6 +1997,26 @@ uint8_t OSDQueuePost(BRTOS_Queue *pont_event, void *pdata)
 ////////////////////////////////////////////////////////////
 
 
+
+
+#if (BRTOS_PEND_MULTIPLE_EN == 1)
+// Used by OSPendMultiple, inside of its critical section
+uint8_t OSDQueueTake(BRTOS_Queue *pont_event, void *pdata)
+{
+  OS_DQUEUE *cqueue = pont_event->OSEventPointer;
+
+  if (cqueue->OSQEntries == 0)
+  {
+    return FALSE;
+  }
+
+  OSDQueueRead(cqueue, (uint8_t*)pdata, 1);
+
+  return TRUE;
+}
+#endif
+
+
 #endif
 
 
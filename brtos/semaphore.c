@@ -128,7 +128,7 @@ uint8_t OSSemCreate (uint8_t cnt, BRTOS_Sem **event)
 #if (BRTOS_BINARY_SEM_EN == 1)
   pont_event->Binary = FALSE;
 #endif
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
 
   *event = pont_event;
 
@@ -204,7 +204,7 @@ uint8_t OSSemBinaryCreate (uint8_t bit, BRTOS_Sem **event)
   }
   pont_event->OSEventWait  = 0;
   pont_event->Binary = TRUE;
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
 
   *event = pont_event;
 
@@ -248,7 +248,7 @@ uint8_t OSSemDelete (BRTOS_Sem **event)
   pont_event->OSEventCount     = 0;
   pont_event->OSEventWait      = 0;
 
-  pont_event->OSEventWaitList=0;
+  OSPrioReset(pont_event->OSEventWaitList);
 
   *event = NULL;
 
@@ -276,7 +276,6 @@ uint8_t OSSemDelete (BRTOS_Sem **event)
 uint8_t OSSemPend (BRTOS_Sem *pont_event, ostick_t time_wait)
 {
   OS_SR_SAVE_VAR
-  uint8_t  iPriority = 0;
   osdtick_t timeout;
   ContextType *Task;
 
@@ -308,13 +307,7 @@ uint8_t OSSemPend (BRTOS_Sem *pont_event, ostick_t time_wait)
   #endif
 
   // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, SEMPEND);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, SEMPEND);
-      #endif
-  #endif
+  OS_TRACE_EVENT(OS_TRACE_SEM_PEND, pont_event);
 
   // Verify if there was a post
   if (pont_event->OSEventCount > 0)
@@ -336,13 +329,11 @@ uint8_t OSSemPend (BRTOS_Sem *pont_event, ostick_t time_wait)
 
   Task = (ContextType*)&ContextTask[currentTask];
 
-  // Copy task priority to local scope
-  iPriority = Task->Priority;
   // Increases the semaphore wait list counter
   pont_event->OSEventWait++;
 
   // Allocates the current task on the semaphore wait list
-  pont_event->OSEventWaitList = pont_event->OSEventWaitList | (PriorityMask[iPriority]);
+  OSEventWaitListInsert(&pont_event->OSEventWaitList, pont_event, Task);
 
   // Task entered suspended state, waiting for semaphore post
   #if (VERBOSE == 1)
@@ -351,7 +342,7 @@ uint8_t OSSemPend (BRTOS_Sem *pont_event, ostick_t time_wait)
   #endif
 
   // Remove current task from the Ready List
-  OSReadyList = OSReadyList & ~(PriorityMask[iPriority]);
+  OSReadyListRemove(Task);
 
   // Set timeout overflow
   if (time_wait)
@@ -398,10 +389,10 @@ uint8_t OSSemPend (BRTOS_Sem *pont_event, ostick_t time_wait)
       if(Task->TimeToWait == EXIT_BY_TIMEOUT)
       {
           // Test if both timeout and post have occured before arrive here
-          if ((pont_event->OSEventWaitList & PriorityMask[iPriority]))
+          if (OSEventWaitListHas(&pont_event->OSEventWaitList, pont_event, Task))
           {
             // Remove the task from the queue wait list
-            pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+            OSEventWaitListRemove(&pont_event->OSEventWaitList, pont_event, Task);
 
             // Decreases the queue wait list counter
             pont_event->OSEventWait--;
@@ -447,10 +438,7 @@ uint8_t OSSemPend (BRTOS_Sem *pont_event, ostick_t time_wait)
 uint8_t OSSemPost(BRTOS_Sem *pont_event)
 {
   OS_SR_SAVE_VAR
-  uint8_t iPriority = (uint8_t)0;
-  #if (VERBOSE == 1)
   uint8_t TaskSelect = 0;
-  #endif
 
   #if (ERROR_CHECK == 1)
     // Verifies if the pointer is NULL
@@ -480,37 +468,23 @@ uint8_t OSSemPost(BRTOS_Sem *pont_event)
   #endif
 
   // BRTOS TRACE SUPPORT
-  #if (OSTRACE == 1)
-    if(!iNesting){
-      #if(OS_TRACE_BY_TASK == 1)
-      Update_OSTrace(currentTask, SEMPOST);
-      #else
-      Update_OSTrace(ContextTask[currentTask].Priority, SEMPOST);
-      #endif
-    }else{
-      Update_OSTrace(0, SEMPOST);
-    }
-  #endif
+  OS_TRACE_EVENT(OS_TRACE_SEM_POST, pont_event);
 
   // See if any task is waiting for semaphore
   if (pont_event->OSEventWait != 0)
   {
-    // Selects the highest priority task
-    iPriority = SAScheduler(pont_event->OSEventWaitList);
-
-    // Remove the selected task from the semaphore wait list
-    pont_event->OSEventWaitList = pont_event->OSEventWaitList & ~(PriorityMask[iPriority]);
+    // Selects the highest priority task and removes it from the semaphore wait list
+    TaskSelect = OSEventWaitListSelect(&pont_event->OSEventWaitList, pont_event);
 
     // Decreases the semaphore wait list counter
     pont_event->OSEventWait--;
 
     // Put the selected task into Ready List
     #if (VERBOSE == 1)
-    TaskSelect = PriorityVector[iPriority];
     ContextTask[TaskSelect].State = READY;
     #endif
 
-    OSReadyList = OSReadyList | (PriorityMask[iPriority]);
+    OSReadyListInsert(&ContextTask[TaskSelect]);
 
     // If outside of an interrupt service routine, change context to the highest priority task
     // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
@@ -28,6 +28,9 @@
 *   Authors:  Gustavo Denardin
 *   Revision: 1.9x
 *   Date:     15/05/2016
+*   Authors:  Gustavo Denardin
+*   Revision: 2.0
+*   Date:     18/10/2016
 *********************************************************************************************************/
 
 
@@ -43,56 +46,284 @@
 #ifdef BRTOS_TMR_EN 
 #if (BRTOS_TMR_EN == 1) 
 
+/* Hierarchical timer wheel
+   Each level has TIMER_WHEEL_SLOTS slots. A slot of the level "n" holds the timers
+   that expire in the same 2^(n*BRTOS_TIMER_WHEEL_BITS) ticks. When the handled time
+   reaches the slot, its timers are moved (cascaded) to the lower levels. The timers
+   of a slot are kept in a doubly linked list, so start and stop are O(1).
+   The wheel counts its own time (clock), which does not overflow with the tick counter.
+   The timer task sleeps until the next slot with timers. */
+
 /* private data */
 static struct {
-    BRTOS_TIMER_T   mem[BRTOS_MAX_TIMER]; /* array of callback structs */            
-    BRTOS_TMR_T*    current;              /* keep current timer list */ 
-    BRTOS_TMR_T*    future;               /* keep future timer list   */
-    uint8_t           handling_task;        /* caller Task ID */          
+    BRTOS_TIMER_T   mem[BRTOS_MAX_TIMER];                            /* array of callback structs */
+    BRTOS_TIMER     wheel[(TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS) + 1]; /* wheel slots and expired list */
+    uint32_t        used[TIMER_WHEEL_LEVELS];                        /* slots with timers of each level */
+    BRTOS_TIMER     expired_tail;                                    /* last timer of the expired list */
+    BRTOS_TIMER     free;                                            /* free timers list */
+    osdtick_t       clock;                                           /* current time of the timer wheel */
+    osdtick_t       now;                                             /* next time handled by the timer wheel */
+    osdtick_t       wake;                                            /* wake up time of the timer task */
+    ostick_t        tick;                                            /* tick count of the clock */
+    uint8_t         handling_task;                                   /* caller Task ID */
 } BRTOS_TIMER_VECTOR;
 
+#define TIMER_EXPIRED_SLOT    (uint8_t)(TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS)
+#define TIMER_NO_EVENT        (osdtick_t)(~(osdtick_t)0)
+/* the timer task wakes up before the tick counter overflows, keeping the clock updated */
+#define TIMER_MAX_SLEEP       (osdtick_t)(TIMER_MAX_COUNTER - 1)
+
+/* "a" is not after "b" */
+#define TIMER_DUE(a,b)        ((osdtick_t)((b) - (a)) < ((osdtick_t)1 << ((sizeof(osdtick_t) * 8) - 1)))
+
+#if (BRTOS_PEND_CALL_EN == 1)
+/* Deferred function calls
+   A ring with one spare slot. The callers (tasks or interrupts) write the entry and
+   the input index inside a critical section, since there may be several of them.
+   The timer task is the only reader: it copies the entry and releases the slot
+   through the output index without disabling the interrupts. */
+#define PEND_CALL_SLOTS       (uint8_t)(BRTOS_PEND_CALL_QUEUE_SIZE + 1)
+#define PEND_CALL_NEXT(i)     (uint8_t)((((i) + 1) == PEND_CALL_SLOTS) ? 0 : ((i) + 1))
+#define PEND_CALL_PENDING()   (uint8_t)((BRTOS_PEND_CALL_VECTOR.in >= BRTOS_PEND_CALL_VECTOR.out) ? \
+                                (BRTOS_PEND_CALL_VECTOR.in - BRTOS_PEND_CALL_VECTOR.out) :          \
+                                (BRTOS_PEND_CALL_VECTOR.in + PEND_CALL_SLOTS - BRTOS_PEND_CALL_VECTOR.out))
 
-/* soft timer lists: memory allocation */
-static BRTOS_TMR_T BRTOS_TMR_PING,BRTOS_TMR_PONG;    /* Timer lists */
+static struct {
+    struct {
+        FCN_PEND_CALL volatile  fn;
+        void * volatile         arg;
+    }                 ring[PEND_CALL_SLOTS];                         /* pending calls */
+    volatile uint8_t  in;                                            /* next free slot */
+    volatile uint8_t  out;                                           /* next call to be run */
+    uint8_t           max_pending;                                   /* statistics */
+    uint32_t          calls;
+    uint32_t          overflows;
+} BRTOS_PEND_CALL_VECTOR;
+#endif
 
 /* local functions */
-/* Binary heap of timers */
-#define PAI(i)    (uint8_t)(i>>1)
-#define LEFT(i)   (uint8_t)(i<<1)
-#define RIGHT(i)  (uint8_t)((i<<1) + 1)
+static void BRTOS_TimerTaskWake(osdtick_t next_time_to_wake);
 
-static void Subir (BRTOS_TIMER* timers,uint8_t i) {
-     while (i > 1 && timers[PAI(i)]->timeout > timers[i]->timeout)
-     {
-         void* tmp = timers[PAI(i)];
-         timers[PAI(i)] = timers[i];
-         timers[i] = tmp;
-         i=PAI(i);
-     }
+/* Updates the clock with the ticks elapsed since the last update */
+static osdtick_t OSTimerClock(void)
+{
+  ostick_t tick = OSGetCount();
+
+  if (tick != BRTOS_TIMER_VECTOR.tick)
+  {
+    if (tick > BRTOS_TIMER_VECTOR.tick)
+    {
+      BRTOS_TIMER_VECTOR.clock += (osdtick_t)(tick - BRTOS_TIMER_VECTOR.tick);
+    }
+    else
+    {
+      BRTOS_TIMER_VECTOR.clock += (osdtick_t)(tick + (TICK_COUNT_OVERFLOW - BRTOS_TIMER_VECTOR.tick));
+    }
+    BRTOS_TIMER_VECTOR.tick = tick;
+  }
+
+  return BRTOS_TIMER_VECTOR.clock;
+}
+
+static void OSTimerLink(BRTOS_TIMER p, uint8_t slot)
+{
+  p->slot = slot;
+  p->prev = NULL;
+  p->next = BRTOS_TIMER_VECTOR.wheel[slot];
+  if (p->next != NULL)
+  {
+    p->next->prev = p;
+  }
+  BRTOS_TIMER_VECTOR.wheel[slot] = p;
+  BRTOS_TIMER_VECTOR.used[slot >> BRTOS_TIMER_WHEEL_BITS] |= (uint32_t)1 << (slot & TIMER_WHEEL_MASK);
+}
+
+/* Puts the timer at the end of the expired list */
+static void OSTimerExpire(BRTOS_TIMER p)
+{
+  p->slot = TIMER_EXPIRED_SLOT;
+  p->next = NULL;
+  p->prev = BRTOS_TIMER_VECTOR.expired_tail;
+  if (p->prev != NULL)
+  {
+    p->prev->next = p;
+  }
+  else
+  {
+    BRTOS_TIMER_VECTOR.wheel[TIMER_EXPIRED_SLOT] = p;
+  }
+  BRTOS_TIMER_VECTOR.expired_tail = p;
 }
 
-static void Descer (BRTOS_TIMER* timers,uint8_t i, uint8_t n) 
+/* Removes the timer from its wheel slot or from the expired list */
+static void OSTimerUnlink(BRTOS_TIMER p)
 {
-  uint8_t son;
-  do{    
-    if ((RIGHT(i) <= n && timers[RIGHT(i)] != NULL && timers[LEFT(i)] != NULL) &&
-    		timers[RIGHT(i)]->timeout < timers[LEFT(i)]->timeout)
+  if (p->prev != NULL)
+  {
+    p->prev->next = p->next;
+  }
+  else
+  {
+    BRTOS_TIMER_VECTOR.wheel[p->slot] = p->next;
+    if ((p->next == NULL) && (p->slot != TIMER_EXPIRED_SLOT))
+    {
+      BRTOS_TIMER_VECTOR.used[p->slot >> BRTOS_TIMER_WHEEL_BITS] &= ~((uint32_t)1 << (p->slot & TIMER_WHEEL_MASK));
+    }
+  }
+
+  if (p->next != NULL)
+  {
+    p->next->prev = p->prev;
+  }
+  else
+  {
+    if (p->slot == TIMER_EXPIRED_SLOT)
+    {
+      BRTOS_TIMER_VECTOR.expired_tail = p->prev;
+    }
+  }
+
+  p->next = NULL;
+  p->prev = NULL;
+}
+
+/* Puts a running timer into the wheel slot of its expiration time */
+static void OSTimerInsert(BRTOS_TIMER p)
+{
+  osdtick_t delta;
+  uint8_t   level;
+
+  /* the wheel can not go back to an already handled time */
+  if (!TIMER_DUE(BRTOS_TIMER_VECTOR.now, p->expires))
+  {
+    p->expires = BRTOS_TIMER_VECTOR.now;
+  }
+
+  delta = (osdtick_t)(p->expires - BRTOS_TIMER_VECTOR.now);
+
+  for(level = 0; level < (TIMER_WHEEL_LEVELS - 1); level++)
+  {
+    if ((delta >> (BRTOS_TIMER_WHEEL_BITS * (level + 1))) == 0)
+    {
+      break;
+    }
+  }
+
+  OSTimerLink(p, (uint8_t)((level * TIMER_WHEEL_SLOTS) + ((p->expires >> (BRTOS_TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK)));
+}
+
+static void OSTimerFree(BRTOS_TIMER p)
+{
+  p->state = TIMER_NOT_USED; // was _NOT_ALLOCATED
+  p->func_cb = NULL;
+  p->next = BRTOS_TIMER_VECTOR.free;
+  BRTOS_TIMER_VECTOR.free = p;
+}
+
+/* Number of ticks from the next handled time until the next wheel slot with timers */
+static osdtick_t OSTimerWheelNext(void)
+{
+  osdtick_t next = TIMER_NO_EVENT;
+  osdtick_t base, block, distance;
+  uint32_t  used;
+  uint8_t   level, index, i;
+
+  for(level = 0; level < TIMER_WHEEL_LEVELS; level++)
+  {
+    used = BRTOS_TIMER_VECTOR.used[level];
+    if (used == 0)
+    {
+      continue;
+    }
+
+    /* the slots of the level are handled at the boundaries of its blocks */
+    block = (osdtick_t)1 << (BRTOS_TIMER_WHEEL_BITS * level);
+    base = (osdtick_t)((BRTOS_TIMER_VECTOR.now + block - 1) & ~(block - 1));
+    index = (uint8_t)((base >> (BRTOS_TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+
+    for(i = 0; !(used & ((uint32_t)1 << ((index + i) & TIMER_WHEEL_MASK))); i++){}
+
+    distance = (osdtick_t)((base - BRTOS_TIMER_VECTOR.now) + ((osdtick_t)i << (BRTOS_TIMER_WHEEL_BITS * level)));
+    if (distance < next)
+    {
+      next = distance;
+    }
+  }
+
+  return next;
+}
+
+/* Handles the wheel until the time "clock". The expired timers are moved to the expired list.
+   The time without timers is skipped. */
+static void OSTimerWheelAdvance(osdtick_t clock)
+{
+  BRTOS_TIMER p;
+  osdtick_t   next;
+  uint8_t     level, slot;
+
+  while (TIMER_DUE(BRTOS_TIMER_VECTOR.now, clock))
+  {
+    /* cascades the slots of the upper levels that start now */
+    if ((BRTOS_TIMER_VECTOR.now & TIMER_WHEEL_MASK) == 0)
     {
-       son = RIGHT(i);
+      for(level = 1; level < TIMER_WHEEL_LEVELS; level++)
+      {
+        slot = (uint8_t)((BRTOS_TIMER_VECTOR.now >> (BRTOS_TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+
+        while((p = BRTOS_TIMER_VECTOR.wheel[(level * TIMER_WHEEL_SLOTS) + slot]) != NULL)
+        {
+          OSTimerUnlink(p);
+          OSTimerInsert(p);
+        }
+
+        if (slot != 0)
+        {
+          break;
+        }
+      }
     }
-    else 
-	{
-		son = LEFT(i);
-	}
-    if ((son <= n && timers[son] != NULL && timers[i] != NULL) &&
-    		(timers[son]->timeout < timers[i]->timeout))
+
+    /* every timer of a slot of the first level expires now */
+    slot = (uint8_t)(BRTOS_TIMER_VECTOR.now & TIMER_WHEEL_MASK);
+    while((p = BRTOS_TIMER_VECTOR.wheel[slot]) != NULL)
+    {
+      OSTimerUnlink(p);
+      OSTimerExpire(p);
+    }
+
+    BRTOS_TIMER_VECTOR.now++;
+
+    next = OSTimerWheelNext();
+    if (next > (osdtick_t)(clock + 1 - BRTOS_TIMER_VECTOR.now))
+    {
+      next = (osdtick_t)(clock + 1 - BRTOS_TIMER_VECTOR.now);
+    }
+    BRTOS_TIMER_VECTOR.now += next;
+  }
+}
+
+/* Starts the timer - must be called inside a critical section */
+static void OSTimerRun(BRTOS_TIMER p, TIMER_CNT time_wait)
+{
+  if (time_wait > TIMER_MAX_COUNTER) time_wait = TIMER_MAX_COUNTER;
+
+  if (p->state == TIMER_RUNNING)
+  {
+    OSTimerUnlink(p);
+  }
+
+  p->expires = (osdtick_t)(OSTimerClock() + time_wait);
+  p->state = TIMER_RUNNING;
+  OSTimerInsert(p);
+
+  // may need to change wake time of timer task
+  if (BRTOS_TIMER_VECTOR.handling_task && (currentTask != BRTOS_TIMER_VECTOR.handling_task))
+  {
+    if (TIMER_DUE(p->expires, BRTOS_TIMER_VECTOR.wake) && (p->expires != BRTOS_TIMER_VECTOR.wake))
     {
-       void* tmp = timers[son];
-       timers[son] = timers[i];
-       timers[i] = tmp;
-       i=son;
-    }else break;
-  }while(1);
+      BRTOS_TimerTaskWake(p->expires);
+    }
+  }
 }
 
 /* private functions */
@@ -100,53 +331,72 @@ static void BRTOS_TimerTaskInit(void)
 {
   
   OS_SR_SAVE_VAR 
-  uint8_t i; 
+  uint16_t i; 
   
   if (currentTask)
     OSEnterCritical();
         
-    BRTOS_TIMER_VECTOR.current = &BRTOS_TMR_PING;
-    BRTOS_TIMER_VECTOR.future  = &BRTOS_TMR_PONG;
-    
-    for(i=0;i<BRTOS_MAX_TIMER;i++)
+    BRTOS_TIMER_VECTOR.free = NULL;
+    for(i=BRTOS_MAX_TIMER;i>0;i--)
     {           
-      BRTOS_TIMER_VECTOR.mem[i].state = TIMER_NOT_USED;
-      BRTOS_TIMER_VECTOR.mem[i].func_cb = NULL;
-      BRTOS_TIMER_VECTOR.mem[i].timeout = 0;  
+      BRTOS_TIMER_VECTOR.mem[i-1].mode = TIMER_CALLBACK;
+      BRTOS_TIMER_VECTOR.mem[i-1].expires = 0;
+      BRTOS_TIMER_VECTOR.mem[i-1].period = 0;
+      BRTOS_TIMER_VECTOR.mem[i-1].prev = NULL;
+      OSTimerFree(&BRTOS_TIMER_VECTOR.mem[i-1]);
     }  
+
+    for(i=0;i<=TIMER_EXPIRED_SLOT;i++)
+    {
+      BRTOS_TIMER_VECTOR.wheel[i] = NULL;
+    }
+
+    for(i=0;i<TIMER_WHEEL_LEVELS;i++)
+    {
+      BRTOS_TIMER_VECTOR.used[i] = 0;
+    }
+
+    BRTOS_TIMER_VECTOR.expired_tail = NULL;
+    BRTOS_TIMER_VECTOR.clock = 0;
+    BRTOS_TIMER_VECTOR.now = 1;
+    BRTOS_TIMER_VECTOR.wake = 0;
+    BRTOS_TIMER_VECTOR.tick = OSGetCount();
+
+    #if (BRTOS_PEND_CALL_EN == 1)
+    BRTOS_PEND_CALL_VECTOR.in = 0;
+    BRTOS_PEND_CALL_VECTOR.out = 0;
+    BRTOS_PEND_CALL_VECTOR.max_pending = 0;
+    BRTOS_PEND_CALL_VECTOR.calls = 0;
+    BRTOS_PEND_CALL_VECTOR.overflows = 0;
+    #endif
     
   if (currentTask)
      OSExitCritical();
 
 }
 
-static void BRTOS_TimerTaskSleep(TIMER_CNT next_time_to_wake)
+/* Changes the wake up time of the sleeping timer task */
+/* Must be called inside a critical section, just after the clock update */
+static void BRTOS_TimerTaskWake(osdtick_t next_time_to_wake)
 {
-  
-  OS_SR_SAVE_VAR
-  
-  ContextType *Task = (ContextType*)&ContextTask[currentTask];      
-  
-  Task->TimeToWait = next_time_to_wake;
-  
-  OSEnterCritical();
-  
-  // Put task into delay list
-  IncludeTaskIntoDelayList();
-  
-  #if (VERBOSE == 1)
-    Task->State = SUSPENDED;
-    Task->SuspendedType = DELAY;
-  #endif
-  
-  OSReadyList = OSReadyList & ~(PriorityMask[Task->Priority]);
-  
-  // Change context
-  // Return to task when occur delay overflow
-  ChangeContext();
-  
-  OSExitCritical();
-    
+  ContextType *Task = (ContextType*)&ContextTask[BRTOS_TIMER_VECTOR.handling_task];
+  osdtick_t timeout;
+
+  /* the delay list is sorted by the wake up time, so the task must be moved */
+  if ((Task->TimeToWait != EXIT_BY_TIMEOUT) && (Task->TimeToWait != NO_TIMEOUT))
+  {
+    BRTOS_TIMER_VECTOR.wake = next_time_to_wake;
+
+    timeout = (osdtick_t)((osdtick_t)BRTOS_TIMER_VECTOR.tick + (osdtick_t)(next_time_to_wake - BRTOS_TIMER_VECTOR.clock));
+    if (timeout >= TICK_COUNT_OVERFLOW)
+    {
+      timeout -= TICK_COUNT_OVERFLOW;
+    }
+
+    RemoveFromDelayList();
+    Task->TimeToWait = (ostick_t)timeout;
+    IncludeTaskIntoDelayList();
+  }
 }
 
 /* Timer Task */
@@ -160,165 +410,134 @@ void BRTOSTimerTask(void)
      OS_SR_SAVE_VAR
      BRTOS_TIMER p;
      TIMER_CNT   repeat;
-     osdtick_t   timeout = 0;
-     TIMER_CNT   next_time_to_wake;      /* tick count of next timer */
-     BRTOS_TMR_T *list, *list_tmp;          
+     osdtick_t   next;
+     osdtick_t   timeout;
+     ContextType *Task = (ContextType*)&ContextTask[currentTask];
+     #if (BRTOS_PEND_CALL_EN == 1)
+     FCN_PEND_CALL pend_fn;
+     void          *pend_arg;
+     uint8_t       out;
+     #endif
      
      #if (TASK_WITH_PARAMETERS == 1)
 	 (void)param;
 	 #endif
      
      BRTOS_TIMER_VECTOR.handling_task = currentTask;
-     
-     list = BRTOS_TIMER_VECTOR.current;
 
-     p=list->timers[1];
-     if(p!= NULL)
-     {      
-       next_time_to_wake = p->timeout;
-     }
-     else
-     {
-       next_time_to_wake = TIMER_MAX_COUNTER;    
-     }
+     OSEnterCritical();
   
      for(;;)
      {
-     
-        BRTOS_TimerTaskSleep(next_time_to_wake);
+        #if (BRTOS_PEND_CALL_EN == 1)
+        /* one deferred call is run at each turn, interleaved with the expired timers */
+        out = BRTOS_PEND_CALL_VECTOR.out;
+        if (out != BRTOS_PEND_CALL_VECTOR.in)
+        {
+            OSExitCritical();
 
-        list = BRTOS_TIMER_VECTOR.current;
-        p=list->timers[1];
+            pend_fn = BRTOS_PEND_CALL_VECTOR.ring[out].fn;
+            pend_arg = BRTOS_PEND_CALL_VECTOR.ring[out].arg;
+            BRTOS_PEND_CALL_VECTOR.out = PEND_CALL_NEXT(out);
 
-        /* Some high priority task ran and took more than one tick to complete.
-        So, if the timer overflows in such time, we must execute all the remaining
-        softtimers and switch the lists. */
-		if(p!= NULL && p->timeout > OSGetTickCount()){
-            while(p!= NULL)
-            {
-            	p->state = TIMER_STOPPED;
+            pend_fn(pend_arg);
 
-                // some timer has expired
-                if((p)->func_cb != NULL)
-                {
-                	repeat = (TIMER_CNT)((p)->func_cb()); /* callback */
-                }
-				else
-				{
-					repeat = 0;
-				}
-                OSEnterCritical();
-
-				if (repeat > 0)
-				{ /* needs to repeat after "repeat" time ? */
-					p->state = TIMER_RUNNING;
-					timeout = (osdtick_t)((osdtick_t)OSGetTickCount() + (osdtick_t)repeat);
-					p->timeout = (TIMER_CNT)timeout;
-					list_tmp = BRTOS_TIMER_VECTOR.future; // add into future list
-					if(list_tmp->count < (BRTOS_MAX_TIMER-1)) list_tmp->count++;
-					list_tmp->timers[list_tmp->count] = p; // insert in the end
-					Subir(list_tmp->timers,list_tmp->count);
-					list->timers[1]=list->timers[list->count]; // remove from current list
-					list->timers[list->count] = NULL;
-					if(list->count > 0) list->count--;
-				}
-				else
-				{
-					p->timeout = 0;
-					p->state = TIMER_NOT_USED; // was _NOT_ALLOCATED
-					p->func_cb = NULL;
-					list->timers[1]=list->timers[list->count]; // remove from current list
-					list->timers[list->count] = NULL;
-					if(list->count > 0) list->count--;
-				}
-
-                Descer (list->timers, 1, list->count); // order it
-                p=list->timers[1];
-                OSExitCritical();
-            }
-            if(p==NULL)
-            {
-              /* time to switch lists */
-              void* tmp = BRTOS_TIMER_VECTOR.current;
-              BRTOS_TIMER_VECTOR.current = BRTOS_TIMER_VECTOR.future;
-              BRTOS_TIMER_VECTOR.future = tmp;
-              list = BRTOS_TIMER_VECTOR.current;
-              p=list->timers[1];
-            }
+            OSEnterCritical();
+            BRTOS_PEND_CALL_VECTOR.calls++;
         }
+        #endif
 
-        while(p!= NULL && p->timeout <= OSGetTickCount())
-        {  
-        	p->state = TIMER_STOPPED;
+        /* handles the time elapsed since the last wake up */
+        OSTimerWheelAdvance(OSTimerClock());
+
+        /* the expired timers are handled in a batch, before sleeping again */
+        p = BRTOS_TIMER_VECTOR.wheel[TIMER_EXPIRED_SLOT];
+        if (p != NULL)
+        {
+            OSTimerUnlink(p);
+            p->state = TIMER_STOPPED;
+
+            OSExitCritical();
 
             // some timer has expired
-            if((p)->func_cb != NULL) 
+            if((p)->func_cb != NULL)
             {
             	repeat = (TIMER_CNT)((p)->func_cb()); /* callback */
             }
-			else
-			{
-				repeat = 0;
-			}
+            else
+            {
+            	repeat = 0;
+            }
+
             OSEnterCritical();
-                           
-            if (repeat > 0)
-            { /* needs to repeat after "repeat" time ? */
-            	p->state = TIMER_RUNNING;
-            	timeout = (osdtick_t)((osdtick_t)OSGetTickCount() + (osdtick_t)repeat);
-                if (timeout >= TICK_COUNT_OVERFLOW)
-                {
-                    p->timeout = (TIMER_CNT)(timeout - TICK_COUNT_OVERFLOW);                                 
-                    list_tmp = BRTOS_TIMER_VECTOR.future; // add into future list
-					if(list_tmp->count < (BRTOS_MAX_TIMER-1)) list_tmp->count++;
-                    list_tmp->timers[list_tmp->count] = p; // insert in the end
-                    Subir(list_tmp->timers,list_tmp->count);                                      
-                    list->timers[1]=list->timers[list->count]; // remove from current list
-                    list->timers[list->count] = NULL;
-					if(list->count > 0) list->count--;
+
+            /* the callback may have started, stopped or deleted the timer */
+            if (p->state == TIMER_STOPPED)
+            {
+                if (repeat > 0)
+                { /* needs to repeat after "repeat" time ? */
+                    OSTimerRun(p, repeat);
                 }
                 else
                 {
-                    p->timeout = (TIMER_CNT)timeout;                  
+                    if (p->mode == TIMER_PERIODIC)
+                    {
+                        /* the period is counted from the expiration time, so it does not drift */
+                        p->expires += p->period;
+                        p->state = TIMER_RUNNING;
+                        OSTimerInsert(p);
+                    }
+                    else
+                    {
+                        if (p->mode == TIMER_CALLBACK)
+                        {
+                            OSTimerFree(p);
+                        }
+                    }
                 }
             }
-            else
-            {
-                p->timeout = 0;
-                p->state = TIMER_NOT_USED; // was _NOT_ALLOCATED
-                p->func_cb = NULL;
-                list->timers[1]=list->timers[list->count]; // remove from current list
-                list->timers[list->count] = NULL;
-				if(list->count > 0) list->count--;
-            }
-             
-            Descer (list->timers, 1, list->count); // order it
-            p=list->timers[1];
-            OSExitCritical();
+            continue;
         }
-                
-        if(timeout > TIMER_MAX_COUNTER)
+
+        #if (BRTOS_PEND_CALL_EN == 1)
+        if (BRTOS_PEND_CALL_VECTOR.out != BRTOS_PEND_CALL_VECTOR.in)
         {
-          if(p==NULL)
-          {
-            /* time to switch lists */
-            void* tmp = BRTOS_TIMER_VECTOR.current;                               
-            BRTOS_TIMER_VECTOR.current = BRTOS_TIMER_VECTOR.future;
-            BRTOS_TIMER_VECTOR.future = tmp; 
-            list = BRTOS_TIMER_VECTOR.current;
-            p=list->timers[1];
-          }
+            continue;
         }
-        
-        /* if any timer waiting, set task to wake */
-        if(p!= NULL)
+        #endif
+
+        /* sleeps until the next wheel slot with timers */
+        next = OSTimerWheelNext();
+        if (next > TIMER_MAX_SLEEP)
         {
-            next_time_to_wake = p->timeout;
+            next = TIMER_MAX_SLEEP;
         }
-        else
-        {              
-            next_time_to_wake = TIMER_MAX_COUNTER;
+
+        BRTOS_TIMER_VECTOR.wake = (osdtick_t)(BRTOS_TIMER_VECTOR.now + next);
+
+        timeout = (osdtick_t)((osdtick_t)BRTOS_TIMER_VECTOR.tick + (osdtick_t)(BRTOS_TIMER_VECTOR.wake - BRTOS_TIMER_VECTOR.clock));
+        if (timeout >= TICK_COUNT_OVERFLOW)
+        {
+            timeout -= TICK_COUNT_OVERFLOW;
         }
+        Task->TimeToWait = (ostick_t)timeout;
+
+        // Put task into delay list
+        IncludeTaskIntoDelayList();
+
+        #if (VERBOSE == 1)
+          Task->State = SUSPENDED;
+          Task->SuspendedType = DELAY;
+        #endif
+
+        OSReadyListRemove(Task);
+
+        // Change context
+        // Return to task when occur delay overflow
+        ChangeContext();
+
+        OSExitCritical();
+        OSEnterCritical();
      }
   
 }
@@ -335,23 +554,28 @@ void BRTOSTimerTask(void)
 */
 void OSTimerInit(uint16_t timertask_stacksize, uint8_t prio){
 
+  OS_CPU_TYPE handle = 0;
+
   BRTOS_TimerTaskInit();
    
    
 #if (TASK_WITH_PARAMETERS == 1)
-  if (InstallTask(&BRTOSTimerTask, "BRTOS Timers Task", timertask_stacksize, prio, NULL, NULL) != OK)
+  if (InstallTask(&BRTOSTimerTask, "BRTOS Timers Task", timertask_stacksize, prio, NULL, &handle) != OK)
 #else
-  if (InstallTask(&BRTOSTimerTask, "BRTOS Timers Task", timertask_stacksize, prio, NULL) != OK)
+  if (InstallTask(&BRTOSTimerTask, "BRTOS Timers Task", timertask_stacksize, prio, &handle) != OK)
 #endif
   {
 	  while (1){};
   }
+
+  BRTOS_TIMER_VECTOR.handling_task = (uint8_t)handle;
   
 }
 /**
   \fn uint8_t BRTOS_TimerSet (BRTOS_TIMER *cbp, FCN_CALLBACK cb, TIMER_CNT time_wait) 
   \brief public function to create and start a soft timer
    must be called before any call to the other public timer functions.
+   The timer is restarted by the callback return value and it is released when the callback returns 0.
   \param *cbp  soft timer pointer
   \param cb    callback function
   \param time_wait soft timer expiration time
@@ -363,87 +587,75 @@ void OSTimerInit(uint16_t timertask_stacksize, uint8_t prio){
 */
 
 uint8_t OSTimerSet (BRTOS_TIMER *cbp, FCN_CALLBACK cb, TIMER_CNT time_wait)
+{
+    return OSTimerCreate(cbp, cb, time_wait, TIMER_CALLBACK);
+}
+
+/**
+  \fn uint8_t OSTimerCreate (BRTOS_TIMER *cbp, FCN_CALLBACK cb, TIMER_CNT time_wait, uint8_t mode)
+  \brief public function to create and start a soft timer with a mode
+   A TIMER_ONE_SHOT timer is stopped on expiration and may be started again.
+   A TIMER_PERIODIC timer is restarted with the period "time_wait" (or the one of OSTimerStart).
+   A callback return value greater than 0 restarts the timer with this timeout in any mode.
+  \param *cbp  soft timer pointer
+  \param cb    callback function
+  \param time_wait soft timer expiration time - 0 creates a stopped timer
+  \param mode  TIMER_CALLBACK, TIMER_ONE_SHOT or TIMER_PERIODIC
+  \return OK success
+  \return NULL_EVENT_POINTER
+  \return INVALID_PARAMETERS
+  \return NO_AVAILABLE_EVENT
+  \return ERR_EVENT_NO_CREATED
+*/
+uint8_t OSTimerCreate (BRTOS_TIMER *cbp, FCN_CALLBACK cb, TIMER_CNT time_wait, uint8_t mode)
 {
     
     OS_SR_SAVE_VAR
     
-    uint8_t i;
     BRTOS_TIMER p;
-    osdtick_t timeout;
-    BRTOS_TMR_T* list;
     
     if((cb == NULL) || (cbp == NULL)) return NULL_EVENT_POINTER;    /* return error code */        
+
+    if(mode > TIMER_PERIODIC) return INVALID_PARAMETERS;
+
+    if(time_wait > TIMER_MAX_COUNTER) time_wait = TIMER_MAX_COUNTER;
     
     if (currentTask)     
      OSEnterCritical();  
+
+    if(BRTOS_TIMER_VECTOR.mem[0].state == TIMER_NOT_ALLOCATED)
+    {
+      // Exit critical Section
+      if (currentTask)
+         OSExitCritical();
+
+      // Return error code
+      return(ERR_EVENT_NO_CREATED);
+    }
     
-    // Search available timer control block
-    for(i=0;i<=BRTOS_MAX_TIMER;i++)
+    // Takes an available timer control block
+    p = BRTOS_TIMER_VECTOR.free;
+    if(p == NULL)
     {
-      
-      if(i >= BRTOS_MAX_TIMER)
-      {        
-        // Exit critical Section
-        if (currentTask)
-           OSExitCritical();
-        
-        // Return error code
-        return(NO_AVAILABLE_EVENT);
-      }
-      if(BRTOS_TIMER_VECTOR.mem[i].state == TIMER_NOT_ALLOCATED){
-        // Exit critical Section
-        if (currentTask)
-           OSExitCritical();
-        
-        // Return error code
-        return(ERR_EVENT_NO_CREATED);
-      }
-      
-      if(BRTOS_TIMER_VECTOR.mem[i].state == TIMER_NOT_USED)
-      {        
-        p = &BRTOS_TIMER_VECTOR.mem[i];
-        break;      
-      }
+      // Exit critical Section
+      if (currentTask)
+         OSExitCritical();
+
+      // Return error code
+      return(NO_AVAILABLE_EVENT);
     }
+    BRTOS_TIMER_VECTOR.free = p->next;
     
     p->state = TIMER_STOPPED;
     p->func_cb = cb;  // store callback function
-    
+    p->mode = mode;
+    p->period = time_wait;
+    p->next = NULL;
+    p->prev = NULL;
        
     if(time_wait > 0)
     {
-    
-      timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
-      
-      if (timeout >= TICK_COUNT_OVERFLOW)
-      {
-        p->timeout = (TIMER_CNT)(timeout - TICK_COUNT_OVERFLOW);
-        list = BRTOS_TIMER_VECTOR.future;   // add into future list
-        if(list->count < (BRTOS_MAX_TIMER-1)) list->count++;
-        list->timers[list->count] = p; // insert in the end
-        Subir (list->timers, list->count); // order it 
-      }
-      else
-      {
-        p->timeout = (TIMER_CNT)timeout;
-        list = BRTOS_TIMER_VECTOR.current;  // add into current list
-        if(list->count < (BRTOS_MAX_TIMER-1)) list->count++;
-        list->timers[list->count] = p; // insert in the end
-        Subir (list->timers, list->count); // order it 
-        
-        // may need to change wake time of timer task
-        if(currentTask)
-        {          
-          if(p->timeout == (list->timers[1])->timeout)
-          {
-            ContextTask[BRTOS_TIMER_VECTOR.handling_task].TimeToWait = p->timeout;
-          }
-        }
-                         
-      }      
-              
-      p->state = TIMER_RUNNING;      
-                                            
+      OSTimerRun(p, time_wait);
     }
     
     *cbp = p;  
@@ -464,8 +676,8 @@ TIMER_CNT OSTimerGet (BRTOS_TIMER p)
 {
      
      OS_SR_SAVE_VAR
-     TIMER_CNT timeout;
-     TIMER_CNT tickcount;
+     TIMER_CNT timeout = 0;
+     osdtick_t clock;
      
      if((p!= NULL) && (p->state == TIMER_RUNNING))
      {
@@ -473,15 +685,11 @@ TIMER_CNT OSTimerGet (BRTOS_TIMER p)
         if (currentTask)
             OSEnterCritical();                      
              
-            tickcount =  OSGetCount();  
-            if(p->timeout >= tickcount)
+            clock = OSTimerClock();
+            if(!TIMER_DUE(p->expires, clock))
             {                
-                timeout = (TIMER_CNT)(p->timeout - tickcount);                   
+                timeout = (TIMER_CNT)(p->expires - clock);                   
             }
-            else
-            {
-                timeout =  (TIMER_CNT)(TIMER_MAX_COUNTER - tickcount +  p->timeout + 1); 
-            }  
                           
         if (currentTask)               
             OSExitCritical(); 
@@ -497,16 +705,16 @@ TIMER_CNT OSTimerGet (BRTOS_TIMER p)
 /**
   \fn uint8_t BRTOS_TimerStart (BRTOS_TIMER p, TIMER_CNT time_wait)
   \brief public function to start or restart a soft timer
+   The time_wait is the new period of a periodic timer.
   \param p  soft timer
   \param time_wait soft timer expiration time
   \return OK success
   \return NULL_EVENT_POINTER error code
+  \return ERR_EVENT_NO_CREATED the timer is not allocated
 */
 uint8_t OSTimerStart (BRTOS_TIMER p, TIMER_CNT time_wait){
  
   OS_SR_SAVE_VAR
-  osdtick_t timeout;
-  BRTOS_TMR_T* list;
   
   if(p!= NULL && time_wait != 0)
   {
@@ -515,42 +723,17 @@ uint8_t OSTimerStart (BRTOS_TIMER p, TIMER_CNT time_wait){
       
       if (currentTask)
           OSEnterCritical();      
+
+      if ((p->state == TIMER_NOT_USED) || (p->state == TIMER_NOT_ALLOCATED))
+      {
+          if (currentTask)
+              OSExitCritical();
+
+          return ERR_EVENT_NO_CREATED;
+      }
         
-      if(time_wait > 0)
-      {      
-    
-        timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
-        
-        if (timeout >= TICK_COUNT_OVERFLOW)
-        {
-          p->timeout = (TIMER_CNT)(timeout - TICK_COUNT_OVERFLOW);
-          list = BRTOS_TIMER_VECTOR.future;   // add into future list
-          if(list->count < (BRTOS_MAX_TIMER-1)) list->count++;
-          list->timers[list->count] = p; // insert in the end
-          Subir (list->timers, list->count); // order it 
-        }
-        else
-        {
-          p->timeout = (TIMER_CNT)timeout;
-          list = BRTOS_TIMER_VECTOR.current;  // add into current list
-          if(list->count < (BRTOS_MAX_TIMER-1)) list->count++;
-          list->timers[list->count] = p; // insert in the end
-          Subir (list->timers, list->count); // order it 
-          
-          // may need to change wake time of timer task
-          if(currentTask)
-          {          
-            if(p->timeout == (list->timers[1])->timeout)
-            {
-              ContextTask[BRTOS_TIMER_VECTOR.handling_task].TimeToWait = p->timeout;
-            }
-          }
-                           
-        }      
-                
-        p->state = TIMER_RUNNING;     
-                                              
-      }                                       
+      p->period = time_wait;
+      OSTimerRun(p, time_wait);
              
       if (currentTask)               
           OSExitCritical();  
@@ -572,8 +755,6 @@ uint8_t OSTimerStart (BRTOS_TIMER p, TIMER_CNT time_wait){
 uint8_t OSTimerStop (BRTOS_TIMER p, uint8_t del){
   
   OS_SR_SAVE_VAR
-  BRTOS_TMR_T* list;
-  uint8_t pos_timer = 0;
 
   if(p != NULL)
   {
@@ -581,41 +762,25 @@ uint8_t OSTimerStop (BRTOS_TIMER p, uint8_t del){
       if (currentTask)
           OSEnterCritical();
 
-        if(p->timeout >= OSGetCount())
+        // remove from the timer wheel
+        if(p->state == TIMER_RUNNING)
         {
-           list = BRTOS_TIMER_VECTOR.current;  // remove from current list   
+          OSTimerUnlink(p);
         }
-        else
-        {
-           list = BRTOS_TIMER_VECTOR.future;   // remove from future list
-        }  
-
-
-        /* search timer index */
-        p->state = TIMER_SEARCH;
-        for(pos_timer = 1; pos_timer <= list->count; pos_timer++)
-        {
-        	if(list->timers[pos_timer]->state == TIMER_SEARCH)
-        	{
-        		break;
-        	}
-        }
-        
-        p->timeout = 0;
-        Subir (list->timers, pos_timer); // order it 
-        list->timers[1]=list->timers[list->count]; // remove from current list
-        list->timers[list->count] = NULL; //// <---- rest problem here!
-        if(list->count > 0)list->count--;
-        Descer (list->timers, 1, list->count); // order it
 
         if(del > 0)
         {
-          p->state = TIMER_NOT_USED; // was TIMER_NOT_ALLOCATED
-          p->func_cb = NULL; 
+          if (p->state != TIMER_NOT_USED)
+          {
+            OSTimerFree(p);
+          }
         }
         else
         {
-          p->state = TIMER_STOPPED; 
+          if (p->state != TIMER_NOT_USED)
+          {
+            p->state = TIMER_STOPPED; 
+          }
         }
 
       if (currentTask)               
@@ -627,6 +792,134 @@ uint8_t OSTimerStop (BRTOS_TIMER p, uint8_t del){
 }
 
 
+#if (BRTOS_PEND_CALL_EN == 1)
+/**
+  \fn uint8_t OSPendFunctionCall (FCN_PEND_CALL fn, void *arg)
+  \brief public function to defer a function call to the timer task
+   May be called from interrupts. The calls are run in the order they were made,
+   with the priority of the timer task, interleaved with the timer callbacks.
+  \param fn  function to be called
+  \param arg argument of the function
+  \return OK success
+  \return NULL_EVENT_POINTER error code
+  \return ERR_EVENT_NO_CREATED the timer service is not initialized
+  \return BUFFER_UNDERRUN the queue is full - the call is lost and counted as an overflow
+*/
+uint8_t OSPendFunctionCall (FCN_PEND_CALL fn, void *arg){
+
+  OS_SR_SAVE_VAR
+  ContextType *Task;
+  uint8_t in, pending;
+
+  if(fn == NULL) return NULL_EVENT_POINTER;
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  if (BRTOS_TIMER_VECTOR.handling_task == 0)
+  {
+    // Exit Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+       OSExitCritical();
+
+    return ERR_EVENT_NO_CREATED;
+  }
+
+  in = BRTOS_PEND_CALL_VECTOR.in;
+  if (PEND_CALL_NEXT(in) == BRTOS_PEND_CALL_VECTOR.out)
+  {
+    BRTOS_PEND_CALL_VECTOR.overflows++;
+
+    // Exit Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+       OSExitCritical();
+
+    return BUFFER_UNDERRUN;
+  }
+
+  BRTOS_PEND_CALL_VECTOR.ring[in].fn = fn;
+  BRTOS_PEND_CALL_VECTOR.ring[in].arg = arg;
+  BRTOS_PEND_CALL_VECTOR.in = PEND_CALL_NEXT(in);
+
+  pending = PEND_CALL_PENDING();
+  if (pending > BRTOS_PEND_CALL_VECTOR.max_pending)
+  {
+    BRTOS_PEND_CALL_VECTOR.max_pending = pending;
+  }
+
+  // Wakes up the timer task, if it is sleeping
+  Task = (ContextType*)&ContextTask[BRTOS_TIMER_VECTOR.handling_task];
+  if ((Task->TimeToWait != EXIT_BY_TIMEOUT) && (Task->TimeToWait != NO_TIMEOUT))
+  {
+    RemoveFromDelayList();
+    Task->TimeToWait = EXIT_BY_TIMEOUT;
+
+    #if (VERBOSE == 1)
+    Task->State = READY;
+    #endif
+
+    OSReadyListInsert(Task);
+
+    // If outside of an interrupt service routine, change context to the highest priority task
+    // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
+    if (!iNesting)
+    {
+      ChangeContext();
+    }
+  }
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+
+  return OK;
+}
+
+/**
+  \fn void OSPendFunctionCallStats (OS_PEND_CALL_STATS *stats, uint8_t reset)
+  \brief public function to get the statistics of the deferred function calls
+  \param stats  returns the statistics
+  \param reset  if "> 0", the counters and the maximum are restarted
+*/
+void OSPendFunctionCallStats (OS_PEND_CALL_STATS *stats, uint8_t reset){
+
+  OS_SR_SAVE_VAR
+
+  // Enter Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSEnterCritical();
+
+  stats->calls = BRTOS_PEND_CALL_VECTOR.calls;
+  stats->overflows = BRTOS_PEND_CALL_VECTOR.overflows;
+  stats->pending = PEND_CALL_PENDING();
+  stats->max_pending = BRTOS_PEND_CALL_VECTOR.max_pending;
+
+  if (reset > 0)
+  {
+    BRTOS_PEND_CALL_VECTOR.calls = 0;
+    BRTOS_PEND_CALL_VECTOR.overflows = 0;
+    BRTOS_PEND_CALL_VECTOR.max_pending = stats->pending;
+  }
+
+  // Exit Critical Section
+  #if (NESTING_INT == 0)
+  if (!iNesting)
+  #endif
+     OSExitCritical();
+}
+#endif
+
 #endif 
 #endif
 
@@ -0,0 +1,372 @@
+/**
+* \file stream.c
+* \brief OS single producer / single consumer stream functions
+*
+* Byte stream between one producer (usually an interrupt handler)
+* and one consumer task. The data path does not disable the interrupts.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                     OS Stream functions
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#include "stream.h"
+#include <string.h>
+
+#if (BRTOS_STREAM_EN == 1)
+
+// Number of bytes stored in the stream, for a given input and output index
+static uint16_t OSStreamCount(BRTOS_Stream *stream, uint16_t in, uint16_t out)
+{
+  if (in >= out)
+  {
+    return (uint16_t)(in - out);
+  }
+
+  return (uint16_t)(stream->OSStreamSize - out + in);
+}
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Create Stream Function                      /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSStreamCreate(BRTOS_Stream *stream, uint8_t *buffer, uint16_t size)
+{
+  if ((stream == NULL) || (buffer == NULL) || (size < 2))
+  {
+    return(INVALID_PARAMETERS);
+  }
+
+  stream->OSStreamBuffer  = buffer;
+  stream->OSStreamSize    = size;
+  stream->OSStreamIn      = 0;
+  stream->OSStreamOut     = 0;
+  stream->OSStreamWaiting = 0;
+  OSPrioReset(stream->OSEventWaitList);
+
+  return(ALLOC_EVENT_OK);
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Stream Write Function                       /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSStreamWrite(BRTOS_Stream *stream, const void *data, uint16_t bytes)
+{
+  OS_SR_SAVE_VAR
+  uint8_t  TaskSelect = 0;
+  uint16_t in  = stream->OSStreamIn;
+  uint16_t out = stream->OSStreamOut;
+  uint16_t chunk;
+
+  // Checks for stream overflow - one byte is always free
+  if (bytes > (uint16_t)(stream->OSStreamSize - 1 - OSStreamCount(stream, in, out)))
+  {
+    return BUFFER_UNDERRUN;
+  }
+
+  // The consumer has finished reading the free bytes
+  OS_MEMORY_BARRIER();
+
+  // Copy the data in at most two chunks, before and after the wrap point
+  chunk = (uint16_t)(stream->OSStreamSize - in);
+  if (chunk > bytes)
+  {
+    chunk = bytes;
+  }
+
+  memcpy(&stream->OSStreamBuffer[in], data, chunk);
+
+  if (chunk < bytes)
+  {
+    memcpy(stream->OSStreamBuffer, (const uint8_t*)data + chunk, (size_t)(bytes - chunk));
+    in = (uint16_t)(bytes - chunk);
+  }
+  else
+  {
+    in = (uint16_t)(in + chunk);
+    if (in == stream->OSStreamSize)
+    {
+      in = 0;
+    }
+  }
+
+  // The data is written before being published to the consumer
+  OS_MEMORY_BARRIER();
+  stream->OSStreamIn = in;
+  OS_MEMORY_BARRIER();
+
+  // Only enter the kernel if the consumer is waiting for data
+  if (stream->OSStreamWaiting != 0)
+  {
+    // Enter Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+       OSEnterCritical();
+
+    if ((stream->OSStreamWaiting != 0) &&
+        (OSStreamCount(stream, in, stream->OSStreamOut) >= stream->OSStreamWaiting))
+    {
+      stream->OSStreamWaiting = 0;
+
+      // Removes the consumer from the stream wait list
+      TaskSelect = OSEventWaitListSelect(&stream->OSEventWaitList, stream);
+
+      // Put the consumer into Ready List
+      #if (VERBOSE == 1)
+      ContextTask[TaskSelect].State = READY;
+      #endif
+
+      OSReadyListInsert(&ContextTask[TaskSelect]);
+
+      // If outside of an interrupt service routine, change context to the highest priority task
+      // If inside of an interrupt, the interrupt itself will change the context to the highest priority task
+      if (!iNesting)
+      {
+        ChangeContext();
+      }
+    }
+
+    // Exit Critical Section
+    #if (NESTING_INT == 0)
+    if (!iNesting)
+    #endif
+       OSExitCritical();
+  }
+
+  return WRITE_BUFFER_OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Stream Read Function                        /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+uint8_t OSStreamRead(BRTOS_Stream *stream, void *data, uint16_t min, uint16_t max, uint16_t *read, ostick_t time_wait)
+{
+  OS_SR_SAVE_VAR
+  osdtick_t   timeout;
+  ContextType *Task;
+  uint16_t    in;
+  uint16_t    out = stream->OSStreamOut;
+  uint16_t    bytes;
+  uint16_t    chunk;
+
+  *read = 0;
+
+  if ((min == 0) || (min > max) || (min >= stream->OSStreamSize))
+  {
+    return(INVALID_PARAMETERS);
+  }
+
+  in = stream->OSStreamIn;
+
+  if (OSStreamCount(stream, in, out) < min)
+  {
+    // If no timeout is used and there is not enough data, exit with an error
+    if (time_wait == NO_TIMEOUT)
+    {
+      return EXIT_BY_NO_ENTRY_AVAILABLE;
+    }
+
+    /// Can not wait inside of an interrupt handling code
+    if (iNesting > 0)
+    {
+      return(IRQ_PEND_ERR);
+    }
+
+    // Enter Critical Section
+    OSEnterCritical();
+
+    // The producer wakes up the consumer when min bytes are available
+    stream->OSStreamWaiting = min;
+    OS_MEMORY_BARRIER();
+
+    // Verify if the data arrived before the wait request
+    in = stream->OSStreamIn;
+    if (OSStreamCount(stream, in, out) < min)
+    {
+      Task = (ContextType*)&ContextTask[currentTask];
+
+      // Allocates the current task on the stream wait list
+      OSEventWaitListInsert(&stream->OSEventWaitList, stream, Task);
+
+      // Task entered suspended state, waiting for stream data
+      #if (VERBOSE == 1)
+      Task->State = SUSPENDED;
+      Task->SuspendedType = STREAM;
+      #endif
+
+      // Remove current task from the Ready List
+      OSReadyListRemove(Task);
+
+      // Set timeout overflow
+      if (time_wait)
+      {
+    	  timeout = (osdtick_t)((osdtick_t)OSGetCount() + (osdtick_t)time_wait);
+
+    	  if (sizeof_ostick_t < 8){
+    		  if (timeout >= TICK_COUNT_OVERFLOW)
+    		  {
+    			  Task->TimeToWait = (ostick_t)(timeout - TICK_COUNT_OVERFLOW);
+    		  }
+    		  else
+    		  {
+    			  Task->TimeToWait = (ostick_t)timeout;
+    		  }
+    	  }else{
+    		  Task->TimeToWait = (ostick_t)timeout;
+    	  }
+
+        // Put task into delay list
+        IncludeTaskIntoDelayList();
+      } else
+      {
+        Task->TimeToWait = NO_TIMEOUT;
+      }
+
+      // Change Context - Returns on time overflow or stream write
+      ChangeContext();
+
+      // Exit Critical Section
+      OSExitCritical();
+      // Enter Critical Section
+      OSEnterCritical();
+
+      if (time_wait)
+      {
+          // Verify if the reason of task wake up was stream timeout
+          if(Task->TimeToWait == EXIT_BY_TIMEOUT)
+          {
+              // Test if both timeout and write have occured before arrive here
+              if (OSEventWaitListHas(&stream->OSEventWaitList, stream, Task))
+              {
+                // Remove the task from the stream wait list
+                OSEventWaitListRemove(&stream->OSEventWaitList, stream, Task);
+                stream->OSStreamWaiting = 0;
+
+                // Exit Critical Section
+                OSExitCritical();
+
+                // Indicates stream timeout
+                return TIMEOUT;
+              }
+          }
+          else
+          {
+              // Remove the time to wait condition
+              Task->TimeToWait = NO_TIMEOUT;
+
+              // Remove from delay list
+              RemoveFromDelayList();
+          }
+      }
+
+      in = stream->OSStreamIn;
+    }
+
+    stream->OSStreamWaiting = 0;
+
+    // Exit Critical Section
+    OSExitCritical();
+  }
+
+  // The data is published before being read
+  OS_MEMORY_BARRIER();
+
+  bytes = OSStreamCount(stream, in, out);
+  if (bytes > max)
+  {
+    bytes = max;
+  }
+
+  // Copy the data in at most two chunks, before and after the wrap point
+  chunk = (uint16_t)(stream->OSStreamSize - out);
+  if (chunk > bytes)
+  {
+    chunk = bytes;
+  }
+
+  memcpy(data, &stream->OSStreamBuffer[out], chunk);
+
+  if (chunk < bytes)
+  {
+    memcpy((uint8_t*)data + chunk, stream->OSStreamBuffer, (size_t)(bytes - chunk));
+    out = (uint16_t)(bytes - chunk);
+  }
+  else
+  {
+    out = (uint16_t)(out + chunk);
+    if (out == stream->OSStreamSize)
+    {
+      out = 0;
+    }
+  }
+
+  // The data is read before its bytes are released to the producer
+  OS_MEMORY_BARRIER();
+  stream->OSStreamOut = out;
+
+  *read = bytes;
+
+  return READ_BUFFER_OK;
+}
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+uint16_t OSStreamAvailable(BRTOS_Stream *stream)
+{
+  uint16_t in  = stream->OSStreamIn;
+  uint16_t out = stream->OSStreamOut;
+
+  return OSStreamCount(stream, in, out);
+}
+
+#endif
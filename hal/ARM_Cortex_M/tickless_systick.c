@@ -0,0 +1,115 @@
+/**
+* \file tickless_systick.c
+* \brief SysTick based tickless idle shared by the ARM Cortex-M ports.
+*
+* See tickless_systick.h for the port requirements.
+*
+**/
+
+#include "BRTOS.h"
+
+#if (TICKLESS == 1)
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Tickless Idle                               /////
+/////                                                  /////
+/////  Stops the tick interrupt until the earliest     /////
+/////  deadline of the delay list. Idle task only.     /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+void WaitTickless(void)
+{
+	ostick_t idle_ticks;
+	ostick_t ticks;
+	INT32U   reload;
+	INT32U   elapsed;
+	INT32U   ctrl;
+
+	UserEnterCritical();
+
+	idle_ticks = OSTicklessIdleTime(TICKLESS_MAX_TICKS);
+
+	if (idle_ticks == 0)
+	{
+		// The next tick is needed. Sleeps until the next interrupt
+		OS_CPU_TICKLESS_SLEEP();
+		UserExitCritical();
+		return;
+	}
+
+	// Stop the tick timer. The counts remaining in the current tick are kept
+	*(TICKLESS_SYSTICK_CTRL) = TICKLESS_SYSTICK_CLK | TICKLESS_SYSTICK_INT;
+
+	// The tick interrupt is already pending - resume the timer and let it run
+	if (*(TICKLESS_INT_CTRL) & TICKLESS_PENDSTSET)
+	{
+		*(TICKLESS_SYSTICK_CTRL) = TICKLESS_SYSTICK_CLK | TICKLESS_SYSTICK_INT | TICKLESS_SYSTICK_ENABLE;
+		UserExitCritical();
+		return;
+	}
+
+	// The next interrupt is at the end of the current tick plus the suppressed ticks
+	reload = *(TICKLESS_SYSTICK_CNT) + (TICKLESS_TICK_COUNTS * (INT32U)(idle_ticks - 1));
+	*(TICKLESS_SYSTICK_LOAD) = reload;
+	*(TICKLESS_SYSTICK_CNT) = 0;
+	*(TICKLESS_SYSTICK_CTRL) = TICKLESS_SYSTICK_CLK | TICKLESS_SYSTICK_INT | TICKLESS_SYSTICK_ENABLE;
+
+	OS_CPU_TICKLESS_SLEEP();
+
+	// Stop the timer. Reading the control register clears the count flag
+	ctrl = *(TICKLESS_SYSTICK_CTRL);
+	*(TICKLESS_SYSTICK_CTRL) = TICKLESS_SYSTICK_CLK | TICKLESS_SYSTICK_INT;
+
+	if (ctrl & TICKLESS_SYSTICK_COUNTFLAG)
+	{
+		// Woken by the tick timer. The tick interrupt is pending and
+		// will account the last tick of the idle period
+		ticks = (ostick_t)(idle_ticks - 1);
+
+		// Counts to the end of the tick that is already running
+		elapsed = reload - *(TICKLESS_SYSTICK_CNT);
+		if (elapsed < TICKLESS_TICK_COUNTS)
+		{
+			reload = (TICKLESS_TICK_COUNTS - 1u) - elapsed;
+		}
+		else
+		{
+			reload = TICKLESS_TICK_COUNTS - 1u;
+		}
+	}
+	else
+	{
+		// Woken by another interrupt. Only the complete ticks are accounted
+		elapsed = (TICKLESS_TICK_COUNTS * (INT32U)idle_ticks) - *(TICKLESS_SYSTICK_CNT);
+		ticks = (ostick_t)(elapsed / TICKLESS_TICK_COUNTS);
+		if (ticks >= idle_ticks)
+		{
+			ticks = (ostick_t)(idle_ticks - 1);
+		}
+
+		// Counts to the end of the current tick
+		reload = (((INT32U)ticks + 1u) * TICKLESS_TICK_COUNTS) - elapsed;
+	}
+
+	if ((reload == 0) || (reload > (TICKLESS_TICK_COUNTS - 1u)))
+	{
+		reload = TICKLESS_TICK_COUNTS - 1u;
+	}
+
+	// Restart the timer with the rest of the current tick, then with the normal tick period
+	*(TICKLESS_SYSTICK_LOAD) = reload;
+	*(TICKLESS_SYSTICK_CNT) = 0;
+	*(TICKLESS_SYSTICK_CTRL) = TICKLESS_SYSTICK_CLK | TICKLESS_SYSTICK_INT | TICKLESS_SYSTICK_ENABLE;
+	*(TICKLESS_SYSTICK_LOAD) = TICKLESS_TICK_COUNTS - 1u;
+
+	// Update the kernel time with the suppressed ticks
+	OSTicklessCompensate(ticks);
+
+	UserExitCritical();
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,49 @@
+/**
+* \file tickless_systick.h
+* \brief SysTick based tickless idle shared by the ARM Cortex-M ports.
+*
+* The SysTick timer and the interrupt control register are defined by the
+* ARMv6-M/ARMv7-M architecture, so every Cortex-M port uses the same code.
+* A port enables it when TICKLESS == 1 by:
+*  - defining OS_CPU_TICKLESS_SLEEP() in its HAL.h as one statement with the
+*    DSB/WFI/ISB sequence in the syntax of its compiler, before including this file;
+*  - adding hal/ARM_Cortex_M to the include path and tickless_systick.c
+*    to the project.
+*
+**/
+
+#ifndef TICKLESS_SYSTICK_H
+#define TICKLESS_SYSTICK_H
+
+/// SysTick and interrupt control registers used by the tickless idle mode
+#define TICKLESS_SYSTICK_CTRL       ( ( volatile unsigned long *) 0xe000e010 )
+#define TICKLESS_SYSTICK_LOAD       ( ( volatile unsigned long *) 0xe000e014 )
+#define TICKLESS_SYSTICK_CNT        ( ( volatile unsigned long *) 0xe000e018 )
+#define TICKLESS_INT_CTRL           ( ( volatile unsigned long *) 0xe000ed04 )
+#define TICKLESS_SYSTICK_CLK        0x00000004
+#define TICKLESS_SYSTICK_INT        0x00000002
+#define TICKLESS_SYSTICK_ENABLE     0x00000001
+#define TICKLESS_SYSTICK_COUNTFLAG  0x00010000
+#define TICKLESS_PENDSTSET          0x04000000
+
+/// Number of SysTick counts in one tick
+#define TICKLESS_TICK_COUNTS    (INT32U)(configCPU_CLOCK_HZ / (INT32U)configTICK_RATE_HZ)
+
+/// Maximum number of ticks supported by the 24 bits SysTick counter
+#define TICKLESS_MAX_TICKS      (ostick_t)(0x00FFFFFFUL / TICKLESS_TICK_COUNTS)
+
+#ifndef OS_CPU_TICKLESS_SLEEP
+#error "The port must define OS_CPU_TICKLESS_SLEEP() to use the SysTick tickless idle"
+#endif
+
+/*****************************************************************************************//**
+* \fn void WaitTickless(void)
+* \brief Idle task low power wait with the tick interrupt suppressed
+*
+* Reprograms the SysTick to the earliest deadline of the delay list, sleeps and
+* compensates the kernel time with the ticks that elapsed. Called only by the idle task.
+* \return NONE
+*********************************************************************************************/
+void WaitTickless(void);
+
+#endif
@@ -44,3 +44,5 @@
 #define ARM_CM0   		9u
 #define ARM_Cortex_M4F  10u
 #define ARM_CM4F   		10u
+#define X86   			11u
+#define POSIX_LINUX		11u
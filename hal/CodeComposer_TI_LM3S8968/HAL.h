@@ -66,6 +66,9 @@
 /// Define if 32 bits register for tick timer will be used
 #define TICK_TIMER_32BITS   1
 
+/// Define if the tickless idle mode will be used
+#define TICKLESS 0
+
 /// Define if nesting interrupt is active
 #define NESTING_INT			1
 
@@ -139,7 +142,14 @@ void OS_CPU_SR_Restore(INT32U);
 #define UserExitCritical()  __asm(" CPSIE I")
 
 /// Defines the low power command of the choosen microcontroller
+#if (TICKLESS == 1)
+/// Low power sequence of the SysTick tickless idle (hal/ARM_Cortex_M)
+#define OS_CPU_TICKLESS_SLEEP() do { __asm(" DSB "); __asm(" WFI "); __asm(" ISB "); } while(0)
+#include "tickless_systick.h"
+#define OS_Wait WaitTickless();
+#else
 #define OS_Wait __asm(" WFI ");
+#endif
 /// Defines the tick timer interrupt handler code (clear flag) of the choosen microcontroller
 #define TICKTIMER_INT_HANDLER
 #define TIMER_MODULE	SYST_RVR
@@ -103,16 +103,16 @@ void TickTimer(void)
   // Interrupt handling
   TICKTIMER_INT_HANDLER;
 
+#if (TICKLESS == 1)
+  OSIncCounter(1);
+#else
   OSIncCounter();
+#endif
   
   // BRTOS TRACE SUPPORT
   #if (OSTRACE == 1) 
       #if(OS_TICK_SHOW == 1) 
-          #if(OS_TRACE_BY_TASK == 1)
-          Update_OSTrace(0, ISR_TICK);
-          #else
-          Update_OSTrace(configMAX_TASK_INSTALL - 1, ISR_TICK);
-          #endif         
+          OS_TRACE(OS_TRACE_TICK, OSGetCount(), 0);
       #endif       
   #endif  
 
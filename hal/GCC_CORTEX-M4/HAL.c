@@ -37,12 +37,6 @@
   INT16U SPvalue;                             ///< Used to save and restore a task stack pointer
 #endif
 
-#if (TICKLESS == 1)
-#define MAX_TICKS	(INT32U)(0x00FFFFFF / ((configCPU_CLOCK_HZ / (INT32U)configTICK_RATE_HZ) - 1))
-  volatile ostick_t time_next_task=0;
-  volatile char normal_run = 1;
-  void OSIncTickLess(void);
-#endif
 
 
 ////////////////////////////////////////////////////////////
@@ -96,12 +90,13 @@ void TickTimer(void)
   // ************************
   // Entrada de interrupo
   // ************************
+  OS_CPU_INT_ENTER();
   
   // Interrupt handling
   TICKTIMER_INT_HANDLER;
 
 #if (TICKLESS == 1)
-  OSIncTickLess();
+  OSIncCounter(1);
 #else
   OSIncCounter();
 #endif
@@ -109,11 +104,7 @@ void TickTimer(void)
   // BRTOS TRACE SUPPORT
   #if (OSTRACE == 1) 
       #if(OS_TICK_SHOW == 1) 
-          #if(OS_TRACE_BY_TASK == 1)
-          Update_OSTrace(0, ISR_TICK);
-          #else
-          Update_OSTrace(configMAX_TASK_INSTALL - 1, ISR_TICK);
-          #endif         
+          OS_TRACE(OS_TRACE_TICK, OSGetCount(), 0);
       #endif       
   #endif  
 
@@ -129,6 +120,7 @@ void TickTimer(void)
   // ************************
   // Interrupt Exit
   // ************************
+  OS_CPU_INT_EXIT();
   OS_INT_EXIT_EXT();
   // ************************  
 }
@@ -152,53 +144,6 @@ void TickTimer(void)
 * \brief Software interrupt handler routine (Internal kernel function).
 *  Used to switch the tasks context.
 ****************************************************************/
-#if (TICKLESS == 1)
-void BRTOS_WakeUP(void){
-	  OS_SR_SAVE_VAR
-	  OSEnterCritical();
-
-		if (!normal_run)
-		{
-			// Calcula o tempo de correo
-			INT32U 		module  = (configCPU_CLOCK_HZ / (INT32U)configTICK_RATE_HZ) - 1;
-			volatile ostick_t time = time_next_task-((*(NVIC_SYSTICK_CNT))/module);
-
-			// Corrige o tempo
-			if (time > 0){
-				OSIncCounter(time);
-    			// ************************
-				// Handler code for the tick
-				// ************************
-				OS_TICK_HANDLER();
-			}
-
-			// Configura o timer para o modo normal, um incremento por tick
-			normal_run=1;
-			TickTimerSetup();
-		}
-
-		OSExitCritical();
-}
-
-void OSIncTickLess(void)
-{
-    OS_SR_SAVE_VAR
-
-	OSEnterCritical();
-	if(!normal_run)
-	{
-		normal_run=1;
-
-		OSIncCounter(time_next_task);
-		TickTimerSetup();
-	} else
-	{
-		OSIncCounter(1);
-	}
-	OSExitCritical();
-
-}
-#endif
 
 __attribute__ ((naked)) void SwitchContext(void)
 {
@@ -207,10 +152,6 @@ __attribute__ ((naked)) void SwitchContext(void)
   // ************************
   OS_SAVE_ISR();
 
-#if (TICKLESS == 1)
-  BRTOS_WakeUP();
-#endif
-
   // Interrupt Handling
   Clear_PendSV();
 
@@ -362,6 +303,73 @@ void          OS_TaskReturn             (void);
 
 
 
+#if (MPU_STACK_GUARD == 1)
+#if (BRTOS_STACK_CHECK_EN != 1)
+#error "MPU_STACK_GUARD requires BRTOS_STACK_CHECK_EN"
+#endif
+
+void OS_CPU_StackGuard(void)
+{
+	INT32U guard = (INT32U)ContextTask[currentTask].StackGuard;
+
+	if (guard == 0)
+	{
+		*(MPU_RBAR) = MPU_RBAR_VALID | MPU_STACK_GUARD_REGION;
+		*(MPU_RASR) = 0;
+	}else
+	{
+		// Read only block at the end of the task stack
+		guard = (guard + (MPU_STACK_GUARD_SIZE - 1)) & ~(INT32U)(MPU_STACK_GUARD_SIZE - 1);
+
+		*(MPU_RBAR) = guard | MPU_RBAR_VALID | MPU_STACK_GUARD_REGION;
+		*(MPU_RASR) = MPU_RASR_STACK_GUARD;
+	}
+
+	// The default memory map is kept for the other addresses
+	*(MPU_CTRL) = MPU_CTRL_PRIVDEFENA | MPU_CTRL_ENABLE;
+	__asm(" DSB ");
+	__asm(" ISB ");
+}
+#endif
+
+
+
+
+#if (OSTRACE == 1)
+// Interrupt nesting of the handlers that use OS_CPU_INT_ENTER
+INT8U OS_CPU_TraceNesting = 0;
+
+INT32U OS_CPU_TraceReserve(volatile INT32U *head, INT32U *timestamp)
+{
+	INT32U value;
+	INT32U failed;
+	INT32U stamp;
+
+	// Retries if an interrupt has reserved a record between the load and the store.
+	// The exception entry clears the exclusive access, so the timestamp read between
+	// them is never older than the one of a record reserved by that interrupt
+	do
+	{
+		__asm volatile
+		(
+				"LDREX   %0, [%3]			\n"
+				"LDR     %2, [%4]			\n"
+				"ADD     %0, %0, #1			\n"
+				"STREX   %1, %0, [%3]		\n"
+				: "=&r" (value), "=&r" (failed), "=&r" (stamp)
+				: "r" (head), "r" (DWT_CYCCNT)
+				: "memory"
+		);
+	}while(failed);
+
+	*timestamp = stamp;
+	return value - 1;
+}
+#endif
+
+
+
+
 #if (NESTING_INT == 1)
 
 INT32U OS_CPU_SR_Save(void)
@@ -383,67 +391,6 @@ void OS_CPU_SR_Restore(INT32U SR)
 	__asm volatile ("MSR PRIMASK, %0\n\t" : : "r" (SR) );
 }
 
-#if (TICKLESS == 1)
-void WaitTickless(void){
-	ostick_t  lowWait = MAX_TIMER;
-    ContextType *Task = Head;
-    volatile ostick_t time_tmp = 0;
-
-    UserEnterCritical();
-
-    //Get current tick count
-    volatile ostick_t OS_tick_counter=OSGetTickCount();
-
-    // Disable systick
-    *(NVIC_SYSTICK_CTRL) = 0;
-
-    while(Task != NULL)
-    {
-        if (Task->TimeToWait >= OS_tick_counter)
-        {
-			time_tmp = Task->TimeToWait - OS_tick_counter;
-			if (time_tmp < lowWait)
-			{
-					lowWait = time_tmp;
-			}
-        }
-		#if  (ostick_t != uint64_t)
-        else
-        {
-			time_tmp = Task->TimeToWait + (TICK_COUNT_OVERFLOW - OS_tick_counter);
-			if (time_tmp < lowWait)
-				{
-					lowWait = time_tmp;
-				}
-        }
-		#endif
-        Task = Task->Next;
-    }
-
-    // Reconfigura o timer para acordar somente quanto a tarefa
-   	// mais prxima estiver pronta
-    time_next_task = lowWait;
-	INT32U 		module  = configCPU_CLOCK_HZ / (INT32U)configTICK_RATE_HZ;
-
-	*(NVIC_SYSTICK_CTRL) = 0;			// Disable Sys Tick Timer
-	if (time_next_task > MAX_TICKS) time_next_task = MAX_TICKS;
-	if (time_next_task > 0){
-    *(NVIC_SYSTICK_LOAD) = (module - 1u) * time_next_task;	// Set tick timer module
-	}else{
-	    *(NVIC_SYSTICK_LOAD) = (module - 1u);	// Set tick timer module
-	}
-    *(NVIC_SYSTICK_CTRL) = NVIC_SYSTICK_CLK | NVIC_SYSTICK_INT | NVIC_SYSTICK_ENABLE;
-
-   	// Entra em modo de economia de energia
-	normal_run = 0;
-
-    __asm("DSB");
-    __asm("WFI");
-    __asm("ISB");
-
-    UserExitCritical();
-}
-#endif
 
 
 
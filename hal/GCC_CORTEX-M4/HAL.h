@@ -66,8 +66,12 @@
 /// Define if 32 bits register for tick timer will be used
 #define TICK_TIMER_32BITS   1
 
+/// Define if the tickless idle mode will be used
 #define TICKLESS 0
 
+/// Define if the MPU guards the end of the task stacks (requires BRTOS_STACK_CHECK_EN)
+#define MPU_STACK_GUARD 0
+
 /// Define if nesting interrupt is active
 #define NESTING_INT 1
 
@@ -115,6 +119,24 @@ extern INT32U SPvalue;
 #define FPU_FPCCR						( ( volatile unsigned long *) 0xE000EF34 )
 #define NVIC_SYSPRI3					( ( volatile unsigned long *) 0xe000ed20 )
 
+// MPU registers and the region that guards the end of the task stacks
+#define MPU_CTRL						( ( volatile unsigned long *) 0xe000ed94 )
+#define MPU_RBAR						( ( volatile unsigned long *) 0xe000ed9c )
+#define MPU_RASR						( ( volatile unsigned long *) 0xe000eda0 )
+#define MPU_CTRL_ENABLE					0x00000001
+#define MPU_CTRL_PRIVDEFENA				0x00000004
+#define MPU_RBAR_VALID					0x00000010
+#define MPU_STACK_GUARD_REGION			7
+#define MPU_STACK_GUARD_SIZE			32
+#define MPU_RASR_STACK_GUARD			0x16060009		// XN, read only, normal memory, 32 bytes, enabled
+
+// DWT cycle counter used as timestamp of the trace records
+#define DEM_CR							( ( volatile unsigned long *) 0xe000edfc )
+#define DWT_CTRL						( ( volatile unsigned long *) 0xe0001000 )
+#define DWT_CYCCNT						( ( volatile unsigned long *) 0xe0001004 )
+#define DEM_CR_TRCENA					0x01000000
+#define DWT_CTRL_CYCCNTENA				0x00000001
+
 // Kernel interrupt priorities
 #define NVIC_PENDSV_PRI					( ( ( unsigned long ) KERNEL_INTERRUPT_PRIORITY ) << 16 )
 #define NVIC_SYSTICK_PRI				( ( ( unsigned long ) KERNEL_INTERRUPT_PRIORITY ) << 24 )
@@ -147,8 +169,10 @@ void OS_CPU_SR_Restore(INT32U);
 
 /// Defines the low power command of the choosen microcontroller
 #if (TICKLESS == 1)
-void WaitTickless(void);
-#define OS_Wait WaitTickless()
+/// Low power sequence of the SysTick tickless idle (hal/ARM_Cortex_M)
+#define OS_CPU_TICKLESS_SLEEP() do { __asm(" DSB "); __asm(" WFI "); __asm(" ISB "); } while(0)
+#include "tickless_systick.h"
+#define OS_Wait WaitTickless();
 #else
 #define OS_Wait __asm(" WFI ");
 #endif
@@ -209,6 +233,74 @@ void TickTimerSetup(void);
 *********************************************************************************************/
 void OSRTCSetup(void);
 
+/*****************************************************************************************//**
+* \fn void OS_CPU_StackGuard(void)
+* \brief Sets the MPU region that guards the end of the current task stack
+*  The first 32 bytes aligned block after the stack guard word is read only, so a stack
+*  overflow causes a MemManage fault at the faulty write. The usable stack is reduced by
+*  up to 64 bytes. Called by the context switch for the task being switched in.
+* \return NONE
+*********************************************************************************************/
+#if (MPU_STACK_GUARD == 1)
+void OS_CPU_StackGuard(void);
+#define OS_STACK_GUARD_SET()	OS_CPU_StackGuard()
+#endif
+
+/*****************************************************************************************//**
+* \fn INT32U OS_CPU_TraceReserve(volatile INT32U *head, INT32U *timestamp)
+* \brief Reserves a trace record with an exclusive access increment (LDREX/STREX),
+*  so the trace can be written by interrupts that preempt a record write.
+*  The timestamp is read inside the exclusive access, so the records are kept in order.
+* \param head Trace record counter
+* \param timestamp Timestamp of the reserved record
+* \return Counter value before the increment
+*********************************************************************************************/
+INT32U OS_CPU_TraceReserve(volatile INT32U *head, INT32U *timestamp);
+#define OS_TRACE_RESERVE(timestamp)	OS_CPU_TraceReserve(&OSTraceHead, &(timestamp))
+
+/// Timestamp of the trace records - DWT cycle counter
+#define OS_TRACE_TIMESTAMP()		(INT32U)(*(DWT_CYCCNT))
+#define OS_TRACE_TIMESTAMP_HZ		configCPU_CLOCK_HZ
+#define OS_TRACE_TIMESTAMP_INIT()	do {								\
+										*(DEM_CR) |= DEM_CR_TRCENA;		\
+										*(DWT_CYCCNT) = 0;				\
+										*(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;	\
+									} while(0)
+
+/// The kernel interrupt exit runs in the PendSV handler, which is not traced as an interrupt
+#define OS_TRACE_ISR(type)
+
+/*****************************************************************************************//**
+* Interrupt entry and exit of the port interrupt handlers. This port does not count the
+* interrupt nesting in iNesting, the handlers that call the kernel services must be written as:
+*
+*   void Handler(void)
+*   {
+*     OS_CPU_INT_ENTER();
+*     // Handler code
+*     OS_CPU_INT_EXIT();
+*     OS_INT_EXIT_EXT();		// Only if the handler may have made a task ready
+*   }
+*
+* With OSTRACE they write the interrupt entry and exit records, and the records written
+* in between carry OS_TRACE_ISR_FLAG.
+*********************************************************************************************/
+#if (OSTRACE == 1)
+extern INT8U OS_CPU_TraceNesting;
+#define OS_CPU_INT_ENTER()			do {																	\
+										OS_CPU_TraceNesting++;												\
+										OSTraceEvent(OS_TRACE_ISR_ENTER, 0, (INT16U)OS_CPU_TraceNesting);	\
+									} while(0)
+#define OS_CPU_INT_EXIT()			do {																	\
+										OSTraceEvent(OS_TRACE_ISR_EXIT, 0, (INT16U)OS_CPU_TraceNesting);	\
+										OS_CPU_TraceNesting--;												\
+									} while(0)
+#define OS_TRACE_IN_ISR()			(OS_CPU_TraceNesting > 0)
+#else
+#define OS_CPU_INT_ENTER()
+#define OS_CPU_INT_EXIT()
+#endif
+
 /* BRTOS port interrupt handlers. Must be used in order to map handlers to the specific processor interrupt vector. */
 extern void TickTimer(void);
 extern __attribute__((naked)) void SwitchContext(void);
@@ -18,6 +18,12 @@
 //                        not worth the grief.
 // D.Frank 2014-04-02  - Fixed heap configuration when UMM_TEST_MAIN is NOT set,
 //                        added user-dependent configuration file umm_malloc_cfg.h
+// G.Denardin 2016-10-18 - Segregated free lists (two level size classes) for
+//                        bounded time allocation, heap initialized with
+//                        sentinel blocks, umm_realloc() growing in place and
+//                        fragmentation metrics
+//                     - Per task accounting of the allocations and trace of
+//                        the allocations
 // ----------------------------------------------------------------------------
 //
 // This is a memory management library specifically designed to work with the
@@ -485,6 +491,38 @@
 //
 // ----------------------------------------------------------------------------
 
+// ----------------------------------------------------------------------------
+//
+// Segregated free lists
+//
+// The diagrams above show a single free list for clarity. In this version
+// every free block is kept in one of several free lists, selected by the size
+// of the block, as done by the TLSF allocator:
+//
+//   - the first level is the most significant bit of the size in blocks
+//   - the second level splits each first level range into 2^UMM_SL_BITS
+//     lists of the same width
+//
+// One bitmap tells which first level ranges have free blocks and one bitmap
+// per range tells which of its lists are not empty. A request is rounded up
+// to the start of the next list, so any block of the list found by the
+// bitmaps is large enough: malloc() does not walk any list and its time does
+// not depend on the number of free blocks. Only when this search fails, the
+// list of the request size itself is walked, before giving up.
+//
+// With UMM_BEST_FIT the list of the request size is walked for its smallest
+// block that fits, then the next non empty list for its smallest block.
+//
+// The free list links (nf and pf) are only used inside each list, and index
+// 0 ends a list. A free block is always moved to the list of its new size
+// when it is assimilated or split.
+//
+// The heap is initialized on the first use: block 0 and the last block are
+// used sentinels, and everything between them is a single free block. There
+// is no "end of the free list" case any more.
+//
+// ----------------------------------------------------------------------------
+
 //#include <stddef.h>
 //#include <stdlib.h>
 #include <stdio.h>
@@ -494,10 +532,8 @@
 
 #ifndef UMM_MALLOC_CFG__DONT_BUILD
 
-#ifndef UMM_FIRST_FIT
-#  ifndef UMM_BEST_FIT
-#    define UMM_BEST_FIT
-#  endif
+#ifndef UMM_SL_BITS
+#  define UMM_SL_BITS 2
 #endif
 
 // ----------------------------------------------------------------------------
@@ -521,6 +557,10 @@ UMM_H_ATTPACKPRE typedef struct umm_block_t {
 #define UMM_FREELIST_MASK (0x8000)
 #define UMM_BLOCKNO_MASK  (0x7FFF)
 
+// Size classes - block numbers have 15 bits
+#define UMM_SL_COUNT      (1 << UMM_SL_BITS)
+#define UMM_FL_COUNT      (16 - UMM_SL_BITS)
+
 // ----------------------------------------------------------------------------
 
 #ifdef UMM_REDEFINE_MEM_FUNCTIONS
@@ -534,6 +574,11 @@ const unsigned short int umm_numblocks = (sizeof(umm_heap) / sizeof(umm_block));
 
 #define UMM_NUMBLOCKS (umm_numblocks)
 
+// Heads of the free lists and the bitmaps of the non empty lists
+static unsigned short int umm_freelist[UMM_FL_COUNT][UMM_SL_COUNT];
+static unsigned short int umm_fl_bitmap;
+static unsigned char      umm_sl_bitmap[UMM_FL_COUNT];
+
 
 
 // ----------------------------------------------------------------------------
@@ -546,6 +591,183 @@ const unsigned short int umm_numblocks = (sizeof(umm_heap) / sizeof(umm_block));
 #define UMM_PFREE(b)  (UMM_BLOCK(b).body.free.prev)
 #define UMM_DATA(b)   (UMM_BLOCK(b).body.data)
 
+#define UMM_SIZE(b)   ((UMM_NBLOCK(b) & UMM_BLOCKNO_MASK) - (b))
+
+// ----------------------------------------------------------------------------
+// Per task accounting and trace of the allocations
+
+#if (BRTOS_HEAP_ACCOUNTING_EN == 1)
+
+// Hidden header of the allocations - the task that made the allocation
+UMM_H_ATTPACKPRE typedef struct umm_tag_t {
+   unsigned char owner;
+   unsigned char unused[3];
+} UMM_H_ATTPACKSUF umm_tag;
+
+#define UMM_TAG_SIZE  (sizeof(umm_tag))
+#define UMM_TAG(b)    ((umm_tag *)UMM_DATA(b))
+
+static OS_HEAP_TASK_STATS umm_task_stats[NUMBER_OF_TASKS + 1];
+
+#if (BRTOS_HEAP_TRACE_SIZE > 0)
+
+static OS_HEAP_TRACE      umm_trace[BRTOS_HEAP_TRACE_SIZE];
+static unsigned short int umm_trace_in;
+static unsigned short int umm_trace_count;
+static uint32_t           umm_trace_lost;
+
+static void umm_trace_event( uint8_t type, uint8_t task,
+      unsigned short int block,
+      unsigned short int blocks ) {
+   OS_HEAP_TRACE *rec;
+
+   // The records are not overwritten, so the trace can be replayed
+
+   if( umm_trace_count >= BRTOS_HEAP_TRACE_SIZE ) {
+      ++umm_trace_lost;
+      return;
+   }
+
+   rec = &umm_trace[umm_trace_in];
+   rec->type   = type;
+   rec->task   = task;
+   rec->block  = block;
+   rec->blocks = blocks;
+   rec->tick   = (uint16_t)OSGetCount();
+
+   if( ++umm_trace_in >= BRTOS_HEAP_TRACE_SIZE ) {
+      umm_trace_in = 0;
+   }
+   ++umm_trace_count;
+}
+
+#else
+#define umm_trace_event(type, task, block, blocks)
+#endif
+
+static void umm_account_alloc( unsigned short int c ) {
+   OS_HEAP_TASK_STATS *stats = &umm_task_stats[currentTask];
+
+   UMM_TAG(c)->owner = currentTask;
+
+   stats->bytes += UMM_SIZE(c) * sizeof(umm_block);
+   if( stats->bytes > stats->peak_bytes ) {
+      stats->peak_bytes = stats->bytes;
+   }
+   ++stats->blocks;
+   ++stats->allocs;
+
+   umm_trace_event( OS_HEAP_TRACE_ALLOC, currentTask, c, UMM_SIZE(c) );
+}
+
+static void umm_account_free( unsigned short int c ) {
+   OS_HEAP_TASK_STATS *stats = &umm_task_stats[UMM_TAG(c)->owner];
+
+   stats->bytes -= UMM_SIZE(c) * sizeof(umm_block);
+   --stats->blocks;
+   ++stats->frees;
+
+   umm_trace_event( OS_HEAP_TRACE_FREE, UMM_TAG(c)->owner, c, UMM_SIZE(c) );
+}
+
+#define umm_account_fail(blocks) umm_trace_event( OS_HEAP_TRACE_FAIL, currentTask, 0, blocks )
+
+#else
+#define UMM_TAG_SIZE  0
+#define umm_account_alloc(c)
+#define umm_account_free(c)
+#define umm_account_fail(blocks)
+#endif
+
+// Pointer of the data of a used block and block of the pointer
+
+#define UMM_PTR(b)    ((void *)((unsigned char *)UMM_DATA(b) + UMM_TAG_SIZE))
+#define UMM_PTR_BLOCK(p) \
+   ((unsigned short int)(((unsigned char *)(p) - UMM_TAG_SIZE - (unsigned char *)(&(umm_heap[0])))/sizeof(umm_block)))
+
+// ----------------------------------------------------------------------------
+// Size class of a number of blocks
+
+static unsigned char umm_fls( unsigned short int x ) {
+   unsigned char bit = 0;
+
+   while( x >>= 1 ) {
+      ++bit;
+   }
+
+   return( bit );
+}
+
+static unsigned char umm_ffs( unsigned short int x ) {
+   unsigned char bit = 0;
+
+   while( !(x & 1) ) {
+      x >>= 1;
+      ++bit;
+   }
+
+   return( bit );
+}
+
+static void umm_mapping( unsigned short int size, unsigned char *fl, unsigned char *sl ) {
+   unsigned char bit;
+
+   if( size < UMM_SL_COUNT ) {
+      *fl = 0;
+      *sl = (unsigned char)size;
+   } else {
+      bit = umm_fls( size );
+      *fl = (unsigned char)(bit - UMM_SL_BITS + 1);
+      *sl = (unsigned char)((size >> (bit - UMM_SL_BITS)) - UMM_SL_COUNT);
+   }
+}
+
+// ----------------------------------------------------------------------------
+
+static void umm_insert_free( unsigned short int c ) {
+   unsigned char fl, sl;
+
+   umm_mapping( UMM_SIZE(c), &fl, &sl );
+
+   UMM_NFREE(c) = umm_freelist[fl][sl];
+   UMM_PFREE(c) = 0;
+   if( umm_freelist[fl][sl] ) {
+      UMM_PFREE(umm_freelist[fl][sl]) = c;
+   }
+   umm_freelist[fl][sl] = c;
+
+   umm_fl_bitmap     |= (unsigned short int)(1 << fl);
+   umm_sl_bitmap[fl] |= (unsigned char)(1 << sl);
+
+   UMM_NBLOCK(c) |= UMM_FREELIST_MASK;
+}
+
+// ----------------------------------------------------------------------------
+
+static void umm_init( void ) {
+
+   // Block 0 and the last block are used blocks that are never freed, so a
+   // free block always has used neighbours at the ends of the heap
+
+   memset( umm_heap, 0, sizeof( umm_heap ) );
+   memset( umm_freelist, 0, sizeof( umm_freelist ) );
+   memset( umm_sl_bitmap, 0, sizeof( umm_sl_bitmap ) );
+   umm_fl_bitmap = 0;
+
+   UMM_NBLOCK(0) = 1;
+   UMM_PBLOCK(0) = 0;
+
+   UMM_NBLOCK(1) = UMM_NUMBLOCKS - 1;
+   UMM_PBLOCK(1) = 0;
+
+   UMM_NBLOCK(UMM_NUMBLOCKS - 1) = 0;
+   UMM_PBLOCK(UMM_NUMBLOCKS - 1) = 1;
+
+   umm_insert_free( 1 );
+}
+
+#define UMM_INIT_CHECK() if( 0 == UMM_NBLOCK(0) ) umm_init()
+
 // ----------------------------------------------------------------------------
 // One of the coolest things about this little library is that it's VERY
 // easy to get debug information about the memory heap by simply iterating
@@ -566,31 +788,42 @@ void *umm_info( void *ptr, int force ) {
 
    OS_SR_SAVE_VAR
    unsigned short int blockNo = 0;
+   unsigned short int size;
+
+   (void)force;
 
    // Protect the critical section...
    //
    UMM_CRITICAL_ENTRY();
 
+   UMM_INIT_CHECK();
+
    // Clear out all of the entries in the heapInfo structure before doing
    // any calculations..
    //
    memset( &heapInfo, 0, sizeof( heapInfo ) );
 
    // Now loop through the block lists, and keep track of the number and size
-   // of used and free blocks. The terminating condition is an nb pointer with
-   // a value of zero...
+   // of used and free blocks. The terminating condition is the last block,
+   // whose nb pointer has a value of zero...
 
    blockNo = UMM_NBLOCK(blockNo) & UMM_BLOCKNO_MASK;
 
    while( UMM_NBLOCK(blockNo) & UMM_BLOCKNO_MASK ) {
+      size = UMM_SIZE(blockNo);
+
       ++heapInfo.totalEntries;
-      heapInfo.totalBlocks += (UMM_NBLOCK(blockNo) & UMM_BLOCKNO_MASK )-blockNo;
+      heapInfo.totalBlocks += size;
 
       // Is this a free block?
 
       if( UMM_NBLOCK(blockNo) & UMM_FREELIST_MASK ) {
          ++heapInfo.freeEntries;
-         heapInfo.freeBlocks += (UMM_NBLOCK(blockNo) & UMM_BLOCKNO_MASK )-blockNo;
+         heapInfo.freeBlocks += size;
+
+         if( size > heapInfo.maxFreeContiguousBlocks ) {
+            heapInfo.maxFreeContiguousBlocks = size;
+         }
 
          // Does this block address match the ptr we may be trying to free?
 
@@ -604,18 +837,12 @@ void *umm_info( void *ptr, int force ) {
          }
       } else {
          ++heapInfo.usedEntries;
-         heapInfo.usedBlocks += (UMM_NBLOCK(blockNo) & UMM_BLOCKNO_MASK )-blockNo;
+         heapInfo.usedBlocks += size;
       }
 
       blockNo = UMM_NBLOCK(blockNo) & UMM_BLOCKNO_MASK;
    }
 
-   // Update the accounting totals with information from the last block, the
-   // rest must be free!
-
-   heapInfo.freeBlocks  += UMM_NUMBLOCKS-blockNo;
-   heapInfo.totalBlocks += UMM_NUMBLOCKS-blockNo;
-
    // Release the critical section...
    //
    UMM_CRITICAL_EXIT();
@@ -633,10 +860,74 @@ unsigned int OSGetFreeHeapSize(void){
 	return heapInfo.freeBlocks * sizeof(umm_block);
 }
 
+unsigned int OSGetMaxFreeHeapBlock(void){
+	umm_info( NULL, 0);
+	return heapInfo.maxFreeContiguousBlocks * sizeof(umm_block);
+}
+
+unsigned int OSGetHeapFragmentation(void){
+	umm_info( NULL, 0);
+	if (heapInfo.freeBlocks == 0) return 0;
+	return 100 - (unsigned int)(((unsigned long)heapInfo.maxFreeContiguousBlocks * 100) / heapInfo.freeBlocks);
+}
+
+#if (BRTOS_HEAP_ACCOUNTING_EN == 1)
+uint8_t OSGetTaskHeapStats( uint8_t task, OS_HEAP_TASK_STATS *stats ){
+	OS_SR_SAVE_VAR
+
+	if ((task > NUMBER_OF_TASKS) || (stats == NULL)) return NOT_VALID_TASK;
+
+	UMM_CRITICAL_ENTRY();
+	*stats = umm_task_stats[task];
+	UMM_CRITICAL_EXIT();
+
+	return OK;
+}
+
+#if (BRTOS_HEAP_TRACE_SIZE > 0)
+// The oldest records are copied and removed from the trace, with the
+// interrupts disabled - read a few records at a time
+uint16_t OSHeapTraceRead( OS_HEAP_TRACE *records, uint16_t max, uint32_t *lost ){
+	OS_SR_SAVE_VAR
+	uint16_t n = 0;
+	uint16_t out;
+
+	UMM_CRITICAL_ENTRY();
+
+	out = (uint16_t)((umm_trace_in + BRTOS_HEAP_TRACE_SIZE - umm_trace_count) % BRTOS_HEAP_TRACE_SIZE);
+
+	while ((n < max) && (umm_trace_count > 0)) {
+		records[n++] = umm_trace[out];
+		if (++out >= BRTOS_HEAP_TRACE_SIZE) out = 0;
+		--umm_trace_count;
+	}
+
+	// Records not written because the trace was full
+	if (lost != NULL) {
+		*lost = umm_trace_lost;
+		umm_trace_lost = 0;
+	}
+
+	UMM_CRITICAL_EXIT();
+
+	return n;
+}
+#endif
+#endif
+
 // ----------------------------------------------------------------------------
 
 static unsigned short int umm_blocks( size_t size ) {
 
+   // Larger than the whole heap - can not be allocated
+
+   if( size >= (size_t)UMM_NUMBLOCKS * sizeof(umm_block) )
+      return( UMM_BLOCKNO_MASK );
+
+   // The hidden header of the allocation, if any
+
+   size += UMM_TAG_SIZE;
+
    // The calculation of the block size is not too difficult, but there are
    // a few little things that we need to be mindful of.
    //
@@ -671,10 +962,28 @@ static void umm_make_new_block( unsigned short int c,
 // ----------------------------------------------------------------------------
 
 static void umm_disconnect_from_free_list( unsigned short int c ) {
-   // Disconnect this block from the FREE list
+   unsigned char fl, sl;
+
+   // Disconnect this block from the FREE list of its size
 
-   UMM_NFREE(UMM_PFREE(c)) = UMM_NFREE(c);
-   UMM_PFREE(UMM_NFREE(c)) = UMM_PFREE(c);
+   umm_mapping( UMM_SIZE(c), &fl, &sl );
+
+   if( UMM_PFREE(c) ) {
+      UMM_NFREE(UMM_PFREE(c)) = UMM_NFREE(c);
+   } else {
+      umm_freelist[fl][sl] = UMM_NFREE(c);
+
+      if( 0 == umm_freelist[fl][sl] ) {
+         umm_sl_bitmap[fl] &= (unsigned char)~(1 << sl);
+         if( 0 == umm_sl_bitmap[fl] ) {
+            umm_fl_bitmap &= (unsigned short int)~(1 << fl);
+         }
+      }
+   }
+
+   if( UMM_NFREE(c) ) {
+      UMM_PFREE(UMM_NFREE(c)) = UMM_PFREE(c);
+   }
 
    // And clear the free block indicator
 
@@ -685,7 +994,7 @@ static void umm_disconnect_from_free_list( unsigned short int c ) {
 
 static void umm_assimilate_up( unsigned short int c ) {
 
-   if( UMM_NBLOCK(UMM_NBLOCK(c)) & UMM_FREELIST_MASK ) {
+   if( UMM_NBLOCK(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) & UMM_FREELIST_MASK ) {
       // The next block is a free block, so assimilate up and remove it from
       // the free list
 
@@ -693,23 +1002,153 @@ static void umm_assimilate_up( unsigned short int c ) {
 
       // Disconnect the next block from the FREE list
 
-      umm_disconnect_from_free_list( UMM_NBLOCK(c) );
+      umm_disconnect_from_free_list( UMM_NBLOCK(c) & UMM_BLOCKNO_MASK );
 
       // Assimilate the next block with this one
 
-      UMM_PBLOCK(UMM_NBLOCK(UMM_NBLOCK(c)) & UMM_BLOCKNO_MASK) = c;
-      UMM_NBLOCK(c) = UMM_NBLOCK(UMM_NBLOCK(c)) & UMM_BLOCKNO_MASK;
+      UMM_PBLOCK(UMM_NBLOCK(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) & UMM_BLOCKNO_MASK) = c;
+      UMM_NBLOCK(c) = (UMM_NBLOCK(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) & UMM_BLOCKNO_MASK) | (UMM_NBLOCK(c) & UMM_FREELIST_MASK);
    } 
 }
 
 // ----------------------------------------------------------------------------
 
-static unsigned short int umm_assimilate_down( unsigned short int c, unsigned short int freemask ) {
+static unsigned short int umm_assimilate_down( unsigned short int c ) {
+   unsigned short int p = UMM_PBLOCK(c);
+
+   // The previous block changes its size, so it leaves its free list
+
+   umm_disconnect_from_free_list( p );
+
+   UMM_NBLOCK(p) = UMM_NBLOCK(c) & UMM_BLOCKNO_MASK;
+   UMM_PBLOCK(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) = p;
+
+   return( p );
+}
+
+// ----------------------------------------------------------------------------
+// Finds a free block of at least "blocks" blocks, or 0
+
+#if defined UMM_BEST_FIT
+
+static unsigned short int umm_find_free( unsigned short int blocks ) {
+   unsigned short int map;
+   unsigned short int cf;
+   unsigned short int best = 0;
+   unsigned char      fl, sl;
+
+   // The smallest block of the list of the request size that fits
+
+   umm_mapping( blocks, &fl, &sl );
+
+   for( cf = umm_freelist[fl][sl]; cf; cf = UMM_NFREE(cf) ) {
+      if( (UMM_SIZE(cf) >= blocks) &&
+          ((0 == best) || (UMM_SIZE(cf) < UMM_SIZE(best))) ) {
+         best = cf;
+         if( UMM_SIZE(cf) == blocks ) {
+            break;
+         }
+      }
+   }
+
+   if( best ) {
+      return( best );
+   }
+
+   // Otherwise the smallest block of the next non empty list, whose blocks
+   // are all larger than the ones of the list of the request size
+
+   map = (unsigned short int)(umm_sl_bitmap[fl] & (0xFFu << (sl + 1)));
+   if( 0 == map ) {
+      map = (unsigned short int)(umm_fl_bitmap & (0xFFFFu << (fl + 1)));
+      if( map ) {
+         fl  = umm_ffs( map );
+         map = umm_sl_bitmap[fl];
+      }
+   }
+
+   if( map ) {
+      for( cf = umm_freelist[fl][umm_ffs( map )]; cf; cf = UMM_NFREE(cf) ) {
+         if( (0 == best) || (UMM_SIZE(cf) < UMM_SIZE(best)) ) {
+            best = cf;
+         }
+      }
+   }
+
+   return( best );
+}
+
+#else
+
+static unsigned short int umm_find_free( unsigned short int blocks ) {
+   unsigned int       size = blocks;
+   unsigned short int map;
+   unsigned short int cf;
+   unsigned char      fl, sl;
+
+   // A block of the list of the request size is the best fit, the first
+   // block of the list is tried
+
+   umm_mapping( blocks, &fl, &sl );
+
+   cf = umm_freelist[fl][sl];
+   if( cf && (UMM_SIZE(cf) >= blocks) ) {
+      return( cf );
+   }
+
+   // Rounds the request up to the next list, so every block of the list fits
+
+   if( size >= UMM_SL_COUNT ) {
+      size += (1u << (umm_fls( blocks ) - UMM_SL_BITS)) - 1;
+   }
+
+   if( size <= UMM_BLOCKNO_MASK ) {
+      umm_mapping( (unsigned short int)size, &fl, &sl );
+
+      map = (unsigned short int)(umm_sl_bitmap[fl] & (0xFFu << sl));
+      if( 0 == map ) {
+         map = (unsigned short int)(umm_fl_bitmap & (0xFFFFu << (fl + 1)));
+         if( map ) {
+            fl  = umm_ffs( map );
+            map = umm_sl_bitmap[fl];
+         }
+      }
+
+      if( map ) {
+         return( umm_freelist[fl][umm_ffs( map )] );
+      }
+   }
+
+   // No list with blocks that surely fit - the other blocks of the list of
+   // the request size may still fit
+
+   umm_mapping( blocks, &fl, &sl );
+
+   for( cf = umm_freelist[fl][sl]; cf; cf = UMM_NFREE(cf) ) {
+      if( UMM_SIZE(cf) >= blocks ) {
+         return( cf );
+      }
+   }
+
+   return( 0 );
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// Allocates "blocks" blocks at the start of the used block c - the remaining
+// blocks are freed
+
+static void umm_split_block( unsigned short int c, unsigned short int blocks ) {
 
-   UMM_NBLOCK(UMM_PBLOCK(c)) = UMM_NBLOCK(c) | freemask;
-   UMM_PBLOCK(UMM_NBLOCK(c)) = UMM_PBLOCK(c);
+   if( UMM_SIZE(c) > blocks ) {
+      umm_make_new_block( c, blocks, 0 );
 
-   return( UMM_PBLOCK(c) );
+      // The next block may be free when a block is shrunk
+
+      umm_assimilate_up( c+blocks );
+      umm_insert_free( c+blocks );
+   }
 }
 
 // ----------------------------------------------------------------------------
@@ -739,10 +1178,12 @@ void umm_free( void *ptr ) {
 
    // Figure out which block we're in. Note the use of truncated division...
 
-   c = ((int)ptr-(int)(&(umm_heap[0])))/sizeof(umm_block);
+   c = UMM_PTR_BLOCK(ptr);
 
    //DBG_LOG_DEBUG( "Freeing block %6i\n", c );
 
+   umm_account_free( c );
+
    // Now let's assimilate this block with the next one if possible.
 
    umm_assimilate_up( c );
@@ -753,41 +1194,12 @@ void umm_free( void *ptr ) {
 
       //DBG_LOG_DEBUG( "Assimilate down to next block, which is FREE\n" );
 
-      c = umm_assimilate_down(c, UMM_FREELIST_MASK);
-   } else {
-      // The previous block is not a free block, so add this one to the head
-      // of the free list
-
-      //DBG_LOG_DEBUG( "Just add to head of free list\n" );
-
-      UMM_PFREE(UMM_NFREE(0)) = c;
-      UMM_NFREE(c)            = UMM_NFREE(0);
-      UMM_PFREE(c)            = 0;
-      UMM_NFREE(0)            = c;
-
-      UMM_NBLOCK(c)          |= UMM_FREELIST_MASK;
+      c = umm_assimilate_down( c );
    }
 
-#if(0)
-   // The following is experimental code that checks to see if the block we just 
-   // freed can be assimilated with the very last block - it's pretty convoluted in
-   // terms of block index manipulation, and has absolutely no effect on heap
-   // fragmentation. I'm not sure that it's worth including but I've left it
-   // here for posterity.
-
-   if( 0 == UMM_NBLOCK(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK ) ) {
-
-      if( UMM_PBLOCK(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) != UMM_PFREE(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) ) {
-         UMM_NFREE(UMM_PFREE(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK)) = c;
-         UMM_NFREE(UMM_PFREE(c))                                = UMM_NFREE(c);
-         UMM_PFREE(UMM_NFREE(c))                                = UMM_PFREE(c);
-         UMM_PFREE(c)                                           = UMM_PFREE(UMM_NBLOCK(c) & UMM_BLOCKNO_MASK);
-      }
+   // Add the resulting block to the free list of its size
 
-      UMM_NFREE(c)  = 0;
-      UMM_NBLOCK(c) = 0;
-   }
-#endif
+   umm_insert_free( c );
 
    // Release the critical section...
    //
@@ -799,12 +1211,6 @@ void umm_free( void *ptr ) {
 void *umm_malloc( size_t size ) {
    OS_SR_SAVE_VAR
    unsigned short int blocks;
-   /* volatile --COMMENTED BY DFRANK because the version from FreeRTOS doesn't have it*/
-   unsigned short int blockSize = 0;
-
-   unsigned short int bestSize;
-   unsigned short int bestBlock;
-
    unsigned short int cf;
 
    // the very first thing we do is figure out if we're being asked to allocate
@@ -822,107 +1228,112 @@ void *umm_malloc( size_t size ) {
    //
    UMM_CRITICAL_ENTRY();
 
+   UMM_INIT_CHECK();
+
    blocks = umm_blocks( size );
 
-   // Now we can scan through the free list until we find a space that's big
-   // enough to hold the number of blocks we need.
-   //
-   // This part may be customized to be a best-fit, worst-fit, or first-fit
-   // algorithm
+   // Now we take a block from the free lists that is big enough to hold the
+   // number of blocks we need.
 
-   cf = UMM_NFREE(0);
+   cf = umm_find_free( blocks );
 
-   bestBlock = UMM_NFREE(0);
-   bestSize  = 0x7FFF;
+   if( 0 == cf ) {
+      //DBG_LOG_DEBUG(  "Can't allocate %5i blocks\n", blocks );
 
-   while( UMM_NFREE(cf) ) {
-      blockSize = (UMM_NBLOCK(cf) & UMM_BLOCKNO_MASK) - cf;
+      umm_account_fail( blocks );
 
-      //DBG_LOG_TRACE( "Looking at block %6i size %6i\n", cf, blockSize );
+      // Release the critical section...
+      //
+      UMM_CRITICAL_EXIT();
 
-#if defined UMM_FIRST_FIT
-      // This is the first block that fits!
-      if( (blockSize >= blocks) )
-         break;
-#elif defined UMM_BEST_FIT
-      if( (blockSize >= blocks) && (blockSize < bestSize) ) {
-         bestBlock = cf;
-         bestSize  = blockSize;
-      }
-#endif
-
-      cf = UMM_NFREE(cf);
+      return( (void *)NULL );
    }
 
-   if( 0x7FFF != bestSize ) {
-      cf        = bestBlock;
-      blockSize = bestSize;
-   }
+   //DBG_LOG_DEBUG( "Allocating %6i blocks starting at %6i\n", blocks, cf );
 
-   if( UMM_NBLOCK(cf) & UMM_BLOCKNO_MASK ) {
-      // This is an existing block in the memory heap, we just need to split off
-      // what we need, unlink it from the free list and mark it as in use, and
-      // link the rest of the block back into the freelist as if it was a new
-      // block on the free list...
+   // Unlink the block from its free list, mark it as in use and free what
+   // is left over
 
-      if( blockSize == blocks ) {
-         // It's an exact fit and we don't neet to split off a block.
-         //DBG_LOG_DEBUG( "Allocating %6i blocks starting at %6i - exact\n", blocks, cf );
+   umm_disconnect_from_free_list( cf );
+   umm_split_block( cf, blocks );
 
-         // Disconnect this block from the FREE list
+   umm_account_alloc( cf );
 
-         umm_disconnect_from_free_list( cf );
+   // Release the critical section...
+   //
+   UMM_CRITICAL_EXIT();
 
-      } else {
-         // It's not an exact fit and we need to split off a block.
-         //DBG_LOG_DEBUG( "Allocating %6i blocks starting at %6i - existing\n", blocks, cf );
+   return( UMM_PTR(cf) );
+}
 
-         umm_make_new_block( cf, blockSize-blocks, UMM_FREELIST_MASK );
+// ----------------------------------------------------------------------------
 
-         cf += blockSize-blocks;
-      }
-   } else {
-      // We're at the end of the heap - allocate a new block, but check to see if
-      // there's enough memory left for the requested block! Actually, we may need
-      // one more than that if we're initializing the umm_heap for the first
-      // time, which happens in the next conditional...
+void *umm_realloc( void *ptr, size_t size ) {
+   OS_SR_SAVE_VAR
+   unsigned short int blocks;
+   unsigned short int c;
+   unsigned short int n;
+   size_t             curSize;
+   void               *ret;
 
-      if( UMM_NUMBLOCKS <= cf+blocks+1 ) {
-         //DBG_LOG_DEBUG(  "Can't allocate %5i blocks at %5i\n", blocks, cf );
+   // realloc of a NULL pointer is a malloc, and a realloc to 0 bytes is a free
 
-         // Release the critical section...
-         //
-         UMM_CRITICAL_EXIT();
+   if( (void *)0 == ptr ) {
+      return( umm_malloc( size ) );
+   }
 
-         return( (void *)NULL );
-      }
+   if( 0 == size ) {
+      umm_free( ptr );
+      return( (void *)NULL );
+   }
 
-      // Now check to see if we need to initialize the free list...this assumes
-      // that the BSS is set to 0 on startup. We should rarely get to the end of
-      // the free list so this is the "cheapest" place to put the initialization!
+   // Protect the critical section...
+   //
+   UMM_CRITICAL_ENTRY();
 
-      if( 0 == cf ) {
-         //DBG_LOG_DEBUG( "Initializing malloc free block pointer\n" );
-         UMM_NBLOCK(0) = 1;
-         UMM_NFREE(0)  = 1;
-         cf            = 1;
-      }
+   blocks = umm_blocks( size );
+
+   c = UMM_PTR_BLOCK(ptr);
+   n = UMM_NBLOCK(c) & UMM_BLOCKNO_MASK;
+
+   // Resize in place if the block shrinks or the next block is free and
+   // large enough, the data does not move
+
+   if( (UMM_SIZE(c) >= blocks) ||
+       ((UMM_NBLOCK(n) & UMM_FREELIST_MASK) && ((UMM_SIZE(c) + UMM_SIZE(n)) >= blocks)) ) {
 
-      //DBG_LOG_DEBUG( "Allocating %6i blocks starting at %6i - new     \n", blocks, cf );
+      umm_account_free( c );
 
-      UMM_NFREE(UMM_PFREE(cf)) = cf+blocks;
+      umm_assimilate_up( c );
+      umm_split_block( c, blocks );
 
-      memcpy( &UMM_BLOCK(cf+blocks), &UMM_BLOCK(cf), sizeof(umm_block) );
+      umm_account_alloc( c );
 
-      UMM_NBLOCK(cf)           = cf+blocks;
-      UMM_PBLOCK(cf+blocks)    = cf;
+      // Release the critical section...
+      //
+      UMM_CRITICAL_EXIT();
+
+      return( ptr );
    }
 
+   // Bytes of data of the current block
+
+   curSize = (size_t)UMM_SIZE(c) * sizeof(umm_block) - sizeof(((umm_block *)0)->header) - UMM_TAG_SIZE;
+
    // Release the critical section...
    //
    UMM_CRITICAL_EXIT();
 
-   return( (void *)&UMM_DATA(cf) );
+   // Move the data to a new block
+
+   ret = umm_malloc( size );
+
+   if( (void *)NULL != ret ) {
+      memcpy( ret, ptr, curSize );
+      umm_free( ptr );
+   }
+
+   return( ret );
 }
 
 
@@ -20,6 +20,8 @@ typedef struct UMM_HEAP_INFO_t {
    unsigned short int totalBlocks; 
    unsigned short int usedBlocks; 
    unsigned short int freeBlocks; 
+
+   unsigned short int maxFreeContiguousBlocks; 
 }
 UMM_HEAP_INFO;
 
@@ -38,6 +40,47 @@ void umm_free( void *ptr );
 
 unsigned int OSGetFreeHeapSize( void );
 unsigned int OSGetUsedHeapSize( void );
+unsigned int OSGetMaxFreeHeapBlock( void );
+unsigned int OSGetHeapFragmentation( void );
+
+#if (BRTOS_HEAP_ACCOUNTING_EN == 1)
+// Heap in use by a task. The allocations are counted by the task that made
+// them (task 0 before the scheduler start) until they are freed, even if
+// freed by another task. umm_realloc gives the allocation to the caller.
+typedef struct OS_HEAP_TASK_STATS_t {
+   uint32_t bytes;         // heap bytes in use, including the headers
+   uint32_t peak_bytes;    // maximum of bytes
+   uint32_t allocs;        // number of allocations
+   uint32_t frees;         // number of allocations freed
+   uint16_t blocks;        // allocations in use
+}
+OS_HEAP_TASK_STATS;
+
+uint8_t OSGetTaskHeapStats( uint8_t task, OS_HEAP_TASK_STATS *stats );
+
+#if (BRTOS_HEAP_TRACE_SIZE > 0)
+// Types of the trace records
+#define OS_HEAP_TRACE_ALLOC   (uint8_t)1
+#define OS_HEAP_TRACE_FREE    (uint8_t)2
+#define OS_HEAP_TRACE_FAIL    (uint8_t)3
+
+// Trace record of an allocation, a free or a failed allocation. A resize is
+// a free followed by an allocation. The sizes are in heap blocks of 8 bytes
+// and the allocation is identified by its first block, so the trace can be
+// replayed over an empty heap of the same size. The fields are in the
+// byte order of the target.
+typedef struct OS_HEAP_TRACE_t {
+   uint8_t  type;
+   uint8_t  task;          // owner of the allocation, the caller on failures
+   uint16_t block;         // first block of the allocation, 0 on failures
+   uint16_t blocks;        // size of the allocation or of the failed request
+   uint16_t tick;          // low 16 bits of the tick counter
+}
+OS_HEAP_TRACE;
+
+uint16_t OSHeapTraceRead( OS_HEAP_TRACE *records, uint16_t max, uint32_t *lost );
+#endif
+#endif
 
 
 // ----------------------------------------------------------------------------
@@ -29,15 +29,22 @@
 // free() and realloc() so that they can be used as the C runtime functions
 // in an embedded environment.
 //
-// -D UMM_BEST_FIT (defualt)
+// -D UMM_SL_BITS=n
 //
-// Set this if you want to use a best-fit algorithm for allocating new
-// blocks
+// The free blocks are kept in segregated lists. Each power of 2 range of
+// block sizes is split into 2^n lists (n from 0 to 3, default 2). More lists
+// waste less memory on the rounding of the requests, at the cost of
+// 2 bytes per list.
 //
-// -D UMM_FIRST_FIT
+// -D UMM_BEST_FIT
 //
-// Set this if you want to use a first-fit algorithm for allocating new
-// blocks
+// Set this if you want the smallest free block that fits. The list of the
+// request size and the next non empty list are walked, so the time of
+// malloc() depends on the number of blocks in these lists.
+//
+// By default the first block of the smallest list whose blocks all fit is
+// taken (good fit), without walking the lists. This replaces UMM_FIRST_FIT,
+// which has no effect any more.
 //
 // -D UMM_DBG_LOG_LEVEL=n
 //
@@ -67,7 +74,22 @@
 // Size of the heap in bytes
 #define UMM_MALLOC_CFG__HEAP_SIZE DYNAMIC_HEAP_SIZE
 
-#define UMM_FIRST_FIT			  1
+// Number of free lists of each power of 2 range of block sizes (2^UMM_SL_BITS)
+#ifndef UMM_SL_BITS
+#define UMM_SL_BITS			      2
+#endif
+
+// Per task heap accounting - each allocation keeps the task that made it in a
+// hidden header of 4 bytes
+#ifndef BRTOS_HEAP_ACCOUNTING_EN
+#define BRTOS_HEAP_ACCOUNTING_EN  0
+#endif
+
+// Number of records of the allocation trace (0 - no trace)
+// The trace requires BRTOS_HEAP_ACCOUNTING_EN
+#ifndef BRTOS_HEAP_TRACE_SIZE
+#define BRTOS_HEAP_TRACE_SIZE     0
+#endif
 
 // ----------------------------------------------------------------------------
 // A couple of macros to make packing structures less compiler dependent
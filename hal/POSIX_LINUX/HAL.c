@@ -0,0 +1,526 @@
+/**
+* \file HAL.c
+* \brief BRTOS Hardware Abstraction Layer Functions for the POSIX/Linux simulation port.
+*
+* This file contain the functions that are processor dependant.
+*
+*
+**/
+
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                  OS HAL Functions to POSIX / Linux hosts
+*
+*
+*   Author:   Gustavo Weber Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*
+*********************************************************************************************************/
+
+#include "BRTOS.h"
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <time.h>
+
+#if ((TICKLESS != OS_CPU_HAL_TICKLESS) || (OS_CPU_SIMULATED_TIME != OS_CPU_HAL_SIMULATED_TIME))
+#error "TICKLESS and OS_CPU_SIMULATED_TIME must be set in HAL.h or with -D, not in BRTOSConfig.h"
+#endif
+
+
+INT32U SPvalue;                               ///< Used to save and restore a task stack pointer
+INT32U SPprevious;                            ///< Stack pointer of the task being switched out
+
+volatile INT32U OSInterruptDisabled = 1;      ///< Simulated interrupt mask - disabled until the first task starts
+static volatile sig_atomic_t OSTickPending = 0;  ///< Tick interrupt requested while the interrupts were disabled
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Interrupt Enable / Disable                  /////
+/////                                                  /////
+/////  The interrupt mask is a software flag. A tick   /////
+/////  signal received with the mask set is postponed  /////
+/////  until the mask is cleared.                      /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+INT32U OS_CPU_SR_Save(void)
+{
+	INT32U SR = OSInterruptDisabled;
+
+	OSInterruptDisabled = 1;
+	__asm volatile ("" ::: "memory");
+
+	return SR;
+}
+
+
+void OS_CPU_SR_Restore(INT32U SR)
+{
+	__asm volatile ("" ::: "memory");
+	OSInterruptDisabled = SR;
+
+	// Runs the tick interrupt postponed by the critical section
+	while ((!OSInterruptDisabled) && OSTickPending)
+	{
+		OSTickPending = 0;
+		OS_CPU_Interrupt(TickTimer);
+	}
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Simulated Interrupt Entry                   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+void OS_CPU_Interrupt(void (*handler)(void))
+{
+  INT32U SR = OS_CPU_SR_Save();
+
+  // ************************
+  // Interrupt entry
+  // ************************
+  OS_INT_ENTER();
+
+  // Interrupt handling
+  handler();
+
+  // ************************
+  // Interrupt Exit
+  // ************************
+  OS_INT_EXIT();
+
+  // The interrupted task was resumed
+  OS_CPU_SR_Restore(SR);
+}
+
+
+#if (OS_CPU_SIMULATED_TIME == 0)
+static void OS_CPU_SignalHandler(int sig)
+{
+  (void)sig;
+
+  if (OSInterruptDisabled)
+  {
+	  OSTickPending = 1;
+  }
+  else
+  {
+	  OS_CPU_Interrupt(TickTimer);
+  }
+}
+#endif
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      OS Tick Timer Setup                         /////
+/////                                                  /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+void TickTimerSetup(void)
+{
+  #if (OS_CPU_SIMULATED_TIME == 0)
+  struct sigaction sa;
+  struct itimerval timer;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = OS_CPU_SignalHandler;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  (void)sigaction(SIGALRM, &sa, NULL);
+
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = (suseconds_t)(1000000UL / configTICK_RATE_HZ);
+  timer.it_value = timer.it_interval;
+  (void)setitimer(ITIMER_REAL, &timer, NULL);
+  #endif
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      OS RTC Setup                                /////
+/////                                                  /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+void OSRTCSetup(void)
+{
+
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+void TickTimer(void)
+{
+  // Interrupt handling
+  TICKTIMER_INT_HANDLER;
+
+#if (TICKLESS == 1)
+  OSIncCounter(1);
+#else
+  OSIncCounter();
+#endif
+
+  // BRTOS TRACE SUPPORT
+  #if (OSTRACE == 1)
+      #if(OS_TICK_SHOW == 1)
+          OS_TRACE(OS_TRACE_TICK, OSGetCount(), 0);
+      #endif
+  #endif
+
+  // ************************
+  // Handler code for the tick
+  // ************************
+  OS_TICK_HANDLER();
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////   Software Interrupt to provide Switch Context   /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+/************************************************************//**
+* \fn void SwitchContext(void)
+* \brief Software interrupt handler routine (Internal kernel function).
+*  Used to switch the tasks context. Must be called with the interrupts disabled.
+****************************************************************/
+void SwitchContext(void)
+{
+  // ************************
+  // Interrupt entry
+  // ************************
+  OS_INT_ENTER();
+
+  // ************************
+  // Interrupt Exit
+  // ************************
+  OS_INT_EXIT();
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+void OS_CPU_StartFirstTask(void)
+{
+  (void)setcontext(&(OS_CPU_FRAME(SPvalue)->Context));
+}
+
+
+
+void OS_CPU_Wait(void)
+{
+  // Sleeps until the next signal
+  if (!OSTickPending)
+  {
+	  (void)pause();
+  }
+}
+
+
+
+#if (OS_CPU_SIMULATED_TIME == 1)
+void OS_CPU_SimulatedIdle(void)
+{
+  #if (TICKLESS == 1)
+  ostick_t idle_ticks;
+
+  UserEnterCritical();
+
+  // Every tick before the next wake up is compensated at once,
+  // the tick of the wake up is run by the tick interrupt
+  idle_ticks = OSTicklessIdleTime((ostick_t)(TICK_COUNT_OVERFLOW - 1));
+  if (idle_ticks > 1)
+  {
+	  OSTicklessCompensate((ostick_t)(idle_ticks - 1));
+  }
+
+  UserExitCritical();
+  #endif
+
+  OS_CPU_Interrupt(TickTimer);
+}
+#endif
+
+
+
+#if (OSTRACE == 1)
+INT32U OS_CPU_TraceTimestamp(void)
+{
+  struct timespec now;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (INT32U)(((long long)now.tv_sec * 1000000LL) + ((long long)now.tv_nsec / 1000LL));
+}
+#endif
+
+
+
+#if (TICKLESS == 1)
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Tickless Idle                               /////
+/////                                                  /////
+/////  Same algorithm of the Cortex-M ports, with the  /////
+/////  interval timer in the place of the SysTick.     /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+/// Tick period in microseconds
+#define TICKLESS_TICK_US        (long long)(1000000UL / configTICK_RATE_HZ)
+
+static long long OS_CPU_TimerToUs(const struct timeval *tv)
+{
+  return ((long long)tv->tv_sec * 1000000LL) + (long long)tv->tv_usec;
+}
+
+static void OS_CPU_TimerStart(long long value_us, long long interval_us, struct itimerval *old)
+{
+  struct itimerval timer;
+
+  timer.it_value.tv_sec = (time_t)(value_us / 1000000LL);
+  timer.it_value.tv_usec = (suseconds_t)(value_us % 1000000LL);
+  timer.it_interval.tv_sec = (time_t)(interval_us / 1000000LL);
+  timer.it_interval.tv_usec = (suseconds_t)(interval_us % 1000000LL);
+  (void)setitimer(ITIMER_REAL, &timer, old);
+}
+
+void WaitTickless(void)
+{
+  struct itimerval remaining;
+  sigset_t alarm_mask, old_mask, wait_mask;
+  ostick_t idle_ticks;
+  ostick_t ticks;
+  long long period_us;
+  long long elapsed_us;
+  long long reload_us;
+
+  UserEnterCritical();
+
+  idle_ticks = OSTicklessIdleTime((ostick_t)(TICK_COUNT_OVERFLOW - 1));
+
+  if (idle_ticks == 0)
+  {
+	  // The next tick is needed. Sleeps until the next signal
+	  OS_CPU_Wait();
+	  UserExitCritical();
+	  return;
+  }
+
+  // The tick signal is blocked until the sleep, so it can not be lost
+  sigemptyset(&alarm_mask);
+  sigaddset(&alarm_mask, SIGALRM);
+  (void)sigprocmask(SIG_BLOCK, &alarm_mask, &old_mask);
+  wait_mask = old_mask;
+  sigdelset(&wait_mask, SIGALRM);
+
+  // Stop the tick timer. The time remaining in the current tick is kept
+  OS_CPU_TimerStart(0, 0, &remaining);
+
+  if (OSTickPending)
+  {
+	  // The tick interrupt is already pending - resume the timer and let it run
+	  OS_CPU_TimerStart(OS_CPU_TimerToUs(&remaining.it_value), TICKLESS_TICK_US, NULL);
+	  (void)sigprocmask(SIG_SETMASK, &old_mask, NULL);
+	  UserExitCritical();
+	  return;
+  }
+
+  // The next signal is at the end of the current tick plus the suppressed ticks
+  period_us = OS_CPU_TimerToUs(&remaining.it_value) + (TICKLESS_TICK_US * (long long)(idle_ticks - 1));
+  OS_CPU_TimerStart(period_us, 0, NULL);
+
+  (void)sigsuspend(&wait_mask);
+
+  // Stop the timer
+  OS_CPU_TimerStart(0, 0, &remaining);
+
+  if (OSTickPending)
+  {
+	  // Woken by the tick timer. The pending tick interrupt
+	  // will account the last tick of the idle period
+	  ticks = (ostick_t)(idle_ticks - 1);
+	  reload_us = TICKLESS_TICK_US;
+  }
+  else
+  {
+	  // Woken by another signal. Only the complete ticks are accounted
+	  elapsed_us = (TICKLESS_TICK_US * (long long)idle_ticks) - OS_CPU_TimerToUs(&remaining.it_value);
+	  ticks = (ostick_t)(elapsed_us / TICKLESS_TICK_US);
+	  if (ticks >= idle_ticks)
+	  {
+		  ticks = (ostick_t)(idle_ticks - 1);
+	  }
+
+	  // Time to the end of the current tick
+	  reload_us = (((long long)ticks + 1) * TICKLESS_TICK_US) - elapsed_us;
+	  if ((reload_us <= 0) || (reload_us > TICKLESS_TICK_US))
+	  {
+		  reload_us = TICKLESS_TICK_US;
+	  }
+  }
+
+  // Restart the timer with the rest of the current tick, then with the normal tick period
+  OS_CPU_TimerStart(reload_us, TICKLESS_TICK_US, NULL);
+  (void)sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+  // Update the kernel time with the suppressed ticks
+  OSTicklessCompensate(ticks);
+
+  UserExitCritical();
+}
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+#endif
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////  Task Installation Function                      /////
+/////                                                  /////
+/////  Parameters:                                     /////
+/////  Function pointer, task priority and task name   /////
+/////                                                  /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+static void OS_TaskEntry(void)
+{
+  OS_CPU_Frame *frame = OS_CPU_FRAME(ContextTask[currentTask].StackPoint);
+
+  // The first run of a task is the exit of a switch context
+  OS_CPU_SR_Restore(0);
+
+  frame->FctPtr(frame->Parameters);
+
+  // BRTOS tasks must not return
+  for (;;)
+  {
+	  (void)OSBlockTask(0);
+  }
+}
+
+
+static unsigned int OS_CPU_InitFrame(void(*FctPtr)(void*), OS_CPU_TYPE *stk_bottom, unsigned int sp, void *parameters)
+{
+	OS_CPU_Frame *frame = OS_CPU_FRAME(sp);
+
+	#ifdef WATERMARK
+	OS_CPU_TYPE *stk_pt = (OS_CPU_TYPE *)frame;
+
+	*stk_bottom++ = (INT32U)(((NumberOfInstalledTasks + '0') << 24) + 'T' + ('S' << 8) + ('K' << 16));
+	do{
+		*--stk_pt = 0x24242424;
+	}while (stk_pt > stk_bottom);
+	#endif
+
+	(void)getcontext(&frame->Context);
+	frame->Context.uc_stack.ss_sp = (void *)stk_bottom;
+	frame->Context.uc_stack.ss_size = (size_t)((unsigned long)frame - (unsigned long)stk_bottom) & ~(size_t)(OS_CPU_FRAME_ALIGN - 1u);
+	frame->Context.uc_link = NULL;
+	sigemptyset(&frame->Context.uc_sigmask);
+	frame->FctPtr = FctPtr;
+	frame->Parameters = parameters;
+	makecontext(&frame->Context, OS_TaskEntry, 0);
+
+	return sp;
+}
+
+
+#if (!BRTOS_DYNAMIC_TASKS_ENABLED)
+#if (TASK_WITH_PARAMETERS == 1)
+  void CreateVirtualStack(void(*FctPtr)(void*), INT16U NUMBER_OF_STACKED_BYTES, void *parameters)
+#else
+  void CreateVirtualStack(void(*FctPtr)(void), INT16U NUMBER_OF_STACKED_BYTES)
+#endif
+{
+	OS_CPU_TYPE *stk_pt = (OS_CPU_TYPE*)&STACK[iStackAddress];
+
+	// Same virtual stack pointer computed by the task installation function
+	unsigned int sp = (unsigned int)(unsigned long)&STACK[iStackAddress] + NUMBER_OF_STACKED_BYTES - NUMBER_MIN_OF_STACKED_BYTES;
+
+   #if (TASK_WITH_PARAMETERS == 1)
+	(void)OS_CPU_InitFrame(FctPtr, stk_pt, sp, parameters);
+   #else
+	(void)OS_CPU_InitFrame((void(*)(void*))FctPtr, stk_pt, sp, NULL);
+   #endif
+}
+#endif
+
+#if (BRTOS_DYNAMIC_TASKS_ENABLED == 1)
+#if (TASK_WITH_PARAMETERS == 1)
+  unsigned int CreateDVirtualStack(void(*FctPtr)(void*), unsigned int stk, unsigned int stk_size, void *parameters)
+#else
+  unsigned int CreateDVirtualStack(void(*FctPtr)(void), unsigned int stk, unsigned int stk_size)
+#endif
+{
+	unsigned int sp = stk + stk_size - NUMBER_MIN_OF_STACKED_BYTES;
+
+   #if (TASK_WITH_PARAMETERS == 1)
+	return OS_CPU_InitFrame(FctPtr, (OS_CPU_TYPE *)(unsigned long)stk, sp, parameters);
+   #else
+	return OS_CPU_InitFrame((void(*)(void*))FctPtr, (OS_CPU_TYPE *)(unsigned long)stk, sp, NULL);
+   #endif
+}
+#endif
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
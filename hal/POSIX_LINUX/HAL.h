@@ -0,0 +1,294 @@
+/**
+* \file HAL.h
+* \brief BRTOS Hardware Abstraction Layer defines for the POSIX/Linux simulation port
+*
+* This file contain the defines that are processor dependant.
+* The POSIX port runs every BRTOS task as a ucontext inside a single host process.
+* The tick timer is a POSIX interval timer (SIGALRM) and the interrupt enable flag
+* is a software flag, so critical sections do not need a system call.
+*
+* Build notes:
+*  - The kernel stores stack addresses in 32 bits fields (StackPoint, StackInit, StackAddress).
+*    The port must be built as a non PIE executable (-fno-pie -no-pie), in order to keep
+*    the task stacks (STACK and the umm_malloc heap) in the first 4GB of the address space.
+*  - The task stack must also hold the signal frame of the host kernel. Use at least 16KB per task.
+*  - Non reentrant libc functions (printf, malloc, ...) called by more than one task must be
+*    protected by a critical section or a mutex, because a tick can preempt the task inside them.
+*
+**/
+
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                   OS HAL Header to POSIX / Linux hosts
+*
+*
+*   Author:   Gustavo Weber Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*
+*********************************************************************************************************/
+
+#ifndef OS_HAL_H
+#define OS_HAL_H
+
+#include "OS_types.h"
+#include <ucontext.h>
+
+#if (defined __PIE__) || (defined __pie__)
+#error "The POSIX port must be built as a non PIE executable (-fno-pie -no-pie)"
+#endif
+
+/// Supported processors
+#define COLDFIRE_V1     1u
+#define HCS08           2u
+#define MSP430          3u
+#define ATMEGA          4u
+#define PIC18           5u
+#define RX600           6u
+#define ARM_Cortex_M3   7u
+#define ARM_Cortex_M4   8u
+#define ARM_Cortex_M0   9u
+#define ARM_Cortex_M4F  10u
+#define X86             11u
+#define POSIX_LINUX     11u
+
+
+/// Define the used processor
+#define PROCESSOR 		X86
+
+/// Define the CPU type
+#define OS_CPU_TYPE 	INT32U
+
+/// Define if the optimized scheduler will be used
+#define OPTIMIZED_SCHEDULER 1
+
+/// Define if InstallTask function will support parameters
+#ifndef TASK_WITH_PARAMETERS
+#define TASK_WITH_PARAMETERS 1
+#endif
+
+/// Define if 32 bits register for tick timer will be used
+#define TICK_TIMER_32BITS   1
+
+/// TICKLESS and OS_CPU_SIMULATED_TIME are used by this header, which is included
+/// before BRTOSConfig.h. Set them here or in the compiler command line (-DTICKLESS=1),
+/// not in BRTOSConfig.h. HAL.c stops the build if BRTOSConfig.h changes them.
+
+/// Define if the tickless idle mode will be used
+#ifndef TICKLESS
+#define TICKLESS 0
+#endif
+
+/// Define if the time of the kernel is simulated (deterministic tests)
+/// There is no tick timer: the ticks are run by the idle task when every task waits,
+/// and with TICKLESS the idle task jumps directly to the next wake up
+#ifndef OS_CPU_SIMULATED_TIME
+#define OS_CPU_SIMULATED_TIME 0
+#endif
+
+/// Values seen by this header, verified by HAL.c after BRTOSConfig.h
+#if (TICKLESS == 1)
+#define OS_CPU_HAL_TICKLESS 1
+#else
+#define OS_CPU_HAL_TICKLESS 0
+#endif
+
+#if (OS_CPU_SIMULATED_TIME == 1)
+#define OS_CPU_HAL_SIMULATED_TIME 1
+#else
+#define OS_CPU_HAL_SIMULATED_TIME 0
+#endif
+
+/// Define if nesting interrupt is active
+#define NESTING_INT 0
+
+/// Define the Reset Watchdog macro
+#define RESET_WATCHDOG()
+
+/// Define if its necessary to save status register / interrupt info
+#define OS_SR_SAVE_VAR INT32U CPU_SR = 0;
+
+/// Define stack growth direction
+#define STACK_GROWTH 0            /// 1 -> down; 0-> up
+
+/// Define CPU Stack Pointer Size
+#define SP_SIZE 32
+
+#define READY_LIST_VAR read_list
+
+extern INT8U iNesting;
+extern INT32U SPvalue;
+extern INT32U SPprevious;
+
+
+
+/**
+* \struct OS_CPU_Frame
+* Host context saved in the task virtual stack, at the address pointed by the task StackPoint
+*/
+typedef struct
+{
+  ucontext_t  Context;                       ///< Host registers, signal mask and stack of the task
+  void        (*FctPtr)(void*);              ///< Task entry point
+  void        *Parameters;                   ///< Task parameters
+} OS_CPU_Frame;
+
+/// Frame alignment required by the host ABI
+#define OS_CPU_FRAME_ALIGN              16u
+
+/// Gets the frame of a task from its virtual stack pointer
+#define OS_CPU_FRAME(sp)	((OS_CPU_Frame*)(((unsigned long)(sp) + (OS_CPU_FRAME_ALIGN - 1u)) & ~(unsigned long)(OS_CPU_FRAME_ALIGN - 1u)))
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Port Defines                                /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+extern volatile INT32U OSInterruptDisabled;
+
+INT32U OS_CPU_SR_Save(void);
+#define  OSEnterCritical() (CPU_SR = OS_CPU_SR_Save())	 // Disable interrupts
+void OS_CPU_SR_Restore(INT32U);
+#define  OSExitCritical()  (OS_CPU_SR_Restore(CPU_SR))	 // Enable interrupts
+
+/// Defines the disable interrupts command of the choosen microcontroller
+#define UserEnterCritical() (void)OS_CPU_SR_Save()
+/// Defines the enable interrupts command of the choosen microcontroller
+#define UserExitCritical()  OS_CPU_SR_Restore(0)
+
+/// Defines the low power command of the choosen microcontroller
+void OS_CPU_Wait(void);
+#if (OS_CPU_SIMULATED_TIME == 1)
+void OS_CPU_SimulatedIdle(void);
+#define OS_Wait OS_CPU_SimulatedIdle();
+#elif (TICKLESS == 1)
+void WaitTickless(void);
+#define OS_Wait WaitTickless();
+#else
+#define OS_Wait OS_CPU_Wait();
+#endif
+
+/// Defines the tick timer interrupt handler code (clear flag) of the choosen microcontroller
+#define TICKTIMER_INT_HANDLER
+
+// The virtual stack stores the host context frame
+#define NUMBER_MIN_OF_STACKED_BYTES (sizeof(OS_CPU_Frame) + OS_CPU_FRAME_ALIGN)
+
+
+
+
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+/////      Functions Prototypes                        /////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+void SwitchContext(void);
+#define ChangeContext() SwitchContext()
+
+#define OS_INT_EXIT_EXT()
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+  void CreateVirtualStack(void(*FctPtr)(void*), INT16U NUMBER_OF_STACKED_BYTES, void *parameters);
+#else
+  void CreateVirtualStack(void(*FctPtr)(void), INT16U NUMBER_OF_STACKED_BYTES);
+#endif
+
+#if (TASK_WITH_PARAMETERS == 1)
+  unsigned int CreateDVirtualStack(void(*FctPtr)(void*), unsigned int stk, unsigned int stk_size, void *parameters);
+#else
+  unsigned int CreateDVirtualStack(void(*FctPtr)(void), unsigned int stk, unsigned int stk_size);
+#endif
+
+/*****************************************************************************************//**
+* \fn void TickTimerSetup(void)
+* \brief Tick timer clock setup. Starts a POSIX interval timer at configTICK_RATE_HZ.
+*  With OS_CPU_SIMULATED_TIME no timer is started.
+* \return NONE
+*********************************************************************************************/
+void TickTimerSetup(void);
+
+#if (OS_CPU_SIMULATED_TIME == 1)
+/*****************************************************************************************//**
+* \fn void OS_CPU_SimulatedIdle(void)
+* \brief Advances the simulated time while every task waits (OS_CPU_SIMULATED_TIME == 1)
+*  Runs the tick interrupt. With TICKLESS the ticks before the next wake up are
+*  compensated at once, so long waits take the time of a single tick.
+* \return NONE
+*********************************************************************************************/
+void OS_CPU_SimulatedIdle(void);
+#endif
+
+/*****************************************************************************************//**
+* \fn void OSRTCSetup(void)
+* \brief Real time clock setup
+* \return NONE
+*********************************************************************************************/
+void OSRTCSetup(void);
+
+/*****************************************************************************************//**
+* \fn void OS_CPU_Interrupt(void (*handler)(void))
+* \brief Runs a handler as an interrupt of the simulated processor
+*  The handler is called with the interrupts disabled and iNesting incremented,
+*  and the context is switched in the interrupt exit if a higher priority task is ready.
+* \param handler Interrupt handler code
+* \return NONE
+*********************************************************************************************/
+void OS_CPU_Interrupt(void (*handler)(void));
+
+/*****************************************************************************************//**
+* \fn INT32U OS_CPU_TraceTimestamp(void)
+* \brief Timestamp of the trace records (OSTRACE == 1)
+* \return Host monotonic clock in microseconds
+*********************************************************************************************/
+INT32U OS_CPU_TraceTimestamp(void);
+#define OS_TRACE_TIMESTAMP()		OS_CPU_TraceTimestamp()
+#define OS_TRACE_TIMESTAMP_HZ		1000000UL
+
+/* BRTOS port interrupt handlers. */
+extern void TickTimer(void);
+extern void OS_CPU_StartFirstTask(void);
+
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////
+
+
+
+/// Save Context Define - the host context is saved by the restore context define
+#define OS_SAVE_CONTEXT()	SPprevious = ContextTask[currentTask].StackPoint
+
+/// Save Stack Pointer Define
+#define OS_SAVE_SP()		SPvalue = SPprevious
+
+/// Restore Stack Pointer Define
+#define OS_RESTORE_SP()
+
+/// Restore Context Define - saves the current task context and restores the selected task context
+#define OS_RESTORE_CONTEXT() (void)swapcontext(&(OS_CPU_FRAME(SPprevious)->Context), &(OS_CPU_FRAME(SPvalue)->Context))
+
+#define OS_ENABLE_NESTING()
+
+#define CriticalDecNesting() iNesting--
+
+#define BTOSStartFirstTask() OS_CPU_StartFirstTask()
+
+
+#define Optimezed_Scheduler()					\
+return (INT8U)(31u - (INT8U)__builtin_clz((INT32U)READY_LIST_VAR))
+
+#endif
@@ -0,0 +1,495 @@
+/*
+ * bench_kernel.c
+ *
+ * Kernel micro-benchmarks: semaphore, mailbox and mutex round trips, queue and
+ * dynamic queue transfers, interrupt to task latency and the cost of the tick
+ * handler against the number of delayed tasks.
+ *
+ * kernel_bench installs the benchmark tasks and must be called before BRTOSStart.
+ * The results are printed by PRINTF as CSV, one line per benchmark:
+ *
+ *   benchmark,parameter,iterations,total,average,min,max,timestamp_hz
+ *
+ * The times are in units of BENCH_TIMESTAMP: nanoseconds of the host clock on the
+ * POSIX port, otherwise the trace timestamp of the port (DWT cycle counter on
+ * Cortex-M4) or the tick counter. The "timestamp" line is the cost of reading the timestamp, included in
+ * every sample. Each sample of the round trips includes two context switches, each
+ * sample of the queue transfers one post, one pend and two context switches.
+ *
+ * The interrupt to task latency needs BENCH_INTERRUPT(handler), which runs the handler
+ * as an interrupt of the kernel (OS_INT_ENTER, handler, OS_INT_EXIT). It is provided
+ * for the POSIX port, other ports can trigger a software interrupt.
+ *
+ * The tick handler is called by the benchmark task with the interrupts disabled,
+ * which advances the tick counter by BENCH_ITERATIONS ticks at each measure.
+ *
+ * A benchmark with a failed kernel call prints "benchmark,parameter,error" instead
+ * of its result. The creation of the objects and tasks is checked by TEST_ASSERT.
+ *
+ * Needs 4 semaphores, 1 mutex, 2 mailboxes, 1 queue and 1 dynamic queue, and
+ * BENCH_SLEEPERS + 2 tasks with priorities from BENCH_PRIORITY to BENCH_PRIORITY + BENCH_SLEEPERS + 2
+ * (the highest one is the priority ceiling of the mutex without BRTOS_ROUND_ROBIN_EN).
+ *
+ */
+
+#include "BRTOS.h"
+
+void kernel_bench(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+/* Timestamp of the samples */
+#ifndef BENCH_TIMESTAMP
+#if (PROCESSOR == X86)
+#include <time.h>
+
+static uint32_t bench_clock(void)
+{
+	struct timespec now;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)(((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec);
+}
+
+#define BENCH_TIMESTAMP()			bench_clock()
+#define BENCH_TIMESTAMP_HZ			1000000000UL
+#elif defined(OS_TRACE_TIMESTAMP)
+#define BENCH_TIMESTAMP()			(uint32_t)OS_TRACE_TIMESTAMP()
+#define BENCH_TIMESTAMP_HZ			(uint32_t)OS_TRACE_TIMESTAMP_HZ
+#ifdef OS_TRACE_TIMESTAMP_INIT
+#define BENCH_TIMESTAMP_INIT()		OS_TRACE_TIMESTAMP_INIT()
+#endif
+#else
+#define BENCH_TIMESTAMP()			(uint32_t)OSGetCount()
+#define BENCH_TIMESTAMP_HZ			(uint32_t)configTICK_RATE_HZ
+#endif
+#endif
+
+#ifndef BENCH_TIMESTAMP_INIT
+#define BENCH_TIMESTAMP_INIT()
+#endif
+
+/* Runs a handler as a kernel interrupt */
+#if !defined(BENCH_INTERRUPT) && (PROCESSOR == X86)
+#define BENCH_INTERRUPT(handler)	OS_CPU_Interrupt(handler)
+#endif
+
+/* Called after the results */
+#ifndef BENCH_DONE
+#if (PROCESSOR == X86)
+#define BENCH_DONE()				exit(0)
+#else
+#define BENCH_DONE()
+#endif
+#endif
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS			1000
+#endif
+
+#ifndef BENCH_PRIORITY
+#define BENCH_PRIORITY				1
+#endif
+
+/* Maximum number of delayed tasks of the tick benchmark */
+#ifndef BENCH_SLEEPERS
+#define BENCH_SLEEPERS				4
+#endif
+
+#ifndef BENCH_STACK_SIZE
+#if (PROCESSOR == X86)
+#define BENCH_STACK_SIZE			16384
+#else
+#define BENCH_STACK_SIZE			(NUMBER_MIN_OF_STACKED_BYTES + 256)
+#endif
+#endif
+
+#define BENCH_SLEEP_TICKS			(ostick_t)30000
+#define BENCH_QUEUE_SIZE			16
+#define BENCH_MAX_ELEMENT			64
+
+/* Benchmarks run by the partner task */
+#define BENCH_SEM					1
+#define BENCH_MBOX					2
+#define BENCH_QUEUE					3
+#define BENCH_DQUEUE				4
+#define BENCH_MUTEX					5
+#define BENCH_ISR					6
+
+/* Counts a kernel call that did not return the expected code */
+#define BENCH_CHECK(call, expected)	do { if ((call) != (expected)) bench_errors++; } while(0)
+
+typedef struct
+{
+	uint32_t iterations;
+	uint32_t total;
+	uint32_t min;
+	uint32_t max;
+} BENCH_RESULT;
+
+static BRTOS_Sem   *bench_start, *bench_ping, *bench_pong, *bench_sleep;
+static BRTOS_Mbox  *bench_mbox_ping, *bench_mbox_pong;
+#if (BRTOS_MUTEX_EN == 1)
+static BRTOS_Mutex *bench_mutex;
+#endif
+#if (BRTOS_QUEUE_EN == 1)
+static BRTOS_Queue *bench_queue;
+#endif
+#if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+static BRTOS_Queue *bench_dqueue;
+#endif
+
+static volatile uint8_t  bench_mode;
+static volatile uint32_t bench_errors;
+static volatile uint32_t bench_t0, bench_t1;
+static uint8_t bench_tx[BENCH_MAX_ELEMENT];
+static uint8_t bench_rx[BENCH_MAX_ELEMENT];
+
+
+static void bench_reset(BENCH_RESULT *r)
+{
+	r->iterations = 0;
+	r->total = 0;
+	r->min = 0xFFFFFFFFUL;
+	r->max = 0;
+	bench_errors = 0;
+}
+
+static void bench_sample(BENCH_RESULT *r, uint32_t time)
+{
+	r->iterations++;
+	r->total += time;
+	if (time < r->min) r->min = time;
+	if (time > r->max) r->max = time;
+}
+
+static void bench_report(const char *name, uint16_t parameter, BENCH_RESULT *r)
+{
+	if (bench_errors != 0)
+	{
+		PRINTF("%s,%u,error\n", name, (unsigned int)parameter);
+		return;
+	}
+
+	PRINTF("%s,%u,%lu,%lu,%lu,%lu,%lu,%lu\n", name, (unsigned int)parameter,
+		   (unsigned long)r->iterations, (unsigned long)r->total,
+		   (unsigned long)(r->total / r->iterations), (unsigned long)r->min,
+		   (unsigned long)r->max, (unsigned long)BENCH_TIMESTAMP_HZ);
+}
+
+/* The partner task has a higher priority, it runs and blocks in the benchmark before the return */
+static void bench_partner_start(uint8_t mode)
+{
+	bench_mode = mode;
+	BENCH_CHECK(OSSemPost(bench_start), OK);
+}
+
+#ifdef BENCH_INTERRUPT
+static void bench_isr(void)
+{
+	bench_t0 = BENCH_TIMESTAMP();
+	BENCH_CHECK(OSSemPost(bench_ping), OK);
+}
+#endif
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void bench_partner(void *parameters)
+#else
+static void bench_partner(void)
+#endif
+{
+	uint32_t i;
+	void *message;
+	#if (BRTOS_QUEUE_EN == 1)
+	uint8_t data;
+	#endif
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	for(;;)
+	{
+		BENCH_CHECK(OSSemPend(bench_start, 0), OK);
+
+		for (i = 0; i < BENCH_ITERATIONS; i++)
+		{
+			switch(bench_mode)
+			{
+				case BENCH_SEM:
+					BENCH_CHECK(OSSemPend(bench_ping, 0), OK);
+					BENCH_CHECK(OSSemPost(bench_pong), OK);
+					break;
+
+				case BENCH_MBOX:
+					BENCH_CHECK(OSMboxPend(bench_mbox_ping, &message, 0), OK);
+					BENCH_CHECK(OSMboxPost(bench_mbox_pong, message), OK);
+					break;
+
+				#if (BRTOS_QUEUE_EN == 1)
+				case BENCH_QUEUE:
+					BENCH_CHECK(OSQueuePend(bench_queue, &data, 0), READ_BUFFER_OK);
+					break;
+				#endif
+
+				#if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+				case BENCH_DQUEUE:
+					BENCH_CHECK(OSDQueuePend(bench_dqueue, bench_rx, 0), READ_BUFFER_OK);
+					break;
+				#endif
+
+				#if (BRTOS_MUTEX_EN == 1)
+				case BENCH_MUTEX:
+					BENCH_CHECK(OSSemPend(bench_ping, 0), OK);
+					BENCH_CHECK(OSMutexAcquire(bench_mutex, 0), OK);
+					bench_t1 = BENCH_TIMESTAMP();
+					BENCH_CHECK(OSMutexRelease(bench_mutex), OK);
+					break;
+				#endif
+
+				case BENCH_ISR:
+					BENCH_CHECK(OSSemPend(bench_ping, 0), OK);
+					bench_t1 = BENCH_TIMESTAMP();
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void bench_sleeper(void *parameters)
+#else
+static void bench_sleeper(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	/* Stays in the delay list after being started by the tick benchmark */
+	BENCH_CHECK(OSSemPend(bench_sleep, 0), OK);
+	for(;;)
+	{
+		BENCH_CHECK(OSDelayTask(BENCH_SLEEP_TICKS), OK);
+	}
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void bench_task(void *parameters)
+#else
+static void bench_task(void)
+#endif
+{
+	OS_SR_SAVE_VAR
+	BENCH_RESULT r;
+	uint32_t i, t0;
+	uint16_t n;
+	#if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+	static const uint8_t sizes[] = {1, 4, 16, BENCH_MAX_ELEMENT};
+	#endif
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	BENCH_TIMESTAMP_INIT();
+
+	for (i = 0; i < BENCH_MAX_ELEMENT; i++)
+	{
+		bench_tx[i] = (uint8_t)i;
+	}
+
+	PRINTF("benchmark,parameter,iterations,total,average,min,max,timestamp_hz\n");
+
+	/* Cost of a sample */
+	bench_reset(&r);
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+	{
+		t0 = BENCH_TIMESTAMP();
+		bench_sample(&r, BENCH_TIMESTAMP() - t0);
+	}
+	bench_report("timestamp", 0, &r);
+
+	/* Semaphore round trip */
+	bench_reset(&r);
+	bench_partner_start(BENCH_SEM);
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+	{
+		t0 = BENCH_TIMESTAMP();
+		BENCH_CHECK(OSSemPost(bench_ping), OK);
+		BENCH_CHECK(OSSemPend(bench_pong, 0), OK);
+		bench_sample(&r, BENCH_TIMESTAMP() - t0);
+	}
+	bench_report("sem_pingpong", 0, &r);
+
+	/* Mailbox round trip */
+	bench_reset(&r);
+	bench_partner_start(BENCH_MBOX);
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+	{
+		void *message;
+
+		t0 = BENCH_TIMESTAMP();
+		BENCH_CHECK(OSMboxPost(bench_mbox_ping, (void *)bench_tx), OK);
+		BENCH_CHECK(OSMboxPend(bench_mbox_pong, &message, 0), OK);
+		bench_sample(&r, BENCH_TIMESTAMP() - t0);
+	}
+	bench_report("mbox_roundtrip", 0, &r);
+
+	#if (BRTOS_QUEUE_EN == 1)
+	/* Queue transfer of one byte to a waiting task */
+	bench_reset(&r);
+	bench_partner_start(BENCH_QUEUE);
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+	{
+		t0 = BENCH_TIMESTAMP();
+		BENCH_CHECK(OSQueuePost(bench_queue, (uint8_t)i), WRITE_BUFFER_OK);
+		bench_sample(&r, BENCH_TIMESTAMP() - t0);
+	}
+	bench_report("queue_transfer", 1, &r);
+	#endif
+
+	#if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+	/* Dynamic queue transfer to a waiting task, for each element size */
+	for (n = 0; n < (uint16_t)sizeof(sizes); n++)
+	{
+		if (OSDQueueCreate(BENCH_QUEUE_SIZE, sizes[n], &bench_dqueue) != ALLOC_EVENT_OK)
+		{
+			PRINTF("dqueue_transfer,%u,error\n", (unsigned int)sizes[n]);
+			continue;
+		}
+
+		bench_reset(&r);
+		bench_partner_start(BENCH_DQUEUE);
+		for (i = 0; i < BENCH_ITERATIONS; i++)
+		{
+			t0 = BENCH_TIMESTAMP();
+			BENCH_CHECK(OSDQueuePost(bench_dqueue, bench_tx), WRITE_BUFFER_OK);
+			bench_sample(&r, BENCH_TIMESTAMP() - t0);
+		}
+		bench_report("dqueue_transfer", sizes[n], &r);
+
+		TEST_ASSERT(OSDQueueDelete(&bench_dqueue) == DELETE_EVENT_OK);
+	}
+	#endif
+
+	#if (BRTOS_MUTEX_EN == 1)
+	/* Mutex release to a waiting task, from the release to the return of its acquire */
+	bench_reset(&r);
+	bench_partner_start(BENCH_MUTEX);
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+	{
+		BENCH_CHECK(OSMutexAcquire(bench_mutex, 0), OK);
+		BENCH_CHECK(OSSemPost(bench_ping), OK);
+		t0 = BENCH_TIMESTAMP();
+		BENCH_CHECK(OSMutexRelease(bench_mutex), OK);
+		bench_sample(&r, bench_t1 - t0);
+	}
+	bench_report("mutex_handoff", 0, &r);
+	#endif
+
+	#ifdef BENCH_INTERRUPT
+	/* From the semaphore post of an interrupt to the return of the task pend */
+	bench_reset(&r);
+	bench_partner_start(BENCH_ISR);
+	for (i = 0; i < BENCH_ITERATIONS; i++)
+	{
+		BENCH_INTERRUPT(bench_isr);
+		bench_sample(&r, bench_t1 - bench_t0);
+	}
+	bench_report("isr_to_task", 0, &r);
+	#endif
+
+	/* Tick handler, with 0 to BENCH_SLEEPERS tasks in the delay list */
+	for (n = 0; n <= BENCH_SLEEPERS; n++)
+	{
+		bench_reset(&r);
+		if (n > 0)
+		{
+			BENCH_CHECK(OSSemPost(bench_sleep), OK);
+		}
+
+		for (i = 0; i < BENCH_ITERATIONS; i++)
+		{
+			OSEnterCritical();
+			t0 = BENCH_TIMESTAMP();
+			#if (TICKLESS == 1)
+			OSIncCounter(1);
+			#else
+			OSIncCounter();
+			#endif
+			OS_TICK_HANDLER();
+			bench_sample(&r, BENCH_TIMESTAMP() - t0);
+			OSExitCritical();
+		}
+		bench_report("tick_handler", n, &r);
+	}
+
+	BENCH_DONE();
+
+	for(;;)
+	{
+		(void)OSDelayTask(1000);
+	}
+}
+
+
+void kernel_bench(void)
+{
+	uint8_t i;
+
+	TEST_ASSERT(OSSemCreate(0, &bench_start) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSSemCreate(0, &bench_ping) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSSemCreate(0, &bench_pong) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSSemCreate(0, &bench_sleep) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSMboxCreate(&bench_mbox_ping, NULL) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSMboxCreate(&bench_mbox_pong, NULL) == ALLOC_EVENT_OK);
+
+	#if (BRTOS_MUTEX_EN == 1)
+	#if (BRTOS_ROUND_ROBIN_EN == 1)
+	TEST_ASSERT(OSMutexCreateOptions(&bench_mutex, 0, OS_MUTEX_INHERIT) == ALLOC_EVENT_OK);
+	#else
+	TEST_ASSERT(OSMutexCreate(&bench_mutex, BENCH_PRIORITY + BENCH_SLEEPERS + 2) == ALLOC_EVENT_OK);
+	#endif
+	#endif
+
+	#if (BRTOS_QUEUE_EN == 1)
+	TEST_ASSERT(OSQueueCreate(BENCH_QUEUE_SIZE, &bench_queue) == ALLOC_EVENT_OK);
+	#endif
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	TEST_ASSERT(OSInstallTask(bench_task, "Benchmark", BENCH_STACK_SIZE, BENCH_PRIORITY, NULL, NULL) == OK);
+	TEST_ASSERT(OSInstallTask(bench_partner, "Bench partner", BENCH_STACK_SIZE, BENCH_PRIORITY + 1, NULL, NULL) == OK);
+	for (i = 0; i < BENCH_SLEEPERS; i++)
+	{
+		TEST_ASSERT(OSInstallTask(bench_sleeper, "Bench sleeper", BENCH_STACK_SIZE, BENCH_PRIORITY + 2 + i, NULL, NULL) == OK);
+	}
+	#else
+	TEST_ASSERT(OSInstallTask(bench_task, "Benchmark", BENCH_STACK_SIZE, BENCH_PRIORITY, NULL) == OK);
+	TEST_ASSERT(OSInstallTask(bench_partner, "Bench partner", BENCH_STACK_SIZE, BENCH_PRIORITY + 1, NULL) == OK);
+	for (i = 0; i < BENCH_SLEEPERS; i++)
+	{
+		TEST_ASSERT(OSInstallTask(bench_sleeper, "Bench sleeper", BENCH_STACK_SIZE, BENCH_PRIORITY + 2 + i, NULL) == OK);
+	}
+	#endif
+}
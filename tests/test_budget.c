@@ -0,0 +1,446 @@
+/*
+ * test_budget.c
+ *
+ * Tests of the CPU budgets of the tasks (BRTOS_BUDGET_EN == 1).
+ * Runs in the simulated time of the POSIX port (OS_CPU_SIMULATED_TIME == 1): a task
+ * simulates its execution by running the tick interrupt and advances the runtime
+ * counter by BUDGET_TICK_UNITS at each tick, so each schedule is exact.
+ *
+ *  - parameters of the budgets;
+ *  - a runaway task starves a lower priority task without a budget, and is blocked at
+ *    each period after its budget with one;
+ *  - a periodic task within its budget is not throttled;
+ *  - a demoted runaway task keeps running below the other tasks (BRTOS_ROUND_ROBIN_EN);
+ *  - the budget is not enforced while the task owns a mutex.
+ *
+ * budget_test installs the test tasks and starts the scheduler. The application must not
+ * define OSGetTimerForRuntimeStats, OSConfigureTimerForRuntimeStats and
+ * BRTOS_BudgetOverrunHook, they are defined here.
+ * Needs 3 semaphores, 1 mutex, 4 tasks and the priorities 3, 5, 20, 25 and 30.
+ *
+ */
+
+#include "BRTOS.h"
+
+void budget_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if ((BRTOS_BUDGET_EN == 1) && (OS_CPU_SIMULATED_TIME == 1))
+
+/* Called after the tests */
+#ifndef BUDGET_DONE
+#define BUDGET_DONE()				exit(0)
+#endif
+
+#define BUDGET_STACK_SIZE			16384
+#define BUDGET_TICK_UNITS			100
+
+#define BUDGET_DEMOTE_PRIORITY		3
+#define BUDGET_CONTROL_PRIORITY		5
+#define BUDGET_RUNAWAY_PRIORITY		20
+#define BUDGET_PERIODIC_PRIORITY	25
+#define BUDGET_DRIVER_PRIORITY		30
+
+/* Each test task waits for its semaphore */
+#define BUDGET_RUNAWAY				0
+#define BUDGET_PERIODIC				1
+#define BUDGET_CONTROL				2
+#define BUDGET_TASKS				3
+
+static BRTOS_Sem *budget_go[BUDGET_TASKS];
+static BRTOS_Mutex *budget_mutex;
+static BRTOS_TH budget_runaway, budget_periodic, budget_control;
+
+static volatile uint32_t budget_clock;
+static volatile uint8_t  budget_stop;
+static volatile ostick_t budget_hold;
+static volatile uint32_t budget_control_ticks;
+static volatile uint32_t budget_jobs;
+static volatile uint32_t budget_hooks;
+static volatile BRTOS_TH budget_hook_task;
+
+
+uint32_t OSGetTimerForRuntimeStats(void)
+{
+	return budget_clock;
+}
+
+void OSConfigureTimerForRuntimeStats(void)
+{
+	budget_clock = 0;
+}
+
+void BRTOS_BudgetOverrunHook(BRTOS_TH task)
+{
+	budget_hooks++;
+	budget_hook_task = task;
+}
+
+/* Execution of a task: ticks that pass while the task runs */
+static void budget_run(ostick_t ticks)
+{
+	while (ticks-- > 0)
+	{
+		budget_clock += BUDGET_TICK_UNITS;
+		OS_CPU_Interrupt(TickTimer);
+	}
+}
+
+static OS_BUDGET_STATS budget_stats(BRTOS_TH task)
+{
+	OS_BUDGET_STATS stats;
+
+	TEST_ASSERT(OSTaskBudgetGetStats(task, &stats) == OK);
+	return stats;
+}
+
+/* Releases a test task from its semaphore */
+static void budget_release(uint8_t i)
+{
+	budget_stop = FALSE;
+	TEST_ASSERT(OSSemPost(budget_go[i]) == OK);
+}
+
+/* Number of test tasks that wait for their semaphores */
+static uint8_t budget_waiting(void)
+{
+	uint8_t i, waiting = 0;
+
+	for (i = 0; i < BUDGET_TASKS; i++)
+	{
+		waiting += budget_go[i]->OSEventWait;
+	}
+
+	return waiting;
+}
+
+/* Removes the budgets and waits for the test tasks at budget_go */
+static void budget_park(void)
+{
+	budget_stop = TRUE;
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 0, 0, 0) == OK);
+	TEST_ASSERT(OSTaskBudgetSet(budget_periodic, 0, 0, 0) == OK);
+	TEST_ASSERT(OSDelayTask(20) == OK);
+	TEST_ASSERT(budget_waiting() == BUDGET_TASKS);
+	TEST_ASSERT(ContextTask[budget_runaway].Priority == BUDGET_RUNAWAY_PRIORITY);
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void budget_runaway_task(void *parameters)
+#else
+static void budget_runaway_task(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	for(;;)
+	{
+		(void)OSSemPend(budget_go[BUDGET_RUNAWAY], 0);
+
+		if (budget_hold != 0)
+		{
+			TEST_ASSERT(OSMutexAcquire(budget_mutex, 0) == OK);
+			budget_run(budget_hold);
+			TEST_ASSERT(OSMutexRelease(budget_mutex) == OK);
+		}
+
+		/* Never waits */
+		while (!budget_stop)
+		{
+			budget_run(1);
+		}
+	}
+}
+
+/* Runs 2 ticks in each 10 ticks */
+#if (TASK_WITH_PARAMETERS == 1)
+static void budget_periodic_task(void *parameters)
+#else
+static void budget_periodic_task(void)
+#endif
+{
+	ostick_t last_wake;
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	for(;;)
+	{
+		(void)OSSemPend(budget_go[BUDGET_PERIODIC], 0);
+
+		last_wake = OSGetTickCount();
+		while (!budget_stop)
+		{
+			budget_run(2);
+			budget_jobs++;
+			(void)OSDelayUntil(&last_wake, 10);
+		}
+	}
+}
+
+/* Runs whenever the higher priority tasks let it */
+#if (TASK_WITH_PARAMETERS == 1)
+static void budget_control_task(void *parameters)
+#else
+static void budget_control_task(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	for(;;)
+	{
+		(void)OSSemPend(budget_go[BUDGET_CONTROL], 0);
+
+		while (!budget_stop)
+		{
+			budget_run(1);
+			budget_control_ticks++;
+		}
+	}
+}
+
+
+void test_budget_parameters(void)
+{
+	OS_BUDGET_STATS stats;
+
+	TEST_ASSERT(OSTaskBudgetSet(0, 300, 10, 0) == NOT_VALID_TASK);
+	TEST_ASSERT(OSTaskBudgetSet(NUMBER_OF_TASKS + 1, 300, 10, 0) == NOT_VALID_TASK);
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 300, 0, 0) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 300, (ostick_t)(TICK_COUNT_OVERFLOW / 2), 0) == INVALID_PARAMETERS);
+
+	/* Demoted to a lower priority only */
+	#if (BRTOS_ROUND_ROBIN_EN == 1)
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 300, 10, BUDGET_RUNAWAY_PRIORITY) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 300, 10, BUDGET_PERIODIC_PRIORITY) == INVALID_PARAMETERS);
+	#else
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 300, 10, BUDGET_DEMOTE_PRIORITY) == INVALID_PARAMETERS);
+	#endif
+
+	TEST_ASSERT(OSTaskBudgetGetStats(budget_runaway, &stats) == NOT_VALID_TASK);
+
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 300, 10, 0) == OK);
+	stats = budget_stats(budget_runaway);
+	TEST_ASSERT(stats.budget == 300);
+	TEST_ASSERT(stats.period == 10);
+	TEST_ASSERT(stats.used == 0);
+	TEST_ASSERT(stats.overruns == 0);
+	TEST_ASSERT(stats.exhausted == FALSE);
+
+	/* Removed by a budget of 0 */
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 0, 0, 0) == OK);
+	TEST_ASSERT(OSTaskBudgetGetStats(budget_runaway, &stats) == NOT_VALID_TASK);
+}
+
+
+/* The runaway task is blocked for the rest of each period after 3 ticks */
+void test_budget_block(void)
+{
+	OS_BUDGET_STATS stats;
+	uint32_t control;
+
+	/* Without a budget, the control task never runs */
+	budget_hold = 0;
+	budget_release(BUDGET_RUNAWAY);
+	budget_release(BUDGET_PERIODIC);
+	budget_release(BUDGET_CONTROL);
+	TEST_ASSERT(OSDelayTask(20) == OK);
+	TEST_ASSERT(budget_control_ticks == 0);
+	TEST_ASSERT(budget_jobs >= 2);
+
+	budget_hooks = 0;
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 3 * BUDGET_TICK_UNITS, 10, 0) == OK);
+	TEST_ASSERT(OSTaskBudgetSet(budget_periodic, 3 * BUDGET_TICK_UNITS, 10, 0) == OK);
+	control = budget_control_ticks;
+	budget_jobs = 0;
+
+	TEST_ASSERT(OSDelayTask(100) == OK);
+
+	/* Exhausted in each period, at its third tick */
+	stats = budget_stats(budget_runaway);
+	TEST_ASSERT((stats.overruns >= 9) && (stats.overruns <= 10));
+	TEST_ASSERT(stats.used <= (3 * BUDGET_TICK_UNITS));
+	TEST_ASSERT(budget_hooks == stats.overruns);
+	TEST_ASSERT(budget_hook_task == budget_runaway);
+
+	/* The periodic task keeps its rate within its budget */
+	stats = budget_stats(budget_periodic);
+	TEST_ASSERT(stats.overruns == 0);
+	TEST_ASSERT(stats.exhausted == FALSE);
+	TEST_ASSERT(budget_jobs >= 9);
+
+	/* 100 ticks - 30 of the runaway task - 20 of the periodic task */
+	control = budget_control_ticks - control;
+	PRINTF("  control task: %lu of 100 ticks\r\n", (unsigned long)control);
+	TEST_ASSERT(control >= 45);
+
+	budget_park();
+}
+
+
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+/* The demoted runaway task runs when nothing else is ready */
+void test_budget_demote(void)
+{
+	OS_BUDGET_STATS stats;
+
+	budget_hold = 0;
+	budget_release(BUDGET_RUNAWAY);
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 3 * BUDGET_TICK_UNITS, 10, BUDGET_DEMOTE_PRIORITY) == OK);
+
+	/* Exhausted at the third tick and kept running */
+	TEST_ASSERT(OSDelayTask(5) == OK);
+	stats = budget_stats(budget_runaway);
+	TEST_ASSERT(stats.exhausted == TRUE);
+	TEST_ASSERT(stats.overruns == 1);
+	TEST_ASSERT(stats.used == (5 * BUDGET_TICK_UNITS));
+	TEST_ASSERT(ContextTask[budget_runaway].Priority == BUDGET_DEMOTE_PRIORITY);
+
+	/* Replenished at the end of the period */
+	TEST_ASSERT(OSDelayTask(5) == OK);
+	stats = budget_stats(budget_runaway);
+	TEST_ASSERT(stats.exhausted == FALSE);
+	TEST_ASSERT(stats.used == 0);
+	TEST_ASSERT(ContextTask[budget_runaway].Priority == BUDGET_RUNAWAY_PRIORITY);
+
+	TEST_ASSERT(OSDelayTask(40) == OK);
+	TEST_ASSERT(budget_stats(budget_runaway).overruns == 5);
+
+	budget_park();
+	TEST_ASSERT(ContextTask[budget_runaway].Priority == BUDGET_RUNAWAY_PRIORITY);
+}
+#endif
+
+
+#if (BRTOS_MUTEX_EN == 1)
+/* The owner of a mutex is blocked at the release of the mutex */
+void test_budget_mutex(void)
+{
+	OS_BUDGET_STATS stats;
+
+	budget_hold = 6;
+	budget_release(BUDGET_RUNAWAY);
+	TEST_ASSERT(OSTaskBudgetSet(budget_runaway, 3 * BUDGET_TICK_UNITS, 20, 0) == OK);
+
+	TEST_ASSERT(OSDelayTask(10) == OK);
+	stats = budget_stats(budget_runaway);
+	TEST_ASSERT(stats.exhausted == TRUE);
+	TEST_ASSERT(stats.overruns == 1);
+	TEST_ASSERT(stats.used == (7 * BUDGET_TICK_UNITS));
+	TEST_ASSERT(budget_mutex->OSEventState == AVAILABLE_RESOURCE);
+
+	/* Unblocked at each replenishment, even from the idle task */
+	TEST_ASSERT(OSDelayTask(45) == OK);
+	stats = budget_stats(budget_runaway);
+	TEST_ASSERT(stats.overruns == 3);
+	TEST_ASSERT(stats.used == (3 * BUDGET_TICK_UNITS));
+
+	budget_park();
+	budget_hold = 0;
+}
+#endif
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void budget_driver(void *parameters)
+#else
+static void budget_driver(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	/* The test tasks wait for budget_go */
+	TEST_ASSERT(OSDelayTask(1) == OK);
+	TEST_ASSERT(budget_waiting() == BUDGET_TASKS);
+
+	run_test(test_budget_parameters);
+	run_test(test_budget_block);
+	#if (BRTOS_ROUND_ROBIN_EN == 1)
+	run_test(test_budget_demote);
+	#endif
+	#if (BRTOS_MUTEX_EN == 1)
+	run_test(test_budget_mutex);
+	#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+
+	BUDGET_DONE();
+
+	for(;;)
+	{
+		(void)OSDelayTask(1000);
+	}
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static BRTOS_TH budget_install(void (*task)(void *), const CHAR8 *name, uint8_t priority)
+#else
+static BRTOS_TH budget_install(void (*task)(void), const CHAR8 *name, uint8_t priority)
+#endif
+{
+	OS_CPU_TYPE handle = 0;
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	TEST_ASSERT(OSInstallTask(task, name, BUDGET_STACK_SIZE, priority, NULL, &handle) == OK);
+	#else
+	TEST_ASSERT(OSInstallTask(task, name, BUDGET_STACK_SIZE, priority, &handle) == OK);
+	#endif
+
+	return (BRTOS_TH)handle;
+}
+#endif
+
+
+void budget_test(void)
+{
+#if ((BRTOS_BUDGET_EN == 1) && (OS_CPU_SIMULATED_TIME == 1))
+	uint8_t i;
+
+	for (i = 0; i < BUDGET_TASKS; i++)
+	{
+		TEST_ASSERT(OSSemCreate(0, &budget_go[i]) == ALLOC_EVENT_OK);
+	}
+	#if (BRTOS_MUTEX_EN == 1)
+	TEST_ASSERT(OSMutexCreate(&budget_mutex, 0) == ALLOC_EVENT_OK);
+	#endif
+
+	budget_runaway = budget_install(budget_runaway_task, "Budget runaway", BUDGET_RUNAWAY_PRIORITY);
+	budget_periodic = budget_install(budget_periodic_task, "Budget periodic", BUDGET_PERIODIC_PRIORITY);
+	budget_control = budget_install(budget_control_task, "Budget control", BUDGET_CONTROL_PRIORITY);
+
+	(void)budget_install(budget_driver, "Budget driver", BUDGET_DRIVER_PRIORITY);
+
+	if (BRTOSStart() != OK) while(1){}
+#else
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+#endif
+}
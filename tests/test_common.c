@@ -0,0 +1,47 @@
+/*
+ * test_common.c
+ *
+ * Fixture shared by the tests that install tasks without starting the scheduler.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#if (TASK_WITH_PARAMETERS == 1)
+void test_task(void *parameters)
+{
+	(void)parameters;
+	for(;;){}
+}
+#else
+void test_task(void)
+{
+	for(;;){}
+}
+#endif
+
+BRTOS_TH test_install(uint8_t priority)
+{
+	OS_CPU_TYPE handle = 0;
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	TEST_ASSERT(OSInstallTask(test_task, "test task", TEST_STACK_SIZE, priority, NULL, &handle) == OK);
+	#else
+	TEST_ASSERT(OSInstallTask(test_task, "test task", TEST_STACK_SIZE, priority, &handle) == OK);
+	#endif
+
+	return (BRTOS_TH)handle;
+}
+
+void test_kernel_ready(void)
+{
+	currentTask = 0;
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+}
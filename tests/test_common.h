@@ -0,0 +1,29 @@
+/*
+ * test_common.h
+ *
+ * Fixture shared by the tests that install tasks without starting the scheduler.
+ * test_common.c must be built with these tests.
+ *
+ */
+
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include "BRTOS.h"
+
+#define TEST_STACK_SIZE		(uint16_t)(NUMBER_MIN_OF_STACKED_BYTES + 64)
+
+/* Function of the tasks installed by the tests */
+#if (TASK_WITH_PARAMETERS == 1)
+void test_task(void *parameters);
+#else
+void test_task(void);
+#endif
+
+/* Installs a task that never runs, the task number is returned */
+BRTOS_TH test_install(uint8_t priority);
+
+/* Uninstalls every task and leaves the kernel ready for the task installation */
+void test_kernel_ready(void);
+
+#endif
@@ -0,0 +1,243 @@
+/*
+ * test_dqueue.c
+ *
+ * Tests of the dynamic queues (BRTOS_DYNAMIC_QUEUE_ENABLED == 1).
+ * Only the calls that do not block are used, so the tests run without starting the scheduler.
+ * Must be called after BRTOS_Init.
+ *
+ */
+
+#include "BRTOS.h"
+
+void dqueue_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+
+#define TEST_QUEUE_LENGTH	5
+#define TEST_MAX_ENTRY		20
+
+static uint8_t test_in[TEST_QUEUE_LENGTH * 2 * TEST_MAX_ENTRY];
+static uint8_t test_out[TEST_QUEUE_LENGTH * 2 * TEST_MAX_ENTRY];
+
+/* Entry "e" is filled with the value e + i for the byte i */
+static void test_fill(uint8_t *buffer, uint16_t size, uint16_t first, uint16_t entries)
+{
+	uint16_t e, i;
+
+	for (e = 0; e < entries; e++)
+	{
+		for (i = 0; i < size; i++)
+		{
+			buffer[e * size + i] = (uint8_t)(first + e + i);
+		}
+	}
+}
+
+static uint8_t test_check(const uint8_t *buffer, uint16_t size, uint16_t first, uint16_t entries)
+{
+	uint16_t e, i;
+
+	for (e = 0; e < entries; e++)
+	{
+		for (i = 0; i < size; i++)
+		{
+			if (buffer[e * size + i] != (uint8_t)(first + e + i))
+			{
+				return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+/* Single entry post and pend, the queue wraps around several times */
+static void test_dqueue_wrap_size(uint16_t size)
+{
+	BRTOS_Queue *queue;
+	uint16_t i;
+
+	TEST_ASSERT(OSDQueueCreate(TEST_QUEUE_LENGTH, size, &queue) == ALLOC_EVENT_OK);
+
+	for (i = 0; i < 3 * TEST_QUEUE_LENGTH; i++)
+	{
+		test_fill(test_in, size, i, 2);
+		TEST_ASSERT(OSDQueuePost(queue, test_in) == WRITE_BUFFER_OK);
+		TEST_ASSERT(OSDQueuePost(queue, &test_in[size]) == WRITE_BUFFER_OK);
+		TEST_ASSERT(OSDQueuePend(queue, test_out, NO_TIMEOUT) == READ_BUFFER_OK);
+		TEST_ASSERT(OSDQueuePend(queue, &test_out[size], NO_TIMEOUT) == READ_BUFFER_OK);
+		TEST_ASSERT(test_check(test_out, size, i, 2));
+	}
+
+	TEST_ASSERT(OSDQueuePend(queue, test_out, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+	TEST_ASSERT(OSDQueueDelete(&queue) == DELETE_EVENT_OK);
+}
+
+void test_dqueue_wrap(void)
+{
+	/* Byte, unaligned, word and multiword entries */
+	test_dqueue_wrap_size(1);
+	test_dqueue_wrap_size(3);
+	test_dqueue_wrap_size(sizeof(OS_CPU_TYPE));
+	test_dqueue_wrap_size(2 * sizeof(OS_CPU_TYPE));
+	test_dqueue_wrap_size(TEST_MAX_ENTRY);
+}
+
+void test_dqueue_post_n(void)
+{
+	BRTOS_Queue *queue;
+	uint16_t count;
+
+	TEST_ASSERT(OSDQueueCreate(TEST_QUEUE_LENGTH, sizeof(OS_CPU_TYPE), &queue) == ALLOC_EVENT_OK);
+	test_fill(test_in, sizeof(OS_CPU_TYPE), 0, 2 * TEST_QUEUE_LENGTH);
+
+	/* Moves the input pointer, so the next posts cross the wrap point */
+	count = 3;
+	TEST_ASSERT(OSDQueuePostN(queue, test_in, &count) == WRITE_BUFFER_OK);
+	TEST_ASSERT(count == 3);
+	TEST_ASSERT(OSDQueuePendN(queue, test_out, &count, NO_TIMEOUT) == READ_BUFFER_OK);
+	TEST_ASSERT(count == 3);
+	TEST_ASSERT(test_check(test_out, sizeof(OS_CPU_TYPE), 0, 3));
+
+	/* Only the entries that fit into the queue are written */
+	count = TEST_QUEUE_LENGTH + 2;
+	TEST_ASSERT(OSDQueuePostN(queue, &test_in[3 * sizeof(OS_CPU_TYPE)], &count) == BUFFER_UNDERRUN);
+	TEST_ASSERT(count == TEST_QUEUE_LENGTH);
+
+	count = 1;
+	TEST_ASSERT(OSDQueuePostN(queue, test_in, &count) == BUFFER_UNDERRUN);
+	TEST_ASSERT(count == 0);
+
+	count = 0;
+	#if (ERROR_CHECK == 1)
+	TEST_ASSERT(OSDQueuePostN(queue, test_in, &count) == INVALID_PARAMETERS);
+	#endif
+
+	TEST_ASSERT(OSDQueueDelete(&queue) == DELETE_EVENT_OK);
+}
+
+void test_dqueue_pend_n(void)
+{
+	BRTOS_Queue *queue;
+	uint16_t count;
+
+	TEST_ASSERT(OSDQueueCreate(TEST_QUEUE_LENGTH, 3, &queue) == ALLOC_EVENT_OK);
+	test_fill(test_in, 3, 0, 2 * TEST_QUEUE_LENGTH);
+
+	count = 4;
+	TEST_ASSERT(OSDQueuePostN(queue, test_in, &count) == WRITE_BUFFER_OK);
+
+	/* Reads across the wrap point */
+	count = 2;
+	TEST_ASSERT(OSDQueuePendN(queue, test_out, &count, NO_TIMEOUT) == READ_BUFFER_OK);
+	count = 3;
+	TEST_ASSERT(OSDQueuePostN(queue, &test_in[4 * 3], &count) == WRITE_BUFFER_OK);
+
+	/* Only the available entries are read */
+	count = TEST_QUEUE_LENGTH + 1;
+	TEST_ASSERT(OSDQueuePendN(queue, &test_out[2 * 3], &count, NO_TIMEOUT) == READ_BUFFER_OK);
+	TEST_ASSERT(count == TEST_QUEUE_LENGTH);
+	TEST_ASSERT(test_check(test_out, 3, 0, 7));
+
+	count = 1;
+	TEST_ASSERT(OSDQueuePendN(queue, test_out, &count, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+	TEST_ASSERT(count == 0);
+
+	TEST_ASSERT(OSDQueueDelete(&queue) == DELETE_EVENT_OK);
+}
+
+void test_dqueue_reserve_commit(void)
+{
+	BRTOS_Queue *queue;
+	void *entry;
+	void *other;
+	uint16_t i;
+
+	TEST_ASSERT(OSDQueueCreate(2, TEST_MAX_ENTRY, &queue) == ALLOC_EVENT_OK);
+
+	for (i = 0; i < 5; i++)
+	{
+		/* Written in place */
+		TEST_ASSERT(OSDQueueReserve(queue, &entry) == WRITE_BUFFER_OK);
+		test_fill((uint8_t*)entry, TEST_MAX_ENTRY, i, 1);
+
+		/* Not visible before the commit */
+		TEST_ASSERT(OSDQueuePeek(queue, &other, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+		TEST_ASSERT(OSDQueueReserve(queue, &other) == BUSY_RESOURCE);
+		TEST_ASSERT(OSDQueuePost(queue, test_in) == BUFFER_UNDERRUN);
+		TEST_ASSERT(OSDQueueCommit(queue) == WRITE_BUFFER_OK);
+
+		/* Read in place */
+		TEST_ASSERT(OSDQueuePeek(queue, &other, NO_TIMEOUT) == READ_BUFFER_OK);
+		TEST_ASSERT(other == entry);
+		TEST_ASSERT(test_check((uint8_t*)other, TEST_MAX_ENTRY, i, 1));
+		TEST_ASSERT(OSDQueueRelease(queue) == READ_BUFFER_OK);
+	}
+
+	TEST_ASSERT(OSDQueueCommit(queue) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSDQueueRelease(queue) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSDQueueDelete(&queue) == DELETE_EVENT_OK);
+}
+
+void test_dqueue_peek_release(void)
+{
+	BRTOS_Queue *queue;
+	void *entry;
+	uint16_t count;
+
+	TEST_ASSERT(OSDQueueCreate(2, sizeof(OS_CPU_TYPE), &queue) == ALLOC_EVENT_OK);
+	test_fill(test_in, sizeof(OS_CPU_TYPE), 0, 3);
+
+	count = 2;
+	TEST_ASSERT(OSDQueuePostN(queue, test_in, &count) == WRITE_BUFFER_OK);
+	TEST_ASSERT(OSDQueuePeek(queue, &entry, NO_TIMEOUT) == READ_BUFFER_OK);
+	TEST_ASSERT(OSDQueuePeek(queue, &entry, NO_TIMEOUT) == BUSY_RESOURCE);
+
+	/* The peeked entry buffer is not reused before the release */
+	TEST_ASSERT(OSDQueuePost(queue, &test_in[2 * sizeof(OS_CPU_TYPE)]) == BUFFER_UNDERRUN);
+	TEST_ASSERT(test_check((uint8_t*)entry, sizeof(OS_CPU_TYPE), 0, 1));
+
+	/* The other entries can still be read */
+	TEST_ASSERT(OSDQueuePend(queue, test_out, NO_TIMEOUT) == READ_BUFFER_OK);
+	TEST_ASSERT(test_check(test_out, sizeof(OS_CPU_TYPE), 1, 1));
+
+	TEST_ASSERT(OSDQueueRelease(queue) == READ_BUFFER_OK);
+	TEST_ASSERT(OSDQueuePost(queue, &test_in[2 * sizeof(OS_CPU_TYPE)]) == WRITE_BUFFER_OK);
+	TEST_ASSERT(OSDQueuePend(queue, test_out, NO_TIMEOUT) == READ_BUFFER_OK);
+	TEST_ASSERT(test_check(test_out, sizeof(OS_CPU_TYPE), 2, 1));
+
+	TEST_ASSERT(OSDQueueDelete(&queue) == DELETE_EVENT_OK);
+}
+#endif
+
+void dqueue_test(void)
+{
+#if (BRTOS_DYNAMIC_QUEUE_ENABLED == 1)
+	run_test(test_dqueue_wrap);
+	run_test(test_dqueue_post_n);
+	run_test(test_dqueue_pend_n);
+	run_test(test_dqueue_reserve_commit);
+	run_test(test_dqueue_peek_release);
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
@@ -0,0 +1,347 @@
+/*
+ * test_edf.c
+ *
+ * Tests of the earliest deadline first scheduling class (BRTOS_EDF_EN == 1).
+ * Runs in the simulated time of the POSIX port (OS_CPU_SIMULATED_TIME == 1): the
+ * execution time of a job is simulated by running the tick interrupt from the task,
+ * so each schedule is exact.
+ *
+ *  - admission control of the utilization and the parameters;
+ *  - the EDF tasks run and are released from a wait list by the earliest deadline;
+ *  - a task set with 100% of utilization, not schedulable by fixed priorities, runs
+ *    without any missed deadline;
+ *  - the deadline misses and the skipped releases of a job longer than its period.
+ *
+ * edf_test installs the test tasks and starts the scheduler.
+ * Needs 1 semaphore, EDF_TASKS + 2 tasks and the priority EDF_DRIVER_PRIORITY,
+ * above BRTOS_EDF_PRIORITY.
+ *
+ */
+
+#include "BRTOS.h"
+
+void edf_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if ((BRTOS_EDF_EN == 1) && (OS_CPU_SIMULATED_TIME == 1))
+
+/* Called after the tests */
+#ifndef EDF_DONE
+#define EDF_DONE()					exit(0)
+#endif
+
+#ifndef EDF_DRIVER_PRIORITY
+#define EDF_DRIVER_PRIORITY			10
+#endif
+
+#define EDF_STACK_SIZE				16384
+#define EDF_TASKS					3
+#define EDF_TRACE_SIZE				16
+
+static BRTOS_Sem *edf_go;
+static BRTOS_TH edf_tasks[EDF_TASKS];
+static BRTOS_TH edf_background;
+
+/* Execution time of the jobs and last result of OSEDFWaitNextPeriod, by task handle */
+static volatile ostick_t edf_exec[NUMBER_OF_TASKS + 1];
+static volatile uint8_t  edf_result[NUMBER_OF_TASKS + 1];
+static volatile uint8_t  edf_stop;
+
+/* Tasks in the order of their job starts */
+static volatile uint8_t  edf_trace[EDF_TRACE_SIZE];
+static volatile uint8_t  edf_trace_count;
+
+
+/* Execution of a job: ticks that pass while the task runs */
+static void edf_run(ostick_t ticks)
+{
+	while (ticks-- > 0)
+	{
+		OS_CPU_Interrupt(TickTimer);
+	}
+}
+
+static OS_EDF_STATS edf_stats(BRTOS_TH task)
+{
+	OS_EDF_STATS stats;
+
+	TEST_ASSERT(OSEDFGetStats(task, &stats) == OK);
+	return stats;
+}
+
+/* Stops the jobs, each task waits for edf_go after its current job */
+static void edf_park(ostick_t longest_period)
+{
+	edf_stop = TRUE;
+	TEST_ASSERT(OSDelayTask(longest_period * 3) == OK);
+	TEST_ASSERT(edf_go->OSEventWait == (EDF_TASKS + 1));
+	edf_stop = FALSE;
+	edf_trace_count = 0;
+}
+
+/* Releases the EDF tasks from the wait list, the background task keeps waiting */
+static void edf_release(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < EDF_TASKS; i++)
+	{
+		TEST_ASSERT(OSSemPost(edf_go) == OK);
+	}
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void edf_task(void *parameters)
+#else
+static void edf_task(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	for(;;)
+	{
+		(void)OSSemPend(edf_go, 0);
+
+		while (!edf_stop)
+		{
+			if (edf_trace_count < EDF_TRACE_SIZE)
+			{
+				edf_trace[edf_trace_count++] = (uint8_t)currentTask;
+			}
+
+			edf_run(edf_exec[currentTask]);
+			edf_result[currentTask] = OSEDFWaitNextPeriod();
+		}
+	}
+}
+
+
+void test_edf_admission(void)
+{
+	/* Parameters */
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[0], 0, 10, 1) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[0], 10, 20, 1) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[0], 10, 5, 6) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[0], (ostick_t)(TICK_COUNT_OVERFLOW / 2), 10, 1) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSEDFTaskSet(0, 10, 10, 1) == NOT_VALID_TASK);
+
+	/* Only the tasks of the EDF priority */
+	TEST_ASSERT(OSEDFTaskSet((BRTOS_TH)currentTask, 10, 10, 1) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSEDFWaitNextPeriod() == NOT_VALID_TASK);
+
+	/* 40% + 40% + 20% */
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[0], 10, 10, 4) == OK);
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[1], 20, 20, 8) == OK);
+	TEST_ASSERT(OSEDFUtilization() == 8000);
+
+	/* The density of a constrained deadline is wcet / deadline: 6 / 15 = 40% */
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[2], 30, 15, 6) == EDF_NOT_ADMITTED);
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[2], 30, 30, 6) == OK);
+	TEST_ASSERT(OSEDFUtilization() == 10000);
+	TEST_ASSERT(OSEDFTaskSet(edf_background, 1000, 1000, 1) == EDF_NOT_ADMITTED);
+
+	/* A task is admitted again with its new parameters */
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[0], 10, 10, 2) == OK);
+	TEST_ASSERT(OSEDFUtilization() == 8000);
+	TEST_ASSERT(OSEDFGetStats(edf_background, NULL) == NOT_VALID_TASK);
+}
+
+
+/* The tasks run by deadline, not by installation or wait order */
+void test_edf_order(void)
+{
+	ostick_t start;
+	uint8_t i;
+
+	/* Installed in the order 0, 1, 2, deadlines in the order 1, 2, 0 */
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[0], 30, 30, 2) == OK);
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[1], 30, 10, 2) == OK);
+	TEST_ASSERT(OSEDFTaskSet(edf_tasks[2], 30, 20, 2) == OK);
+	for (i = 0; i < EDF_TASKS; i++)
+	{
+		edf_exec[edf_tasks[i]] = 2;
+	}
+
+	start = OSGetTickCount();
+	edf_release();
+	TEST_ASSERT(edf_go->OSEventWait == 1);
+
+	/* Two periods */
+	TEST_ASSERT(OSDelayTask(60) == OK);
+
+	TEST_ASSERT(edf_trace_count == 6);
+	for (i = 0; i < 6; i += 3)
+	{
+		TEST_ASSERT(edf_trace[i] == edf_tasks[1]);
+		TEST_ASSERT(edf_trace[i + 1] == edf_tasks[2]);
+		TEST_ASSERT(edf_trace[i + 2] == edf_tasks[0]);
+	}
+
+	for (i = 0; i < EDF_TASKS; i++)
+	{
+		TEST_ASSERT(edf_stats(edf_tasks[i]).jobs == 2);
+		TEST_ASSERT(edf_stats(edf_tasks[i]).misses == 0);
+		TEST_ASSERT(edf_result[edf_tasks[i]] == OK);
+	}
+
+	/* The next jobs are released at the period, with their deadlines */
+	TEST_ASSERT(edf_stats(edf_tasks[1]).abs_deadline == (ostick_t)((start + 60 + 10) % TICK_COUNT_OVERFLOW));
+
+	edf_park(30);
+}
+
+
+/* 100% of utilization: the task with the longest period misses its deadlines with
+ * the fixed priorities of the rate monotonic order, never with EDF */
+void test_edf_full_utilization(void)
+{
+	static const ostick_t period[EDF_TASKS] = {10, 20, 30};
+	static const ostick_t wcet[EDF_TASKS]   = {4, 8, 6};
+	OS_EDF_STATS stats;
+	uint8_t i;
+
+	for (i = 0; i < EDF_TASKS; i++)
+	{
+		TEST_ASSERT(OSEDFTaskSet(edf_tasks[i], period[i], period[i], wcet[i]) == OK);
+		edf_exec[edf_tasks[i]] = wcet[i];
+	}
+	TEST_ASSERT(OSEDFUtilization() == 10000);
+
+	edf_release();
+
+	/* Ten hyperperiods, the driver wakes up at the end of the last one */
+	TEST_ASSERT(OSDelayTask(600) == OK);
+
+	for (i = 0; i < EDF_TASKS; i++)
+	{
+		stats = edf_stats(edf_tasks[i]);
+		TEST_ASSERT(stats.misses == 0);
+		TEST_ASSERT(stats.jobs >= (uint32_t)((600 / period[i]) - 1));
+		PRINTF("  period %u: %lu jobs, %lu missed\r\n", (unsigned int)period[i],
+			   (unsigned long)stats.jobs, (unsigned long)stats.misses);
+	}
+
+	edf_park(30);
+}
+
+
+/* A job longer than two periods misses its deadline and the next release */
+void test_edf_overrun(void)
+{
+	OS_EDF_STATS stats;
+	uint8_t i;
+
+	for (i = 0; i < EDF_TASKS; i++)
+	{
+		TEST_ASSERT(OSEDFTaskSet(edf_tasks[i], 20, 20, 2) == OK);
+		edf_exec[edf_tasks[i]] = 2;
+	}
+	edf_exec[edf_tasks[0]] = 45;
+
+	edf_release();
+	TEST_ASSERT(OSDelayTask(60) == OK);
+
+	/* Completed after 45 to 49 ticks: missed its deadline and the release at 20 */
+	stats = edf_stats(edf_tasks[0]);
+	TEST_ASSERT(stats.jobs >= 1);
+	TEST_ASSERT(stats.misses >= 2);
+	TEST_ASSERT(edf_result[edf_tasks[0]] == DEADLINE_MISSED);
+
+	edf_park(60);
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void edf_driver(void *parameters)
+#else
+static void edf_driver(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	/* The tasks of the EDF priority wait for edf_go */
+	TEST_ASSERT(OSDelayTask(1) == OK);
+	TEST_ASSERT(edf_go->OSEventWait == (EDF_TASKS + 1));
+
+	run_test(test_edf_admission);
+	run_test(test_edf_order);
+	run_test(test_edf_full_utilization);
+	run_test(test_edf_overrun);
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+
+	EDF_DONE();
+
+	for(;;)
+	{
+		(void)OSDelayTask(1000);
+	}
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static BRTOS_TH edf_install(void (*task)(void *), const CHAR8 *name, uint8_t priority)
+#else
+static BRTOS_TH edf_install(void (*task)(void), const CHAR8 *name, uint8_t priority)
+#endif
+{
+	OS_CPU_TYPE handle = 0;
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	TEST_ASSERT(OSInstallTask(task, name, EDF_STACK_SIZE, priority, NULL, &handle) == OK);
+	#else
+	TEST_ASSERT(OSInstallTask(task, name, EDF_STACK_SIZE, priority, &handle) == OK);
+	#endif
+
+	return (BRTOS_TH)handle;
+}
+#endif
+
+
+void edf_test(void)
+{
+#if ((BRTOS_EDF_EN == 1) && (OS_CPU_SIMULATED_TIME == 1))
+	uint8_t i;
+
+	TEST_ASSERT(OSSemCreate(0, &edf_go) == ALLOC_EVENT_OK);
+
+	for (i = 0; i < EDF_TASKS; i++)
+	{
+		edf_tasks[i] = edf_install(edf_task, "EDF task", BRTOS_EDF_PRIORITY);
+	}
+
+	/* Runs at the EDF priority without being an EDF task */
+	edf_background = edf_install(edf_task, "EDF background", BRTOS_EDF_PRIORITY);
+
+	(void)edf_install(edf_driver, "EDF driver", EDF_DRIVER_PRIORITY);
+
+	if (BRTOSStart() != OK) while(1){}
+#else
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+#endif
+}
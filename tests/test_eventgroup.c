@@ -0,0 +1,150 @@
+/*
+ * test_eventgroup.c
+ *
+ * Tests of the event groups (BRTOS_EVENT_GROUP_EN == 1).
+ * The waiting tasks are placed into the wait list by the test and the flags are set
+ * as done by an interrupt, so the tests run without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void eventgroup_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_EVENT_GROUP_EN == 1)
+
+#define FLAG_A				(osflags_t)0x00000001
+#define FLAG_B				(osflags_t)0x00000002
+#define FLAG_C				(osflags_t)0x80000000
+
+/* Does what OSEventGroupWait does before the context switch */
+static void test_wait(BRTOS_EventGroup *group, BRTOS_TH task, osflags_t flags, uint8_t options)
+{
+	ContextType *Task = &ContextTask[task];
+
+	Task->WaitFlags = flags;
+	Task->WaitFlagsOptions = options;
+	group->OSEventWait++;
+	OSEventWaitListInsert(&group->OSEventWaitList, group, Task);
+	OSReadyListRemove(Task);
+}
+
+/* Sets the flags as done by an interrupt handler */
+static void test_isr_set(BRTOS_EventGroup *group, osflags_t flags)
+{
+	iNesting++;
+	TEST_ASSERT(OSEventGroupSet(group, flags) == OK);
+	iNesting--;
+}
+
+void test_eventgroup_no_wait(void)
+{
+	BRTOS_EventGroup *group;
+	osflags_t result = 0;
+
+	TEST_ASSERT(OSEventGroupCreate(FLAG_A, &group) == ALLOC_EVENT_OK);
+
+	/* Wait any and wait all, without blocking */
+	TEST_ASSERT(OSEventGroupWait(group, FLAG_A | FLAG_B, OS_FLAGS_WAIT_ANY, &result, NO_TIMEOUT) == OK);
+	TEST_ASSERT(result == FLAG_A);
+	TEST_ASSERT(OSEventGroupWait(group, FLAG_A | FLAG_B, OS_FLAGS_WAIT_ALL, &result, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+
+	TEST_ASSERT(OSEventGroupSet(group, FLAG_B | FLAG_C) == OK);
+	TEST_ASSERT(OSEventGroupGet(group) == (FLAG_A | FLAG_B | FLAG_C));
+
+	/* Only the waited flags are cleared on exit */
+	TEST_ASSERT(OSEventGroupWait(group, FLAG_A | FLAG_B, OS_FLAGS_WAIT_ALL | OS_FLAGS_CLEAR_ON_EXIT, &result, NO_TIMEOUT) == OK);
+	TEST_ASSERT(result == (FLAG_A | FLAG_B | FLAG_C));
+	TEST_ASSERT(OSEventGroupGet(group) == FLAG_C);
+
+	TEST_ASSERT(OSEventGroupClear(group, FLAG_C) == OK);
+	TEST_ASSERT(OSEventGroupWait(group, FLAG_C, OS_FLAGS_WAIT_ANY, NULL, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+	TEST_ASSERT(OSEventGroupWait(group, 0, OS_FLAGS_WAIT_ANY, NULL, NO_TIMEOUT) == INVALID_PARAMETERS);
+
+	TEST_ASSERT(OSEventGroupDelete(&group) == DELETE_EVENT_OK);
+	TEST_ASSERT(group == NULL);
+}
+
+void test_eventgroup_broadcast(void)
+{
+	BRTOS_EventGroup *group;
+	BRTOS_TH task_any, task_all, task_other, task_high;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task_any = test_install(2);
+	task_all = test_install(3);
+	task_other = test_install(4);
+	task_high = test_install(5);
+
+	TEST_ASSERT(OSEventGroupCreate(0, &group) == ALLOC_EVENT_OK);
+
+	test_wait(group, task_any, FLAG_A | FLAG_B, OS_FLAGS_WAIT_ANY);
+	test_wait(group, task_all, FLAG_A | FLAG_B, OS_FLAGS_WAIT_ALL);
+	test_wait(group, task_other, FLAG_C, OS_FLAGS_WAIT_ANY);
+	test_wait(group, task_high, FLAG_A, OS_FLAGS_WAIT_ANY | OS_FLAGS_CLEAR_ON_EXIT);
+
+	/* One set wakes up every task whose condition is satisfied */
+	test_isr_set(group, FLAG_A);
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_high]));
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_any]));
+	TEST_ASSERT(!OSIsTaskReady(&ContextTask[task_all]));
+	TEST_ASSERT(!OSIsTaskReady(&ContextTask[task_other]));
+	TEST_ASSERT(group->OSEventWait == 2);
+
+	/* Both tasks see the flags before the clear on exit */
+	TEST_ASSERT(ContextTask[task_high].WaitFlags == FLAG_A);
+	TEST_ASSERT(ContextTask[task_any].WaitFlags == FLAG_A);
+	TEST_ASSERT(OSEventGroupGet(group) == 0);
+
+	/* Wait all */
+	test_isr_set(group, FLAG_B);
+	TEST_ASSERT(!OSIsTaskReady(&ContextTask[task_all]));
+	test_isr_set(group, FLAG_A);
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_all]));
+	TEST_ASSERT(ContextTask[task_all].WaitFlags == (FLAG_A | FLAG_B));
+
+	/* The event group keeps the wait list of the remaining task */
+	TEST_ASSERT(OSEventWaitListHas(&group->OSEventWaitList, group, &ContextTask[task_other]));
+	TEST_ASSERT(OSPrioHighest(group->OSEventWaitList) == 4);
+	test_isr_set(group, FLAG_C);
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_other]));
+	TEST_ASSERT(OSPrioIsEmpty(group->OSEventWaitList));
+	TEST_ASSERT(group->OSEventWait == 0);
+
+	TEST_ASSERT(OSEventGroupDelete(&group) == DELETE_EVENT_OK);
+}
+#endif
+
+void eventgroup_test(void)
+{
+#if (BRTOS_EVENT_GROUP_EN == 1)
+	run_test(test_eventgroup_no_wait);
+	run_test(test_eventgroup_broadcast);
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
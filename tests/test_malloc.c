@@ -0,0 +1,312 @@
+/*
+ * test_malloc.c
+ *
+ * Tests of the dynamic memory heap (umm_malloc).
+ * The allocations, the resizes in place of umm_realloc and the fragmentation
+ * metrics are verified. The heap must not be in use by the kernel, so the tests
+ * must be called before any dynamic task or queue is created.
+ *
+ */
+
+#include "BRTOS.h"
+
+void malloc_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if ((BRTOS_DYNAMIC_QUEUE_ENABLED == 1) || (BRTOS_DYNAMIC_TASKS_ENABLED == 1))
+
+#define TEST_SIZE			64
+#define TEST_BLOCKS			8
+#define TEST_FIT_SIZE		(9 * TEST_SIZE)
+
+/* Fills a buffer with a pattern that depends on the seed */
+static void test_fill(uint8_t *data, int size, uint8_t seed)
+{
+	int i;
+
+	for(i = 0; i < size; i++)
+	{
+		data[i] = (uint8_t)(seed + i);
+	}
+}
+
+static int test_check(uint8_t *data, int size, uint8_t seed)
+{
+	int i;
+
+	for(i = 0; i < size; i++)
+	{
+		if (data[i] != (uint8_t)(seed + i)) return FALSE;
+	}
+
+	return TRUE;
+}
+
+void test_malloc_free(void)
+{
+	uint8_t *ptr[TEST_BLOCKS];
+	unsigned int free_size;
+	int i;
+
+	free_size = OSGetFreeHeapSize();
+	TEST_ASSERT(OSGetHeapFragmentation() == 0);
+	TEST_ASSERT(umm_malloc(0) == NULL);
+
+	for(i = 0; i < TEST_BLOCKS; i++)
+	{
+		ptr[i] = umm_malloc(TEST_SIZE);
+		TEST_ASSERT(ptr[i] != NULL);
+		test_fill(ptr[i], TEST_SIZE, (uint8_t)i);
+	}
+	TEST_ASSERT(OSGetFreeHeapSize() < free_size);
+	TEST_ASSERT(OSGetUsedHeapSize() >= (TEST_BLOCKS * TEST_SIZE));
+
+	/* Holes between the used blocks fragment the free memory */
+	for(i = 0; i < TEST_BLOCKS; i += 2)
+	{
+		umm_free(ptr[i]);
+	}
+	TEST_ASSERT(OSGetHeapFragmentation() > 0);
+	TEST_ASSERT(OSGetMaxFreeHeapBlock() < OSGetFreeHeapSize());
+
+	/* A block of the same size reuses a hole */
+	ptr[0] = umm_malloc(TEST_SIZE);
+	TEST_ASSERT(ptr[0] != NULL);
+	TEST_ASSERT(ptr[0] < ptr[TEST_BLOCKS - 1]);
+	test_fill(ptr[0], TEST_SIZE, 0);
+
+	for(i = 1; i < TEST_BLOCKS; i += 2)
+	{
+		TEST_ASSERT(test_check(ptr[i], TEST_SIZE, (uint8_t)i));
+		umm_free(ptr[i]);
+	}
+	umm_free(ptr[0]);
+
+	/* Every free block is merged again */
+	TEST_ASSERT(OSGetFreeHeapSize() == free_size);
+	TEST_ASSERT(OSGetMaxFreeHeapBlock() == free_size);
+	TEST_ASSERT(OSGetHeapFragmentation() == 0);
+}
+
+void test_malloc_exhaust(void)
+{
+	uint8_t *ptr[TEST_BLOCKS];
+	unsigned int free_size;
+	int i;
+
+	free_size = OSGetFreeHeapSize();
+	TEST_ASSERT(umm_malloc(free_size + 1) == NULL);
+	TEST_ASSERT(umm_malloc((size_t)-1) == NULL);
+
+	/* The largest free block can be allocated, less the block header and the */
+	/* allocation header of BRTOS_HEAP_ACCOUNTING_EN */
+	ptr[0] = umm_malloc(OSGetMaxFreeHeapBlock() - 2 * sizeof(uint32_t));
+	TEST_ASSERT(ptr[0] != NULL);
+	TEST_ASSERT(OSGetFreeHeapSize() == 0);
+	TEST_ASSERT(umm_malloc(1) == NULL);
+	umm_free(ptr[0]);
+
+	/* Allocates until the heap is full */
+	for(i = 0; i < TEST_BLOCKS; i++)
+	{
+		ptr[i] = umm_malloc(free_size / TEST_BLOCKS);
+		if (ptr[i] == NULL) break;
+	}
+	TEST_ASSERT(i > 0);
+	while(i > 0)
+	{
+		umm_free(ptr[--i]);
+	}
+	TEST_ASSERT(OSGetFreeHeapSize() == free_size);
+	TEST_ASSERT(OSGetHeapFragmentation() == 0);
+}
+
+void test_malloc_realloc(void)
+{
+	uint8_t *ptr, *next, *moved;
+	unsigned int free_size;
+
+	free_size = OSGetFreeHeapSize();
+
+	TEST_ASSERT(umm_realloc(NULL, 0) == NULL);
+	ptr = umm_realloc(NULL, TEST_SIZE);
+	TEST_ASSERT(ptr != NULL);
+	test_fill(ptr, TEST_SIZE, 0x10);
+
+	/* Grows into the free memory after the block */
+	next = umm_realloc(ptr, 4 * TEST_SIZE);
+	TEST_ASSERT(next == ptr);
+	TEST_ASSERT(test_check(ptr, TEST_SIZE, 0x10));
+
+	/* Shrinks in place, the memory after the block is released */
+	next = umm_realloc(ptr, TEST_SIZE);
+	TEST_ASSERT(next == ptr);
+	TEST_ASSERT(test_check(ptr, TEST_SIZE, 0x10));
+	TEST_ASSERT(OSGetHeapFragmentation() == 0);
+
+	/* A used block after it - the data is moved */
+	next = umm_malloc(TEST_SIZE);
+	TEST_ASSERT(next != NULL);
+	moved = umm_realloc(ptr, 2 * TEST_SIZE);
+	TEST_ASSERT(moved != NULL);
+	TEST_ASSERT(moved != ptr);
+	TEST_ASSERT(test_check(moved, TEST_SIZE, 0x10));
+
+	/* The old block is free again and grows in place up to the used block */
+	ptr = umm_malloc(TEST_SIZE / 2);
+	TEST_ASSERT(ptr != NULL);
+	TEST_ASSERT(umm_realloc(ptr, TEST_SIZE) == ptr);
+
+	/* A realloc that can not be done keeps the block */
+	TEST_ASSERT(umm_realloc(moved, free_size + 1) == NULL);
+	TEST_ASSERT(test_check(moved, TEST_SIZE, 0x10));
+
+	TEST_ASSERT(umm_realloc(moved, 0) == NULL);
+	umm_free(next);
+	umm_free(ptr);
+	TEST_ASSERT(OSGetFreeHeapSize() == free_size);
+	TEST_ASSERT(OSGetHeapFragmentation() == 0);
+}
+
+/* Two free blocks in the same free list: the smallest one that fits is taken */
+/* with UMM_BEST_FIT, otherwise the first block of the list */
+void test_malloc_fit(void)
+{
+	uint8_t *small, *large, *sep[2], *ptr;
+	unsigned int free_size;
+
+	free_size = OSGetFreeHeapSize();
+
+	small = umm_malloc(TEST_FIT_SIZE);
+	sep[0] = umm_malloc(1);
+	large = umm_malloc(TEST_FIT_SIZE + 8);
+	sep[1] = umm_malloc(1);
+	TEST_ASSERT((small != NULL) && (sep[0] != NULL) && (large != NULL) && (sep[1] != NULL));
+
+	/* The last freed block is the first of the list */
+	umm_free(small);
+	umm_free(large);
+
+	ptr = umm_malloc(TEST_FIT_SIZE);
+	#if defined UMM_BEST_FIT
+	TEST_ASSERT(ptr == small);
+	#else
+	TEST_ASSERT(ptr == large);
+	#endif
+
+	umm_free(ptr);
+	umm_free(sep[0]);
+	umm_free(sep[1]);
+	TEST_ASSERT(OSGetFreeHeapSize() == free_size);
+	TEST_ASSERT(OSGetHeapFragmentation() == 0);
+}
+
+#if (BRTOS_HEAP_ACCOUNTING_EN == 1)
+void test_malloc_accounting(void)
+{
+	OS_HEAP_TASK_STATS stats1, stats2;
+	uint8_t *ptr1, *ptr2;
+	uint32_t bytes1, bytes2, lost;
+	#if (BRTOS_HEAP_TRACE_SIZE > 0)
+	OS_HEAP_TRACE trace[4];
+
+	/* Discards the records of the previous tests */
+	while(OSHeapTraceRead(trace, 4, &lost) > 0){}
+	#endif
+
+	TEST_ASSERT(OSGetTaskHeapStats(1, &stats1) == OK);
+	TEST_ASSERT(OSGetTaskHeapStats(2, &stats2) == OK);
+	TEST_ASSERT(OSGetTaskHeapStats(NUMBER_OF_TASKS + 1, &stats1) == NOT_VALID_TASK);
+	bytes1 = stats1.bytes;
+	bytes2 = stats2.bytes;
+
+	/* The allocations are counted by the task that made them */
+	currentTask = 1;
+	ptr1 = umm_malloc(TEST_SIZE);
+	currentTask = 2;
+	ptr2 = umm_malloc(TEST_SIZE);
+	currentTask = 0;
+	TEST_ASSERT((ptr1 != NULL) && (ptr2 != NULL));
+
+	TEST_ASSERT(OSGetTaskHeapStats(1, &stats1) == OK);
+	TEST_ASSERT(stats1.bytes >= (bytes1 + TEST_SIZE));
+	TEST_ASSERT(stats1.blocks == 1);
+	TEST_ASSERT(stats1.peak_bytes >= stats1.bytes);
+
+	/* Freed by another task */
+	umm_free(ptr1);
+	TEST_ASSERT(OSGetTaskHeapStats(1, &stats1) == OK);
+	TEST_ASSERT(stats1.bytes == bytes1);
+	TEST_ASSERT(stats1.blocks == 0);
+	TEST_ASSERT(stats1.frees == 1);
+	TEST_ASSERT(stats1.peak_bytes >= (bytes1 + TEST_SIZE));
+
+	/* umm_realloc gives the allocation to the caller */
+	currentTask = 1;
+	ptr2 = umm_realloc(ptr2, 2 * TEST_SIZE);
+	currentTask = 0;
+	TEST_ASSERT(ptr2 != NULL);
+	TEST_ASSERT(OSGetTaskHeapStats(1, &stats1) == OK);
+	TEST_ASSERT(OSGetTaskHeapStats(2, &stats2) == OK);
+	TEST_ASSERT(stats1.blocks == 1);
+	TEST_ASSERT(stats2.blocks == 0);
+	TEST_ASSERT(stats2.bytes == bytes2);
+
+	umm_free(ptr2);
+	TEST_ASSERT(umm_malloc((size_t)-1) == NULL);
+
+	#if (BRTOS_HEAP_TRACE_SIZE > 0)
+	/* Allocations of the tasks 1 and 2, free, resize in place, free and failure */
+	TEST_ASSERT(OSHeapTraceRead(trace, 2, &lost) == 2);
+	TEST_ASSERT(lost == 0);
+	TEST_ASSERT((trace[0].type == OS_HEAP_TRACE_ALLOC) && (trace[0].task == 1));
+	TEST_ASSERT((trace[1].type == OS_HEAP_TRACE_ALLOC) && (trace[1].task == 2));
+	TEST_ASSERT(OSHeapTraceRead(trace, 4, NULL) == 4);
+	TEST_ASSERT((trace[0].type == OS_HEAP_TRACE_FREE) && (trace[0].task == 1));
+	TEST_ASSERT((trace[1].type == OS_HEAP_TRACE_FREE) && (trace[1].task == 2));
+	TEST_ASSERT((trace[2].type == OS_HEAP_TRACE_ALLOC) && (trace[2].task == 1));
+	TEST_ASSERT(trace[2].block == trace[1].block);
+	TEST_ASSERT(trace[2].blocks > trace[1].blocks);
+	TEST_ASSERT((trace[3].type == OS_HEAP_TRACE_FREE) && (trace[3].block == trace[2].block));
+	TEST_ASSERT(OSHeapTraceRead(trace, 4, &lost) == 1);
+	TEST_ASSERT((trace[0].type == OS_HEAP_TRACE_FAIL) && (trace[0].block == 0));
+	TEST_ASSERT(OSHeapTraceRead(trace, 4, &lost) == 0);
+	#else
+	(void)lost;
+	#endif
+}
+#endif
+#endif
+
+void malloc_test(void)
+{
+#if ((BRTOS_DYNAMIC_QUEUE_ENABLED == 1) || (BRTOS_DYNAMIC_TASKS_ENABLED == 1))
+	run_test(test_malloc_free);
+	run_test(test_malloc_exhaust);
+	run_test(test_malloc_realloc);
+	run_test(test_malloc_fit);
+	#if (BRTOS_HEAP_ACCOUNTING_EN == 1)
+	run_test(test_malloc_accounting);
+	#endif
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
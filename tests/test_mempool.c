@@ -0,0 +1,177 @@
+/*
+ * test_mempool.c
+ *
+ * Tests of the fixed block memory pools (BRTOS_MEMPOOL_EN == 1).
+ * The waiting tasks are placed into the wait list by the test and the blocks are
+ * released as done by an interrupt, so the tests run without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void mempool_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_MEMPOOL_EN == 1)
+
+#define TEST_BLOCK_SIZE		10
+#define TEST_BLOCKS			4
+
+static OS_MEMPOOL_STORAGE(test_memory, TEST_BLOCK_SIZE, TEST_BLOCKS);
+
+/* Does what OSMemPoolGet does before the context switch */
+static void test_wait(BRTOS_MemPool *pool, BRTOS_TH task)
+{
+	ContextType *Task = &ContextTask[task];
+
+	Task->WaitBlock = NULL;
+	pool->OSEventWait++;
+	OSEventWaitListInsert(&pool->OSEventWaitList, pool, Task);
+	OSReadyListRemove(Task);
+}
+
+/* Releases a block as done by an interrupt handler */
+static uint8_t test_isr_put(BRTOS_MemPool *pool, void *block)
+{
+	uint8_t status;
+
+	iNesting++;
+	status = OSMemPoolPut(pool, block);
+	iNesting--;
+
+	return status;
+}
+
+void test_mempool_get_put(void)
+{
+	BRTOS_MemPool *pool;
+	void *block[TEST_BLOCKS + 1];
+	uint8_t *start = (uint8_t*)test_memory;
+	int i, j;
+
+	TEST_ASSERT(OSMemPoolCreate(NULL, TEST_BLOCK_SIZE, TEST_BLOCKS, &pool) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSMemPoolCreate(test_memory, TEST_BLOCK_SIZE, TEST_BLOCKS, &pool) == ALLOC_EVENT_OK);
+	TEST_ASSERT((pool->OSBlockSize % sizeof(void*)) == 0);
+	TEST_ASSERT((pool->OSBlockSize * TEST_BLOCKS) == sizeof(test_memory));
+
+	/* Every block is inside the memory and the blocks do not overlap */
+	for(i = 0; i < TEST_BLOCKS; i++)
+	{
+		TEST_ASSERT(OSMemPoolGet(pool, &block[i], NO_TIMEOUT) == OK);
+		TEST_ASSERT(((uint8_t*)block[i] - start) % pool->OSBlockSize == 0);
+		TEST_ASSERT((uint8_t*)block[i] < (start + sizeof(test_memory)));
+		for(j = 0; j < i; j++)
+		{
+			TEST_ASSERT(block[i] != block[j]);
+		}
+	}
+	TEST_ASSERT(OSMemPoolGet(pool, &block[TEST_BLOCKS], NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+
+	/* Statistics */
+	TEST_ASSERT(pool->OSFreeBlocks == 0);
+	TEST_ASSERT(pool->OSMinFreeBlocks == 0);
+	TEST_ASSERT(pool->OSAllocFails == 1);
+
+	TEST_ASSERT(test_isr_put(pool, block[1]) == OK);
+	TEST_ASSERT(OSMemPoolPut(pool, block[2]) == OK);
+	TEST_ASSERT(pool->OSFreeBlocks == 2);
+
+	/* The last released block is the first to be reused */
+	iNesting++;
+	TEST_ASSERT(OSMemPoolGet(pool, &block[TEST_BLOCKS], NO_TIMEOUT) == OK);
+	#if (ERROR_CHECK == 1)
+	TEST_ASSERT(OSMemPoolGet(pool, &block[TEST_BLOCKS], 10) == IRQ_PEND_ERR);
+	#endif
+	iNesting--;
+	TEST_ASSERT(block[TEST_BLOCKS] == block[2]);
+	TEST_ASSERT(OSMemPoolPut(pool, block[2]) == OK);
+
+	#if (ERROR_CHECK == 1)
+	/* Blocks that do not belong to the pool */
+	TEST_ASSERT(OSMemPoolPut(pool, start + 1) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSMemPoolPut(pool, start + sizeof(test_memory)) == INVALID_PARAMETERS);
+	#endif
+
+	TEST_ASSERT(OSMemPoolPut(pool, block[0]) == OK);
+	TEST_ASSERT(OSMemPoolPut(pool, block[3]) == OK);
+	TEST_ASSERT(pool->OSFreeBlocks == TEST_BLOCKS);
+	TEST_ASSERT(OSMemPoolPut(pool, block[3]) == BUFFER_UNDERRUN);
+	TEST_ASSERT(pool->OSMinFreeBlocks == 0);
+
+	TEST_ASSERT(OSMemPoolDelete(&pool) == DELETE_EVENT_OK);
+	TEST_ASSERT(pool == NULL);
+}
+
+void test_mempool_handoff(void)
+{
+	BRTOS_MemPool *pool;
+	BRTOS_TH task_low, task_high;
+	void *block[TEST_BLOCKS];
+	int i;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task_low = test_install(2);
+	task_high = test_install(3);
+
+	TEST_ASSERT(OSMemPoolCreate(test_memory, TEST_BLOCK_SIZE, TEST_BLOCKS, &pool) == ALLOC_EVENT_OK);
+	for(i = 0; i < TEST_BLOCKS; i++)
+	{
+		TEST_ASSERT(OSMemPoolGet(pool, &block[i], NO_TIMEOUT) == OK);
+	}
+
+	test_wait(pool, task_low);
+	test_wait(pool, task_high);
+
+	/* The released block is given to the highest priority waiting task */
+	TEST_ASSERT(test_isr_put(pool, block[0]) == OK);
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_high]));
+	TEST_ASSERT(ContextTask[task_high].WaitBlock == block[0]);
+	TEST_ASSERT(!OSIsTaskReady(&ContextTask[task_low]));
+	TEST_ASSERT(pool->OSFreeBlocks == 0);
+	TEST_ASSERT(pool->OSEventWait == 1);
+
+	TEST_ASSERT(test_isr_put(pool, block[1]) == OK);
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_low]));
+	TEST_ASSERT(ContextTask[task_low].WaitBlock == block[1]);
+	TEST_ASSERT(OSPrioIsEmpty(pool->OSEventWaitList));
+
+	/* Without waiting tasks the block returns to the pool */
+	TEST_ASSERT(test_isr_put(pool, block[2]) == OK);
+	TEST_ASSERT(pool->OSFreeBlocks == 1);
+
+	TEST_ASSERT(OSMemPoolDelete(&pool) == DELETE_EVENT_OK);
+}
+#endif
+
+void mempool_test(void)
+{
+#if (BRTOS_MEMPOOL_EN == 1)
+	run_test(test_mempool_get_put);
+	run_test(test_mempool_handoff);
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
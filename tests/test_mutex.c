@@ -0,0 +1,124 @@
+/*
+ * test_mutex.c
+ *
+ * Tests of the mutex options (BRTOS_MUTEX_EN == 1).
+ * The tasks acquire the mutexes while currentTask is changed by the test and
+ * the waiting tasks are placed into the wait lists by the test, so the tests
+ * run without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void mutex_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_MUTEX_EN == 1)
+
+void test_mutex_recursive(void)
+{
+	BRTOS_Mutex *mutex;
+	BRTOS_TH task;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task = test_install(2);
+
+	/* Priority inheritance does not use a priority ceiling */
+	TEST_ASSERT(OSMutexCreateOptions(&mutex, 10, OS_MUTEX_INHERIT) == INVALID_PARAMETERS);
+	#if (BRTOS_ROUND_ROBIN_EN != 1)
+	TEST_ASSERT(OSMutexCreateOptions(&mutex, 0, OS_MUTEX_INHERIT) == INVALID_PARAMETERS);
+	#endif
+
+	TEST_ASSERT(OSMutexCreateOptions(&mutex, 0, OS_MUTEX_RECURSIVE) == ALLOC_EVENT_OK);
+
+	/* The task acquires the mutex twice */
+	currentTask = task;
+	TEST_ASSERT(OSMutexAcquire(mutex, NO_TIMEOUT) == OK);
+	TEST_ASSERT(OSMutexAcquire(mutex, NO_TIMEOUT) == OK);
+	TEST_ASSERT(mutex->OSEventNesting == 2);
+
+	/* and keeps it until the second release */
+	TEST_ASSERT(OSMutexRelease(mutex) == OK);
+	TEST_ASSERT(mutex->OSEventOwner == task);
+	TEST_ASSERT(mutex->OSEventState == BUSY_RESOURCE);
+	TEST_ASSERT(OSMutexRelease(mutex) == OK);
+	TEST_ASSERT(mutex->OSEventState == AVAILABLE_RESOURCE);
+	TEST_ASSERT(OSMutexRelease(mutex) == ERR_EVENT_OWNER);
+	currentTask = 0;
+
+	TEST_ASSERT(OSMutexDelete(&mutex) == DELETE_EVENT_OK);
+}
+
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+void test_mutex_wait_priority(void)
+{
+	BRTOS_Mutex *mutex;
+	BRTOS_TH task_low, task_high;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task_low = test_install(2);
+	task_high = test_install(4);
+
+	TEST_ASSERT(OSMutexCreateOptions(&mutex, 0, OS_MUTEX_INHERIT) == ALLOC_EVENT_OK);
+	TEST_ASSERT(ContextTask[task_low].InheritBase == EMPTY_PRIO);
+
+	/* Does what OSMutexAcquire does before the context switch */
+	mutex->OSEventWait = 2;
+	OSEventWaitListInsert(&mutex->OSEventWaitList, mutex, &ContextTask[task_low]);
+	OSReadyListRemove(&ContextTask[task_low]);
+	OSEventWaitListInsert(&mutex->OSEventWaitList, mutex, &ContextTask[task_high]);
+	OSReadyListRemove(&ContextTask[task_high]);
+
+	/* A waiting task that receives another priority keeps waiting with the new priority */
+	OSSetTaskPriority(task_low, 4);
+	TEST_ASSERT(!OSPrioIsSet(mutex->OSEventWaitList, 2));
+	TEST_ASSERT(OSPrioHighest(mutex->OSEventWaitList) == 4);
+	TEST_ASSERT(OSEventWaitListHas(&mutex->OSEventWaitList, mutex, &ContextTask[task_low]));
+	TEST_ASSERT(!OSIsTaskReady(&ContextTask[task_low]));
+
+	/* and keeps its arrival order */
+	TEST_ASSERT(OSEventWaitListSelect(&mutex->OSEventWaitList, mutex) == task_low);
+	TEST_ASSERT(OSEventWaitListSelect(&mutex->OSEventWaitList, mutex) == task_high);
+	TEST_ASSERT(OSPrioIsEmpty(mutex->OSEventWaitList));
+
+	mutex->OSEventWait = 0;
+	TEST_ASSERT(OSMutexDelete(&mutex) == DELETE_EVENT_OK);
+}
+#endif
+#endif
+
+void mutex_test(void)
+{
+#if (BRTOS_MUTEX_EN == 1)
+	run_test(test_mutex_recursive);
+	#if (BRTOS_ROUND_ROBIN_EN == 1)
+	run_test(test_mutex_wait_priority);
+	#endif
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
@@ -0,0 +1,144 @@
+/*
+ * test_notify.c
+ *
+ * Tests of the direct to task notifications (BRTOS_TASK_NOTIFY_EN == 1).
+ * A task is notified as done by an interrupt and the notification value is
+ * verified without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void notify_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_TASK_NOTIFY_EN == 1)
+
+/* Notifies the task as done by an interrupt handler */
+static uint8_t test_isr_notify(BRTOS_TH task, uint32_t value, uint8_t action)
+{
+	uint8_t status;
+
+	iNesting++;
+	status = OSTaskNotify(task, value, action);
+	iNesting--;
+
+	return status;
+}
+
+void test_notify_actions(void)
+{
+	BRTOS_TH task;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task = test_install(2);
+
+	TEST_ASSERT(ContextTask[task].NotifyValue == 0);
+	TEST_ASSERT(ContextTask[task].NotifyState == OS_NOTIFY_IDLE);
+
+	TEST_ASSERT(test_isr_notify(task, 0, OS_NOTIFY_INCREMENT) == OK);
+	TEST_ASSERT(OSTaskNotifyGive(task) == OK);
+	TEST_ASSERT(ContextTask[task].NotifyValue == 2);
+	TEST_ASSERT(ContextTask[task].NotifyState == OS_NOTIFY_PENDING);
+
+	TEST_ASSERT(test_isr_notify(task, 0x10, OS_NOTIFY_SET_BITS) == OK);
+	TEST_ASSERT(ContextTask[task].NotifyValue == 0x12);
+
+	/* The pending notification is kept */
+	TEST_ASSERT(test_isr_notify(task, 0x55, OS_NOTIFY_NO_OVERWRITE) == BUSY_RESOURCE);
+	TEST_ASSERT(ContextTask[task].NotifyValue == 0x12);
+	TEST_ASSERT(test_isr_notify(task, 0x55, OS_NOTIFY_OVERWRITE) == OK);
+	TEST_ASSERT(ContextTask[task].NotifyValue == 0x55);
+
+	TEST_ASSERT(test_isr_notify(task, 0xAA, OS_NOTIFY_NO_ACTION) == OK);
+	TEST_ASSERT(ContextTask[task].NotifyValue == 0x55);
+
+	#if (ERROR_CHECK == 1)
+	TEST_ASSERT(OSTaskNotify(0, 0, OS_NOTIFY_INCREMENT) == NOT_VALID_TASK);
+	#endif
+}
+
+void test_notify_wake(void)
+{
+	BRTOS_TH task;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task = test_install(2);
+
+	/* Does what OSTaskNotifyTake does before the context switch */
+	ContextTask[task].NotifyState = OS_NOTIFY_WAITING;
+	OSReadyListRemove(&ContextTask[task]);
+
+	TEST_ASSERT(test_isr_notify(task, 0, OS_NOTIFY_INCREMENT) == OK);
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task]));
+	TEST_ASSERT(ContextTask[task].NotifyState == OS_NOTIFY_PENDING);
+	TEST_ASSERT(OSSchedule() == task);
+}
+
+void test_notify_take(void)
+{
+	uint32_t value = 0;
+
+	/* The kernel runs the tests as task 0 */
+	ContextTask[currentTask].NotifyValue = 0;
+	ContextTask[currentTask].NotifyState = OS_NOTIFY_IDLE;
+	TEST_ASSERT(OSTaskNotifyTake(TRUE, &value, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+	TEST_ASSERT(OSTaskNotifyWait(0, 0, &value, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+
+	/* Counting semaphore */
+	ContextTask[currentTask].NotifyValue = 2;
+	TEST_ASSERT(OSTaskNotifyTake(FALSE, &value, NO_TIMEOUT) == OK);
+	TEST_ASSERT(value == 2);
+	TEST_ASSERT(OSTaskNotifyTake(FALSE, &value, NO_TIMEOUT) == OK);
+	TEST_ASSERT(OSTaskNotifyTake(FALSE, &value, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+
+	/* Binary semaphore */
+	ContextTask[currentTask].NotifyValue = 3;
+	TEST_ASSERT(OSTaskNotifyTake(TRUE, &value, NO_TIMEOUT) == OK);
+	TEST_ASSERT(value == 3);
+	TEST_ASSERT(ContextTask[currentTask].NotifyValue == 0);
+
+	/* Event bits, cleared on exit */
+	ContextTask[currentTask].NotifyValue = 0x0F;
+	ContextTask[currentTask].NotifyState = OS_NOTIFY_PENDING;
+	TEST_ASSERT(OSTaskNotifyWait(0, 0x03, &value, NO_TIMEOUT) == OK);
+	TEST_ASSERT(value == 0x0F);
+	TEST_ASSERT(ContextTask[currentTask].NotifyValue == 0x0C);
+	TEST_ASSERT(ContextTask[currentTask].NotifyState == OS_NOTIFY_IDLE);
+}
+#endif
+
+void notify_test(void)
+{
+#if (BRTOS_TASK_NOTIFY_EN == 1)
+	run_test(test_notify_actions);
+	run_test(test_notify_wake);
+	run_test(test_notify_take);
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
@@ -0,0 +1,148 @@
+/*
+ * test_pendcall.c
+ *
+ * Tests of the deferred function calls (BRTOS_PEND_CALL_EN == 1).
+ * The calls are made as done by an interrupt. The queue, the overflow counter and
+ * the wake up of the timer task are verified without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+#include "stimer.h"
+
+void pendcall_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if ((BRTOS_TMR_EN == 1) && (BRTOS_PEND_CALL_EN == 1))
+
+#define TEST_TIMER_PRIO		(uint8_t)5
+
+static void test_call(void *arg)
+{
+	(void)arg;
+}
+
+/* Installs the timer task, the task number is returned */
+static BRTOS_TH test_timer_init(void)
+{
+	BRTOS_TH task;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	OSTimerInit(TEST_STACK_SIZE, TEST_TIMER_PRIO);
+
+	for(task = 1; task <= NUMBER_OF_TASKS; task++)
+	{
+		if (ContextTask[task].Priority == TEST_TIMER_PRIO)
+		{
+			break;
+		}
+	}
+	TEST_ASSERT(task <= NUMBER_OF_TASKS);
+
+	return task;
+}
+
+/* Defers a call as done by an interrupt handler */
+static uint8_t test_isr_call(void *arg)
+{
+	uint8_t status;
+
+	iNesting++;
+	status = OSPendFunctionCall(test_call, arg);
+	iNesting--;
+
+	return status;
+}
+
+void test_pendcall_overflow(void)
+{
+	OS_PEND_CALL_STATS stats;
+	int i;
+
+	(void)test_timer_init();
+
+	TEST_ASSERT(OSPendFunctionCall(NULL, NULL) == NULL_EVENT_POINTER);
+
+	for(i = 0; i < BRTOS_PEND_CALL_QUEUE_SIZE; i++)
+	{
+		TEST_ASSERT(test_isr_call(NULL) == OK);
+	}
+
+	/* The queue is full, the calls are lost and counted */
+	TEST_ASSERT(test_isr_call(NULL) == BUFFER_UNDERRUN);
+	TEST_ASSERT(test_isr_call(NULL) == BUFFER_UNDERRUN);
+
+	OSPendFunctionCallStats(&stats, TRUE);
+	TEST_ASSERT(stats.calls == 0);
+	TEST_ASSERT(stats.overflows == 2);
+	TEST_ASSERT(stats.pending == BRTOS_PEND_CALL_QUEUE_SIZE);
+	TEST_ASSERT(stats.max_pending == BRTOS_PEND_CALL_QUEUE_SIZE);
+
+	/* The reset keeps the calls that are still pending */
+	OSPendFunctionCallStats(&stats, FALSE);
+	TEST_ASSERT(stats.overflows == 0);
+	TEST_ASSERT(stats.max_pending == BRTOS_PEND_CALL_QUEUE_SIZE);
+}
+
+void test_pendcall_wake(void)
+{
+	OS_PEND_CALL_STATS stats;
+	ContextType *Task;
+	BRTOS_TH task;
+
+	task = test_timer_init();
+	Task = &ContextTask[task];
+
+	/* Not sleeping - only queued */
+	TEST_ASSERT(test_isr_call(NULL) == OK);
+	TEST_ASSERT(OSIsTaskReady(Task));
+
+	/* Does what the timer task does before sleeping */
+	Task->TimeToWait = 100;
+	IncludeTaskIntoDelayList();
+	OSReadyListRemove(Task);
+
+	TEST_ASSERT(test_isr_call(NULL) == OK);
+	TEST_ASSERT(OSIsTaskReady(Task));
+	TEST_ASSERT(Task->TimeToWait == EXIT_BY_TIMEOUT);
+	TEST_ASSERT(Head == NULL);
+	TEST_ASSERT(OSSchedule() == task);
+
+	OSPendFunctionCallStats(&stats, FALSE);
+	TEST_ASSERT(stats.pending == 2);
+	TEST_ASSERT(stats.overflows == 0);
+}
+#endif
+
+void pendcall_test(void)
+{
+#if ((BRTOS_TMR_EN == 1) && (BRTOS_PEND_CALL_EN == 1))
+	run_test(test_pendcall_overflow);
+	run_test(test_pendcall_wake);
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
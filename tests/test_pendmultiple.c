@@ -0,0 +1,177 @@
+/*
+ * test_pendmultiple.c
+ *
+ * Tests of the wait for multiple events (BRTOS_PEND_MULTIPLE_EN == 1).
+ * Uses a semaphore, a mailbox and a queue. The waiting task is placed into the
+ * wait lists by the test and the events are posted as done by an interrupt,
+ * so the tests run without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void pendmultiple_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if ((BRTOS_PEND_MULTIPLE_EN == 1) && (BRTOS_SEM_EN == 1) && (BRTOS_MBOX_EN == 1) && (BRTOS_QUEUE_EN == 1))
+
+static BRTOS_Sem *test_sem;
+static BRTOS_Mbox *test_mbox;
+static BRTOS_Queue *test_queue;
+static void *test_message;
+static uint8_t test_entry;
+static OS_PEND_EVENT test_events[3];
+
+static void test_create(void)
+{
+	static uint8_t created = FALSE;
+
+	if (!created)
+	{
+		TEST_ASSERT(OSSemCreate(0, &test_sem) == ALLOC_EVENT_OK);
+		TEST_ASSERT(OSMboxCreate(&test_mbox, NULL) == ALLOC_EVENT_OK);
+		TEST_ASSERT(OSQueueCreate(4, &test_queue) == ALLOC_EVENT_OK);
+		created = TRUE;
+	}
+
+	test_events[0].OSPendEvent = test_sem;
+	test_events[0].OSPendType  = OS_PEND_SEM;
+	test_events[0].OSPendData  = NULL;
+	test_events[1].OSPendEvent = test_mbox;
+	test_events[1].OSPendType  = OS_PEND_MBOX;
+	test_events[1].OSPendData  = &test_message;
+	test_events[2].OSPendEvent = test_queue;
+	test_events[2].OSPendType  = OS_PEND_QUEUE;
+	test_events[2].OSPendData  = &test_entry;
+}
+
+/* Does what OSPendMultiple does before the context switch */
+static void test_wait(BRTOS_TH task)
+{
+	ContextType *Task = &ContextTask[task];
+
+	test_sem->OSEventWait++;
+	OSEventWaitListInsert(&test_sem->OSEventWaitList, test_sem, Task);
+	test_mbox->OSEventWait++;
+	OSEventWaitListInsert(&test_mbox->OSEventWaitList, test_mbox, Task);
+	test_queue->OSEventWait++;
+	OSEventWaitListInsert(&test_queue->OSEventWaitList, test_queue, Task);
+	#if (BRTOS_ROUND_ROBIN_EN == 1)
+	Task->WaitEvent = NULL;
+	#endif
+	Task->WaitMultiple = test_events;
+	Task->WaitMultipleCount = 3;
+	OSReadyListRemove(Task);
+}
+
+void test_pendmultiple_available(void)
+{
+	uint8_t index = 0xFF;
+	int dummy;
+
+	test_create();
+
+	TEST_ASSERT(OSPendMultiple(test_events, 3, &index, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+	TEST_ASSERT(OSPendMultiple(test_events, 0, &index, NO_TIMEOUT) == INVALID_PARAMETERS);
+
+	/* The first available event of the array is received */
+	TEST_ASSERT(OSQueuePost(test_queue, 0x5A) == WRITE_BUFFER_OK);
+	TEST_ASSERT(OSMboxPost(test_mbox, &dummy) == OK);
+	TEST_ASSERT(OSPendMultiple(test_events, 3, &index, NO_TIMEOUT) == OK);
+	TEST_ASSERT(index == 1);
+	TEST_ASSERT(test_message == &dummy);
+	TEST_ASSERT(OSPendMultiple(test_events, 3, &index, NO_TIMEOUT) == OK);
+	TEST_ASSERT(index == 2);
+	TEST_ASSERT(test_entry == 0x5A);
+
+	TEST_ASSERT(OSSemPost(test_sem) == OK);
+	TEST_ASSERT(OSPendMultiple(test_events, 3, &index, NO_TIMEOUT) == OK);
+	TEST_ASSERT(index == 0);
+	TEST_ASSERT(OSPendMultiple(test_events, 3, &index, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+
+	#if (ERROR_CHECK == 1)
+	/* An event can not be repeated */
+	test_events[2] = test_events[0];
+	TEST_ASSERT(OSPendMultiple(test_events, 3, &index, NO_TIMEOUT) == INVALID_PARAMETERS);
+	#endif
+}
+
+void test_pendmultiple_post(void)
+{
+	BRTOS_TH task_low, task_high;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task_low = test_install(2);
+	task_high = test_install(3);
+	test_create();
+
+	test_wait(task_low);
+	test_wait(task_high);
+	TEST_ASSERT(test_queue->OSEventWait == 2);
+
+	/* The post selects the highest priority task, which leaves every wait list */
+	iNesting++;
+	TEST_ASSERT(OSQueuePost(test_queue, 0x33) == WRITE_BUFFER_OK);
+	iNesting--;
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_high]));
+	TEST_ASSERT(ContextTask[task_high].WaitMultiple == NULL);
+	TEST_ASSERT(ContextTask[task_high].WaitMultipleIndex == 2);
+	TEST_ASSERT(!OSEventWaitListHas(&test_sem->OSEventWaitList, test_sem, &ContextTask[task_high]));
+	TEST_ASSERT(!OSEventWaitListHas(&test_mbox->OSEventWaitList, test_mbox, &ContextTask[task_high]));
+	TEST_ASSERT(test_sem->OSEventWait == 1);
+	TEST_ASSERT(test_mbox->OSEventWait == 1);
+	TEST_ASSERT(test_queue->OSEventWait == 1);
+
+	/* The other task keeps waiting for the three events */
+	TEST_ASSERT(!OSIsTaskReady(&ContextTask[task_low]));
+	TEST_ASSERT(OSPrioHighest(test_sem->OSEventWaitList) == 2);
+	TEST_ASSERT(OSPrioHighest(test_mbox->OSEventWaitList) == 2);
+	TEST_ASSERT(OSPrioHighest(test_queue->OSEventWaitList) == 2);
+
+	iNesting++;
+	TEST_ASSERT(OSSemPost(test_sem) == OK);
+	iNesting--;
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_low]));
+	TEST_ASSERT(ContextTask[task_low].WaitMultipleIndex == 0);
+	TEST_ASSERT(OSPrioIsEmpty(test_mbox->OSEventWaitList));
+	TEST_ASSERT(OSPrioIsEmpty(test_queue->OSEventWaitList));
+	TEST_ASSERT(test_mbox->OSEventWait == 0);
+	TEST_ASSERT(test_queue->OSEventWait == 0);
+
+	/* The semaphore was given to the task */
+	TEST_ASSERT(test_sem->OSEventCount == 0);
+}
+#endif
+
+void pendmultiple_test(void)
+{
+#if ((BRTOS_PEND_MULTIPLE_EN == 1) && (BRTOS_SEM_EN == 1) && (BRTOS_MBOX_EN == 1) && (BRTOS_QUEUE_EN == 1))
+	run_test(test_pendmultiple_available);
+	run_test(test_pendmultiple_post);
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
@@ -0,0 +1,129 @@
+/*
+ * test_priority.c
+ *
+ * Tests of the priority lists (ready list, blocked list and event wait lists).
+ * With NUMBER_OF_PRIORITIES above 32 the two level bitmap is used.
+ * The lists are verified without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void priority_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+/* One priority of each end of the list and one in the middle */
+#define TEST_PRIO_LOW		(uint8_t)1
+#define TEST_PRIO_MID		(uint8_t)(configMAX_TASK_PRIORITY / 2)
+#define TEST_PRIO_HIGH		(uint8_t)configMAX_TASK_PRIORITY
+
+void test_priority_list(void)
+{
+	PriorityType list;
+
+	OSPrioReset(list);
+	TEST_ASSERT(OSPrioIsEmpty(list));
+
+	OSPrioSet(list, TEST_PRIO_LOW);
+	OSPrioSet(list, TEST_PRIO_HIGH);
+	OSPrioSet(list, TEST_PRIO_MID);
+	TEST_ASSERT(OSPrioHighest(list) == TEST_PRIO_HIGH);
+
+	OSPrioClear(list, TEST_PRIO_HIGH);
+	TEST_ASSERT(!OSPrioIsSet(list, TEST_PRIO_HIGH));
+	TEST_ASSERT(OSPrioHighest(list) == TEST_PRIO_MID);
+
+	/* Clearing a priority that is not in the list */
+	OSPrioClear(list, TEST_PRIO_HIGH);
+	TEST_ASSERT(OSPrioHighest(list) == TEST_PRIO_MID);
+
+	OSPrioClear(list, TEST_PRIO_MID);
+	TEST_ASSERT(OSPrioHighest(list) == TEST_PRIO_LOW);
+
+	OSPrioClear(list, TEST_PRIO_LOW);
+	TEST_ASSERT(OSPrioIsEmpty(list));
+}
+
+void test_priority_schedule(void)
+{
+	BRTOS_TH task_low, task_mid, task_high;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task_low = test_install(TEST_PRIO_LOW);
+	task_mid = test_install(TEST_PRIO_MID);
+	task_high = test_install(TEST_PRIO_HIGH);
+
+	TEST_ASSERT(OSSchedule() == task_high);
+
+	/* A blocked task is skipped, even if it is the only one of its group */
+	OSBlockedListInsert(&ContextTask[task_high]);
+	TEST_ASSERT(OSSchedule() == task_mid);
+	OSReadyListRemove(&ContextTask[task_mid]);
+	TEST_ASSERT(OSSchedule() == task_low);
+
+	OSBlockedListRemove(&ContextTask[task_high]);
+	TEST_ASSERT(OSSchedule() == task_high);
+
+	/* As done by the mutex priority ceiling */
+	OSSetTaskPriority(task_low, (uint8_t)(TEST_PRIO_HIGH - 1));
+	OSReadyListRemove(&ContextTask[task_high]);
+	TEST_ASSERT(OSSchedule() == task_low);
+}
+
+void test_priority_event_wait_list(void)
+{
+	PriorityType wait_list;
+	uint8_t event = 0;
+	BRTOS_TH task_low, task_mid, task_high;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	OSPrioReset(wait_list);
+	task_low = test_install(TEST_PRIO_LOW);
+	task_mid = test_install(TEST_PRIO_MID);
+	task_high = test_install(TEST_PRIO_HIGH);
+
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_low]);
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_high]);
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_mid]);
+
+	/* Timeout of the highest priority task */
+	OSEventWaitListRemove(&wait_list, &event, &ContextTask[task_high]);
+	TEST_ASSERT(!OSEventWaitListHas(&wait_list, &event, &ContextTask[task_high]));
+
+	TEST_ASSERT(OSEventWaitListSelect(&wait_list, &event) == task_mid);
+	TEST_ASSERT(OSEventWaitListSelect(&wait_list, &event) == task_low);
+	TEST_ASSERT(OSPrioIsEmpty(wait_list));
+}
+
+void priority_test(void)
+{
+	run_test(test_priority_list);
+	run_test(test_priority_schedule);
+	run_test(test_priority_event_wait_list);
+
+	test_kernel_ready();
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
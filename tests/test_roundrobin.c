@@ -0,0 +1,207 @@
+/*
+ * test_roundrobin.c
+ *
+ * Tests of the tasks that share a priority (BRTOS_ROUND_ROBIN_EN == 1).
+ * The ready lists and the event wait lists are verified without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void roundrobin_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+
+/* Three tasks with priority 4 and one task with priority 5 */
+static BRTOS_TH task_a, task_b, task_c, task_high;
+
+static void test_reset(void)
+{
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task_a = test_install(4);
+	task_b = test_install(4);
+	task_c = test_install(4);
+	task_high = test_install(5);
+}
+
+void test_rr_install_same_priority(void)
+{
+	test_reset();
+
+	TEST_ASSERT(NumberOfInstalledTasks == 4);
+	TEST_ASSERT(ContextTask[task_c].Priority == 4);
+
+	/* The highest priority runs first */
+	TEST_ASSERT(OSSchedule() == task_high);
+
+	/* Then the tasks of the same priority, in the installation order */
+	OSReadyListRemove(&ContextTask[task_high]);
+	TEST_ASSERT(OSSchedule() == task_a);
+}
+
+void test_rr_ready_fifo(void)
+{
+	test_reset();
+	OSReadyListRemove(&ContextTask[task_high]);
+
+	/* A task that becomes ready again goes to the end of the list */
+	OSReadyListRemove(&ContextTask[task_a]);
+	TEST_ASSERT(OSSchedule() == task_b);
+	OSReadyListInsert(&ContextTask[task_a]);
+	TEST_ASSERT(OSSchedule() == task_b);
+
+	OSReadyListRemove(&ContextTask[task_b]);
+	TEST_ASSERT(OSSchedule() == task_c);
+	OSReadyListRemove(&ContextTask[task_c]);
+	TEST_ASSERT(OSSchedule() == task_a);
+
+	/* No task of the priority is ready */
+	OSReadyListRemove(&ContextTask[task_a]);
+	TEST_ASSERT(!OSPrioIsSet(OSReadyList, 4));
+}
+
+void test_rr_block(void)
+{
+	test_reset();
+	OSReadyListRemove(&ContextTask[task_high]);
+
+	OSBlockedListInsert(&ContextTask[task_a]);
+	TEST_ASSERT(OSSchedule() == task_b);
+	TEST_ASSERT(OSIsTaskBlocked(&ContextTask[task_a]));
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[task_a]));
+
+	/* A blocked task that becomes ready is only scheduled after being unblocked */
+	OSReadyListRemove(&ContextTask[task_a]);
+	OSReadyListInsert(&ContextTask[task_a]);
+	OSReadyListRemove(&ContextTask[task_b]);
+	OSReadyListRemove(&ContextTask[task_c]);
+	TEST_ASSERT(!OSPrioIsSet(OSReadyList, 4));
+
+	OSBlockedListRemove(&ContextTask[task_a]);
+	TEST_ASSERT(OSSchedule() == task_a);
+}
+
+void test_rr_event_wait_list(void)
+{
+	PriorityType wait_list;
+	uint8_t event = 0;
+	uint8_t other_event = 0;
+
+	OSPrioReset(wait_list);
+	test_reset();
+
+	/* Arrival order: c, a, high - b waits for another event */
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_c]);
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_a]);
+	OSEventWaitListInsert(&wait_list, &other_event, &ContextTask[task_b]);
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_high]);
+
+	/* Highest priority first, then the arrival order */
+	TEST_ASSERT(OSEventWaitListSelect(&wait_list, &event) == task_high);
+	TEST_ASSERT(!OSPrioIsSet(wait_list, 5));
+	TEST_ASSERT(OSEventWaitListSelect(&wait_list, &event) == task_c);
+	TEST_ASSERT(!OSEventWaitListHas(&wait_list, &event, &ContextTask[task_c]));
+	TEST_ASSERT(OSEventWaitListHas(&wait_list, &event, &ContextTask[task_a]));
+	TEST_ASSERT(OSEventWaitListSelect(&wait_list, &event) == task_a);
+}
+
+void test_rr_event_timeout(void)
+{
+	PriorityType wait_list;
+	uint8_t event = 0;
+
+	OSPrioReset(wait_list);
+	test_reset();
+
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_a]);
+	OSEventWaitListInsert(&wait_list, &event, &ContextTask[task_b]);
+
+	/* The priority stays in the wait list while another task of the priority waits */
+	OSEventWaitListRemove(&wait_list, &event, &ContextTask[task_a]);
+	TEST_ASSERT(OSPrioIsSet(wait_list, 4));
+	TEST_ASSERT(!OSEventWaitListHas(&wait_list, &event, &ContextTask[task_a]));
+
+	OSEventWaitListRemove(&wait_list, &event, &ContextTask[task_b]);
+	TEST_ASSERT(OSPrioIsEmpty(wait_list));
+}
+
+void test_rr_change_priority(void)
+{
+	test_reset();
+	OSReadyListRemove(&ContextTask[task_high]);
+
+	/* As done by the mutex priority ceiling */
+	OSSetTaskPriority(task_b, 6);
+	TEST_ASSERT(OSSchedule() == task_b);
+	TEST_ASSERT(PriorityVector[6] == task_b);
+
+	OSSetTaskPriority(task_b, 4);
+	TEST_ASSERT(PriorityVector[6] == EMPTY_PRIO);
+	TEST_ASSERT(OSSchedule() == task_a);
+
+	/* task_b is now the last task of priority 4 */
+	OSReadyListRemove(&ContextTask[task_a]);
+	OSReadyListRemove(&ContextTask[task_c]);
+	TEST_ASSERT(OSSchedule() == task_b);
+}
+
+#if (BRTOS_MUTEX_EN == 1)
+void test_rr_mutex_ceiling(void)
+{
+	BRTOS_Mutex *mutex;
+
+	test_reset();
+
+	/* The priority of a task can not be the priority ceiling of a mutex */
+	TEST_ASSERT(OSMutexCreate(&mutex, 4) == BUSY_PRIORITY);
+	TEST_ASSERT(OSMutexCreate(&mutex, 7) == ALLOC_EVENT_OK);
+	#if (TASK_WITH_PARAMETERS == 1)
+	TEST_ASSERT(OSInstallTask(test_task, "rr test", TEST_STACK_SIZE, 7, NULL, NULL) == BUSY_PRIORITY);
+	#else
+	TEST_ASSERT(OSInstallTask(test_task, "rr test", TEST_STACK_SIZE, 7, NULL) == BUSY_PRIORITY);
+	#endif
+	TEST_ASSERT(OSMutexDelete(&mutex) == DELETE_EVENT_OK);
+}
+#endif
+#endif
+
+void roundrobin_test(void)
+{
+#if (BRTOS_ROUND_ROBIN_EN == 1)
+	run_test(test_rr_install_same_priority);
+	run_test(test_rr_ready_fifo);
+	run_test(test_rr_block);
+	run_test(test_rr_event_wait_list);
+	run_test(test_rr_event_timeout);
+	run_test(test_rr_change_priority);
+	#if (BRTOS_MUTEX_EN == 1)
+	run_test(test_rr_mutex_ceiling);
+	#endif
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
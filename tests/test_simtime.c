@@ -0,0 +1,679 @@
+/*
+ * test_simtime.c
+ *
+ * Deterministic tests of the kernel timeouts in simulated time (OS_CPU_SIMULATED_TIME == 1
+ * of the POSIX port). There is no tick timer: the ticks are run by the idle task when
+ * every task waits, so each wait of the tests ends at an exact tick and hours of ticks
+ * run in a fraction of a second (immediately with TICKLESS).
+ *
+ * Extends the scenarios of test_stimer.c, which run in real time:
+ *  - exact timeouts of the semaphore, queue, mailbox and mutex pends, with the wait
+ *    lists and the delay list verified after each timeout;
+ *  - a post or a release in the same tick of the timeout (EXIT_BY_TIMEOUT races),
+ *    where the post must be received or kept, never lost;
+ *  - timeouts across the overflow of the tick counter (TICK_COUNT_OVERFLOW);
+ *  - SIM_UPTIME_TICKS ticks of delays and periodic timers without any drift;
+ *  - the preemption by a task made ready while the driver held a priority ceiling.
+ *
+ * simtime_test installs the test tasks and the timer task and starts the scheduler.
+ * Needs 4 semaphores, 1 queue, 1 mailbox, 2 mutexes (1 without BRTOS_ROUND_ROBIN_EN),
+ * 2 soft timers and the priorities SIM_PRIORITY - 5, SIM_PRIORITY, SIM_PRIORITY + 1,
+ * SIM_PRIORITY + 2 and SIM_PRIORITY + 3 (the priority ceiling).
+ *
+ */
+
+#include "BRTOS.h"
+#include "stimer.h"
+
+void simtime_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (OS_CPU_SIMULATED_TIME == 1)
+
+/* Called after the tests */
+#ifndef SIM_DONE
+#if (PROCESSOR == X86)
+#define SIM_DONE()					exit(0)
+#else
+#define SIM_DONE()
+#endif
+#endif
+
+#ifndef SIM_PRIORITY
+#define SIM_PRIORITY				10
+#endif
+
+/* Ticks of the uptime test - one hour by default */
+#ifndef SIM_UPTIME_TICKS
+#define SIM_UPTIME_TICKS			(3600UL * configTICK_RATE_HZ)
+#endif
+
+#ifndef SIM_STACK_SIZE
+#if (PROCESSOR == X86)
+#define SIM_STACK_SIZE				16384
+#else
+#define SIM_STACK_SIZE				(NUMBER_MIN_OF_STACKED_BYTES + 256)
+#endif
+#endif
+
+#define SIM_WORKER_PRIORITY			(SIM_PRIORITY - 5)
+#define SIM_PREEMPT_PRIORITY		(SIM_PRIORITY + 1)
+#define SIM_TIMER_PRIORITY			(SIM_PRIORITY + 2)
+#define SIM_CEILING_PRIORITY		(SIM_PRIORITY + 3)
+
+#define SIM_TIMEOUT					(ostick_t)10
+#define SIM_DELAY					(ostick_t)1000
+#define SIM_PERIOD					(ostick_t)100
+
+/* Operations run by the worker task */
+#define SIM_SEM						0
+#define SIM_QUEUE					1
+#define SIM_MBOX					2
+#define SIM_MUTEX					3
+#define SIM_OPERATIONS				4
+
+static BRTOS_Sem   *sim_start, *sim_finish, *sim_sem, *sim_preempt;
+static BRTOS_Queue *sim_queue;
+static BRTOS_Mbox  *sim_mbox;
+static BRTOS_Mutex *sim_mutex, *sim_ceiling;
+
+static BRTOS_TH sim_worker_task;
+static volatile uint8_t  sim_op;
+static volatile uint8_t  sim_result;
+static volatile uint8_t  sim_owner;
+static volatile uint8_t  sim_preempted;
+static volatile ostick_t sim_return_tick;
+static volatile uint32_t sim_periodic_count, sim_callback_count;
+static volatile ostick_t sim_periodic_last, sim_callback_last;
+
+static const char *sim_names[SIM_OPERATIONS] = {"semaphore", "queue", "mailbox", "mutex"};
+
+
+/* Ticks from one tick count to another, across the overflow */
+static ostick_t sim_elapsed(ostick_t from, ostick_t to)
+{
+	if (to < from)
+	{
+		return (ostick_t)(to + (TICK_COUNT_OVERFLOW - from));
+	}
+	return (ostick_t)(to - from);
+}
+
+/* Verifies if a task is in the delay list */
+static uint8_t sim_delayed(BRTOS_TH task)
+{
+	OS_SR_SAVE_VAR
+	ContextType *Task;
+	uint8_t found = FALSE;
+
+	OSEnterCritical();
+	for (Task = Head; Task != NULL; Task = Task->Next)
+	{
+		if (Task == &ContextTask[task])
+		{
+			found = TRUE;
+			break;
+		}
+	}
+	OSExitCritical();
+
+	return found;
+}
+
+/* Result of a pend that expired */
+static uint8_t sim_timeout_result(uint8_t op)
+{
+	return (op == SIM_MUTEX) ? EXIT_BY_NO_RESOURCE_AVAILABLE : TIMEOUT;
+}
+
+static uint8_t sim_wait_count(uint8_t op)
+{
+	switch(op)
+	{
+		case SIM_SEM:	return sim_sem->OSEventWait;
+		case SIM_QUEUE:	return sim_queue->OSEventWait;
+		case SIM_MBOX:	return sim_mbox->OSEventWait;
+		default:		return sim_mutex->OSEventWait;
+	}
+}
+
+/* Entries of the semaphore, queue or mailbox */
+static uint16_t sim_entries(uint8_t op)
+{
+	switch(op)
+	{
+		case SIM_SEM:	return sim_sem->OSEventCount;
+		case SIM_QUEUE:	return ((OS_QUEUE *)sim_queue->OSEventPointer)->OSQEntries;
+		default:		return (sim_mbox->OSEventState == AVAILABLE_MESSAGE) ? 1 : 0;
+	}
+}
+
+static void sim_post(uint8_t op)
+{
+	switch(op)
+	{
+		case SIM_SEM:	(void)OSSemPost(sim_sem); break;
+		case SIM_QUEUE:	(void)OSQueuePost(sim_queue, 0x55); break;
+		default:		(void)OSMboxPost(sim_mbox, (void *)&sim_op); break;
+	}
+}
+
+/* Takes the entry left by a post, without waiting */
+static void sim_drain(uint8_t op)
+{
+	uint8_t data;
+	void *message;
+
+	switch(op)
+	{
+		case SIM_SEM:	TEST_ASSERT(OSSemPend(sim_sem, NO_TIMEOUT) == OK); break;
+		case SIM_QUEUE:	TEST_ASSERT(OSQueuePend(sim_queue, &data, NO_TIMEOUT) == OK); break;
+		default:		TEST_ASSERT(OSMboxPend(sim_mbox, &message, NO_TIMEOUT) == OK); break;
+	}
+}
+
+
+/* The worker has a lower priority, it pends in the tick of the next wait of the driver */
+static ostick_t sim_worker_start(uint8_t op)
+{
+	sim_op = op;
+	sim_result = 0xFF;
+	sim_owner = FALSE;
+	(void)OSSemPost(sim_start);
+
+	return OSGetTickCount();
+}
+
+static void sim_worker_wait(void)
+{
+	TEST_ASSERT(OSSemPend(sim_finish, 0) == OK);
+}
+
+/* The worker was woken up: ready and out of the wait list and of the delay list */
+static void sim_check_lists(uint8_t op)
+{
+	TEST_ASSERT(OSIsTaskReady(&ContextTask[sim_worker_task]));
+	TEST_ASSERT(sim_wait_count(op) == 0);
+	TEST_ASSERT(sim_delayed(sim_worker_task) == FALSE);
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void sim_worker(void *parameters)
+#else
+static void sim_worker(void)
+#endif
+{
+	uint8_t data;
+	void *message;
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	for(;;)
+	{
+		(void)OSSemPend(sim_start, 0);
+
+		switch(sim_op)
+		{
+			case SIM_SEM:
+				sim_result = OSSemPend(sim_sem, SIM_TIMEOUT);
+				break;
+
+			case SIM_QUEUE:
+				sim_result = OSQueuePend(sim_queue, &data, SIM_TIMEOUT);
+				break;
+
+			case SIM_MBOX:
+				sim_result = OSMboxPend(sim_mbox, &message, SIM_TIMEOUT);
+				break;
+
+			default:
+				sim_result = OSMutexAcquire(sim_mutex, SIM_TIMEOUT);
+				sim_owner = (sim_mutex->OSEventOwner == currentTask);
+				if (sim_result == OK)
+				{
+					(void)OSMutexRelease(sim_mutex);
+				}
+				break;
+		}
+
+		sim_return_tick = OSGetTickCount();
+		(void)OSSemPost(sim_finish);
+	}
+}
+
+
+/* Each pend expires exactly SIM_TIMEOUT ticks after it started */
+void test_simtime_timeouts(void)
+{
+	ostick_t start;
+	uint8_t op;
+
+	for (op = 0; op < SIM_OPERATIONS; op++)
+	{
+		if (op == SIM_MUTEX)
+		{
+			TEST_ASSERT(OSMutexAcquire(sim_mutex, 0) == OK);
+		}
+
+		start = sim_worker_start(op);
+		sim_worker_wait();
+
+		TEST_ASSERT(sim_result == sim_timeout_result(op));
+		TEST_ASSERT(sim_elapsed(start, sim_return_tick) == SIM_TIMEOUT);
+		TEST_ASSERT(sim_owner == FALSE);
+		sim_check_lists(op);
+
+		if (op == SIM_MUTEX)
+		{
+			TEST_ASSERT(OSMutexRelease(sim_mutex) == OK);
+		}
+
+		PRINTF("  %s timeout at tick %u\r\n", sim_names[op], (unsigned int)sim_return_tick);
+	}
+}
+
+
+static volatile uint8_t sim_isr_op;
+
+static void sim_tick_and_post(void)
+{
+	TickTimer();
+	sim_post(sim_isr_op);
+}
+
+/* A post of an interrupt after the tick of the timeout is received or kept */
+void test_simtime_post_at_timeout(void)
+{
+	ostick_t start;
+	uint8_t op;
+
+	for (op = 0; op < SIM_MUTEX; op++)
+	{
+		start = sim_worker_start(op);
+		TEST_ASSERT(OSDelayTask(SIM_TIMEOUT - 1) == OK);
+		TEST_ASSERT(sim_elapsed(start, OSGetTickCount()) == (SIM_TIMEOUT - 1));
+		TEST_ASSERT(sim_wait_count(op) == 1);
+
+		/* The tick of the timeout and the post in the same interrupt */
+		sim_isr_op = op;
+		OS_CPU_Interrupt(sim_tick_and_post);
+		sim_worker_wait();
+
+		TEST_ASSERT(sim_elapsed(start, sim_return_tick) == SIM_TIMEOUT);
+		if (sim_result == OK)
+		{
+			TEST_ASSERT(sim_entries(op) == 0);
+		}
+		else
+		{
+			TEST_ASSERT(sim_result == TIMEOUT);
+			TEST_ASSERT(sim_entries(op) == 1);
+			sim_drain(op);
+		}
+		sim_check_lists(op);
+
+		PRINTF("  %s post at timeout: %s\r\n", sim_names[op], (sim_result == OK) ? "received" : "kept");
+	}
+}
+
+
+/* A mutex released in the tick of the timeout is taken by the worker or stays free */
+void test_simtime_release_at_timeout(void)
+{
+	ostick_t start;
+
+	TEST_ASSERT(OSMutexAcquire(sim_mutex, 0) == OK);
+	start = sim_worker_start(SIM_MUTEX);
+
+	/* Wakes up in the tick of the timeout of the worker, before the worker runs */
+	TEST_ASSERT(OSDelayTask(SIM_TIMEOUT) == OK);
+	TEST_ASSERT(sim_elapsed(start, OSGetTickCount()) == SIM_TIMEOUT);
+	TEST_ASSERT(OSMutexRelease(sim_mutex) == OK);
+	sim_worker_wait();
+
+	TEST_ASSERT(sim_elapsed(start, sim_return_tick) == SIM_TIMEOUT);
+	if (sim_result == OK)
+	{
+		TEST_ASSERT(sim_owner == TRUE);
+	}
+	else
+	{
+		TEST_ASSERT(sim_result == EXIT_BY_NO_RESOURCE_AVAILABLE);
+		TEST_ASSERT(sim_owner == FALSE);
+	}
+	sim_check_lists(SIM_MUTEX);
+
+	/* The mutex is free */
+	TEST_ASSERT(sim_mutex->OSEventState == AVAILABLE_RESOURCE);
+	TEST_ASSERT(OSMutexAcquire(sim_mutex, NO_TIMEOUT) == OK);
+	TEST_ASSERT(OSMutexRelease(sim_mutex) == OK);
+
+	PRINTF("  mutex release at timeout: %s\r\n", (sim_result == OK) ? "acquired" : "expired");
+}
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void sim_preempter(void *parameters)
+#else
+static void sim_preempter(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	for(;;)
+	{
+		(void)OSSemPend(sim_preempt, 0);
+		sim_preempted = TRUE;
+	}
+}
+
+/* A task made ready while the driver holds the priority ceiling runs right after the release */
+void test_simtime_ceiling_release(void)
+{
+	sim_preempted = FALSE;
+	TEST_ASSERT(OSMutexAcquire(sim_ceiling, 0) == OK);
+
+	/* Lower than the ceiling, higher than the driver */
+	TEST_ASSERT(OSSemPost(sim_preempt) == OK);
+	TEST_ASSERT(sim_preempted == FALSE);
+
+	TEST_ASSERT(OSMutexRelease(sim_ceiling) == OK);
+	TEST_ASSERT(sim_preempted == TRUE);
+}
+
+
+/* Timeouts and delays across the overflow of the tick counter */
+void test_simtime_overflow(void)
+{
+	ostick_t start, ticks;
+	uint8_t op;
+
+	/* Skipped where the overflow is too far without the tickless idle */
+	if ((sizeof_ostick_t > 2) && (TICKLESS == 0))
+	{
+		PRINTF("  skipped, ticks of %u bytes\r\n", (unsigned int)sizeof_ostick_t);
+		return;
+	}
+
+	for (op = 0; op < SIM_OPERATIONS; op++)
+	{
+		/* Starts 5 ticks before the overflow */
+		ticks = sim_elapsed(OSGetTickCount(), (ostick_t)(TICK_COUNT_OVERFLOW - 5));
+		if (ticks > 0)
+		{
+			TEST_ASSERT(OSDelayTask(ticks) == OK);
+		}
+		TEST_ASSERT(OSGetTickCount() == (ostick_t)(TICK_COUNT_OVERFLOW - 5));
+
+		if (op == SIM_MUTEX)
+		{
+			TEST_ASSERT(OSMutexAcquire(sim_mutex, 0) == OK);
+		}
+
+		start = sim_worker_start(op);
+		sim_worker_wait();
+
+		TEST_ASSERT(sim_result == sim_timeout_result(op));
+		TEST_ASSERT(sim_return_tick == (ostick_t)(SIM_TIMEOUT - 5));
+		TEST_ASSERT(sim_elapsed(start, sim_return_tick) == SIM_TIMEOUT);
+		sim_check_lists(op);
+
+		if (op == SIM_MUTEX)
+		{
+			TEST_ASSERT(OSMutexRelease(sim_mutex) == OK);
+		}
+	}
+
+	/* A delay that ends exactly at the overflow */
+	ticks = sim_elapsed(OSGetTickCount(), (ostick_t)(TICK_COUNT_OVERFLOW - 5));
+	TEST_ASSERT(OSDelayTask(ticks) == OK);
+	TEST_ASSERT(OSDelayTask(5) == OK);
+	TEST_ASSERT(OSGetTickCount() == 0);
+}
+
+
+/* Execution time of the task: ticks that pass while it runs */
+static void sim_run(ostick_t ticks)
+{
+	while (ticks-- > 0)
+	{
+		OS_CPU_Interrupt(TickTimer);
+	}
+}
+
+/* Periodic task without drift, whatever its execution time, and its overruns */
+void test_simtime_delay_until(void)
+{
+	ostick_t start, last_wake;
+	uint32_t i;
+
+	/* Across at least one overflow of 16 bit ticks */
+	start = OSGetTickCount();
+	last_wake = start;
+	for (i = 1; i <= 8000; i++)
+	{
+		sim_run((ostick_t)(i % SIM_TIMEOUT));
+		TEST_ASSERT(OSDelayUntil(&last_wake, SIM_TIMEOUT) == OK);
+		TEST_ASSERT(OSGetTickCount() == last_wake);
+		TEST_ASSERT(sim_elapsed(start, last_wake) == (ostick_t)((i * SIM_TIMEOUT) % TICK_COUNT_OVERFLOW));
+	}
+
+	/* An execution of 2.5 periods: the missed wake ups are skipped, the phase is kept */
+	start = last_wake;
+	sim_run((ostick_t)(SIM_TIMEOUT * 2 + SIM_TIMEOUT / 2));
+	TEST_ASSERT(OSDelayUntil(&last_wake, SIM_TIMEOUT) == DELAY_OVERRUN);
+	TEST_ASSERT(sim_elapsed(start, last_wake) == (ostick_t)(SIM_TIMEOUT * 2));
+	TEST_ASSERT(sim_elapsed(start, OSGetTickCount()) == (ostick_t)(SIM_TIMEOUT * 2 + SIM_TIMEOUT / 2));
+	TEST_ASSERT(OSDelayUntil(&last_wake, SIM_TIMEOUT) == OK);
+	TEST_ASSERT(sim_elapsed(start, OSGetTickCount()) == (ostick_t)(SIM_TIMEOUT * 3));
+
+	/* An execution of exactly one period does not wait */
+	sim_run(SIM_TIMEOUT);
+	TEST_ASSERT(OSDelayUntil(&last_wake, SIM_TIMEOUT) == DELAY_OVERRUN);
+	TEST_ASSERT(last_wake == OSGetTickCount());
+
+	/* The parts of a long delay do not accumulate errors */
+	start = OSGetTickCount();
+	TEST_ASSERT(OSDelayTaskHMSM(0, 1, 10, 0) == OK);
+	TEST_ASSERT(sim_elapsed(start, OSGetTickCount()) == (ostick_t)((70UL * configTICK_RATE_HZ) % TICK_COUNT_OVERFLOW));
+
+	TEST_ASSERT(OSDelayUntil(&last_wake, 0) == NO_TASK_DELAY);
+	TEST_ASSERT(OSDelayUntil(&last_wake, TICK_COUNT_OVERFLOW) == INVALID_TIME);
+}
+
+#if (BRTOS_TICK64_EN == 1)
+/* 64 bit tick count and delays longer than the overflow of the tick counter */
+void test_simtime_tick64(void)
+{
+	uint64_t start, last_wake;
+	ostick_t tick;
+
+	start = OSGetTickCount64();
+	tick = OSGetTickCount();
+	TEST_ASSERT((ostick_t)(start % TICK_COUNT_OVERFLOW) == tick);
+
+	/* Three overflows of the tick counter in one delay */
+	last_wake = start;
+	sim_run(7);
+	TEST_ASSERT(OSDelayUntil64(&last_wake, (uint64_t)TICK_COUNT_OVERFLOW * 3 + 1) == OK);
+	TEST_ASSERT(OSGetTickCount64() == (start + ((uint64_t)TICK_COUNT_OVERFLOW * 3) + 1));
+	TEST_ASSERT(last_wake == OSGetTickCount64());
+	TEST_ASSERT(OSGetTickCount() == (ostick_t)(last_wake % TICK_COUNT_OVERFLOW));
+
+	/* Overrun of the 64 bit delay */
+	start = last_wake;
+	sim_run(25);
+	TEST_ASSERT(OSDelayUntil64(&last_wake, 10) == DELAY_OVERRUN);
+	TEST_ASSERT(last_wake == (start + 20));
+	TEST_ASSERT(OSDelayUntil64(&last_wake, 10) == OK);
+	TEST_ASSERT(OSGetTickCount64() == (start + 30));
+
+	/* Long delays are not split by the application */
+	start = OSGetTickCount64();
+	TEST_ASSERT(OSDelayTaskHMSM(0, 1, 10, 0) == OK);
+	TEST_ASSERT(OSGetTickCount64() == (start + (70UL * configTICK_RATE_HZ)));
+
+	PRINTF("  %lu ticks of 64 bits\r\n", (unsigned long)OSGetTickCount64());
+}
+#endif
+
+
+#if (BRTOS_TMR_EN == 1)
+static TIMER_CNT sim_periodic_cb(void)
+{
+	ostick_t now = OSGetTickCount();
+
+	TEST_ASSERT(sim_elapsed(sim_periodic_last, now) == SIM_PERIOD);
+	sim_periodic_last = now;
+	sim_periodic_count++;
+
+	return 0;
+}
+
+static TIMER_CNT sim_callback_cb(void)
+{
+	ostick_t now = OSGetTickCount();
+
+	TEST_ASSERT(sim_elapsed(sim_callback_last, now) == SIM_PERIOD);
+	sim_callback_last = now;
+	sim_callback_count++;
+
+	return SIM_PERIOD;
+}
+
+/* Delays and soft timers without drift for SIM_UPTIME_TICKS ticks */
+void test_simtime_uptime(void)
+{
+	BRTOS_TIMER periodic, callback;
+	ostick_t last, now;
+	uint32_t i, loops = SIM_UPTIME_TICKS / SIM_DELAY;
+
+	sim_periodic_count = 0;
+	sim_callback_count = 0;
+	sim_periodic_last = OSGetTickCount();
+	sim_callback_last = sim_periodic_last;
+	TEST_ASSERT(OSTimerCreate(&periodic, sim_periodic_cb, SIM_PERIOD, TIMER_PERIODIC) == OK);
+	TEST_ASSERT(OSTimerSet(&callback, sim_callback_cb, SIM_PERIOD) == OK);
+
+	last = OSGetTickCount();
+	for (i = 0; i < loops; i++)
+	{
+		TEST_ASSERT(OSDelayTask(SIM_DELAY) == OK);
+		now = OSGetTickCount();
+		TEST_ASSERT(sim_elapsed(last, now) == SIM_DELAY);
+		last = now;
+
+		/* The timer task has a higher priority, the timers of this tick were run */
+		TEST_ASSERT(sim_periodic_count == ((i + 1) * (SIM_DELAY / SIM_PERIOD)));
+		TEST_ASSERT(sim_callback_count == sim_periodic_count);
+	}
+
+	(void)OSTimerStop(periodic, TRUE);
+	(void)OSTimerStop(callback, TRUE);
+
+	PRINTF("  %lu ticks, %lu timer expirations\r\n", (unsigned long)(loops * SIM_DELAY),
+		   (unsigned long)(sim_periodic_count + sim_callback_count));
+}
+#endif
+
+
+#if (TASK_WITH_PARAMETERS == 1)
+static void sim_driver(void *parameters)
+#else
+static void sim_driver(void)
+#endif
+{
+	#if (TASK_WITH_PARAMETERS == 1)
+	(void)parameters;
+	#endif
+
+	run_test(test_simtime_timeouts);
+	run_test(test_simtime_post_at_timeout);
+	run_test(test_simtime_release_at_timeout);
+	run_test(test_simtime_ceiling_release);
+	run_test(test_simtime_overflow);
+	run_test(test_simtime_delay_until);
+	#if (BRTOS_TICK64_EN == 1)
+	run_test(test_simtime_tick64);
+	#endif
+	#if (BRTOS_TMR_EN == 1)
+	run_test(test_simtime_uptime);
+	#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+
+	SIM_DONE();
+
+	for(;;)
+	{
+		(void)OSDelayTask(1000);
+	}
+}
+#endif
+
+
+void simtime_test(void)
+{
+#if (OS_CPU_SIMULATED_TIME == 1)
+	OS_CPU_TYPE handle = 0;
+
+	TEST_ASSERT(OSSemCreate(0, &sim_start) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSSemCreate(0, &sim_finish) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSSemCreate(0, &sim_sem) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSSemCreate(0, &sim_preempt) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSQueueCreate(8, &sim_queue) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSMboxCreate(&sim_mbox, NULL) == ALLOC_EVENT_OK);
+	#if (BRTOS_ROUND_ROBIN_EN == 1)
+	TEST_ASSERT(OSMutexCreateOptions(&sim_mutex, 0, OS_MUTEX_INHERIT) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSMutexCreate(&sim_ceiling, SIM_CEILING_PRIORITY) == ALLOC_EVENT_OK);
+	#else
+	TEST_ASSERT(OSMutexCreate(&sim_mutex, SIM_CEILING_PRIORITY) == ALLOC_EVENT_OK);
+	sim_ceiling = sim_mutex;
+	#endif
+
+	#if (BRTOS_TMR_EN == 1)
+	OSTimerInit(SIM_STACK_SIZE, SIM_TIMER_PRIORITY);
+	#endif
+
+	#if (TASK_WITH_PARAMETERS == 1)
+	TEST_ASSERT(OSInstallTask(sim_worker, "Sim worker", SIM_STACK_SIZE, SIM_WORKER_PRIORITY, NULL, &handle) == OK);
+	sim_worker_task = (BRTOS_TH)handle;
+	TEST_ASSERT(OSInstallTask(sim_driver, "Sim driver", SIM_STACK_SIZE, SIM_PRIORITY, NULL, NULL) == OK);
+	TEST_ASSERT(OSInstallTask(sim_preempter, "Sim preempter", SIM_STACK_SIZE, SIM_PREEMPT_PRIORITY, NULL, NULL) == OK);
+	#else
+	TEST_ASSERT(OSInstallTask(sim_worker, "Sim worker", SIM_STACK_SIZE, SIM_WORKER_PRIORITY, &handle) == OK);
+	sim_worker_task = (BRTOS_TH)handle;
+	TEST_ASSERT(OSInstallTask(sim_driver, "Sim driver", SIM_STACK_SIZE, SIM_PRIORITY, NULL) == OK);
+	TEST_ASSERT(OSInstallTask(sim_preempter, "Sim preempter", SIM_STACK_SIZE, SIM_PREEMPT_PRIORITY, NULL) == OK);
+	#endif
+
+	if (BRTOSStart() != OK) while(1){}
+#else
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+#endif
+}
@@ -0,0 +1,134 @@
+/*
+ * test_stack.c
+ *
+ * Tests of the task stack overflow detection (BRTOS_STACK_CHECK_EN == 1).
+ * The guard word of an installed task is overwritten and the check done at the
+ * context switch is called directly, so the tests run without starting the scheduler.
+ * The application must not define BRTOS_StackOverflowHook, it is defined here.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void stack_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_STACK_CHECK_EN == 1)
+
+static BRTOS_TH test_overflow_task;
+static int test_overflows;
+static BRTOS_TH task1, task2;
+
+void BRTOS_StackOverflowHook(BRTOS_TH task)
+{
+	test_overflow_task = task;
+	test_overflows++;
+}
+
+/* Does the check of the context switch with the task running */
+static void test_check(BRTOS_TH task)
+{
+	uint8_t running = currentTask;
+
+	currentTask = task;
+	OSStackCheck();
+	currentTask = running;
+}
+
+void test_stack_guard(void)
+{
+	uint32_t *guard;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task1 = test_install(2);
+	task2 = test_install(3);
+	test_overflows = 0;
+
+	/* The guard words are written by the installation and are not shared */
+	guard = ContextTask[task1].StackGuard;
+	TEST_ASSERT(guard != NULL);
+	TEST_ASSERT(*guard == BRTOS_STACK_CANARY);
+	TEST_ASSERT(ContextTask[task2].StackGuard != guard);
+	TEST_ASSERT(*ContextTask[task2].StackGuard == BRTOS_STACK_CANARY);
+
+	/* Without overflow the hook is not called */
+	test_check(task1);
+	test_check(task2);
+	TEST_ASSERT(test_overflows == 0);
+
+	/* The task that overwrote the guard is reported */
+	*guard = 0;
+	test_check(task2);
+	TEST_ASSERT(test_overflows == 0);
+	test_check(task1);
+	TEST_ASSERT(test_overflows == 1);
+	TEST_ASSERT(test_overflow_task == task1);
+
+	/* The guard is written again, only a new overflow is reported */
+	TEST_ASSERT(*guard == BRTOS_STACK_CANARY);
+	test_check(task1);
+	TEST_ASSERT(test_overflows == 1);
+
+	/* The installation of the kernel has no guard word */
+	test_check(0);
+	TEST_ASSERT(test_overflows == 1);
+}
+
+#if (BRTOS_DYNAMIC_TASKS_ENABLED == 1)
+void test_stack_uninstall(void)
+{
+	test_overflows = 0;
+
+	/* The stack of an uninstalled task is not verified */
+	*ContextTask[task1].StackGuard = 0;
+	TEST_ASSERT(OSUninstallTask(task1, TRUE) == OK);
+	TEST_ASSERT(ContextTask[task1].StackGuard == NULL);
+	test_check(task1);
+	TEST_ASSERT(test_overflows == 0);
+
+	/* A new task in the same slot has a new guard word */
+	TEST_ASSERT(test_install(2) == task1);
+	TEST_ASSERT(*ContextTask[task1].StackGuard == BRTOS_STACK_CANARY);
+	test_check(task1);
+	TEST_ASSERT(test_overflows == 0);
+
+	TEST_ASSERT(OSUninstallTask(task1, TRUE) == OK);
+	TEST_ASSERT(OSUninstallTask(task2, TRUE) == OK);
+}
+#endif
+#endif
+
+void stack_test(void)
+{
+#if (BRTOS_STACK_CHECK_EN == 1)
+	run_test(test_stack_guard);
+	#if (BRTOS_DYNAMIC_TASKS_ENABLED == 1)
+	run_test(test_stack_uninstall);
+	#endif
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
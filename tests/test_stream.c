@@ -0,0 +1,125 @@
+/*
+ * test_stream.c
+ *
+ * Tests of the single producer / single consumer streams (BRTOS_STREAM_EN == 1).
+ * Only the calls that do not block are used, so the tests run without starting the scheduler.
+ *
+ */
+
+#include "BRTOS.h"
+#include "stream.h"
+
+void stream_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_STREAM_EN == 1)
+
+#define TEST_STREAM_SIZE	16
+
+static BRTOS_Stream test_stream;
+static uint8_t test_buffer[TEST_STREAM_SIZE];
+static uint8_t test_in[TEST_STREAM_SIZE];
+static uint8_t test_out[TEST_STREAM_SIZE];
+
+void test_stream_write_read(void)
+{
+	uint16_t i, read;
+
+	TEST_ASSERT(OSStreamCreate(&test_stream, test_buffer, TEST_STREAM_SIZE) == ALLOC_EVENT_OK);
+
+	for (i = 0; i < TEST_STREAM_SIZE; i++)
+	{
+		test_in[i] = (uint8_t)i;
+	}
+
+	/* Nothing to read */
+	TEST_ASSERT(OSStreamRead(&test_stream, test_out, 1, 1, &read, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+	TEST_ASSERT(read == 0);
+
+	/* Up to TEST_STREAM_SIZE - 1 bytes are stored, and a write is never split */
+	TEST_ASSERT(OSStreamWrite(&test_stream, test_in, 10) == WRITE_BUFFER_OK);
+	TEST_ASSERT(OSStreamWrite(&test_stream, &test_in[10], 6) == BUFFER_UNDERRUN);
+	TEST_ASSERT(OSStreamWrite(&test_stream, &test_in[10], 5) == WRITE_BUFFER_OK);
+	TEST_ASSERT(OSStreamAvailable(&test_stream) == TEST_STREAM_SIZE - 1);
+
+	/* Less than min bytes - nothing is read */
+	TEST_ASSERT(OSStreamRead(&test_stream, test_out, 4, 4, &read, NO_TIMEOUT) == READ_BUFFER_OK);
+	TEST_ASSERT(read == 4);
+	TEST_ASSERT(OSStreamRead(&test_stream, &test_out[4], 12, 12, &read, NO_TIMEOUT) == EXIT_BY_NO_ENTRY_AVAILABLE);
+	TEST_ASSERT(OSStreamRead(&test_stream, &test_out[4], 1, 12, &read, NO_TIMEOUT) == READ_BUFFER_OK);
+	TEST_ASSERT(read == 11);
+
+	for (i = 0; i < TEST_STREAM_SIZE - 1; i++)
+	{
+		TEST_ASSERT(test_out[i] == (uint8_t)i);
+	}
+}
+
+void test_stream_wrap(void)
+{
+	uint16_t i, j, read;
+
+	TEST_ASSERT(OSStreamCreate(&test_stream, test_buffer, TEST_STREAM_SIZE) == ALLOC_EVENT_OK);
+
+	/* Writes and reads of 7 bytes cross the end of the buffer */
+	for (i = 0; i < 3 * TEST_STREAM_SIZE; i++)
+	{
+		for (j = 0; j < 7; j++)
+		{
+			test_in[j] = (uint8_t)(i + j);
+		}
+
+		TEST_ASSERT(OSStreamWrite(&test_stream, test_in, 7) == WRITE_BUFFER_OK);
+		TEST_ASSERT(OSStreamRead(&test_stream, test_out, 7, TEST_STREAM_SIZE, &read, NO_TIMEOUT) == READ_BUFFER_OK);
+		TEST_ASSERT(read == 7);
+
+		for (j = 0; j < 7; j++)
+		{
+			TEST_ASSERT(test_out[j] == (uint8_t)(i + j));
+		}
+	}
+
+	TEST_ASSERT(OSStreamAvailable(&test_stream) == 0);
+}
+
+void test_stream_parameters(void)
+{
+	uint16_t read;
+
+	TEST_ASSERT(OSStreamCreate(&test_stream, test_buffer, 1) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSStreamCreate(&test_stream, test_buffer, TEST_STREAM_SIZE) == ALLOC_EVENT_OK);
+
+	TEST_ASSERT(OSStreamRead(&test_stream, test_out, 0, 1, &read, NO_TIMEOUT) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSStreamRead(&test_stream, test_out, 2, 1, &read, NO_TIMEOUT) == INVALID_PARAMETERS);
+	TEST_ASSERT(OSStreamRead(&test_stream, test_out, TEST_STREAM_SIZE, TEST_STREAM_SIZE, &read, NO_TIMEOUT) == INVALID_PARAMETERS);
+}
+#endif
+
+void stream_test(void)
+{
+#if (BRTOS_STREAM_EN == 1)
+	run_test(test_stream_write_read);
+	run_test(test_stream_wrap);
+	run_test(test_stream_parameters);
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
@@ -0,0 +1,195 @@
+/*
+ * test_taskstats.c
+ *
+ * Tests of the per task scheduling statistics (BRTOS_TASK_STATS_EN == 1).
+ * The runtime counter is controlled by the tests and the switches of context are
+ * emulated by calling COMPUTE_TASK_LOAD, so the tests run without starting the scheduler.
+ * The application must not define OSGetTimerForRuntimeStats and
+ * OSConfigureTimerForRuntimeStats, they are defined here.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void taskstats_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (BRTOS_TASK_STATS_EN == 1)
+
+static uint32_t test_counter;
+static BRTOS_TH task1, task2;
+
+uint32_t OSGetTimerForRuntimeStats(void)
+{
+	return test_counter;
+}
+
+void OSConfigureTimerForRuntimeStats(void)
+{
+	test_counter = 0;
+}
+
+/* Switch of context at the given counter value, as done by OS_INT_EXIT */
+static void test_switch(uint32_t counter, BRTOS_TH task)
+{
+	test_counter = counter;
+	SelectedTask = task;
+	COMPUTE_TASK_LOAD();
+	currentTask = SelectedTask;
+}
+
+static OS_TASK_STATS test_stats(BRTOS_TH task)
+{
+	OS_TASK_STATS stats;
+
+	TEST_ASSERT(OSGetTaskStats(task, &stats) == OK);
+	return stats;
+}
+
+void test_taskstats_runtime(void)
+{
+	OS_TASK_STATS stats;
+
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	task1 = test_install(2);
+	task2 = test_install(3);
+
+	/* The installation is not a wake up */
+	currentTask = 0;
+	test_switch(1000, task2);
+	stats = test_stats(task2);
+	TEST_ASSERT(stats.switches == 1);
+	TEST_ASSERT(stats.wakeups == 0);
+	TEST_ASSERT(stats.runtime == 0);
+
+	/* A task switched out while ready is preempted */
+	test_switch(1100, task1);
+	stats = test_stats(task2);
+	TEST_ASSERT(stats.runtime == 100);
+	TEST_ASSERT(stats.preemptions == 1);
+	TEST_ASSERT(ContextTask[task2].Runtime == 100);
+
+	/* A task switched out while waiting is not preempted */
+	OSReadyListRemove(&ContextTask[task1]);
+	test_switch(1150, task2);
+	stats = test_stats(task1);
+	TEST_ASSERT(stats.runtime == 50);
+	TEST_ASSERT(stats.preemptions == 0);
+	TEST_ASSERT(stats.switches == 1);
+
+	/* The runtime is computed across an overflow of the counter */
+	OSReadyListInsert(&ContextTask[task1]);
+	test_switch(0xFFFFFFF0UL, task1);
+	test_switch(0x10UL, task2);
+	stats = test_stats(task1);
+	TEST_ASSERT(stats.runtime == (50 + 0x20));
+
+	/* The kernel installation and the invalid tasks have no statistics */
+	TEST_ASSERT(OSGetTaskStats(0, &stats) == NOT_VALID_TASK);
+	TEST_ASSERT(OSGetTaskStats(NUMBER_OF_TASKS + 1, &stats) == NOT_VALID_TASK);
+}
+
+void test_taskstats_latency(void)
+{
+	OS_TASK_STATS stats;
+	uint8_t i;
+
+	OSResetTaskStats();
+	stats = test_stats(task1);
+	TEST_ASSERT((stats.runtime == 0) && (stats.switches == 0) && (stats.wakeups == 0));
+
+	/* Task 1 waits, is woken up at 2000 and runs at 2040 */
+	test_switch(1000, task1);
+	OSReadyListRemove(&ContextTask[task1]);
+	test_switch(1500, task2);
+	test_counter = 2000;
+	OSReadyListInsert(&ContextTask[task1]);
+
+	/* Inserting a ready task again does not restart the wake up */
+	test_counter = 2020;
+	OSReadyListInsert(&ContextTask[task1]);
+	test_switch(2040, task1);
+
+	stats = test_stats(task1);
+	TEST_ASSERT(stats.wakeups == 1);
+	TEST_ASSERT(stats.latency_min == 40);
+	TEST_ASSERT(stats.latency_max == 40);
+
+	#if (BRTOS_LATENCY_HIST_SHIFT == 4)
+	/* 40 is in the bin of [32, 64) */
+	TEST_ASSERT(stats.latency_hist[2] == 1);
+	#endif
+
+	/* Only the switch after a wake up is a sample of latency */
+	test_switch(2100, task2);
+	test_switch(2200, task1);
+	stats = test_stats(task1);
+	TEST_ASSERT(stats.wakeups == 1);
+
+	/* Second wake up with a shorter latency */
+	OSReadyListRemove(&ContextTask[task1]);
+	test_switch(2300, task2);
+	test_counter = 3000;
+	OSReadyListInsert(&ContextTask[task1]);
+	test_switch(3005, task1);
+
+	stats = test_stats(task1);
+	TEST_ASSERT(stats.wakeups == 2);
+	TEST_ASSERT(stats.latency_min == 5);
+	TEST_ASSERT(stats.latency_max == 40);
+	TEST_ASSERT(stats.latency_total == 45);
+	#if (BRTOS_LATENCY_HIST_SHIFT == 4)
+	TEST_ASSERT(stats.latency_hist[0] == 1);
+	#endif
+
+	/* A latency above all the bins is counted in the last bin */
+	OSReadyListRemove(&ContextTask[task1]);
+	test_switch(3100, task2);
+	test_counter = 4000;
+	OSReadyListInsert(&ContextTask[task1]);
+	test_switch(4000 + 0x7FFFFFFFUL, task1);
+
+	stats = test_stats(task1);
+	TEST_ASSERT(stats.wakeups == 3);
+	TEST_ASSERT(stats.latency_max == 0x7FFFFFFFUL);
+	TEST_ASSERT(stats.latency_hist[BRTOS_LATENCY_HIST_SIZE - 1] == 1);
+
+	for (i = 0; i < BRTOS_LATENCY_HIST_SIZE; i++)
+	{
+		TEST_ASSERT(test_stats(task2).latency_hist[i] == 0);
+	}
+}
+#endif
+
+void taskstats_test(void)
+{
+#if (BRTOS_TASK_STATS_EN == 1)
+	run_test(test_taskstats_runtime);
+	run_test(test_taskstats_latency);
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
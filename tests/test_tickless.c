@@ -0,0 +1,220 @@
+/*
+ * test_tickless.c
+ *
+ * Tests of the tickless idle support of the kernel (TICKLESS == 1).
+ * The tick timer of the port is not used: the tests drive the tick counter
+ * and the delay list directly, as the tick interrupt and the HAL idle function do.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void tickless_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (TICKLESS == 1)
+
+#define TEST_MAX_IDLE_TICKS		(ostick_t)5000
+
+static ostick_t test_time_after(ostick_t ticks)
+{
+	osdtick_t time = (osdtick_t)OSGetCount() + (osdtick_t)ticks;
+
+	if (time >= TICK_COUNT_OVERFLOW)
+	{
+		time -= TICK_COUNT_OVERFLOW;
+	}
+
+	return (ostick_t)time;
+}
+
+/* Puts the task "n" (priority n) into the delay list */
+static void test_delay_task(uint8_t n, ostick_t ticks)
+{
+	ContextTask[n].Priority = n;
+	ContextTask[n].TimeToWait = test_time_after(ticks);
+	OSPrioClear(OSReadyList, n);
+	OSDelayListInsert(&ContextTask[n]);
+}
+
+/* One tick interrupt */
+static void test_tick(void)
+{
+	OSIncCounter(1);
+	OS_TICK_HANDLER();
+}
+
+/* Only the idle task is ready, at the tick count "start" */
+static void test_reset(ostick_t start)
+{
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+	OSPrioSet(OSReadyList, 0);
+
+	/* The tick handler synchronizes the empty delay list with the tick counter */
+	if (start != 0)
+	{
+		OSIncCounter(start);
+		OS_TICK_HANDLER();
+	}
+}
+
+void test_tickless_no_delayed_tasks(void)
+{
+	test_reset(0);
+
+	/* Nothing to wait for - sleep as long as the timer allows */
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == TEST_MAX_IDLE_TICKS);
+}
+
+void test_tickless_ready_task(void)
+{
+	test_reset(0);
+	test_delay_task(1, 100);
+
+	/* A ready task other than the idle task needs the next tick */
+	OSPrioSet(OSReadyList, 2);
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 0);
+
+	/* A blocked task does not */
+	OSPrioClear(OSBlockedList, 2);
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 100);
+	OSPrioSet(OSBlockedList, 2);
+}
+
+void test_tickless_earliest_deadline(void)
+{
+	test_reset(0);
+	test_delay_task(1, 300);
+	test_delay_task(2, 40);
+	test_delay_task(3, 7000);
+
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 40);
+
+	/* Limited by the tick timer */
+	TEST_ASSERT(OSTicklessIdleTime(30) == 30);
+
+	/* Below the minimum idle time */
+	test_delay_task(4, 1);
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 0);
+}
+
+void test_tickless_pending_tick(void)
+{
+	test_reset(0);
+	test_delay_task(1, 100);
+
+	/* The tick counter was incremented but the tick handler did not run yet */
+	OSIncCounter(1);
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 0);
+
+	OS_TICK_HANDLER();
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 99);
+}
+
+void test_tickless_compensate(void)
+{
+	ostick_t idle;
+
+	test_reset(0);
+	test_delay_task(1, 50);
+	test_delay_task(2, 80);
+
+	/* Woken early by another interrupt - no task is due */
+	idle = OSTicklessIdleTime(TEST_MAX_IDLE_TICKS);
+	TEST_ASSERT(idle == 50);
+	OSTicklessCompensate(20);
+	TEST_ASSERT(OSGetCount() == 20);
+	TEST_ASSERT(!OSPrioIsSet(OSReadyList, 1) && !OSPrioIsSet(OSReadyList, 2));
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 30);
+
+	/* Woken by the tick timer - the last tick is a regular tick interrupt */
+	idle = OSTicklessIdleTime(TEST_MAX_IDLE_TICKS);
+	OSTicklessCompensate((ostick_t)(idle - 1));
+	TEST_ASSERT(!OSPrioIsSet(OSReadyList, 1));
+	test_tick();
+	TEST_ASSERT(OSGetCount() == 50);
+	TEST_ASSERT(OSPrioIsSet(OSReadyList, 1));
+	TEST_ASSERT(ContextTask[1].TimeToWait == EXIT_BY_TIMEOUT);
+	TEST_ASSERT(!OSPrioIsSet(OSReadyList, 2));
+
+	/* Late wake up - every due task is released at once */
+	OSPrioReset(OSReadyList);
+	OSPrioSet(OSReadyList, 0);
+	test_delay_task(3, 10);
+	OSTicklessCompensate(40);
+	TEST_ASSERT(OSGetCount() == 90);
+	TEST_ASSERT(OSPrioIsSet(OSReadyList, 2) && OSPrioIsSet(OSReadyList, 3));
+	TEST_ASSERT(Head == NULL);
+}
+
+void test_tickless_counter_overflow(void)
+{
+	ostick_t start = (ostick_t)(TICK_COUNT_OVERFLOW - 10);
+
+	test_reset(start);
+	test_delay_task(1, 25);
+
+	/* The deadline is after the tick counter overflow */
+	TEST_ASSERT(ContextTask[1].TimeToWait == 15);
+	TEST_ASSERT(OSTicklessIdleTime(TEST_MAX_IDLE_TICKS) == 25);
+
+	OSTicklessCompensate(24);
+	TEST_ASSERT(OSGetCount() == 14);
+	TEST_ASSERT(!OSPrioIsSet(OSReadyList, 1));
+	test_tick();
+	TEST_ASSERT(OSPrioIsSet(OSReadyList, 1));
+}
+
+#if (COMPUTES_CPU_LOAD == 1)
+/* The load windows suppressed by a long tickless idle were idle windows */
+void test_tickless_cpu_load(void)
+{
+	test_reset(0);
+	OSDuty = 500;
+	LastOSDuty = 500;
+
+	OSTicklessCompensate(2500);
+	TEST_ASSERT(LastOSDuty == 0);
+}
+#endif
+#endif
+
+void tickless_test(void)
+{
+#if (TICKLESS == 1)
+	run_test(test_tickless_no_delayed_tasks);
+	run_test(test_tickless_ready_task);
+	run_test(test_tickless_earliest_deadline);
+	run_test(test_tickless_pending_tick);
+	run_test(test_tickless_compensate);
+	run_test(test_tickless_counter_overflow);
+	#if (COMPUTES_CPU_LOAD == 1)
+	run_test(test_tickless_cpu_load);
+	#endif
+
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
@@ -0,0 +1,144 @@
+/*
+ * test_trace.c
+ *
+ * Tests of the binary event trace (OSTRACE == 1).
+ * The records of the kernel and of the application are read back with OSTraceRead
+ * and the overwrite of the oldest records is verified, without starting the scheduler.
+ * Must be called before BRTOSStart.
+ *
+ */
+
+#include "BRTOS.h"
+#include "test_common.h"
+
+void trace_test(void);
+
+#if (PROCESSOR == X86)
+#include <stdio.h>
+
+#define PRINTF(...) printf(__VA_ARGS__);
+#endif
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#if (OSTRACE == 1)
+
+#define TEST_PRIORITY		(uint8_t)3
+
+static OS_TRACE_RECORD test_records[BRTOS_TRACE_SIZE];
+
+void test_trace_records(void)
+{
+	BRTOS_TH handle;
+	uint32_t lost;
+	uint16_t i, count;
+	#if (BRTOS_SEM_EN == 1)
+	BRTOS_Sem *sem;
+	#endif
+
+	OSTraceInit();
+	PreInstallTasks();
+	OSPrioReset(OSReadyList);
+
+	handle = test_install(TEST_PRIORITY);
+
+	#if (BRTOS_SEM_EN == 1)
+	TEST_ASSERT(OSSemCreate(0, &sem) == ALLOC_EVENT_OK);
+	TEST_ASSERT(OSSemPost(sem) == OK);
+	#endif
+
+	/* Application records, from a task and from an interrupt */
+	OSTraceUser(3, 42);
+	iNesting++;
+	OSTraceUser(4, 43);
+	iNesting--;
+
+	count = OSTraceRead(test_records, BRTOS_TRACE_SIZE, &lost);
+	TEST_ASSERT(lost == 0);
+
+	/* The start record gives the timestamp frequency */
+	TEST_ASSERT(test_records[0].type == OS_TRACE_START);
+	TEST_ASSERT(test_records[0].object == (uint32_t)OS_TRACE_TIMESTAMP_HZ);
+
+	TEST_ASSERT(test_records[1].type == OS_TRACE_TASK_INSTALL);
+	TEST_ASSERT(test_records[1].data == (uint16_t)handle);
+	TEST_ASSERT(test_records[1].object == TEST_PRIORITY);
+	i = 2;
+
+	#if (BRTOS_SEM_EN == 1)
+	/* The event is identified by its address */
+	TEST_ASSERT(test_records[i].type == OS_TRACE_SEM_POST);
+	TEST_ASSERT(test_records[i].object == (uint32_t)(size_t)sem);
+	TEST_ASSERT(OSSemDelete(&sem) == DELETE_EVENT_OK);
+	i++;
+	#endif
+
+	TEST_ASSERT(test_records[i].type == OS_TRACE_USER);
+	TEST_ASSERT((test_records[i].data == 3) && (test_records[i].object == 42));
+	TEST_ASSERT(test_records[i].task == 0);
+	i++;
+	TEST_ASSERT(test_records[i].type == (OS_TRACE_USER | OS_TRACE_ISR_FLAG));
+	TEST_ASSERT((test_records[i].data == 4) && (test_records[i].object == 43));
+	i++;
+	TEST_ASSERT(count == i);
+
+	/* The timestamps do not go back */
+	for(i = 1; i < count; i++)
+	{
+		TEST_ASSERT((int32_t)(test_records[i].timestamp - test_records[i - 1].timestamp) >= 0);
+	}
+
+	TEST_ASSERT(OSTraceRead(test_records, BRTOS_TRACE_SIZE, NULL) == 0);
+}
+
+void test_trace_overwrite(void)
+{
+	uint32_t lost, value;
+	uint16_t count;
+
+	OSTraceInit();
+	TEST_ASSERT(OSTraceRead(test_records, 1, NULL) == 1);
+
+	/* The oldest records are overwritten and counted as lost by the reader */
+	for(value = 0; value < (BRTOS_TRACE_SIZE + 5); value++)
+	{
+		OSTraceUser(1, value);
+	}
+
+	count = OSTraceRead(test_records, 2, &lost);
+	TEST_ASSERT(count == 2);
+	TEST_ASSERT(lost == 5);
+	TEST_ASSERT(test_records[0].object == 5);
+	TEST_ASSERT(test_records[1].object == 6);
+
+	/* The lost counter is cleared by the read */
+	count = OSTraceRead(test_records, BRTOS_TRACE_SIZE, &lost);
+	TEST_ASSERT(count == (BRTOS_TRACE_SIZE - 2));
+	TEST_ASSERT(lost == 0);
+	TEST_ASSERT(test_records[count - 1].object == (BRTOS_TRACE_SIZE + 4));
+}
+#endif
+
+void trace_test(void)
+{
+#if (OSTRACE == 1)
+	run_test(test_trace_records);
+	run_test(test_trace_overwrite);
+
+	OSTraceInit();
+	test_kernel_ready();
+#endif
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
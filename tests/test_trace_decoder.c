@@ -0,0 +1,120 @@
+/*
+ * test_trace_decoder.c
+ *
+ * Tests of the host decoder of the binary event trace (tools/brtos_trace.c).
+ * Synthetic little endian records are converted and the timestamps of the JSON events
+ * are verified. Host only, does not need the kernel.
+ *
+ */
+
+#define BRTOS_TRACE_NO_MAIN
+#include "../tools/brtos_trace.c"
+
+void trace_decoder_test(void);
+
+#define PRINTF(...) printf(__VA_ARGS__);
+
+/* config TEST_ASSERT( macro */
+#ifndef TEST_ASSERT
+#define TEST_ASSERT(x)		if(!(x)) while(1){}
+#endif
+
+#define run_test(test) do { test(); PRINTF("Test %d OK\r\n", tests_run); fflush(stdout); tests_run++; } while (0)
+static int tests_run = 0;
+
+#define DECODER_HZ			1000000UL
+#define DECODER_MAX_EVENTS	16
+
+static double decoder_ts[DECODER_MAX_EVENTS];
+
+static void decoder_put32(FILE *f, uint32_t value)
+{
+	fputc((int)(value & 0xFF), f);
+	fputc((int)((value >> 8) & 0xFF), f);
+	fputc((int)((value >> 16) & 0xFF), f);
+	fputc((int)((value >> 24) & 0xFF), f);
+}
+
+static void decoder_record(FILE *f, uint32_t timestamp, uint8_t type, uint32_t object)
+{
+	decoder_put32(f, timestamp);
+	fputc(type, f);
+	fputc(1, f);
+	fputc(0, f);
+	fputc(0, f);
+	decoder_put32(f, object);
+}
+
+/* Converts the records of in and returns the number of events with a timestamp */
+static int decoder_run(FILE *in)
+{
+	char json[4096];
+	const char *p = json;
+	size_t size;
+	int events = 0;
+
+	out = tmpfile();
+	TEST_ASSERT(out != NULL);
+
+	rewind(in);
+	TEST_ASSERT(convert(in, 0, 0) >= 0);
+
+	rewind(out);
+	size = fread(json, 1, sizeof(json) - 1, out);
+	json[size] = '\0';
+	fclose(out);
+	fclose(in);
+
+	while(((p = strstr(p, "\"ts\":")) != NULL) && (events < DECODER_MAX_EVENTS))
+	{
+		p += 5;
+		decoder_ts[events++] = atof(p);
+	}
+
+	return events;
+}
+
+/* A record written by an interrupt that preempted the write of the previous one */
+void test_trace_decoder_out_of_order(void)
+{
+	FILE *in = tmpfile();
+
+	TEST_ASSERT(in != NULL);
+	decoder_record(in, 0, OS_TRACE_START, DECODER_HZ);
+	decoder_record(in, 100, OS_TRACE_USER, 1);
+	decoder_record(in, 200, OS_TRACE_USER, 2);
+	decoder_record(in, 150, OS_TRACE_USER | OS_TRACE_ISR_FLAG, 3);
+	decoder_record(in, 300, OS_TRACE_USER, 4);
+
+	TEST_ASSERT(decoder_run(in) == 5);
+	TEST_ASSERT(decoder_ts[0] == 0.0);
+	TEST_ASSERT(decoder_ts[1] == 100.0);
+	TEST_ASSERT(decoder_ts[2] == 200.0);
+	TEST_ASSERT(decoder_ts[3] == 150.0);
+	TEST_ASSERT(decoder_ts[4] == 300.0);
+}
+
+/* The timestamp of 32 bits overflows between two records */
+void test_trace_decoder_overflow(void)
+{
+	FILE *in = tmpfile();
+
+	TEST_ASSERT(in != NULL);
+	decoder_record(in, 0xFFFFFF00UL, OS_TRACE_START, DECODER_HZ);
+	decoder_record(in, 0x00000100UL, OS_TRACE_USER, 1);
+	decoder_record(in, 0xFFFFFFF0UL, OS_TRACE_USER | OS_TRACE_ISR_FLAG, 2);
+
+	TEST_ASSERT(decoder_run(in) == 3);
+	TEST_ASSERT(decoder_ts[0] == 0.0);
+	TEST_ASSERT(decoder_ts[1] == 512.0);
+	TEST_ASSERT(decoder_ts[2] == 240.0);
+}
+
+void trace_decoder_test(void)
+{
+	run_test(test_trace_decoder_out_of_order);
+	run_test(test_trace_decoder_overflow);
+
+	PRINTF("ALL TESTS PASSED\n");
+	PRINTF("Tests run: %d\n", tests_run);
+}
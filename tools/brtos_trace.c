@@ -0,0 +1,370 @@
+/**
+* \file brtos_trace.c
+* \brief Host decoder of the BRTOS binary event trace
+*
+* Converts the records read by OSTraceRead (OSTRACE == 1) into the Chrome
+* trace event JSON format, which is opened by chrome://tracing and by the
+* Perfetto UI (ui.perfetto.dev). Each task is a thread of the timeline, the
+* interrupts are shown in a separated thread.
+*
+* Build:  cc -O2 -o brtos_trace brtos_trace.c
+* Usage:  brtos_trace [-b] [-f hz] [input.bin [output.json]]
+*
+*   -b     records of a big endian target
+*   -f hz  timestamp frequency, if the trace start record was not captured
+*
+* The input is the sequence of 12 bytes records as copied from OSTraceRead,
+* by default read from stdin and written to stdout. The timestamps of
+* 32 bits are extended by the decoder, so the target must write at least
+* one record at each half of the counter period (e.g. OS_TICK_SHOW == 1).
+* A timestamp older than the one of the previous record, written by an
+* interrupt that preempted the record write, goes back in the timeline.
+*
+* tests/test_trace_decoder.c includes this file with BRTOS_TRACE_NO_MAIN.
+*
+**/
+/*********************************************************************************************************
+*                                               BRTOS
+*                                Brazilian Real-Time Operating System
+*                            Acronymous of Basic Real-Time Operating System
+*
+*
+*                                  Open Source RTOS under MIT License
+*
+*
+*
+*                                        OS Trace host decoder
+*
+*
+*   Authors:  Gustavo Denardin
+*   Revision: 1.0
+*   Date:     18/10/2016
+*********************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Record types, as defined by OSTrace.h
+#define OS_TRACE_START          0
+#define OS_TRACE_SWITCH         1
+#define OS_TRACE_ISR_ENTER      2
+#define OS_TRACE_ISR_EXIT       3
+#define OS_TRACE_TICK           4
+#define OS_TRACE_TIMEOUT        5
+#define OS_TRACE_DELAY          6
+#define OS_TRACE_TASK_INSTALL   7
+#define OS_TRACE_SEM_PEND       8
+#define OS_TRACE_USER           16
+#define OS_TRACE_ISR_FLAG       0x80
+
+#define RECORD_SIZE             12
+#define ISR_THREAD              256
+#define MAX_TASKS               256
+
+// Names of the pend and post records, from OS_TRACE_SEM_PEND
+static const char *EventNames[] =
+{
+  "sem pend", "sem post", "mutex acquire", "mutex release",
+  "mbox pend", "mbox post", "queue pend", "queue post"
+};
+
+static FILE     *out;
+static int      first_event = 1;
+static double   now_us;
+
+// Task running and open interrupt slices at the end of the input
+static int      running = -1;
+static int      isr_depth = 0;
+static int      named[MAX_TASKS];
+
+
+
+static uint32_t get32(const unsigned char *p, int big)
+{
+  if (big)
+  {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+  }
+  return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | (uint32_t)p[0];
+}
+
+static uint16_t get16(const unsigned char *p, int big)
+{
+  if (big)
+  {
+    return (uint16_t)(((uint16_t)p[0] << 8) | (uint16_t)p[1]);
+  }
+  return (uint16_t)(((uint16_t)p[1] << 8) | (uint16_t)p[0]);
+}
+
+
+
+// Starts a JSON event - the fields common to every event
+static void event(const char *ph, const char *name, int tid)
+{
+  fprintf(out, "%s\n{\"ph\":\"%s\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+          first_event ? "" : ",", ph, name, tid, now_us);
+  first_event = 0;
+}
+
+static void instant(const char *name, int tid, const char *key, uint32_t value, int hex)
+{
+  event("i", name, tid);
+  fprintf(out, ",\"s\":\"t\",\"args\":{\"%s\":", key);
+  if (hex)
+  {
+    fprintf(out, "\"0x%08lx\"}}", (unsigned long)value);
+  }
+  else
+  {
+    fprintf(out, "%lu}}", (unsigned long)value);
+  }
+}
+
+static void thread_name(int tid, const char *name, int sort)
+{
+  fprintf(out, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+          first_event ? "" : ",", tid, name);
+  fprintf(out, ",\n{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+          tid, sort);
+  first_event = 0;
+}
+
+static void task_name(int task, int priority)
+{
+  char name[32];
+
+  if (priority < 0)
+  {
+    if (named[task]) return;
+    if (task == 0)
+    {
+      sprintf(name, "task 0 (startup)");
+    }
+    else
+    {
+      sprintf(name, "task %d", task);
+    }
+  }
+  else
+  {
+    sprintf(name, "task %d (priority %d)", task, priority);
+  }
+
+  named[task] = 1;
+
+  // Higher priority tasks on top
+  thread_name(task, name, (priority < 0) ? 1000 : 255 - priority);
+}
+
+
+
+static void decode(const unsigned char *r, int big)
+{
+  uint8_t  type   = r[4] & (uint8_t)~OS_TRACE_ISR_FLAG;
+  int      isr    = (r[4] & OS_TRACE_ISR_FLAG) != 0;
+  int      task   = r[5];
+  uint16_t data   = get16(&r[6], big);
+  uint32_t object = get32(&r[8], big);
+  int      tid    = isr ? ISR_THREAD : task;
+
+  switch(type)
+  {
+    case OS_TRACE_START:
+      instant("trace start", tid, "timestamp_hz", object, 0);
+      break;
+
+    case OS_TRACE_SWITCH:
+      if (running >= 0)
+      {
+        event("E", "running", running);
+        fprintf(out, "}");
+      }
+      running = data & 0xFF;
+      task_name(running, -1);
+      event("B", "running", running);
+      fprintf(out, "}");
+      break;
+
+    case OS_TRACE_ISR_ENTER:
+      isr_depth++;
+      event("B", "interrupt", ISR_THREAD);
+      fprintf(out, ",\"args\":{\"nesting\":%u,\"task\":%d}}", data, task);
+      break;
+
+    case OS_TRACE_ISR_EXIT:
+      if (isr_depth > 0)
+      {
+        isr_depth--;
+        event("E", "interrupt", ISR_THREAD);
+        fprintf(out, "}");
+      }
+      break;
+
+    case OS_TRACE_TICK:
+      instant("tick", ISR_THREAD, "tick", object, 0);
+      break;
+
+    case OS_TRACE_TIMEOUT:
+      task_name(data & 0xFF, -1);
+      instant("timeout", data & 0xFF, "task", data, 0);
+      break;
+
+    case OS_TRACE_DELAY:
+      task_name(task, -1);
+      instant("delay", task, "ticks", object, 0);
+      break;
+
+    case OS_TRACE_TASK_INSTALL:
+      task_name(data & 0xFF, (int)object);
+      break;
+
+    case OS_TRACE_USER:
+    {
+      char name[24];
+
+      sprintf(name, "user %u", data);
+      if (!isr) task_name(task, -1);
+      instant(name, tid, "value", object, 0);
+      break;
+    }
+
+    default:
+      if ((type >= OS_TRACE_SEM_PEND) && (type < OS_TRACE_USER))
+      {
+        if (!isr) task_name(task, -1);
+        instant(EventNames[type - OS_TRACE_SEM_PEND], tid, "object", object, 1);
+      }
+      else
+      {
+        fprintf(stderr, "unknown record type %u\n", type);
+      }
+      break;
+  }
+}
+
+
+
+// Converts the records of in to the JSON written to out, returns the number of records or -1
+static long convert(FILE *in, double hz, int big)
+{
+  unsigned char record[RECORD_SIZE];
+  int      first = 1;
+  uint32_t last = 0;
+  int64_t  ticks = 0;
+  long     count = 0;
+
+  first_event = 1;
+  running = -1;
+  isr_depth = 0;
+  memset(named, 0, sizeof(named));
+
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  thread_name(ISR_THREAD, "interrupts", -1);
+
+  while(fread(record, 1, RECORD_SIZE, in) == RECORD_SIZE)
+  {
+    uint32_t timestamp = get32(record, big);
+
+    // Timestamps of 32 bits extended to 64 bits, a signed difference
+    // keeps the records written out of order close to their neighbours
+    if (!first)
+    {
+      ticks += (int32_t)(timestamp - last);
+    }
+    first = 0;
+    last = timestamp;
+
+    // The start record gives the frequency of its own timestamp
+    if (((record[4] & (uint8_t)~OS_TRACE_ISR_FLAG) == OS_TRACE_START) && (hz == 0))
+    {
+      hz = (double)get32(&record[8], big);
+    }
+
+    if (hz == 0)
+    {
+      fprintf(stderr, "no trace start record, use -f to give the timestamp frequency\n");
+      return -1;
+    }
+
+    now_us = ((double)ticks * 1000000.0) / hz;
+    decode(record, big);
+    count++;
+  }
+
+  // Closes the slices still open
+  while(isr_depth-- > 0)
+  {
+    event("E", "interrupt", ISR_THREAD);
+    fprintf(out, "}");
+  }
+  if (running >= 0)
+  {
+    event("E", "running", running);
+    fprintf(out, "}");
+  }
+
+  fprintf(out, "\n]}\n");
+
+  return count;
+}
+
+
+
+#ifndef BRTOS_TRACE_NO_MAIN
+int main(int argc, char **argv)
+{
+  FILE     *in = stdin;
+  double   hz = 0;
+  int      big = 0;
+  int      arg = 1;
+  long     count;
+
+  out = stdout;
+
+  while((arg < argc) && (argv[arg][0] == '-') && (argv[arg][1] != '\0'))
+  {
+    if (strcmp(argv[arg], "-b") == 0)
+    {
+      big = 1;
+    }
+    else if ((strcmp(argv[arg], "-f") == 0) && ((arg + 1) < argc))
+    {
+      hz = atof(argv[++arg]);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [-b] [-f hz] [input.bin [output.json]]\n", argv[0]);
+      return 1;
+    }
+    arg++;
+  }
+
+  if ((arg < argc) && ((in = fopen(argv[arg], "rb")) == NULL))
+  {
+    perror(argv[arg]);
+    return 1;
+  }
+  arg++;
+
+  if ((arg < argc) && ((out = fopen(argv[arg], "w")) == NULL))
+  {
+    perror(argv[arg]);
+    return 1;
+  }
+
+  count = convert(in, hz, big);
+  if (count < 0)
+  {
+    return 1;
+  }
+  fprintf(stderr, "%ld records\n", count);
+
+  if (in != stdin) fclose(in);
+  if (out != stdout) fclose(out);
+
+  return 0;
+}
+#endif